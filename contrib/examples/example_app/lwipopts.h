@@ -70,6 +70,9 @@
 
 #define LWIP_TCPIP_CORE_LOCKING    1
 
+/* tapif sends the pbuf chains with writev() */
+#define LWIP_NETIF_LINKOUTPUT_SG        1
+
 #define LWIP_NETIF_LINK_CALLBACK        1
 #define LWIP_NETIF_STATUS_CALLBACK      1
 #define LWIP_NETIF_EXT_STATUS_CALLBACK  1
@@ -323,6 +326,10 @@ void sys_lock_tcpip_core(void);
 #define LOCK_TCPIP_CORE()          sys_lock_tcpip_core()
 void sys_unlock_tcpip_core(void);
 #define UNLOCK_TCPIP_CORE()        sys_unlock_tcpip_core()
+void sys_lock_tcpip_core_shared(void);
+#define LOCK_TCPIP_CORE_SHARED()   sys_lock_tcpip_core_shared()
+void sys_unlock_tcpip_core_shared(void);
+#define UNLOCK_TCPIP_CORE_SHARED() sys_unlock_tcpip_core_shared()
 #endif
 #endif
 
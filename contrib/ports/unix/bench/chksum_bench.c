@@ -0,0 +1,141 @@
+/**
+ * @file
+ * Throughput benchmark for the Internet checksum functions
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/def.h"
+#include "lwip/init.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/pbuf.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* bytes summed per measurement */
+#define BENCH_BYTES (256 * 1024 * 1024)
+/* pbuf size used for inet_chksum_pbuf() chains */
+#define BENCH_PBUF_LEN 1460
+
+static const u16_t bench_sizes[] = {20, 64, 576, 1500, 9000, 65535};
+
+static u8_t bench_src[0x10000 + 1];
+static u8_t bench_dst[0x10000 + 1];
+static volatile u16_t bench_sink;
+
+static double
+bench_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+/* returns MByte/s summing 'len' bytes at 'offset' */
+static double
+bench_chksum(size_t offset, u16_t len)
+{
+  struct timespec start, end;
+  u32_t i, rounds = BENCH_BYTES / len;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < rounds; i++) {
+    bench_sink = inet_chksum(&bench_src[offset], len);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (double)rounds * len * 1e3 / bench_ns(&start, &end);
+}
+
+static double
+bench_chksum_pbuf(u16_t len)
+{
+  struct timespec start, end;
+  struct pbuf *p = NULL;
+  u32_t i, rounds = BENCH_BYTES / len;
+  u32_t pos;
+
+  /* chain of PBUF_REF pbufs covering 'len' bytes, like a received packet */
+  for (pos = 0; pos < len; pos += BENCH_PBUF_LEN) {
+    struct pbuf *q = pbuf_alloc(PBUF_RAW, (u16_t)LWIP_MIN(BENCH_PBUF_LEN, len - pos), PBUF_REF);
+    LWIP_ASSERT("pbuf_alloc failed", q != NULL);
+    q->payload = &bench_src[pos];
+    if (p == NULL) {
+      p = q;
+    } else {
+      pbuf_cat(p, q);
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < rounds; i++) {
+    bench_sink = inet_chksum_pbuf(p);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  pbuf_free(p);
+  return (double)rounds * len * 1e3 / bench_ns(&start, &end);
+}
+
+static double
+bench_chksum_copy(u16_t len)
+{
+  struct timespec start, end;
+  u32_t i, rounds = BENCH_BYTES / len;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < rounds; i++) {
+    bench_sink = LWIP_CHKSUM_COPY(bench_dst, bench_src, len);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (double)rounds * len * 1e3 / bench_ns(&start, &end);
+}
+
+int
+main(void)
+{
+  size_t i;
+
+  lwip_init();
+
+  for (i = 0; i < sizeof(bench_src); i++) {
+    bench_src[i] = (u8_t)(i * 7 + (i >> 8));
+  }
+
+  printf("LWIP_CHKSUM_ALGORITHM=%d (MByte/s)\n", LWIP_CHKSUM_ALGORITHM);
+  printf("%6s %12s %12s %12s %12s\n", "size", "aligned", "odd", "pbuf chain", "copy");
+
+  for (i = 0; i < LWIP_ARRAYSIZE(bench_sizes); i++) {
+    u16_t len = bench_sizes[i];
+    printf("%6"U16_F" %12.0f %12.0f %12.0f %12.0f\n", len,
+           bench_chksum(0, len), bench_chksum(1, len),
+           bench_chksum_pbuf(len), bench_chksum_copy(len));
+  }
+  return 0;
+}
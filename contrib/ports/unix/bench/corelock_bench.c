@@ -0,0 +1,168 @@
+/**
+ * @file
+ * Benchmark for the core lock of the unix port: lwip_getsockopt() calls per
+ * second from several threads, with and without a thread calling
+ * lwip_setsockopt() at the same time
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/def.h"
+#include "lwip/tcpip.h"
+#include "lwip/sockets.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_CALLS 400000
+#define BENCH_MAX_THREADS 4
+
+static const int bench_threads[] = {1, 2, 4};
+
+static volatile int bench_ready;
+static volatile int bench_writer_stop;
+static int bench_sock;
+
+static void
+bench_init_done(void *arg)
+{
+  LWIP_UNUSED_ARG(arg);
+  __atomic_store_n(&bench_ready, 1, __ATOMIC_RELEASE);
+}
+
+static void *
+bench_reader(void *arg)
+{
+  u32_t i, num = *(u32_t *)arg;
+
+  for (i = 0; i < num; i++) {
+    int type;
+    socklen_t len = sizeof(type);
+    if ((lwip_getsockopt(bench_sock, SOL_SOCKET, SO_TYPE, &type, &len) != 0) || (type != SOCK_DGRAM)) {
+      printf("lwip_getsockopt failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  return NULL;
+}
+
+static void *
+bench_writer(void *arg)
+{
+  int on = 0;
+
+  LWIP_UNUSED_ARG(arg);
+  while (!__atomic_load_n(&bench_writer_stop, __ATOMIC_ACQUIRE)) {
+    on = !on;
+    lwip_setsockopt(bench_sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    sched_yield();
+  }
+  return NULL;
+}
+
+static double
+bench_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+/* Run BENCH_CALLS lwip_getsockopt() calls spread over num threads, returns
+   the calls per second */
+static double
+bench_run(int num, int with_writer)
+{
+  pthread_t threads[BENCH_MAX_THREADS];
+  pthread_t writer;
+  struct timespec start, end;
+  u32_t per_thread = BENCH_CALLS / (u32_t)num;
+  int j;
+
+  if (with_writer) {
+    __atomic_store_n(&bench_writer_stop, 0, __ATOMIC_RELEASE);
+    if (pthread_create(&writer, NULL, bench_writer, NULL) != 0) {
+      printf("pthread_create failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (j = 0; j < num; j++) {
+    if (pthread_create(&threads[j], NULL, bench_reader, &per_thread) != 0) {
+      printf("pthread_create failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (j = 0; j < num; j++) {
+    pthread_join(threads[j], NULL);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if (with_writer) {
+    __atomic_store_n(&bench_writer_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(writer, NULL);
+  }
+  return (double)(per_thread * (u32_t)num) * 1e9 / bench_ns(&start, &end);
+}
+
+int
+main(void)
+{
+  size_t i;
+
+  tcpip_init(bench_init_done, NULL);
+  while (!__atomic_load_n(&bench_ready, __ATOMIC_ACQUIRE)) {
+    sched_yield();
+  }
+
+#ifdef SYS_CORE_LOCK_RW
+  printf("SYS_CORE_LOCK_RW=%d\n", SYS_CORE_LOCK_RW);
+#endif
+
+  bench_sock = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+  if (bench_sock < 0) {
+    printf("lwip_socket failed\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("%8s %16s %16s\n", "threads", "calls/s", "calls/s+writer");
+  for (i = 0; i < LWIP_ARRAYSIZE(bench_threads); i++) {
+    double alone = bench_run(bench_threads[i], 0);
+    double mixed = bench_run(bench_threads[i], 1);
+    printf("%8d %16.0f %16.0f\n", bench_threads[i], alone, mixed);
+  }
+  lwip_close(bench_sock);
+
+#if SYS_CORE_LOCK_PROFILE
+  sys_core_lock_profile_dump();
+#endif
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file
+ * lwIP options for the unix port benchmarks
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_BENCH_LWIPOPTS_H
+#define LWIP_BENCH_LWIPOPTS_H
+
+#define NO_SYS                          0
+#define SYS_LIGHTWEIGHT_PROT            1
+#define LWIP_NETCONN                    1
+#define LWIP_SOCKET                     1
+
+/* mem_bench keeps up to 64 blocks of up to 1600 bytes and 256 small ones */
+#define MEM_SIZE                        160000
+/* memp_bench allocates PBUF_POOL elements from up to 8 threads */
+#define PBUF_POOL_SIZE                  1024
+
+/* timers_bench adds 1000 timeouts on top of up to 20000 pending ones */
+#define MEMP_NUM_SYS_TIMEOUT            (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 21000)
+
+#ifndef LWIP_TIMERS_WHEEL
+#define LWIP_TIMERS_WHEEL               1
+#endif
+#define LWIP_TIMERS_WHEEL_SIZE          4096
+
+/* chksum_bench measures LWIP_CHKSUM_ALGORITHM and lwip_chksum_copy() */
+#ifndef LWIP_CHKSUM_ALGORITHM
+#define LWIP_CHKSUM_ALGORITHM           5
+#endif
+#define LWIP_CHECKSUM_ON_COPY           1
+#ifndef LWIP_CHKSUM_COPY_ALGORITHM
+#define LWIP_CHKSUM_COPY_ALGORITHM      2
+#endif
+/* enough PBUF_REF pbufs to chain 64 KByte in 1460 byte segments */
+#define MEMP_NUM_PBUF                   64
+
+/* memp_bench compares the pool locking variants, the shared pool stats
+   would dominate the lock-free variant */
+#define MEMP_STATS                      0
+#ifndef MEMP_LOCKFREE
+#define MEMP_LOCKFREE                   0
+#endif
+#ifndef MEMP_CACHE
+#define MEMP_CACHE                      0
+#endif
+
+/* mem_bench compares the first-fit heap with and without size classes */
+#ifndef MEM_SIZE_CLASSES
+#define MEM_SIZE_CLASSES                0
+#endif
+
+#ifndef LWIP_PBUF_REF_ATOMIC
+#define LWIP_PBUF_REF_ATOMIC            0
+#endif
+
+/* mbox_bench keeps up to 4 threads posting to tcpip_mbox, more messages than
+   fit into the mailbox so that full mailboxes block the producers */
+#define MEMP_NUM_TCPIP_MSG_API          512
+
+/* Core locking checks of the unix port */
+void sys_check_core_locking(void);
+#define LWIP_ASSERT_CORE_LOCKED()  sys_check_core_locking()
+void sys_mark_tcpip_thread(void);
+#define LWIP_MARK_TCPIP_THREAD()   sys_mark_tcpip_thread()
+void sys_lock_tcpip_core(void);
+#define LOCK_TCPIP_CORE()          sys_lock_tcpip_core()
+void sys_unlock_tcpip_core(void);
+#define UNLOCK_TCPIP_CORE()        sys_unlock_tcpip_core()
+void sys_lock_tcpip_core_shared(void);
+#define LOCK_TCPIP_CORE_SHARED()   sys_lock_tcpip_core_shared()
+void sys_unlock_tcpip_core_shared(void);
+#define UNLOCK_TCPIP_CORE_SHARED() sys_unlock_tcpip_core_shared()
+
+#endif /* LWIP_BENCH_LWIPOPTS_H */
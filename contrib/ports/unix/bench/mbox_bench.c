@@ -0,0 +1,161 @@
+/**
+ * @file
+ * Benchmark for the mailboxes of the unix port: tcpip_callback() round-trip
+ * latency and throughput from several threads
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/def.h"
+#include "lwip/tcpip.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_RTT_ROUNDS 100000
+#define BENCH_TP_MSGS 400000
+#define BENCH_MAX_THREADS 4
+
+static const int bench_threads[] = {1, 2, 4};
+
+static volatile int bench_ready;
+/* only changed by tcpip_thread */
+static u32_t bench_received;
+
+static void
+bench_init_done(void *arg)
+{
+  LWIP_UNUSED_ARG(arg);
+  __atomic_store_n(&bench_ready, 1, __ATOMIC_RELEASE);
+}
+
+static void
+bench_set_flag(void *arg)
+{
+  __atomic_store_n((int *)arg, 1, __ATOMIC_RELEASE);
+}
+
+static void
+bench_count(void *arg)
+{
+  LWIP_UNUSED_ARG(arg);
+  __atomic_store_n(&bench_received, bench_received + 1, __ATOMIC_RELEASE);
+}
+
+/* Post a callback, retrying while the message pool is exhausted. Blocks while
+   tcpip_mbox is full. */
+static void
+bench_post(tcpip_callback_fn fn, void *arg)
+{
+  while (tcpip_callback(fn, arg) != ERR_OK) {
+    sched_yield();
+  }
+}
+
+static void *
+bench_producer(void *arg)
+{
+  u32_t i, num = *(u32_t *)arg;
+
+  for (i = 0; i < num; i++) {
+    bench_post(bench_count, NULL);
+  }
+  return NULL;
+}
+
+static double
+bench_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+int
+main(void)
+{
+  pthread_t threads[BENCH_MAX_THREADS];
+  struct timespec start, end;
+  size_t i;
+  int j;
+  u32_t per_thread;
+
+  tcpip_init(bench_init_done, NULL);
+  while (!__atomic_load_n(&bench_ready, __ATOMIC_ACQUIRE)) {
+    sched_yield();
+  }
+
+#ifdef SYS_MBOX_LOCKFREE
+  printf("SYS_MBOX_LOCKFREE=%d\n", SYS_MBOX_LOCKFREE);
+#endif
+
+  /* one callback at a time: every round trip wakes up tcpip_thread */
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < BENCH_RTT_ROUNDS; i++) {
+    int flag = 0;
+    bench_post(bench_set_flag, &flag);
+    while (!__atomic_load_n(&flag, __ATOMIC_ACQUIRE)) {
+      sched_yield();
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  printf("round trip: %.0f ns\n", bench_ns(&start, &end) / BENCH_RTT_ROUNDS);
+
+  printf("%8s %16s\n", "threads", "msgs/s");
+  for (i = 0; i < LWIP_ARRAYSIZE(bench_threads); i++) {
+    int num = bench_threads[i];
+    u32_t total;
+
+    per_thread = BENCH_TP_MSGS / (u32_t)num;
+    total = per_thread * (u32_t)num;
+    LOCK_TCPIP_CORE();
+    bench_received = 0;
+    UNLOCK_TCPIP_CORE();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (j = 0; j < num; j++) {
+      if (pthread_create(&threads[j], NULL, bench_producer, &per_thread) != 0) {
+        printf("pthread_create failed\n");
+        return EXIT_FAILURE;
+      }
+    }
+    for (j = 0; j < num; j++) {
+      pthread_join(threads[j], NULL);
+    }
+    while (__atomic_load_n(&bench_received, __ATOMIC_ACQUIRE) != total) {
+      sched_yield();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%8d %16.0f\n", num, total * 1e9 / bench_ns(&start, &end));
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file
+ * Fragmentation and latency benchmark for mem_malloc()/mem_free()/mem_trim()
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/def.h"
+#include "lwip/init.h"
+#include "lwip/mem.h"
+#include "lwip/stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !LWIP_STATS || !MEM_STATS
+#error "mem_bench needs MEM_STATS"
+#endif
+
+/* allocations held at once, replaced in random order */
+#define BENCH_BIG_SLOTS   64
+#define BENCH_SMALL_SLOTS 256
+#define BENCH_ROUNDS      1000000
+/* every n-th allocation is shrunk with mem_trim() like pbuf_realloc() does */
+#define BENCH_TRIM_EVERY  8
+
+struct bench_scenario {
+  const char *name;
+  /* percentage of the rounds that replace a small instead of a big block */
+  u32_t small_percent;
+};
+
+/* small and big blocks with the same lifetime, and small blocks (e.g. queued
+   ACKs or small writes) living 20 times longer than big blocks */
+static const struct bench_scenario bench_scenarios[] = {
+  {"mixed", 73},
+  {"long-lived small", 12}
+};
+
+static void *big_slots[BENCH_BIG_SLOTS];
+static void *small_slots[BENCH_SMALL_SLOTS];
+static u32_t bench_seed = 0x12345678;
+
+static u32_t
+bench_rand(void)
+{
+  /* xorshift32: the same sequence for every allocator variant */
+  bench_seed ^= bench_seed << 13;
+  bench_seed ^= bench_seed >> 17;
+  bench_seed ^= bench_seed << 5;
+  return bench_seed;
+}
+
+static double
+bench_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+/* the biggest block that can still be allocated */
+static mem_size_t
+bench_largest_free(void)
+{
+  mem_size_t lo = 0, hi = MEM_SIZE;
+  while (lo < hi) {
+    mem_size_t mid = (mem_size_t)(lo + (hi - lo + 1) / 2);
+    void *p = mem_malloc(mid);
+    if (p != NULL) {
+      mem_free(p);
+      lo = mid;
+    } else {
+      hi = (mem_size_t)(mid - 1);
+    }
+  }
+  return lo;
+}
+
+static void
+bench_free_all(void **slots, u32_t num)
+{
+  u32_t i;
+  for (i = 0; i < num; i++) {
+    if (slots[i] != NULL) {
+      mem_free(slots[i]);
+      slots[i] = NULL;
+    }
+  }
+}
+
+static int
+bench_run(const struct bench_scenario *sc)
+{
+  struct timespec start, end, t0, t1;
+  u32_t i, r, failed = 0;
+  double ns, worst = 0;
+  mem_size_t size, largest, free_bytes;
+  void **slot;
+
+  lwip_stats.mem.err = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < BENCH_ROUNDS; i++) {
+    r = bench_rand();
+    if ((r % 100) < sc->small_percent) {
+      /* headers, ACKs and small writes */
+      slot = &small_slots[(r >> 8) % BENCH_SMALL_SLOTS];
+      size = (mem_size_t)(20 + (r >> 16) % 230);
+    } else {
+      /* full and partial segments */
+      slot = &big_slots[(r >> 8) % BENCH_BIG_SLOTS];
+      size = (mem_size_t)(500 + (r >> 16) % 1100);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (*slot != NULL) {
+      mem_free(*slot);
+    }
+    *slot = mem_malloc(size);
+    if ((*slot != NULL) && ((i % BENCH_TRIM_EVERY) == 0)) {
+      size = (mem_size_t)(size / 2);
+      mem_trim(*slot, size);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    if (*slot == NULL) {
+      failed++;
+    } else {
+      memset(*slot, 0xaa, size);
+    }
+    ns = bench_ns(&t0, &t1);
+    if (ns > worst) {
+      worst = ns;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  /* with all slots still allocated: how much of the free memory is usable? */
+  free_bytes = (mem_size_t)(lwip_stats.mem.avail - lwip_stats.mem.used);
+  largest = bench_largest_free();
+
+  printf("%-18s %8.1f %12.0f %8"U32_F" %8d %8d %8d %13.1f%%\n", sc->name,
+         bench_ns(&start, &end) / BENCH_ROUNDS, worst, failed, (int)lwip_stats.mem.used,
+         (int)free_bytes, (int)largest, 100.0 * (1.0 - (double)largest / (double)free_bytes));
+
+  bench_free_all(big_slots, BENCH_BIG_SLOTS);
+  bench_free_all(small_slots, BENCH_SMALL_SLOTS);
+  if (lwip_stats.mem.used != 0) {
+    printf("FAILED: %d bytes were lost\n", (int)lwip_stats.mem.used);
+    return 0;
+  }
+  return 1;
+}
+
+int
+main(void)
+{
+  size_t i;
+  int ret = EXIT_SUCCESS;
+
+  lwip_init();
+
+  printf("MEM_SIZE=%d MEM_SIZE_CLASSES=%d\n", MEM_SIZE, MEM_SIZE_CLASSES);
+  printf("%-18s %8s %12s %8s %8s %8s %8s %14s\n", "scenario", "ns/op", "worst ns/op",
+         "failed", "used", "free", "largest", "fragmentation");
+  for (i = 0; i < LWIP_ARRAYSIZE(bench_scenarios); i++) {
+    if (!bench_run(&bench_scenarios[i])) {
+      ret = EXIT_FAILURE;
+    }
+  }
+  return ret;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file
+ * Stress test and benchmark for memp_malloc()/memp_free() from many threads
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/def.h"
+#include "lwip/init.h"
+#include "lwip/memp.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* allocations per thread and round: elements held at once */
+#define BENCH_BURST  8
+#define BENCH_ROUNDS 200000
+#define BENCH_MAX_THREADS 8
+/* take and return each burst with memp_malloc_bulk()/memp_free_bulk() */
+#ifndef MEMP_BENCH_BULK
+#define MEMP_BENCH_BULK 0
+#endif
+
+static const int bench_threads[] = {1, 2, 4, 8};
+
+struct bench_thread {
+  pthread_t thread;
+  u32_t id;
+  u32_t failed;
+  u32_t corrupted;
+};
+
+static void *
+bench_thread_fn(void *arg)
+{
+  struct bench_thread *t = (struct bench_thread *)arg;
+  u32_t *elems[BENCH_BURST];
+  u32_t i, j, n;
+
+  for (i = 0; i < BENCH_ROUNDS; i++) {
+#if MEMP_BENCH_BULK
+    n = memp_malloc_bulk(MEMP_PBUF_POOL, (void **)elems, BENCH_BURST);
+    t->failed += BENCH_BURST - n;
+    for (j = 0; j < n; j++) {
+      elems[j][0] = t->id;
+      elems[j][1] = i;
+    }
+#else /* MEMP_BENCH_BULK */
+    n = 0;
+    for (j = 0; j < BENCH_BURST; j++) {
+      elems[n] = (u32_t *)memp_malloc(MEMP_PBUF_POOL);
+      if (elems[n] == NULL) {
+        t->failed++;
+        continue;
+      }
+      /* mark the element as ours: a concurrent owner would overwrite it */
+      elems[n][0] = t->id;
+      elems[n][1] = i;
+      n++;
+    }
+#endif /* MEMP_BENCH_BULK */
+    for (j = 0; j < n; j++) {
+      if ((elems[j][0] != t->id) || (elems[j][1] != i)) {
+        t->corrupted++;
+      }
+#if !MEMP_BENCH_BULK
+      memp_free(MEMP_PBUF_POOL, elems[j]);
+#endif /* !MEMP_BENCH_BULK */
+    }
+#if MEMP_BENCH_BULK
+    memp_free_bulk(MEMP_PBUF_POOL, (void **)elems, (u16_t)n);
+#endif /* MEMP_BENCH_BULK */
+  }
+  return NULL;
+}
+
+static double
+bench_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+/* all elements must be back in the pool */
+static int
+bench_check_pool(void)
+{
+  void *first = NULL;
+  void *p;
+  u32_t n = 0;
+
+  while ((p = memp_malloc(MEMP_PBUF_POOL)) != NULL) {
+    *(void **)p = first;
+    first = p;
+    n++;
+  }
+  while (first != NULL) {
+    p = first;
+    first = *(void **)p;
+    memp_free(MEMP_PBUF_POOL, p);
+  }
+  return n == memp_pools[MEMP_PBUF_POOL]->num;
+}
+
+int
+main(void)
+{
+  struct bench_thread threads[BENCH_MAX_THREADS];
+  struct timespec start, end;
+  size_t i;
+  int j;
+  int ret = EXIT_SUCCESS;
+
+  lwip_init();
+
+  printf("MEMP_LOCKFREE=%d MEMP_CACHE=%d MEMP_BENCH_BULK=%d\n", MEMP_LOCKFREE, MEMP_CACHE, MEMP_BENCH_BULK);
+  printf("%8s %16s %10s\n", "threads", "ops/s", "failed");
+
+  for (i = 0; i < LWIP_ARRAYSIZE(bench_threads); i++) {
+    int num = bench_threads[i];
+    u32_t failed = 0, corrupted = 0;
+    double ops;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (j = 0; j < num; j++) {
+      threads[j].id = (u32_t)j + 1;
+      threads[j].failed = 0;
+      threads[j].corrupted = 0;
+      if (pthread_create(&threads[j].thread, NULL, bench_thread_fn, &threads[j]) != 0) {
+        printf("pthread_create failed\n");
+        return EXIT_FAILURE;
+      }
+    }
+    for (j = 0; j < num; j++) {
+      pthread_join(threads[j].thread, NULL);
+      failed += threads[j].failed;
+      corrupted += threads[j].corrupted;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    /* one memp_malloc() and one memp_free() per element */
+    ops = 2.0 * num * BENCH_ROUNDS * BENCH_BURST - failed;
+    printf("%8d %16.0f %10"U32_F"\n", num, ops * 1e9 / bench_ns(&start, &end), failed);
+
+    if (corrupted != 0) {
+      printf("FAILED: %"U32_F" elements were handed out twice\n", corrupted);
+      ret = EXIT_FAILURE;
+    }
+    if (!bench_check_pool()) {
+      printf("FAILED: elements were lost\n");
+      ret = EXIT_FAILURE;
+    }
+  }
+  return ret;
+}
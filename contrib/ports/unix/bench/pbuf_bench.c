@@ -0,0 +1,135 @@
+/**
+ * @file
+ * Stress test and benchmark for pbuf_ref()/pbuf_free() of one pbuf shared
+ * by many threads
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/def.h"
+#include "lwip/init.h"
+#include "lwip/pbuf.h"
+#include "lwip/memp.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* references per thread and round: held at once, like a flooded frame
+   queued on several ports */
+#define BENCH_FANOUT 8
+#define BENCH_ROUNDS 500000
+#define BENCH_MAX_THREADS 8
+
+static const int bench_threads[] = {1, 2, 4, 8};
+
+struct bench_thread {
+  pthread_t thread;
+  struct pbuf *p;
+};
+
+static void *
+bench_thread_fn(void *arg)
+{
+  struct bench_thread *t = (struct bench_thread *)arg;
+  u32_t i, j;
+
+  for (i = 0; i < BENCH_ROUNDS; i++) {
+    for (j = 0; j < BENCH_FANOUT; j++) {
+      pbuf_ref(t->p);
+    }
+    for (j = 0; j < BENCH_FANOUT; j++) {
+      pbuf_free(t->p);
+    }
+  }
+  return NULL;
+}
+
+static double
+bench_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+int
+main(void)
+{
+  struct bench_thread threads[BENCH_MAX_THREADS];
+  struct timespec start, end;
+  struct pbuf *p;
+  size_t i;
+  int j;
+  int ret = EXIT_SUCCESS;
+
+  lwip_init();
+
+  printf("LWIP_PBUF_REF_ATOMIC=%d sizeof(LWIP_PBUF_REF_T)=%d\n", LWIP_PBUF_REF_ATOMIC, (int)sizeof(LWIP_PBUF_REF_T));
+  printf("%8s %16s\n", "threads", "ops/s");
+
+  for (i = 0; i < LWIP_ARRAYSIZE(bench_threads); i++) {
+    int num = bench_threads[i];
+    double ops;
+
+    p = pbuf_alloc(PBUF_RAW, 1500, PBUF_POOL);
+    if (p == NULL) {
+      printf("pbuf_alloc failed\n");
+      return EXIT_FAILURE;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (j = 0; j < num; j++) {
+      threads[j].p = p;
+      if (pthread_create(&threads[j].thread, NULL, bench_thread_fn, &threads[j]) != 0) {
+        printf("pthread_create failed\n");
+        return EXIT_FAILURE;
+      }
+    }
+    for (j = 0; j < num; j++) {
+      pthread_join(threads[j].thread, NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    /* one pbuf_ref() and one pbuf_free() per reference */
+    ops = 2.0 * num * BENCH_ROUNDS * BENCH_FANOUT;
+    printf("%8d %16.0f\n", num, ops * 1e9 / bench_ns(&start, &end));
+
+    /* all references must be dropped again, leaving ours */
+    if (p->ref != 1) {
+      printf("FAILED: reference count is %d instead of 1\n", (int)p->ref);
+      ret = EXIT_FAILURE;
+    } else if (pbuf_free(p) == 0) {
+      printf("FAILED: pbuf was not freed\n");
+      ret = EXIT_FAILURE;
+    }
+  }
+  return ret;
+}
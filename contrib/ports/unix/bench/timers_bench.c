@@ -0,0 +1,111 @@
+/**
+ * @file
+ * Benchmark for sys_timeout()/sys_untimeout() with many pending timeouts
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/def.h"
+#include "lwip/init.h"
+#include "lwip/timeouts.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_OPS 1000
+
+static const u32_t bench_pending[] = {10, 100, 1000, 10000, 20000};
+
+static void
+bench_handler(void *arg)
+{
+  LWIP_UNUSED_ARG(arg);
+}
+
+static u32_t bench_seed = 12345;
+
+/* timeouts between 1 ms and ~1 minute, like DHCP, DNS or TCP timers */
+static u32_t
+bench_rand_msecs(void)
+{
+  bench_seed = bench_seed * 1103515245UL + 12345UL;
+  return 1 + ((bench_seed >> 8) % 60000);
+}
+
+static double
+bench_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+int
+main(void)
+{
+  size_t i;
+  u32_t j;
+  struct timespec start, end;
+  double ns_add, ns_del;
+
+  lwip_init();
+
+  printf("LWIP_TIMERS_WHEEL=%d\n", LWIP_TIMERS_WHEEL);
+  printf("%8s %16s %16s\n", "pending", "sys_timeout ns", "sys_untimeout ns");
+
+  for (i = 0; i < LWIP_ARRAYSIZE(bench_pending); i++) {
+    u32_t pending = bench_pending[i];
+
+    for (j = 0; j < pending; j++) {
+      sys_timeout(bench_rand_msecs(), bench_handler, LWIP_PTR_NUMERIC_CAST(void *, j));
+    }
+
+    /* add and remove BENCH_OPS timeouts on top of the pending ones */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (j = 0; j < BENCH_OPS; j++) {
+      sys_timeout(bench_rand_msecs(), bench_handler, LWIP_PTR_NUMERIC_CAST(void *, pending + j));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ns_add = bench_ns(&start, &end) / BENCH_OPS;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (j = 0; j < BENCH_OPS; j++) {
+      sys_untimeout(bench_handler, LWIP_PTR_NUMERIC_CAST(void *, pending + j));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ns_del = bench_ns(&start, &end) / BENCH_OPS;
+
+    printf("%8"U32_F" %16.1f %16.1f\n", pending, ns_add, ns_del);
+
+    for (j = 0; j < pending; j++) {
+      sys_untimeout(bench_handler, LWIP_PTR_NUMERIC_CAST(void *, j));
+    }
+  }
+  return 0;
+}
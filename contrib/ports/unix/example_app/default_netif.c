@@ -35,6 +35,7 @@
 #include "lwip/netif.h"
 #include "lwip/ip_addr.h"
 #include "lwip/tcpip.h"
+#include "lwip/netifapi.h"
 #include "netif/tapif.h"
 #include "examples/example_app/default_netif.h"
 
@@ -65,4 +66,11 @@ default_netif_poll(void)
 void
 default_netif_shutdown(void)
 {
+  /* stop using the tap device, then close it */
+#if NO_SYS
+  netif_remove(&netif);
+#else
+  netifapi_netif_remove(&netif);
+#endif
+  tapif_shutdown(&netif);
 }
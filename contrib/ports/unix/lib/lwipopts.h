@@ -439,6 +439,10 @@ void sys_lock_tcpip_core(void);
 #define LOCK_TCPIP_CORE()          sys_lock_tcpip_core()
 void sys_unlock_tcpip_core(void);
 #define UNLOCK_TCPIP_CORE()        sys_unlock_tcpip_core()
+void sys_lock_tcpip_core_shared(void);
+#define LOCK_TCPIP_CORE_SHARED()   sys_lock_tcpip_core_shared()
+void sys_unlock_tcpip_core_shared(void);
+#define UNLOCK_TCPIP_CORE_SHARED() sys_unlock_tcpip_core_shared()
 #endif
 #endif
 
@@ -59,6 +59,22 @@ typedef struct sys_mbox * sys_mbox_t;
 struct sys_thread;
 typedef struct sys_thread * sys_thread_t;
 
+#if MEMP_CACHE && !defined(LWIP_MEMP_THREAD_CACHE_GET)
+struct memp_cache;
+struct memp_cache *sys_arch_memp_cache_get(void);
+#define LWIP_MEMP_THREAD_CACHE_GET() sys_arch_memp_cache_get()
+#endif /* MEMP_CACHE */
+
+/* SYS_CORE_LOCK_PROFILE==1: record wait and hold times of the core lock
+   per call site, print them with sys_core_lock_profile_dump() */
+#ifndef SYS_CORE_LOCK_PROFILE
+#define SYS_CORE_LOCK_PROFILE 0
+#endif
+#if SYS_CORE_LOCK_PROFILE
+void sys_core_lock_profile_dump(void);
+void sys_core_lock_profile_reset(void);
+#endif /* SYS_CORE_LOCK_PROFILE */
+
 #define LWIP_EXAMPLE_APP_ABORT() lwip_unix_keypressed()
 int lwip_unix_keypressed(void);
 
@@ -36,6 +36,7 @@
 
 err_t tapif_init(struct netif *netif);
 void tapif_poll(struct netif *netif);
+void tapif_shutdown(struct netif *netif);
 #if NO_SYS
 int tapif_select(struct netif *netif);
 #endif /* NO_SYS */
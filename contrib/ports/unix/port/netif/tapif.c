@@ -98,9 +98,26 @@
 #define TAPIF_DEBUG LWIP_DBG_OFF
 #endif
 
+/* Number of RX pbufs allocated at once (with pbuf_alloc_bulk) */
+#ifndef TAPIF_RX_BATCH
+#define TAPIF_RX_BATCH 8
+#endif
+
+/* How often (in ms) the RX thread checks whether tapif_shutdown() stops it */
+#ifndef TAPIF_RX_STOP_POLL_MS
+#define TAPIF_RX_STOP_POLL_MS 100
+#endif
+
 struct tapif {
   /* Add whatever per-interface state that is needed here. */
   int fd;
+  /* preallocated PBUF_POOL_BUFSIZE pbufs for received frames */
+  struct pbuf *rx[TAPIF_RX_BATCH];
+  u16_t rx_count;
+#if !NO_SYS
+  volatile int rx_run;
+  volatile int rx_running;
+#endif /* !NO_SYS */
 };
 
 /* Forward declarations. */
@@ -201,9 +218,20 @@ low_level_init(struct netif *netif)
   }
 
 #if !NO_SYS
+  tapif->rx_run = 1;
+  tapif->rx_running = 1;
   sys_thread_new("tapif_thread", tapif_thread, netif, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO);
 #endif /* !NO_SYS */
 }
+
+/* Give the pbufs preallocated for received frames back to the pool */
+static void
+tapif_free_rx_stash(struct tapif *tapif)
+{
+  while (tapif->rx_count > 0) {
+    pbuf_free(tapif->rx[--tapif->rx_count]);
+  }
+}
 /*-----------------------------------------------------------------------------------*/
 /*
  * low_level_output():
@@ -249,6 +277,48 @@ low_level_output(struct netif *netif, struct pbuf *p)
     return ERR_OK;
   }
 }
+#if LWIP_NETIF_LINKOUTPUT_SG
+/*-----------------------------------------------------------------------------------*/
+/*
+ * low_level_output_sg():
+ *
+ * Same as low_level_output(), but the frame is gathered from its pieces by
+ * writev() instead of being copied into a local buffer first.
+ *
+ */
+/*-----------------------------------------------------------------------------------*/
+
+static err_t
+low_level_output_sg(struct netif *netif, const struct netif_iovec *iov, u16_t iovcnt, struct pbuf *p)
+{
+  struct tapif *tapif = (struct tapif *)netif->state;
+  struct iovec vec[LWIP_NETIF_SG_MAX_IOV];
+  ssize_t written;
+  u16_t i;
+
+  if (p->tot_len > 1518) { /* max packet size including VLAN excluding CRC */
+    MIB2_STATS_NETIF_INC(netif, ifoutdiscards);
+    perror("tapif: packet too large");
+    return ERR_IF;
+  }
+
+  for (i = 0; i < iovcnt; i++) {
+    vec[i].iov_base = LWIP_CONST_CAST(void *, iov[i].base);
+    vec[i].iov_len = iov[i].len;
+  }
+
+  /* signal that packet should be sent(); */
+  written = writev(tapif->fd, vec, iovcnt);
+  if (written < p->tot_len) {
+    MIB2_STATS_NETIF_INC(netif, ifoutdiscards);
+    perror("tapif: writev");
+    return ERR_IF;
+  } else {
+    MIB2_STATS_NETIF_ADD(netif, ifoutoctets, (u32_t)written);
+    return ERR_OK;
+  }
+}
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
 /*-----------------------------------------------------------------------------------*/
 /*
  * low_level_input():
@@ -285,8 +355,17 @@ low_level_input(struct netif *netif)
   }
 #endif
 
-  /* We allocate a pbuf chain of pbufs from the pool. */
-  p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+  /* Frames that fit into one pool buffer take a preallocated pbuf (the
+     stash is refilled in bulk), bigger ones get a pbuf chain from the pool. */
+  if (tapif->rx_count == 0) {
+    tapif->rx_count = pbuf_alloc_bulk(PBUF_RAW, PBUF_POOL_BUFSIZE, PBUF_POOL, tapif->rx, TAPIF_RX_BATCH);
+  }
+  if ((len <= PBUF_POOL_BUFSIZE) && (tapif->rx_count > 0)) {
+    p = tapif->rx[--tapif->rx_count];
+    pbuf_realloc(p, len);
+  } else {
+    p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+  }
   if (p != NULL) {
     pbuf_take(p, buf, len);
     /* acknowledge that packet has been read(); */
@@ -347,6 +426,7 @@ tapif_init(struct netif *netif)
     LWIP_DEBUGF(NETIF_DEBUG, ("tapif_init: out of memory for tapif\n"));
     return ERR_MEM;
   }
+  tapif->rx_count = 0;
   netif->state = tapif;
   MIB2_INIT_NETIF(netif, snmp_ifType_other, 100000000);
 
@@ -359,6 +439,9 @@ tapif_init(struct netif *netif)
   netif->output_ip6 = ethip6_output;
 #endif /* LWIP_IPV6 */
   netif->linkoutput = low_level_output;
+#if LWIP_NETIF_LINKOUTPUT_SG
+  netif->linkoutput_sg = low_level_output_sg;
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
   netif->mtu = 1500;
 
   low_level_init(netif);
@@ -374,6 +457,35 @@ tapif_poll(struct netif *netif)
   tapif_input(netif);
 }
 
+/*-----------------------------------------------------------------------------------*/
+/*
+ * tapif_shutdown():
+ *
+ * Close the tap device (no more packets can be sent or received) and free
+ * the pbufs preallocated for received frames. Call after netif_remove().
+ *
+ */
+/*-----------------------------------------------------------------------------------*/
+void
+tapif_shutdown(struct netif *netif)
+{
+  struct tapif *tapif = (struct tapif *)netif->state;
+
+  if (tapif != NULL) {
+#if !NO_SYS
+    /* wait for tapif_thread to end, it owns the RX stash until then */
+    tapif->rx_run = 0;
+    while (tapif->rx_running) {
+      sys_msleep(TAPIF_RX_STOP_POLL_MS);
+    }
+#endif /* !NO_SYS */
+    tapif_free_rx_stash(tapif);
+    close(tapif->fd);
+    netif->state = NULL;
+    mem_free(tapif);
+  }
+}
+
 #if NO_SYS
 
 int
@@ -413,12 +525,16 @@ tapif_thread(void *arg)
   netif = (struct netif *)arg;
   tapif = (struct tapif *)netif->state;
 
-  while(1) {
+  while(tapif->rx_run) {
+    struct timeval tv;
+
     FD_ZERO(&fdset);
     FD_SET(tapif->fd, &fdset);
+    tv.tv_sec = TAPIF_RX_STOP_POLL_MS / 1000;
+    tv.tv_usec = (TAPIF_RX_STOP_POLL_MS % 1000) * 1000;
 
     /* Wait for a packet to arrive. */
-    ret = select(tapif->fd + 1, &fdset, NULL, NULL, NULL);
+    ret = select(tapif->fd + 1, &fdset, NULL, NULL, &tv);
 
     if(ret == 1) {
       /* Handle incoming packet. */
@@ -427,6 +543,7 @@ tapif_thread(void *arg)
       perror("tapif_thread: select");
     }
   }
+  tapif->rx_running = 0;
 }
 
 #endif /* NO_SYS */
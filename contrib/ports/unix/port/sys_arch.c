@@ -67,6 +67,36 @@
 #include "lwip/opt.h"
 #include "lwip/stats.h"
 #include "lwip/tcpip.h"
+#include "lwip/memp.h"
+
+/* SYS_CORE_LOCK_RW==1: make the core lock a reader-writer lock, so that
+   LOCK_TCPIP_CORE_SHARED() callers (getsockopt() etc.) run concurrently */
+#ifndef SYS_CORE_LOCK_RW
+#define SYS_CORE_LOCK_RW 0
+#endif
+
+#if SYS_CORE_LOCK_PROFILE
+#include <stdio.h>
+#include <execinfo.h>
+#ifndef SYS_CORE_LOCK_PROFILE_SITES
+#define SYS_CORE_LOCK_PROFILE_SITES 256
+#endif
+#endif /* SYS_CORE_LOCK_PROFILE */
+
+/* SYS_MBOX_LOCKFREE==1: use lock-free rings for the mailboxes, threads only
+   sleep (on a futex) when a mailbox is empty or full */
+#ifndef SYS_MBOX_LOCKFREE
+#define SYS_MBOX_LOCKFREE 0
+#endif
+
+#if SYS_MBOX_LOCKFREE
+#ifndef LWIP_UNIX_LINUX
+#error "SYS_MBOX_LOCKFREE needs futexes (Linux)"
+#endif
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#endif /* SYS_MBOX_LOCKFREE */
 
 u32_t
 lwip_port_rand(void)
@@ -110,6 +140,35 @@ struct sys_mbox_msg {
 
 #define SYS_MBOX_SIZE 128
 
+#if SYS_MBOX_LOCKFREE
+/* Bounded MPMC ring (after D. Vyukov): every cell carries a sequence number
+   that tells whether it can be written (== position) or read (== position + 1)
+   in the current lap of the ring. */
+struct sys_mbox_cell {
+  u32_t seq;
+  void *msg;
+};
+
+#define SYS_MBOX_CACHE_LINE 64
+/* Number of retries before a thread goes to sleep on an empty or full ring */
+#define SYS_MBOX_SPIN 200
+
+struct sys_mbox {
+  /* next position to read and to write, on their own cache lines */
+  u32_t head;
+  u8_t pad_head[SYS_MBOX_CACHE_LINE - sizeof(u32_t)];
+  u32_t tail;
+  u8_t pad_tail[SYS_MBOX_CACHE_LINE - sizeof(u32_t)];
+  /* futex words, changed to wake up sleepers, and the number of sleepers */
+  u32_t not_empty;
+  u32_t fetch_waiting;
+  u8_t pad_fetch[SYS_MBOX_CACHE_LINE - 2 * sizeof(u32_t)];
+  u32_t not_full;
+  u32_t post_waiting;
+  u8_t pad_post[SYS_MBOX_CACHE_LINE - 2 * sizeof(u32_t)];
+  struct sys_mbox_cell cells[SYS_MBOX_SIZE];
+};
+#else /* SYS_MBOX_LOCKFREE */
 struct sys_mbox {
   int first, last;
   void *msgs[SYS_MBOX_SIZE];
@@ -118,6 +177,7 @@ struct sys_mbox {
   struct sys_sem *mutex;
   int wait_send;
 };
+#endif /* SYS_MBOX_LOCKFREE */
 
 struct sys_sem {
   unsigned int c;
@@ -216,16 +276,226 @@ sys_thread_new(const char *name, lwip_thread_fn function, void *arg, int stacksi
 
 #if LWIP_TCPIP_CORE_LOCKING
 static pthread_t lwip_core_lock_holder_thread_id;
-void sys_lock_tcpip_core(void)
+#if SYS_CORE_LOCK_RW
+/* Core lock: LOCK_TCPIP_CORE() takes it exclusively,
+   LOCK_TCPIP_CORE_SHARED() takes the read side */
+static pthread_rwlock_t lwip_core_rwlock;
+/* Number of shared core locks held by this thread */
+static __thread int lwip_core_lock_shared_depth;
+#endif /* SYS_CORE_LOCK_RW */
+
+#if SYS_CORE_LOCK_PROFILE
+/* Hold and wait times of the core lock per call site */
+struct sys_core_lock_site {
+  void *site;
+  u32_t count;
+  u32_t shared;
+  u64_t wait_ns;
+  u64_t hold_ns;
+  u64_t hold_max_ns;
+};
+
+static struct sys_core_lock_site lwip_core_lock_sites[SYS_CORE_LOCK_PROFILE_SITES];
+/* Site and start of the core lock held by this thread */
+static __thread struct sys_core_lock_site *lwip_core_lock_cur_site;
+static __thread u64_t lwip_core_lock_since;
+
+static u64_t
+sys_core_lock_now(void)
+{
+  struct timespec ts;
+
+  get_monotonic_time(&ts);
+  return (u64_t)ts.tv_sec * 1000000000UL + (u64_t)ts.tv_nsec;
+}
+
+/* Find or insert the entry of a call site, NULL if the table is full */
+static struct sys_core_lock_site *
+sys_core_lock_site_get(void *site)
+{
+  u32_t hash = (u32_t)(((mem_ptr_t)site >> 2) * 2654435761UL);
+  u32_t i;
+
+  for (i = 0; i < SYS_CORE_LOCK_PROFILE_SITES; i++) {
+    struct sys_core_lock_site *entry = &lwip_core_lock_sites[(hash + i) % SYS_CORE_LOCK_PROFILE_SITES];
+    void *cur = __atomic_load_n(&entry->site, __ATOMIC_ACQUIRE);
+
+    if (cur == NULL) {
+      if (__atomic_compare_exchange_n(&entry->site, &cur, site, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return entry;
+      }
+    }
+    if (cur == site) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static void
+sys_core_lock_acquired(void *site, u64_t start, int shared)
+{
+  struct sys_core_lock_site *entry = sys_core_lock_site_get(site);
+  u64_t now = sys_core_lock_now();
+
+  if (entry != NULL) {
+    __atomic_fetch_add(&entry->count, 1, __ATOMIC_RELAXED);
+    if (shared) {
+      __atomic_fetch_add(&entry->shared, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&entry->wait_ns, now - start, __ATOMIC_RELAXED);
+  }
+  lwip_core_lock_cur_site = entry;
+  lwip_core_lock_since = now;
+}
+
+static void
+sys_core_lock_released(void)
+{
+  struct sys_core_lock_site *entry = lwip_core_lock_cur_site;
+
+  if (entry != NULL) {
+    u64_t hold = sys_core_lock_now() - lwip_core_lock_since;
+    u64_t max = __atomic_load_n(&entry->hold_max_ns, __ATOMIC_RELAXED);
+
+    __atomic_fetch_add(&entry->hold_ns, hold, __ATOMIC_RELAXED);
+    while ((hold > max) &&
+           !__atomic_compare_exchange_n(&entry->hold_max_ns, &max, hold, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    lwip_core_lock_cur_site = NULL;
+  }
+}
+
+static int
+sys_core_lock_site_cmp(const void *a, const void *b)
+{
+  u64_t hold_a = ((const struct sys_core_lock_site *)a)->hold_ns;
+  u64_t hold_b = ((const struct sys_core_lock_site *)b)->hold_ns;
+
+  return (hold_a < hold_b) ? 1 : ((hold_a > hold_b) ? -1 : 0);
+}
+
+/** Print the core lock call sites sorted by total hold time. Sites are
+ * return addresses of the LOCK_TCPIP_CORE() callers; link with -rdynamic
+ * (or use addr2line) to resolve them. */
+void
+sys_core_lock_profile_dump(void)
+{
+  struct sys_core_lock_site *sites;
+  int i, num = 0;
+
+  sites = (struct sys_core_lock_site *)malloc(sizeof(lwip_core_lock_sites));
+  if (sites == NULL) {
+    return;
+  }
+  for (i = 0; i < SYS_CORE_LOCK_PROFILE_SITES; i++) {
+    if (__atomic_load_n(&lwip_core_lock_sites[i].site, __ATOMIC_ACQUIRE) != NULL) {
+      sites[num++] = lwip_core_lock_sites[i];
+    }
+  }
+  qsort(sites, (size_t)num, sizeof(sites[0]), sys_core_lock_site_cmp);
+
+  printf("%10s %10s %12s %12s %12s %14s  site\n",
+         "count", "shared", "wait_avg_ns", "hold_avg_ns", "hold_max_ns", "hold_total_us");
+  for (i = 0; i < num; i++) {
+    char **sym = backtrace_symbols(&sites[i].site, 1);
+    u32_t count = LWIP_MAX(sites[i].count, 1);
+
+    printf("%10"U32_F" %10"U32_F" %12lu %12lu %12lu %14lu  %s\n",
+           sites[i].count, sites[i].shared,
+           (unsigned long)(sites[i].wait_ns / count), (unsigned long)(sites[i].hold_ns / count),
+           (unsigned long)sites[i].hold_max_ns, (unsigned long)(sites[i].hold_ns / 1000),
+           (sym != NULL) ? sym[0] : "?");
+    free(sym);
+  }
+  free(sites);
+}
+
+/** Clear the counters of all call sites (call while the stack is idle) */
+void
+sys_core_lock_profile_reset(void)
 {
+  int i;
+
+  for (i = 0; i < SYS_CORE_LOCK_PROFILE_SITES; i++) {
+    struct sys_core_lock_site *entry = &lwip_core_lock_sites[i];
+
+    __atomic_store_n(&entry->count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->shared, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->wait_ns, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->hold_ns, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->hold_max_ns, 0, __ATOMIC_RELAXED);
+  }
+}
+#endif /* SYS_CORE_LOCK_PROFILE */
+
+static void
+sys_core_lock_take(void *site, int shared)
+{
+#if SYS_CORE_LOCK_PROFILE
+  u64_t start = sys_core_lock_now();
+#else
+  LWIP_UNUSED_ARG(site);
+#endif
+
+#if SYS_CORE_LOCK_RW
+  if (shared) {
+    pthread_rwlock_rdlock(&lwip_core_rwlock);
+    lwip_core_lock_shared_depth++;
+  } else {
+    pthread_rwlock_wrlock(&lwip_core_rwlock);
+    lwip_core_lock_holder_thread_id = pthread_self();
+  }
+#else /* SYS_CORE_LOCK_RW */
+  LWIP_UNUSED_ARG(shared);
   sys_mutex_lock(&lock_tcpip_core);
   lwip_core_lock_holder_thread_id = pthread_self();
+#endif /* SYS_CORE_LOCK_RW */
+
+#if SYS_CORE_LOCK_PROFILE
+  sys_core_lock_acquired(site, start, shared);
+#endif
 }
 
-void sys_unlock_tcpip_core(void)
+static void
+sys_core_lock_give(int shared)
 {
+#if SYS_CORE_LOCK_PROFILE
+  sys_core_lock_released();
+#endif
+
+#if SYS_CORE_LOCK_RW
+  if (shared) {
+    lwip_core_lock_shared_depth--;
+  } else {
+    lwip_core_lock_holder_thread_id = 0;
+  }
+  pthread_rwlock_unlock(&lwip_core_rwlock);
+#else /* SYS_CORE_LOCK_RW */
+  LWIP_UNUSED_ARG(shared);
   lwip_core_lock_holder_thread_id = 0;
   sys_mutex_unlock(&lock_tcpip_core);
+#endif /* SYS_CORE_LOCK_RW */
+}
+
+void sys_lock_tcpip_core(void)
+{
+  sys_core_lock_take(__builtin_return_address(0), 0);
+}
+
+void sys_unlock_tcpip_core(void)
+{
+  sys_core_lock_give(0);
+}
+
+void sys_lock_tcpip_core_shared(void)
+{
+  sys_core_lock_take(__builtin_return_address(0), 1);
+}
+
+void sys_unlock_tcpip_core_shared(void)
+{
+  sys_core_lock_give(1);
 }
 #endif /* LWIP_TCPIP_CORE_LOCKING */
 
@@ -243,7 +513,12 @@ void sys_check_core_locking(void)
     pthread_t current_thread_id = pthread_self();
 
 #if LWIP_TCPIP_CORE_LOCKING
+#if SYS_CORE_LOCK_RW
+    LWIP_ASSERT("Function called without core lock",
+                (current_thread_id == lwip_core_lock_holder_thread_id) || (lwip_core_lock_shared_depth > 0));
+#else /* SYS_CORE_LOCK_RW */
     LWIP_ASSERT("Function called without core lock", current_thread_id == lwip_core_lock_holder_thread_id);
+#endif /* SYS_CORE_LOCK_RW */
 #else /* LWIP_TCPIP_CORE_LOCKING */
     LWIP_ASSERT("Function called from wrong thread", current_thread_id == lwip_tcpip_thread_id);
 #endif /* LWIP_TCPIP_CORE_LOCKING */
@@ -252,6 +527,213 @@ void sys_check_core_locking(void)
 
 /*-----------------------------------------------------------------------------------*/
 /* Mailbox */
+#if SYS_MBOX_LOCKFREE
+/* Put a message into the ring, returns 0 if it is full */
+static int
+sys_mbox_ring_put(struct sys_mbox *mbox, void *msg)
+{
+  u32_t pos = __atomic_load_n(&mbox->tail, __ATOMIC_RELAXED);
+
+  for (;;) {
+    struct sys_mbox_cell *cell = &mbox->cells[pos % SYS_MBOX_SIZE];
+    s32_t diff = (s32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+    if (diff == 0) {
+      /* a failed exchange updates pos */
+      if (__atomic_compare_exchange_n(&mbox->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        cell->msg = msg;
+        __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+        return 1;
+      }
+    } else if (diff < 0) {
+      /* the cell has not been read in the previous lap */
+      return 0;
+    } else {
+      pos = __atomic_load_n(&mbox->tail, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+/* Take a message from the ring, returns 0 if it is empty */
+static int
+sys_mbox_ring_get(struct sys_mbox *mbox, void **msg)
+{
+  u32_t pos = __atomic_load_n(&mbox->head, __ATOMIC_RELAXED);
+
+  for (;;) {
+    struct sys_mbox_cell *cell = &mbox->cells[pos % SYS_MBOX_SIZE];
+    s32_t diff = (s32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&mbox->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        void *m = cell->msg;
+        __atomic_store_n(&cell->seq, pos + SYS_MBOX_SIZE, __ATOMIC_RELEASE);
+        if (msg != NULL) {
+          *msg = m;
+        }
+        return 1;
+      }
+    } else if (diff < 0) {
+      /* the cell has not been written in this lap */
+      return 0;
+    } else {
+      pos = __atomic_load_n(&mbox->head, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+/* Wake up one thread sleeping in sys_mbox_sleep() on 'word', if any. The
+   fence orders the preceding ring update before reading the sleeper count. */
+static void
+sys_mbox_wake(u32_t *word, u32_t *waiting)
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(waiting, __ATOMIC_RELAXED) != 0) {
+    __atomic_add_fetch(word, 1, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+  }
+}
+
+/* Retry getting (fetch != 0) or putting *msg for a while, then register as
+   sleeper and retry once more. If that fails, sleep until woken up by
+   sys_mbox_wake() or until 'timeout' ms (0: forever) have passed. Returns 1 if the retry succeeded. */
+static int
+sys_mbox_sleep(struct sys_mbox *mbox, int fetch, void **msg, u32_t timeout)
+{
+  u32_t *word = fetch ? &mbox->not_empty : &mbox->not_full;
+  u32_t *waiting = fetch ? &mbox->fetch_waiting : &mbox->post_waiting;
+  struct timespec ts;
+  u32_t val;
+  int ret, i;
+
+  for (i = 0; i < SYS_MBOX_SPIN; i++) {
+    if (fetch ? sys_mbox_ring_get(mbox, msg) : sys_mbox_ring_put(mbox, *msg)) {
+      return 1;
+    }
+    sched_yield();
+  }
+  __atomic_add_fetch(waiting, 1, __ATOMIC_SEQ_CST);
+  val = __atomic_load_n(word, __ATOMIC_SEQ_CST);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  ret = fetch ? sys_mbox_ring_get(mbox, msg) : sys_mbox_ring_put(mbox, *msg);
+  if (!ret) {
+    ts.tv_sec = timeout / 1000L;
+    ts.tv_nsec = (timeout % 1000L) * 1000000L;
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, val, (timeout != 0) ? &ts : NULL, NULL, 0);
+  }
+  __atomic_sub_fetch(waiting, 1, __ATOMIC_SEQ_CST);
+  return ret;
+}
+
+err_t
+sys_mbox_new(struct sys_mbox **mb, int size)
+{
+  struct sys_mbox *mbox;
+  u32_t i;
+  LWIP_UNUSED_ARG(size);
+
+  mbox = (struct sys_mbox *)malloc(sizeof(struct sys_mbox));
+  if (mbox == NULL) {
+    return ERR_MEM;
+  }
+  memset(mbox, 0, sizeof(struct sys_mbox));
+  for (i = 0; i < SYS_MBOX_SIZE; i++) {
+    mbox->cells[i].seq = i;
+  }
+
+  SYS_STATS_INC_USED(mbox);
+  *mb = mbox;
+  return ERR_OK;
+}
+
+void
+sys_mbox_free(struct sys_mbox **mb)
+{
+  if ((mb != NULL) && (*mb != SYS_MBOX_NULL)) {
+    SYS_STATS_DEC(mbox.used);
+    free(*mb);
+  }
+}
+
+err_t
+sys_mbox_trypost(struct sys_mbox **mb, void *msg)
+{
+  struct sys_mbox *mbox;
+  LWIP_ASSERT("invalid mbox", (mb != NULL) && (*mb != NULL));
+  mbox = *mb;
+
+  LWIP_DEBUGF(SYS_DEBUG, ("sys_mbox_trypost: mbox %p msg %p\n",
+                          (void *)mbox, (void *)msg));
+  if (!sys_mbox_ring_put(mbox, msg)) {
+    return ERR_MEM;
+  }
+  sys_mbox_wake(&mbox->not_empty, &mbox->fetch_waiting);
+  return ERR_OK;
+}
+
+err_t
+sys_mbox_trypost_fromisr(sys_mbox_t *q, void *msg)
+{
+  return sys_mbox_trypost(q, msg);
+}
+
+void
+sys_mbox_post(struct sys_mbox **mb, void *msg)
+{
+  struct sys_mbox *mbox;
+  LWIP_ASSERT("invalid mbox", (mb != NULL) && (*mb != NULL));
+  mbox = *mb;
+
+  LWIP_DEBUGF(SYS_DEBUG, ("sys_mbox_post: mbox %p msg %p\n", (void *)mbox, (void *)msg));
+  while (!sys_mbox_ring_put(mbox, msg)) {
+    if (sys_mbox_sleep(mbox, 0, &msg, 0)) {
+      break;
+    }
+  }
+  sys_mbox_wake(&mbox->not_empty, &mbox->fetch_waiting);
+}
+
+u32_t
+sys_arch_mbox_tryfetch(struct sys_mbox **mb, void **msg)
+{
+  struct sys_mbox *mbox;
+  LWIP_ASSERT("invalid mbox", (mb != NULL) && (*mb != NULL));
+  mbox = *mb;
+
+  if (!sys_mbox_ring_get(mbox, msg)) {
+    return SYS_MBOX_EMPTY;
+  }
+  sys_mbox_wake(&mbox->not_full, &mbox->post_waiting);
+  return 0;
+}
+
+u32_t
+sys_arch_mbox_fetch(struct sys_mbox **mb, void **msg, u32_t timeout)
+{
+  struct timespec start, now;
+  u32_t waited = 0;
+  struct sys_mbox *mbox;
+  LWIP_ASSERT("invalid mbox", (mb != NULL) && (*mb != NULL));
+  mbox = *mb;
+
+  if (timeout != 0) {
+    get_monotonic_time(&start);
+  }
+  while (!sys_mbox_ring_get(mbox, msg)) {
+    if (timeout != 0) {
+      get_monotonic_time(&now);
+      waited = (u32_t)((now.tv_sec - start.tv_sec) * 1000L + (now.tv_nsec - start.tv_nsec) / 1000000L);
+      if (waited >= timeout) {
+        return SYS_ARCH_TIMEOUT;
+      }
+    }
+    if (sys_mbox_sleep(mbox, 1, msg, (timeout != 0) ? (timeout - waited) : 0)) {
+      break;
+    }
+  }
+  sys_mbox_wake(&mbox->not_full, &mbox->post_waiting);
+  return waited;
+}
+
+#else /* SYS_MBOX_LOCKFREE */
 err_t
 sys_mbox_new(struct sys_mbox **mb, int size)
 {
@@ -451,6 +933,7 @@ sys_arch_mbox_fetch(struct sys_mbox **mb, void **msg, u32_t timeout)
 
   return time_needed;
 }
+#endif /* SYS_MBOX_LOCKFREE */
 
 /*-----------------------------------------------------------------------------------*/
 /* Semaphore */
@@ -640,6 +1123,43 @@ sys_mutex_free(struct sys_mutex **mutex)
   free(*mutex);
 }
 
+#if MEMP_CACHE
+/*-----------------------------------------------------------------------------------*/
+/* Per-thread memp caches, returned to the pools when the thread exits */
+static pthread_key_t memp_cache_key;
+static pthread_once_t memp_cache_key_once = PTHREAD_ONCE_INIT;
+
+static void
+memp_cache_destroy(void *arg)
+{
+  memp_cache_flush((struct memp_cache *)arg);
+  free(arg);
+}
+
+static void
+memp_cache_key_create(void)
+{
+  pthread_key_create(&memp_cache_key, memp_cache_destroy);
+}
+
+struct memp_cache *
+sys_arch_memp_cache_get(void)
+{
+  struct memp_cache *cache;
+
+  pthread_once(&memp_cache_key_once, memp_cache_key_create);
+  cache = (struct memp_cache *)pthread_getspecific(memp_cache_key);
+  if (cache == NULL) {
+    cache = (struct memp_cache *)malloc(sizeof(struct memp_cache));
+    if (cache != NULL) {
+      memp_cache_init(cache);
+      pthread_setspecific(memp_cache_key, cache);
+    }
+  }
+  return cache;
+}
+#endif /* MEMP_CACHE */
+
 #endif /* !NO_SYS */
 
 /*-----------------------------------------------------------------------------------*/
@@ -668,6 +1188,18 @@ sys_jiffies(void)
 void
 sys_init(void)
 {
+#if LWIP_TCPIP_CORE_LOCKING && SYS_CORE_LOCK_RW
+  pthread_rwlockattr_t attr;
+
+  pthread_rwlockattr_init(&attr);
+#ifdef LWIP_UNIX_LINUX
+  /* tcpip_thread takes the lock exclusively for every message and timer:
+     don't let a steady stream of readers starve it */
+  pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif /* LWIP_UNIX_LINUX */
+  pthread_rwlock_init(&lwip_core_rwlock, &attr);
+  pthread_rwlockattr_destroy(&attr);
+#endif /* LWIP_TCPIP_CORE_LOCKING && SYS_CORE_LOCK_RW */
 }
 
 /*-----------------------------------------------------------------------------------*/
@@ -379,6 +379,10 @@ Call these functions in the order of appearance:
  * the functions sys_lock_tcpip_core() and sys_unlock_tcpip_core().
  * Let @ref LOCK_TCPIP_CORE() and @ref UNLOCK_TCPIP_CORE() point
  * to these functions.
+ * Read-only API calls (getsockopt(), netconn_getaddr(), netif name/index
+ * lookups) use @ref LOCK_TCPIP_CORE_SHARED() instead; if your OS has
+ * reader-writer locks, sys_lock_tcpip_core_shared() of the unix port
+ * (SYS_CORE_LOCK_RW) shows how to let these run concurrently.
  */
 
 /**
@@ -104,6 +104,8 @@
 #endif /* LWIP_NETCONN_FULLDUPLEX */
 
 static err_t netconn_close_shutdown(struct netconn *conn, u8_t how);
+static err_t netconn_write_vectors_ref(struct netconn *conn, struct netvector *vectors, u16_t vectorcnt,
+                                       u8_t apiflags, size_t *bytes_written, struct pbuf *ref);
 
 /**
  * Call the lower part of a netconn_* function
@@ -278,14 +280,22 @@ netconn_getaddr(struct netconn *conn, ip_addr_t *addr, u16_t *port, u8_t local)
   API_MSG_VAR_ALLOC(msg);
   API_MSG_VAR_REF(msg).conn = conn;
   API_MSG_VAR_REF(msg).msg.ad.local = local;
-#if LWIP_MPU_COMPATIBLE
+#if !LWIP_MPU_COMPATIBLE
+  msg.msg.ad.ipaddr = addr;
+  msg.msg.ad.port = port;
+#endif /* !LWIP_MPU_COMPATIBLE */
+#if LWIP_TCPIP_CORE_LOCKING
+  /* getaddr only reads the pcb: call it directly under the shared lock */
+  LOCK_TCPIP_CORE_SHARED();
+  lwip_netconn_do_getaddr(&API_MSG_VAR_REF(msg));
+  UNLOCK_TCPIP_CORE_SHARED();
+  err = API_MSG_VAR_REF(msg).err;
+#else /* LWIP_TCPIP_CORE_LOCKING */
   err = netconn_apimsg(lwip_netconn_do_getaddr, &API_MSG_VAR_REF(msg));
+#endif /* LWIP_TCPIP_CORE_LOCKING */
+#if LWIP_MPU_COMPATIBLE
   *addr = msg->msg.ad.ipaddr;
   *port = msg->msg.ad.port;
-#else /* LWIP_MPU_COMPATIBLE */
-  msg.msg.ad.ipaddr = addr;
-  msg.msg.ad.port = port;
-  err = netconn_apimsg(lwip_netconn_do_getaddr, &msg);
 #endif /* LWIP_MPU_COMPATIBLE */
   API_MSG_VAR_FREE(msg);
 
@@ -679,15 +689,27 @@ netconn_tcp_recvd_msg(struct netconn *conn, size_t len, struct api_msg *msg)
   LWIP_ERROR("netconn_recv_tcp_pbuf: invalid conn", (conn != NULL) &&
              NETCONNTYPE_GROUP(netconn_type(conn)) == NETCONN_TCP, return ERR_ARG;);
 
+#if LWIP_NETCONN_FASTPATH
+  /* msg is NULL here, the callers don't allocate it */
+  LWIP_UNUSED_ARG(msg);
+  LOCK_TCPIP_CORE();
+  lwip_netconn_tcp_recved(conn, len);
+  UNLOCK_TCPIP_CORE();
+  return ERR_OK;
+#else /* LWIP_NETCONN_FASTPATH */
   msg->conn = conn;
   msg->msg.r.len = len;
 
   return netconn_apimsg(lwip_netconn_do_recv, msg);
+#endif /* LWIP_NETCONN_FASTPATH */
 }
 
 err_t
 netconn_tcp_recvd(struct netconn *conn, size_t len)
 {
+#if LWIP_NETCONN_FASTPATH
+  return netconn_tcp_recvd_msg(conn, len, NULL);
+#else /* LWIP_NETCONN_FASTPATH */
   err_t err;
   API_MSG_VAR_DECLARE(msg);
   LWIP_ERROR("netconn_recv_tcp_pbuf: invalid conn", (conn != NULL) &&
@@ -697,6 +719,7 @@ netconn_tcp_recvd(struct netconn *conn, size_t len)
   err = netconn_tcp_recvd_msg(conn, len, &API_VAR_REF(msg));
   API_MSG_VAR_FREE(msg);
   return err;
+#endif /* LWIP_NETCONN_FASTPATH */
 }
 
 static err_t
@@ -704,10 +727,12 @@ netconn_recv_data_tcp(struct netconn *conn, struct pbuf **new_buf, u8_t apiflags
 {
   err_t err;
   struct pbuf *buf;
+#if !LWIP_NETCONN_FASTPATH
   API_MSG_VAR_DECLARE(msg);
 #if LWIP_MPU_COMPATIBLE
   msg = NULL;
 #endif
+#endif /* !LWIP_NETCONN_FASTPATH */
 
   if (!NETCONN_RECVMBOX_WAITABLE(conn)) {
     /* This only happens when calling this function more than once *after* receiving FIN */
@@ -718,17 +743,21 @@ netconn_recv_data_tcp(struct netconn *conn, struct pbuf **new_buf, u8_t apiflags
     goto handle_fin;
   }
 
+#if !LWIP_NETCONN_FASTPATH
   if (!(apiflags & NETCONN_NOAUTORCVD)) {
     /* need to allocate API message here so empty message pool does not result in event loss
       * see bug #47512: MPU_COMPATIBLE may fail on empty pool */
     API_MSG_VAR_ALLOC(msg);
   }
+#endif /* !LWIP_NETCONN_FASTPATH */
 
   err = netconn_recv_data(conn, (void **)new_buf, apiflags);
   if (err != ERR_OK) {
+#if !LWIP_NETCONN_FASTPATH
     if (!(apiflags & NETCONN_NOAUTORCVD)) {
       API_MSG_VAR_FREE(msg);
     }
+#endif /* !LWIP_NETCONN_FASTPATH */
     return err;
   }
   buf = *new_buf;
@@ -737,8 +766,12 @@ netconn_recv_data_tcp(struct netconn *conn, struct pbuf **new_buf, u8_t apiflags
     u16_t len = buf ? buf->tot_len : 1;
     /* don't care for the return value of lwip_netconn_do_recv */
     /* @todo: this should really be fixed, e.g. by retrying in poll on error */
+#if LWIP_NETCONN_FASTPATH
+    netconn_tcp_recvd_msg(conn, len, NULL);
+#else /* LWIP_NETCONN_FASTPATH */
     netconn_tcp_recvd_msg(conn, len,  &API_VAR_REF(msg));
     API_MSG_VAR_FREE(msg);
+#endif /* LWIP_NETCONN_FASTPATH */
   }
 
   /* If we are closed, we indicate that we no longer wish to use the socket */
@@ -940,13 +973,22 @@ netconn_sendto(struct netconn *conn, struct netbuf *buf, const ip_addr_t *addr,
 err_t
 netconn_send(struct netconn *conn, struct netbuf *buf)
 {
+#if !LWIP_NETCONN_FASTPATH
   API_MSG_VAR_DECLARE(msg);
+#endif /* !LWIP_NETCONN_FASTPATH */
   err_t err;
 
   LWIP_ERROR("netconn_send: invalid conn",  (conn != NULL), return ERR_ARG;);
 
   LWIP_DEBUGF(API_LIB_DEBUG, ("netconn_send: sending %"U16_F" bytes\n", buf->p->tot_len));
 
+#if LWIP_NETCONN_FASTPATH
+  /* sending never blocks: call into the core directly */
+  LOCK_TCPIP_CORE();
+  err = lwip_netconn_send_netbuf(conn, buf);
+  UNLOCK_TCPIP_CORE();
+  return err;
+#else /* LWIP_NETCONN_FASTPATH */
   API_MSG_VAR_ALLOC(msg);
   API_MSG_VAR_REF(msg).conn = conn;
   API_MSG_VAR_REF(msg).msg.b = buf;
@@ -954,6 +996,7 @@ netconn_send(struct netconn *conn, struct netbuf *buf)
   API_MSG_VAR_FREE(msg);
 
   return err;
+#endif /* LWIP_NETCONN_FASTPATH */
 }
 
 /**
@@ -996,6 +1039,43 @@ netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
 err_t
 netconn_write_vectors_partly(struct netconn *conn, struct netvector *vectors, u16_t vectorcnt,
                              u8_t apiflags, size_t *bytes_written)
+{
+  return netconn_write_vectors_ref(conn, vectors, vectorcnt, apiflags, bytes_written, NULL);
+}
+
+#if LWIP_TCP_ZEROCOPY
+/**
+ * @ingroup netconn_tcp
+ * Send data over a TCP netconn without copying it, see tcp_write_ref().
+ * The stack keeps a reference on 'ref' for as long as it uses the data: make
+ * it a custom pbuf and free your own reference after this call to be notified
+ * (by its custom_free_function) when the data may be reused.
+ *
+ * @param conn the TCP netconn over which to send data
+ * @param dataptr pointer to the application buffer that contains the data to send
+ * @param size size of the application data to send
+ * @param apiflags NETCONN_MORE and/or NETCONN_DONTBLOCK (NETCONN_COPY is ignored)
+ * @param ref pbuf to keep referenced while the data is in use
+ * @param bytes_written pointer to a location that receives the number of written bytes
+ * @return ERR_OK if data was sent, any other err_t on error
+ */
+err_t
+netconn_write_ref(struct netconn *conn, const void *dataptr, size_t size,
+                  u8_t apiflags, struct pbuf *ref, size_t *bytes_written)
+{
+  struct netvector vector;
+  LWIP_ERROR("netconn_write_ref: invalid ref", (ref != NULL), return ERR_ARG;);
+  vector.ptr = dataptr;
+  vector.len = size;
+  return netconn_write_vectors_ref(conn, &vector, 1, (u8_t)(apiflags & ~NETCONN_COPY), bytes_written, ref);
+}
+#endif /* LWIP_TCP_ZEROCOPY */
+
+/** Implementation of netconn_write_vectors_partly() and netconn_write_ref():
+ * the data is passed to tcp_write_ref() if 'ref' is not NULL */
+static err_t
+netconn_write_vectors_ref(struct netconn *conn, struct netvector *vectors, u16_t vectorcnt,
+                          u8_t apiflags, size_t *bytes_written, struct pbuf *ref)
 {
   API_MSG_VAR_DECLARE(msg);
   err_t err;
@@ -1039,6 +1119,21 @@ netconn_write_vectors_partly(struct netconn *conn, struct netvector *vectors, u1
     size = (size_t)limited;
   }
 
+#if LWIP_NETCONN_FASTPATH
+  if ((vectorcnt == 1) && (size <= 0xffff)) {
+    /* write directly if everything fits into the send buffer */
+    LOCK_TCPIP_CORE();
+    err = lwip_netconn_write_fast(conn, vectors[0].ptr, (u16_t)size, apiflags, ref);
+    UNLOCK_TCPIP_CORE();
+    if (err != ERR_INPROGRESS) {
+      if ((err == ERR_OK) && (bytes_written != NULL)) {
+        *bytes_written = size;
+      }
+      return err;
+    }
+  }
+#endif /* LWIP_NETCONN_FASTPATH */
+
   API_MSG_VAR_ALLOC(msg);
   /* non-blocking write sends as much  */
   API_MSG_VAR_REF(msg).conn = conn;
@@ -1048,6 +1143,11 @@ netconn_write_vectors_partly(struct netconn *conn, struct netvector *vectors, u1
   API_MSG_VAR_REF(msg).msg.w.apiflags = apiflags;
   API_MSG_VAR_REF(msg).msg.w.len = size;
   API_MSG_VAR_REF(msg).msg.w.offset = 0;
+#if LWIP_TCP_ZEROCOPY
+  API_MSG_VAR_REF(msg).msg.w.ref = ref;
+#else /* LWIP_TCP_ZEROCOPY */
+  LWIP_UNUSED_ARG(ref);
+#endif /* LWIP_TCP_ZEROCOPY */
 #if LWIP_SO_SNDTIMEO
   if (conn->send_timeout != 0) {
     /* get the time we started, which is later compared to
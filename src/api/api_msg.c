@@ -1526,45 +1526,46 @@ lwip_netconn_do_listen(void *m)
 #endif /* LWIP_TCP */
 
 /**
- * Send some data on a RAW or UDP pcb contained in a netconn
- * Called from netconn_send
+ * Send a netbuf on a UDP or RAW pcb contained in a netconn.
+ * Called with the core locked from lwip_netconn_do_send() and, with
+ * LWIP_NETCONN_FASTPATH, directly from netconn_send().
  *
- * @param m the api_msg pointing to the connection
+ * @param conn the netconn to send on
+ * @param buf the data and (if not any) the destination address and port
+ * @return ERR_OK if the data was sent, another err_t otherwise
  */
-void
-lwip_netconn_do_send(void *m)
+err_t
+lwip_netconn_send_netbuf(struct netconn *conn, struct netbuf *buf)
 {
-  struct api_msg *msg = (struct api_msg *)m;
-
-  err_t err = netconn_err(msg->conn);
+  err_t err = netconn_err(conn);
   if (err == ERR_OK) {
-    if (msg->conn->pcb.tcp != NULL) {
-      switch (NETCONNTYPE_GROUP(msg->conn->type)) {
+    if (conn->pcb.tcp != NULL) {
+      switch (NETCONNTYPE_GROUP(conn->type)) {
 #if LWIP_RAW
         case NETCONN_RAW:
-          if (ip_addr_isany(&msg->msg.b->addr) || IP_IS_ANY_TYPE_VAL(msg->msg.b->addr)) {
-            err = raw_send(msg->conn->pcb.raw, msg->msg.b->p);
+          if (ip_addr_isany(&buf->addr) || IP_IS_ANY_TYPE_VAL(buf->addr)) {
+            err = raw_send(conn->pcb.raw, buf->p);
           } else {
-            err = raw_sendto(msg->conn->pcb.raw, msg->msg.b->p, &msg->msg.b->addr);
+            err = raw_sendto(conn->pcb.raw, buf->p, &buf->addr);
           }
           break;
 #endif
 #if LWIP_UDP
         case NETCONN_UDP:
 #if LWIP_CHECKSUM_ON_COPY
-          if (ip_addr_isany(&msg->msg.b->addr) || IP_IS_ANY_TYPE_VAL(msg->msg.b->addr)) {
-            err = udp_send_chksum(msg->conn->pcb.udp, msg->msg.b->p,
-                                  msg->msg.b->flags & NETBUF_FLAG_CHKSUM, msg->msg.b->toport_chksum);
+          if (ip_addr_isany(&buf->addr) || IP_IS_ANY_TYPE_VAL(buf->addr)) {
+            err = udp_send_chksum(conn->pcb.udp, buf->p,
+                                  buf->flags & NETBUF_FLAG_CHKSUM, buf->toport_chksum);
           } else {
-            err = udp_sendto_chksum(msg->conn->pcb.udp, msg->msg.b->p,
-                                    &msg->msg.b->addr, msg->msg.b->port,
-                                    msg->msg.b->flags & NETBUF_FLAG_CHKSUM, msg->msg.b->toport_chksum);
+            err = udp_sendto_chksum(conn->pcb.udp, buf->p,
+                                    &buf->addr, buf->port,
+                                    buf->flags & NETBUF_FLAG_CHKSUM, buf->toport_chksum);
           }
 #else /* LWIP_CHECKSUM_ON_COPY */
-          if (ip_addr_isany_val(msg->msg.b->addr) || IP_IS_ANY_TYPE_VAL(msg->msg.b->addr)) {
-            err = udp_send(msg->conn->pcb.udp, msg->msg.b->p);
+          if (ip_addr_isany_val(buf->addr) || IP_IS_ANY_TYPE_VAL(buf->addr)) {
+            err = udp_send(conn->pcb.udp, buf->p);
           } else {
-            err = udp_sendto(msg->conn->pcb.udp, msg->msg.b->p, &msg->msg.b->addr, msg->msg.b->port);
+            err = udp_sendto(conn->pcb.udp, buf->p, &buf->addr, buf->port);
           }
 #endif /* LWIP_CHECKSUM_ON_COPY */
           break;
@@ -1577,7 +1578,21 @@ lwip_netconn_do_send(void *m)
       err = ERR_CONN;
     }
   }
-  msg->err = err;
+  return err;
+}
+
+/**
+ * Send some data on a RAW or UDP pcb contained in a netconn
+ * Called from netconn_send
+ *
+ * @param m the api_msg pointing to the connection
+ */
+void
+lwip_netconn_do_send(void *m)
+{
+  struct api_msg *msg = (struct api_msg *)m;
+
+  msg->err = lwip_netconn_send_netbuf(msg->conn, msg->msg.b);
   TCPIP_APIMSG_ACK(msg);
 }
 
@@ -1594,17 +1609,31 @@ lwip_netconn_do_recv(void *m)
   struct api_msg *msg = (struct api_msg *)m;
 
   msg->err = ERR_OK;
-  if (msg->conn->pcb.tcp != NULL) {
-    if (NETCONNTYPE_GROUP(msg->conn->type) == NETCONN_TCP) {
-      size_t remaining = msg->msg.r.len;
+  lwip_netconn_tcp_recved(msg->conn, msg->msg.r.len);
+  TCPIP_APIMSG_ACK(msg);
+}
+
+/**
+ * Open the receive window of a TCP pcb contained in a netconn by 'len' bytes.
+ * Called with the core locked from lwip_netconn_do_recv() and, with
+ * LWIP_NETCONN_FASTPATH, directly from netconn_tcp_recvd().
+ *
+ * @param conn the netconn the application has taken the data from
+ * @param len the number of bytes taken
+ */
+void
+lwip_netconn_tcp_recved(struct netconn *conn, size_t len)
+{
+  if (conn->pcb.tcp != NULL) {
+    if (NETCONNTYPE_GROUP(conn->type) == NETCONN_TCP) {
+      size_t remaining = len;
       do {
         u16_t recved = (u16_t)((remaining > 0xffff) ? 0xffff : remaining);
-        tcp_recved(msg->conn->pcb.tcp, recved);
+        tcp_recved(conn->pcb.tcp, recved);
         remaining -= recved;
       } while (remaining != 0);
     }
   }
-  TCPIP_APIMSG_ACK(msg);
 }
 
 #if TCP_LISTEN_BACKLOG
@@ -1712,7 +1741,14 @@ lwip_netconn_do_writemore(struct netconn *conn  WRITE_DELAYED_PARAM)
       } else {
         write_more = 0;
       }
-      err = tcp_write(conn->pcb.tcp, dataptr, len, apiflags);
+#if LWIP_TCP_ZEROCOPY
+      if (conn->current_msg->msg.w.ref != NULL) {
+        err = tcp_write_ref(conn->pcb.tcp, dataptr, len, apiflags, conn->current_msg->msg.w.ref);
+      } else
+#endif /* LWIP_TCP_ZEROCOPY */
+      {
+        err = tcp_write(conn->pcb.tcp, dataptr, len, apiflags);
+      }
       if (err == ERR_OK) {
         conn->current_msg->msg.w.offset += len;
         conn->current_msg->msg.w.vector_off += len;
@@ -1806,6 +1842,61 @@ err_mem:
 }
 #endif /* LWIP_TCP */
 
+#if LWIP_TCP && LWIP_NETCONN_FASTPATH
+/**
+ * Write data on a TCP pcb contained in a netconn if that can be done at once,
+ * without waiting: called with the core locked from netconn_write*() instead
+ * of lwip_netconn_do_write() (LWIP_NETCONN_FASTPATH).
+ *
+ * @param conn the netconn to write on
+ * @param dataptr the data to write
+ * @param len the number of bytes to write
+ * @param apiflags NETCONN_COPY, NETCONN_MORE and/or NETCONN_DONTBLOCK
+ * @param ref pbuf to pass to tcp_write_ref(), NULL to use tcp_write()
+ * @return ERR_OK if all data was written, ERR_RTE if it could not be sent,
+ *         ERR_INPROGRESS if the write has to go through lwip_netconn_do_write()
+ *         (e.g. not enough send buffer, another write in progress, an error
+ *         pending on the netconn)
+ */
+err_t
+lwip_netconn_write_fast(struct netconn *conn, const void *dataptr, u16_t len,
+                        u8_t apiflags, struct pbuf *ref)
+{
+  err_t err;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  /* conn->pending_err is only checked here: lwip_netconn_do_write() reports it */
+  if ((NETCONNTYPE_GROUP(conn->type) != NETCONN_TCP) || (conn->pending_err != ERR_OK) ||
+      (conn->state != NETCONN_NONE) || (conn->pcb.tcp == NULL) ||
+      (tcp_sndbuf(conn->pcb.tcp) < len)) {
+    return ERR_INPROGRESS;
+  }
+#if LWIP_TCP_ZEROCOPY
+  if (ref != NULL) {
+    err = tcp_write_ref(conn->pcb.tcp, dataptr, len, apiflags, ref);
+  } else
+#else /* LWIP_TCP_ZEROCOPY */
+  LWIP_UNUSED_ARG(ref);
+#endif /* LWIP_TCP_ZEROCOPY */
+  {
+    err = tcp_write(conn->pcb.tcp, dataptr, len, apiflags);
+  }
+  if (err != ERR_OK) {
+    /* nothing was written (e.g. ERR_MEM: too many segments queued) */
+    return ERR_INPROGRESS;
+  }
+  if ((tcp_sndbuf(conn->pcb.tcp) <= TCP_SNDLOWAT) ||
+      (tcp_sndqueuelen(conn->pcb.tcp) >= TCP_SNDQUEUELOWAT)) {
+    /* let select mark this pcb as non-writable, as lwip_netconn_do_writemore() */
+    API_EVENT(conn, NETCONN_EVT_SENDMINUS, 0);
+  }
+  if (tcp_output(conn->pcb.tcp) == ERR_RTE) {
+    return ERR_RTE;
+  }
+  return ERR_OK;
+}
+#endif /* LWIP_TCP && LWIP_NETCONN_FASTPATH */
+
 /**
  * Send some data on a TCP pcb contained in a netconn
  * Called from netconn_write
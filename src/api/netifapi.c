@@ -338,7 +338,14 @@ netifapi_netif_name_to_index(const char *name, u8_t *idx)
 #else
   NETIFAPI_VAR_REF(msg).msg.ifs.name = LWIP_CONST_CAST(char *, name);
 #endif /* LWIP_MPU_COMPATIBLE */
+#if LWIP_TCPIP_CORE_LOCKING
+  /* lookups only read the netif list: the shared lock is enough */
+  LOCK_TCPIP_CORE_SHARED();
+  err = netifapi_do_name_to_index(&API_VAR_REF(msg).call);
+  UNLOCK_TCPIP_CORE_SHARED();
+#else /* LWIP_TCPIP_CORE_LOCKING */
   err = tcpip_api_call(netifapi_do_name_to_index, &API_VAR_REF(msg).call);
+#endif /* LWIP_TCPIP_CORE_LOCKING */
   if (!err) {
     *idx = NETIFAPI_VAR_REF(msg).msg.ifs.index;
   }
@@ -366,7 +373,14 @@ netifapi_netif_index_to_name(u8_t idx, char *name)
 #if !LWIP_MPU_COMPATIBLE
   NETIFAPI_VAR_REF(msg).msg.ifs.name = name;
 #endif /* LWIP_MPU_COMPATIBLE */
+#if LWIP_TCPIP_CORE_LOCKING
+  /* lookups only read the netif list: the shared lock is enough */
+  LOCK_TCPIP_CORE_SHARED();
+  err = netifapi_do_index_to_name(&API_VAR_REF(msg).call);
+  UNLOCK_TCPIP_CORE_SHARED();
+#else /* LWIP_TCPIP_CORE_LOCKING */
   err = tcpip_api_call(netifapi_do_index_to_name, &API_VAR_REF(msg).call);
+#endif /* LWIP_TCPIP_CORE_LOCKING */
 #if LWIP_MPU_COMPATIBLE
   if (!err) {
     strncpy(name, NETIFAPI_VAR_REF(msg).msg.ifs.name, NETIF_NAMESIZE - 1);
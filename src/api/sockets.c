@@ -513,6 +513,10 @@ alloc_socket(struct netconn *newconn, int accepted)
       sockets[i].fd_free_pending = 0;
 #endif
       sockets[i].conn       = newconn;
+#if LWIP_TCP_ZEROCOPY
+      sockets[i].zerocopy_gen++;
+      sockets[i].zerocopy_done = 0;
+#endif /* LWIP_TCP_ZEROCOPY */
       /* The socket is not yet known to anyone, so no need to protect
          after having marked it as used. */
       SYS_ARCH_UNPROTECT(lev);
@@ -1271,6 +1275,97 @@ lwip_recv(int s, void *mem, size_t len, int flags)
   return lwip_recvfrom(s, mem, len, flags, NULL, NULL);
 }
 
+#if LWIP_SOCKET_RECV_PBUF
+/**
+ * @ingroup socket
+ * Receive data from a TCP socket without copying it.
+ *
+ * On success, *p is set to the next chain of received data (data left over
+ * from a previous lwip_recv() comes first) and its length is returned. The
+ * application owns that chain and must pass it to lwip_recv_pbuf_free() once
+ * done: the receive window is not opened for that data before.
+ *
+ * @param s the socket
+ * @param p returns the pbuf chain (NULL if no data is returned)
+ * @param flags 0 or MSG_DONTWAIT
+ * @return length of the chain, 0 at end of stream, -1 on error (errno set)
+ */
+ssize_t
+lwip_recv_pbuf(int s, struct pbuf **p, int flags)
+{
+  struct lwip_sock *sock;
+  struct pbuf *q;
+  u8_t apiflags = NETCONN_NOAUTORCVD;
+
+  LWIP_ERROR("lwip_recv_pbuf: invalid pbuf pointer", p != NULL, set_errno(EINVAL); return -1;);
+  *p = NULL;
+  LWIP_ERROR("lwip_recv_pbuf: unsupported flags", (flags & ~MSG_DONTWAIT) == 0,
+             set_errno(EOPNOTSUPP); return -1;);
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) != NETCONN_TCP) {
+    done_socket(sock);
+    set_errno(EOPNOTSUPP);
+    return -1;
+  }
+  if (flags & MSG_DONTWAIT) {
+    apiflags |= NETCONN_DONTBLOCK;
+  }
+
+  q = sock->lastdata.pbuf;
+  if (q != NULL) {
+    sock->lastdata.pbuf = NULL;
+  } else {
+    err_t err = netconn_recv_tcp_pbuf_flags(sock->conn, &q, apiflags);
+    LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_pbuf(%d): netconn_recv err=%d, pbuf=%p\n",
+                                s, err, (void *)q));
+    if (err != ERR_OK) {
+      done_socket(sock);
+      set_errno(err_to_errno(err));
+      return (err == ERR_CLSD) ? 0 : -1;
+    }
+    LWIP_ASSERT("q != NULL", q != NULL);
+  }
+  *p = q;
+  done_socket(sock);
+  set_errno(0);
+  return (ssize_t)q->tot_len;
+}
+
+/**
+ * @ingroup socket
+ * Free a pbuf chain returned by lwip_recv_pbuf() and open the receive window
+ * by its length. The chain's tot_len must not have been changed.
+ *
+ * @param s the socket the chain has been received from
+ * @param p the pbuf chain
+ * @return 0 on success, -1 on error (errno set, the chain is freed anyway)
+ */
+int
+lwip_recv_pbuf_free(int s, struct pbuf *p)
+{
+  struct lwip_sock *sock;
+  size_t len;
+  err_t err;
+
+  LWIP_ERROR("lwip_recv_pbuf_free: invalid pbuf", p != NULL, set_errno(EINVAL); return -1;);
+  len = p->tot_len;
+  pbuf_free(p);
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+  err = netconn_tcp_recvd(sock->conn, len);
+  done_socket(sock);
+  set_errno(err_to_errno(err));
+  return (err == ERR_OK) ? 0 : -1;
+}
+#endif /* LWIP_SOCKET_RECV_PBUF */
+
 ssize_t
 lwip_recvmsg(int s, struct msghdr *message, int flags)
 {
@@ -1372,6 +1467,58 @@ lwip_recvmsg(int s, struct msghdr *message, int flags)
 #endif /* LWIP_UDP || LWIP_RAW */
 }
 
+#if LWIP_TCP_ZEROCOPY
+/** custom_free_function of the pbuf passed to netconn_write_ref() by
+ * lwip_send_zerocopy(): counts the send for SO_ZEROCOPY_DONE */
+static void
+lwip_zerocopy_done(struct pbuf *p)
+{
+  struct lwip_sock_zerocopy *zc = (struct lwip_sock_zerocopy *)p;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  /* don't count for a socket that has been closed (and reused) since */
+  if ((zc->sock->conn != NULL) && (zc->sock->zerocopy_gen == zc->gen)) {
+    zc->sock->zerocopy_done++;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  memp_free(MEMP_SOCKET_ZEROCOPY, zc);
+}
+
+/** lwip_send() with MSG_ZEROCOPY: pass the data to netconn_write_ref(). Every
+ * such send is counted by SO_ZEROCOPY_DONE exactly once when the stack has
+ * released the data, even if it failed. If no pbuf to track the data is
+ * available, it is copied instead and counted right away. */
+static err_t
+lwip_send_zerocopy(struct lwip_sock *sock, const void *data, size_t size,
+                   u8_t write_flags, size_t *written)
+{
+  struct lwip_sock_zerocopy *zc;
+  struct pbuf *ref;
+  err_t err;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  zc = (struct lwip_sock_zerocopy *)memp_malloc(MEMP_SOCKET_ZEROCOPY);
+  if (zc == NULL) {
+    err = netconn_write_partly(sock->conn, data, size, write_flags, written);
+    SYS_ARCH_PROTECT(lev);
+    sock->zerocopy_done++;
+    SYS_ARCH_UNPROTECT(lev);
+    return err;
+  }
+  zc->pc.custom_free_function = lwip_zerocopy_done;
+  zc->sock = sock;
+  zc->gen = sock->zerocopy_gen;
+  ref = pbuf_alloced_custom(PBUF_RAW, 0, PBUF_REF, &zc->pc, NULL, 0);
+  LWIP_ASSERT("lwip_send_zerocopy: custom pbuf fits", ref != NULL);
+
+  err = netconn_write_ref(sock->conn, data, size, write_flags, ref, written);
+  /* from now on, only the queued segments keep the data referenced */
+  pbuf_free(ref);
+  return err;
+}
+#endif /* LWIP_TCP_ZEROCOPY */
+
 ssize_t
 lwip_send(int s, const void *data, size_t size, int flags)
 {
@@ -1403,7 +1550,14 @@ lwip_send(int s, const void *data, size_t size, int flags)
                        ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
                        ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0));
   written = 0;
-  err = netconn_write_partly(sock->conn, data, size, write_flags, &written);
+#if LWIP_TCP_ZEROCOPY
+  if (flags & MSG_ZEROCOPY) {
+    err = lwip_send_zerocopy(sock, data, size, write_flags, &written);
+  } else
+#endif /* LWIP_TCP_ZEROCOPY */
+  {
+    err = netconn_write_partly(sock->conn, data, size, write_flags, &written);
+  }
 
   LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send(%d) err=%d written=%"SZT_F"\n", s, err, written));
   set_errno(err_to_errno(err));
@@ -1495,16 +1649,22 @@ lwip_sendmsg(int s, const struct msghdr *msg, int flags)
     } else {
       /* flatten the IO vectors */
       size_t offset = 0;
+#if LWIP_CHECKSUM_ON_COPY
+      /* checksum each IO vector while copying it and aggregate the results */
+      u16_t chksum = 0;
+      for (i = 0; i < msg->msg_iovlen; i++) {
+        if (msg->msg_iov[i].iov_len > 0) {
+          pbuf_fill_chksum(chain_buf.p, (u16_t)offset, msg->msg_iov[i].iov_base,
+                           (u16_t)msg->msg_iov[i].iov_len, &chksum);
+          offset += msg->msg_iov[i].iov_len;
+        }
+      }
+      netbuf_set_chksum(&chain_buf, chksum);
+#else /* LWIP_CHECKSUM_ON_COPY */
       for (i = 0; i < msg->msg_iovlen; i++) {
         MEMCPY(&((u8_t *)chain_buf.p->payload)[offset], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
         offset += msg->msg_iov[i].iov_len;
       }
-#if LWIP_CHECKSUM_ON_COPY
-      {
-        /* This can be improved by using LWIP_CHKSUM_COPY() and aggregating the checksum for each IO vector */
-        u16_t chksum = ~inet_chksum_pbuf(chain_buf.p);
-        netbuf_set_chksum(&chain_buf, chksum);
-      }
 #endif /* LWIP_CHECKSUM_ON_COPY */
       err = ERR_OK;
     }
@@ -1642,7 +1802,8 @@ lwip_sendto(int s, const void *data, size_t size, int flags,
   } else {
 #if LWIP_CHECKSUM_ON_COPY
     if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) != NETCONN_RAW) {
-      u16_t chksum = LWIP_CHKSUM_COPY(buf.p->payload, data, short_size);
+      u16_t chksum;
+      pbuf_take_chksum(buf.p, data, short_size, &chksum);
       netbuf_set_chksum(&buf, chksum);
     } else
 #endif /* LWIP_CHECKSUM_ON_COPY */
@@ -2770,10 +2931,11 @@ lwip_getsockopt(int s, int level, int optname, void *optval, socklen_t *optlen)
   }
 
 #if LWIP_TCPIP_CORE_LOCKING
-  /* core-locking can just call the -impl function */
-  LOCK_TCPIP_CORE();
+  /* core-locking can just call the -impl function; it only reads
+     stack state, so the shared lock is enough */
+  LOCK_TCPIP_CORE_SHARED();
   err = lwip_getsockopt_impl(s, level, optname, optval, optlen);
-  UNLOCK_TCPIP_CORE();
+  UNLOCK_TCPIP_CORE_SHARED();
 
 #else /* LWIP_TCPIP_CORE_LOCKING */
 
@@ -2957,6 +3119,21 @@ lwip_getsockopt_impl(int s, int level, int optname, void *optval, socklen_t *opt
                                       s, *(int *)optval));
           break;
 
+#if LWIP_TCP_ZEROCOPY
+        case SO_ZEROCOPY_DONE: {
+          SYS_ARCH_DECL_PROTECT(lev);
+          LWIP_SOCKOPT_CHECK_OPTLEN_CONN(sock, *optlen, u32_t);
+          if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) != NETCONN_TCP) {
+            done_socket(sock);
+            return ENOPROTOOPT;
+          }
+          SYS_ARCH_PROTECT(lev);
+          *(u32_t *)optval = sock->zerocopy_done;
+          SYS_ARCH_UNPROTECT(lev);
+        }
+        break;
+#endif /* LWIP_TCP_ZEROCOPY */
+
 #if LWIP_SO_SNDTIMEO
         case SO_SNDTIMEO:
           LWIP_SOCKOPT_CHECK_OPTLEN_CONN(sock, *optlen, LWIP_SO_SNDRCVTIMEO_OPTTYPE);
@@ -3070,9 +3247,10 @@ lwip_getsockopt_impl(int s, int level, int optname, void *optval, socklen_t *opt
 #if LWIP_TCP
     /* Level: IPPROTO_TCP */
     case IPPROTO_TCP:
-      /* Special case: all IPPROTO_TCP option take an int */
+      /* Special case: all IPPROTO_TCP option take an int (TCP_CONGESTION: a string at least that long) */
       LWIP_SOCKOPT_CHECK_OPTLEN_CONN_PCB_TYPE(sock, *optlen, int, NETCONN_TCP);
-      if (sock->conn->pcb.tcp->state == LISTEN) {
+      /* listening pcbs only keep the congestion control module */
+      if ((sock->conn->pcb.tcp->state == LISTEN) && (optname != TCP_CONGESTION)) {
         done_socket(sock);
         return EINVAL;
       }
@@ -3105,6 +3283,17 @@ lwip_getsockopt_impl(int s, int level, int optname, void *optval, socklen_t *opt
                                       s, *(int *)optval));
           break;
 #endif /* LWIP_TCP_KEEPALIVE */
+#if LWIP_TCP_CC
+        case TCP_CONGESTION: {
+          const char *name = tcp_get_cc(sock->conn->pcb.tcp)->name;
+          size_t len = LWIP_MIN(*optlen, strlen(name) + 1);
+          MEMCPY(optval, name, len);
+          *optlen = (socklen_t)len;
+          LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_getsockopt(%d, IPPROTO_TCP, TCP_CONGESTION) = %s\n",
+                                      s, name));
+        }
+        break;
+#endif /* LWIP_TCP_CC */
         default:
           LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_getsockopt(%d, IPPROTO_TCP, UNIMPL: optname=0x%x, ..)\n",
                                       s, optname));
@@ -3543,9 +3732,10 @@ lwip_setsockopt_impl(int s, int level, int optname, const void *optval, socklen_
 #if LWIP_TCP
     /* Level: IPPROTO_TCP */
     case IPPROTO_TCP:
-      /* Special case: all IPPROTO_TCP option take an int */
+      /* Special case: all IPPROTO_TCP option take an int (TCP_CONGESTION: a string at least that long) */
       LWIP_SOCKOPT_CHECK_OPTLEN_CONN_PCB_TYPE(sock, optlen, int, NETCONN_TCP);
-      if (sock->conn->pcb.tcp->state == LISTEN) {
+      /* listening pcbs only keep the congestion control module */
+      if ((sock->conn->pcb.tcp->state == LISTEN) && (optname != TCP_CONGESTION)) {
         done_socket(sock);
         return EINVAL;
       }
@@ -3582,6 +3772,25 @@ lwip_setsockopt_impl(int s, int level, int optname, const void *optval, socklen_
                                       s, sock->conn->pcb.tcp->keep_cnt));
           break;
 #endif /* LWIP_TCP_KEEPALIVE */
+#if LWIP_TCP_CC
+        case TCP_CONGESTION: {
+          /* the name need not be NUL-terminated within optlen */
+          char name[TCP_CC_NAME_MAX + 1];
+          const struct tcp_cc_ops *ops;
+          size_t len = LWIP_MIN(optlen, TCP_CC_NAME_MAX);
+          MEMCPY(name, optval, len);
+          name[len] = 0;
+          ops = tcp_cc_find(name);
+          if (ops == NULL) {
+            err = ENOENT;
+            break;
+          }
+          tcp_set_cc(sock->conn->pcb.tcp, ops);
+          LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_setsockopt(%d, IPPROTO_TCP, TCP_CONGESTION) -> %s\n",
+                                      s, ops->name));
+        }
+        break;
+#endif /* LWIP_TCP_CC */
         default:
           LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_setsockopt(%d, IPPROTO_TCP, UNIMPL: optname=0x%x, ..)\n",
                                       s, optname));
@@ -3844,7 +4053,7 @@ lwip_fcntl(int s, int cmd, int val)
 
       if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
 #if LWIP_TCPIP_CORE_LOCKING
-        LOCK_TCPIP_CORE();
+        LOCK_TCPIP_CORE_SHARED();
 #else
         SYS_ARCH_DECL_PROTECT(lev);
         /* the proper thing to do here would be to get into the tcpip_thread,
@@ -3862,7 +4071,7 @@ lwip_fcntl(int s, int cmd, int val)
         }
 #endif
 #if LWIP_TCPIP_CORE_LOCKING
-        UNLOCK_TCPIP_CORE();
+        UNLOCK_TCPIP_CORE_SHARED();
 #else
         SYS_ARCH_UNPROTECT(lev);
 #endif
@@ -49,6 +49,7 @@
 #include "lwip/pbuf.h"
 #include "lwip/etharp.h"
 #include "netif/ethernet.h"
+#include "lwip/stats.h"
 
 #define TCPIP_MSG_VAR_REF(name)     API_VAR_REF(name)
 #define TCPIP_MSG_VAR_DECLARE(name) API_VAR_DECLARE(struct tcpip_msg, name)
@@ -60,6 +61,11 @@ static tcpip_init_done_fn tcpip_init_done;
 static void *tcpip_init_done_arg;
 static sys_mbox_t tcpip_mbox;
 
+#if LWIP_TCPIP_INPUT_BATCH && !LWIP_TCPIP_CORE_LOCKING_INPUT
+/** The packets of a TCPIP_MSG_INPKT_BATCH message follow it in its pool element */
+#define TCPIP_MSG_INPKT_BATCH_PKTS(msg) ((struct pbuf **)(void *)((msg) + 1))
+#endif /* LWIP_TCPIP_INPUT_BATCH && !LWIP_TCPIP_CORE_LOCKING_INPUT */
+
 #if LWIP_TCPIP_CORE_LOCKING
 /** The global semaphore to lock the stack. */
 sys_mutex_t lock_tcpip_core;
@@ -67,6 +73,73 @@ sys_mutex_t lock_tcpip_core;
 
 static void tcpip_thread_handle_msg(struct tcpip_msg *msg);
 
+#if LWIP_TCPIP_BUSY_POLL
+/** tcpip_busy_poll_round() results */
+#define TCPIP_BUSY_POLL_NONE 0
+#define TCPIP_BUSY_POLL_MSG  1
+#define TCPIP_BUSY_POLL_RX   2
+
+/**
+ * One busy-polling round: try to fetch a message (with the core unlocked so
+ * that other threads can take it meanwhile), then let every netif with an
+ * rx_poll function pass up the frames it has received.
+ * Called with the core locked, returns with the core locked.
+ *
+ * @param mbox the mbox to fetch the message from
+ * @param msg the place to store the message
+ * @return TCPIP_BUSY_POLL_MSG if a message was fetched, TCPIP_BUSY_POLL_RX if
+ *         frames were received, TCPIP_BUSY_POLL_NONE otherwise
+ */
+static int
+tcpip_busy_poll_round(sys_mbox_t *mbox, void **msg)
+{
+  struct netif *netif;
+  u32_t res;
+  u16_t rx = 0;
+
+  TCPIP_STATS_INC(tcpip.poll);
+  UNLOCK_TCPIP_CORE();
+  res = sys_arch_mbox_tryfetch(mbox, msg);
+  LOCK_TCPIP_CORE();
+  if (res != SYS_MBOX_EMPTY) {
+    TCPIP_STATS_INC(tcpip.poll_hit);
+    return TCPIP_BUSY_POLL_MSG;
+  }
+  NETIF_FOREACH(netif) {
+    if (netif->rx_poll != NULL) {
+      rx = (u16_t)(rx + netif->rx_poll(netif));
+    }
+  }
+  if (rx != 0) {
+    TCPIP_STATS_INC(tcpip.poll_hit);
+    return TCPIP_BUSY_POLL_RX;
+  }
+  return TCPIP_BUSY_POLL_NONE;
+}
+
+/**
+ * Busy-poll for up to TCPIP_BUSY_POLL_BUDGET rounds until a round finds work.
+ *
+ * @param mbox the mbox to fetch the message from
+ * @param msg the place to store the message
+ * @return the result of the last round
+ */
+static int
+tcpip_busy_poll(sys_mbox_t *mbox, void **msg)
+{
+  u32_t i;
+
+  for (i = 0; i < TCPIP_BUSY_POLL_BUDGET; i++) {
+    int res = tcpip_busy_poll_round(mbox, msg);
+    if (res != TCPIP_BUSY_POLL_NONE) {
+      return res;
+    }
+  }
+  TCPIP_STATS_INC(tcpip.idle);
+  return TCPIP_BUSY_POLL_NONE;
+}
+#endif /* LWIP_TCPIP_BUSY_POLL */
+
 #if !LWIP_TIMERS
 /* wait for a message with timers disabled (e.g. pass a timer-check trigger into tcpip_thread) */
 #define TCPIP_MBOX_FETCH(mbox, msg) sys_mbox_fetch(mbox, msg)
@@ -75,7 +148,8 @@ static void tcpip_thread_handle_msg(struct tcpip_msg *msg);
 #define TCPIP_MBOX_FETCH(mbox, msg) tcpip_timeouts_mbox_fetch(mbox, msg)
 /**
  * Wait (forever) for a message to arrive in an mbox.
- * While waiting, timeouts are processed.
+ * While waiting, timeouts are processed. With LWIP_TCPIP_BUSY_POLL, the mbox
+ * and the netifs are polled for a while before blocking.
  *
  * @param mbox the mbox to fetch the message from
  * @param msg the place to store the message
@@ -84,11 +158,30 @@ static void
 tcpip_timeouts_mbox_fetch(sys_mbox_t *mbox, void **msg)
 {
   u32_t sleeptime, res;
+#if LWIP_TCPIP_BUSY_POLL
+  /* busy-poll only once per call, not again after each timeout check */
+  int busy_polled = 0;
+#endif /* LWIP_TCPIP_BUSY_POLL */
 
 again:
   LWIP_ASSERT_CORE_LOCKED();
 
   sleeptime = sys_timeouts_sleeptime();
+#if LWIP_TCPIP_BUSY_POLL
+  if ((sleeptime != 0) && !busy_polled) {
+    int polled = tcpip_busy_poll(mbox, msg);
+    if (polled == TCPIP_BUSY_POLL_MSG) {
+      return;
+    } else if (polled == TCPIP_BUSY_POLL_NONE) {
+      /* Time has passed while polling, so the sleep time has to be
+         computed again before blocking. */
+      busy_polled = 1;
+    }
+    /* Frames were processed or the budget ran out: check the timeouts
+       before polling on or blocking. */
+    goto again;
+  }
+#endif /* LWIP_TCPIP_BUSY_POLL */
   if (sleeptime == SYS_TIMEOUTS_SLEEPTIME_INFINITE) {
     UNLOCK_TCPIP_CORE();
     sys_arch_mbox_fetch(mbox, msg, 0);
@@ -176,6 +269,21 @@ tcpip_thread_handle_msg(struct tcpip_msg *msg)
       }
       memp_free(MEMP_TCPIP_MSG_INPKT, msg);
       break;
+#if LWIP_TCPIP_INPUT_BATCH
+    case TCPIP_MSG_INPKT_BATCH: {
+      struct pbuf **pkts = TCPIP_MSG_INPKT_BATCH_PKTS(msg);
+      u16_t i;
+      LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: PACKET BATCH %p (%"U16_F")\n",
+                                (void *)msg, msg->msg.inp_batch.count));
+      for (i = 0; i < msg->msg.inp_batch.count; i++) {
+        if (msg->msg.inp_batch.input_fn(pkts[i], msg->msg.inp_batch.netif) != ERR_OK) {
+          pbuf_free(pkts[i]);
+        }
+      }
+      memp_free(MEMP_TCPIP_MSG_INPKT_BATCH, msg);
+      break;
+    }
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 #endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
 
 #if LWIP_TCPIP_TIMEOUT && LWIP_TIMERS
@@ -225,6 +333,25 @@ tcpip_thread_poll_one(void)
     }
     UNLOCK_TCPIP_CORE();
   }
+#if LWIP_TCPIP_BUSY_POLL
+  if (!ret) {
+    LOCK_TCPIP_CORE();
+    switch (tcpip_busy_poll_round(&tcpip_mbox, (void **)&msg)) {
+      case TCPIP_BUSY_POLL_MSG:
+        if (msg != NULL) {
+          tcpip_thread_handle_msg(msg);
+        }
+        ret = 1;
+        break;
+      case TCPIP_BUSY_POLL_RX:
+        ret = 1;
+        break;
+      default:
+        break;
+    }
+    UNLOCK_TCPIP_CORE();
+  }
+#endif /* LWIP_TCPIP_BUSY_POLL */
   return ret;
 }
 #endif
@@ -290,6 +417,93 @@ tcpip_input(struct pbuf *p, struct netif *inp)
     return tcpip_inpkt(p, inp, ip_input);
 }
 
+#if LWIP_TCPIP_INPUT_BATCH
+/**
+ * Pass a burst of received packets to tcpip_thread for input processing,
+ * using one message instead of one per packet.
+ *
+ * Every packet passed on to the stack is set to NULL in the array. On error,
+ * the packets left in the array are still owned by the caller.
+ *
+ * @param p array of received packets
+ * @param count number of packets (at most TCPIP_INPUT_BATCH_MAX)
+ * @param inp the network interface on which the packets were received
+ * @param input_fn input function to call
+ * @return ERR_OK if all packets have been passed on, another err_t if not
+ */
+err_t
+tcpip_inpkt_batch(struct pbuf **p, u16_t count, struct netif *inp, netif_input_fn input_fn)
+{
+#if LWIP_TCPIP_CORE_LOCKING_INPUT
+  u16_t i;
+  LWIP_ERROR("tcpip_inpkt_batch: too many packets", count <= TCPIP_INPUT_BATCH_MAX, return ERR_ARG;);
+  LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_inpkt_batch: %"U16_F" PACKETS/%p\n", count, (void *)inp));
+  LOCK_TCPIP_CORE();
+  for (i = 0; i < count; i++) {
+    if (input_fn(p[i], inp) != ERR_OK) {
+      pbuf_free(p[i]);
+    }
+    p[i] = NULL;
+  }
+  UNLOCK_TCPIP_CORE();
+  return ERR_OK;
+#else /* LWIP_TCPIP_CORE_LOCKING_INPUT */
+  struct tcpip_msg *msg;
+  struct pbuf **pkts;
+  u16_t i;
+
+  LWIP_ERROR("tcpip_inpkt_batch: too many packets", count <= TCPIP_INPUT_BATCH_MAX, return ERR_ARG;);
+  LWIP_ASSERT("Invalid mbox", sys_mbox_valid_val(tcpip_mbox));
+
+  if (count == 0) {
+    return ERR_OK;
+  }
+  msg = (struct tcpip_msg *)memp_malloc(MEMP_TCPIP_MSG_INPKT_BATCH);
+  if (msg == NULL) {
+    return ERR_MEM;
+  }
+  pkts = TCPIP_MSG_INPKT_BATCH_PKTS(msg);
+  for (i = 0; i < count; i++) {
+    pkts[i] = p[i];
+  }
+  msg->type = TCPIP_MSG_INPKT_BATCH;
+  msg->msg.inp_batch.netif = inp;
+  msg->msg.inp_batch.input_fn = input_fn;
+  msg->msg.inp_batch.count = count;
+  if (sys_mbox_trypost(&tcpip_mbox, msg) != ERR_OK) {
+    memp_free(MEMP_TCPIP_MSG_INPKT_BATCH, msg);
+    return ERR_MEM;
+  }
+  for (i = 0; i < count; i++) {
+    p[i] = NULL;
+  }
+  return ERR_OK;
+#endif /* LWIP_TCPIP_CORE_LOCKING_INPUT */
+}
+
+/**
+ * @ingroup lwip_os
+ * Pass a burst of received packets to tcpip_thread for input processing with
+ * ethernet_input or ip_input, see tcpip_inpkt_batch(). To be called by
+ * drivers instead of netif->input() for every packet.
+ *
+ * @param p array of received packets, set to NULL when passed on
+ * @param count number of packets (at most TCPIP_INPUT_BATCH_MAX)
+ * @param inp the network interface on which the packets were received
+ * @return ERR_OK if all packets have been passed on, another err_t if not
+ */
+err_t
+tcpip_input_batch(struct pbuf **p, u16_t count, struct netif *inp)
+{
+#if LWIP_ETHERNET
+  if (inp->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) {
+    return tcpip_inpkt_batch(p, count, inp, ethernet_input);
+  } else
+#endif /* LWIP_ETHERNET */
+    return tcpip_inpkt_batch(p, count, inp, ip_input);
+}
+#endif /* LWIP_TCPIP_INPUT_BATCH */
+
 /**
  * @ingroup lwip_os
  * Call a specific function in the thread context of
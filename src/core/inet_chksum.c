@@ -10,7 +10,8 @@
  * \#define LWIP_CHKSUM your_checksum_routine
  *
  * Or you can select from the implementations below by defining
- * LWIP_CHKSUM_ALGORITHM to 1, 2 or 3.
+ * LWIP_CHKSUM_ALGORITHM to 1, 2, 3, 4 or 5 (4 and 5 need a 64-bit integer
+ * type, 5 uses AVX2, SSE2 or NEON if the compiler targets it).
  */
 
 /*
@@ -255,6 +256,176 @@ lwip_standard_chksum(const void *dataptr, int len)
 }
 #endif
 
+#if (LWIP_CHKSUM_ALGORITHM == 5) /* SIMD version #5 */
+/* Pick the widest vector unit the compiler targets. Without one, version #5
+ * is the same as version #4. */
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LWIP_CHKSUM_SIMD_BLOCK 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LWIP_CHKSUM_SIMD_BLOCK 16
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LWIP_CHKSUM_SIMD_BLOCK 16
+#endif
+
+#ifdef LWIP_CHKSUM_SIMD_BLOCK
+/**
+ * Sum 'blocks' blocks of LWIP_CHKSUM_SIMD_BLOCK bytes as 32-bit words into
+ * 64-bit lanes, so no carry can get lost.
+ *
+ * @param dst if != NULL, the data is copied here while it is summed
+ * @param pb start of the data, aligned to 4 bytes
+ * @param blocks number of blocks to sum
+ * @return 64-bit sum of all 32-bit words
+ */
+static u64_t
+lwip_chksum_simd(u8_t *dst, const u8_t *pb, int blocks)
+{
+#if defined(__AVX2__)
+  u64_t lanes[4];
+  __m256i zero = _mm256_setzero_si256();
+  __m256i acc_lo = zero;
+  __m256i acc_hi = zero;
+
+  while (blocks-- > 0) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)pb);
+    if (dst != NULL) {
+      _mm256_storeu_si256((__m256i *)(void *)dst, v);
+      dst += LWIP_CHKSUM_SIMD_BLOCK;
+    }
+    acc_lo = _mm256_add_epi64(acc_lo, _mm256_unpacklo_epi32(v, zero));
+    acc_hi = _mm256_add_epi64(acc_hi, _mm256_unpackhi_epi32(v, zero));
+    pb += LWIP_CHKSUM_SIMD_BLOCK;
+  }
+  _mm256_storeu_si256((__m256i *)(void *)lanes, _mm256_add_epi64(acc_lo, acc_hi));
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE2__)
+  u64_t lanes[2];
+  __m128i zero = _mm_setzero_si128();
+  __m128i acc_lo = zero;
+  __m128i acc_hi = zero;
+
+  while (blocks-- > 0) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(const void *)pb);
+    if (dst != NULL) {
+      _mm_storeu_si128((__m128i *)(void *)dst, v);
+      dst += LWIP_CHKSUM_SIMD_BLOCK;
+    }
+    acc_lo = _mm_add_epi64(acc_lo, _mm_unpacklo_epi32(v, zero));
+    acc_hi = _mm_add_epi64(acc_hi, _mm_unpackhi_epi32(v, zero));
+    pb += LWIP_CHKSUM_SIMD_BLOCK;
+  }
+  _mm_storeu_si128((__m128i *)(void *)lanes, _mm_add_epi64(acc_lo, acc_hi));
+  return lanes[0] + lanes[1];
+#else /* NEON */
+  uint64x2_t acc = vdupq_n_u64(0);
+
+  while (blocks-- > 0) {
+    uint32x4_t v = vld1q_u32((const uint32_t *)(const void *)pb);
+    if (dst != NULL) {
+      vst1q_u8(dst, vreinterpretq_u8_u32(v));
+      dst += LWIP_CHKSUM_SIMD_BLOCK;
+    }
+    /* pairwise add the 32-bit words into the 64-bit lanes */
+    acc = vpadalq_u32(acc, v);
+    pb += LWIP_CHKSUM_SIMD_BLOCK;
+  }
+  return vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+}
+#endif /* LWIP_CHKSUM_SIMD_BLOCK */
+#endif /* (LWIP_CHKSUM_ALGORITHM == 5) */
+
+#if (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_ALGORITHM == 5) /* Version #4 and #5 */
+/**
+ * Checksum using a 64-bit accumulator: 32-bit words are added without
+ * checking for carries, which are folded back in once at the end.
+ * Version #5 sums the bulk of the data with SIMD instructions (AVX2, SSE2 or
+ * NEON, depending on the compiler target). Both need u64_t.
+ *
+ * @param dataptr points to start of data to be summed at any boundary
+ * @param len length of data to be summed
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+u16_t
+lwip_standard_chksum(const void *dataptr, int len)
+{
+  const u8_t *pb = (const u8_t *)dataptr;
+  const u32_t *pl;
+  const u16_t *ps;
+  u16_t t = 0;
+  u64_t sum = 0;
+  u32_t sum32;
+  /* starts at odd byte address? */
+  int odd = ((mem_ptr_t)pb & 1);
+
+  if (odd && len > 0) {
+    ((u8_t *)&t)[1] = *pb++;
+    len--;
+  }
+
+  /* get aligned to u32_t */
+  if (((mem_ptr_t)pb & 2) && len > 1) {
+    sum += *(const u16_t *)(const void *)pb;
+    pb += 2;
+    len -= 2;
+  }
+
+#ifdef LWIP_CHKSUM_SIMD_BLOCK
+  if (len >= LWIP_CHKSUM_SIMD_BLOCK) {
+    int blocks = len / LWIP_CHKSUM_SIMD_BLOCK;
+    sum += lwip_chksum_simd(NULL, pb, blocks);
+    pb += blocks * LWIP_CHKSUM_SIMD_BLOCK;
+    len -= blocks * LWIP_CHKSUM_SIMD_BLOCK;
+  }
+#endif /* LWIP_CHKSUM_SIMD_BLOCK */
+
+  pl = (const u32_t *)(const void *)pb;
+  while (len > 15) {
+    sum += pl[0];
+    sum += pl[1];
+    sum += pl[2];
+    sum += pl[3];
+    pl += 4;
+    len -= 16;
+  }
+  while (len > 3) {
+    sum += *pl++;
+    len -= 4;
+  }
+
+  ps = (const u16_t *)(const void *)pl;
+
+  /* 16-bit aligned word remaining? */
+  if (len > 1) {
+    sum += *ps++;
+    len -= 2;
+  }
+
+  /* dangling tail byte remaining? */
+  if (len > 0) {
+    ((u8_t *)&t)[0] = *(const u8_t *)ps;
+  }
+
+  sum += t;
+
+  /* Fold 64-bit sum to 32 bits, then to 16 bits */
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  sum32 = (u32_t)sum;
+  sum32 = FOLD_U32T(sum32);
+  sum32 = FOLD_U32T(sum32);
+
+  if (odd) {
+    sum32 = SWAP_BYTES_IN_WORD(sum32);
+  }
+
+  return (u16_t)sum32;
+}
+#endif /* (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_ALGORITHM == 5) */
+
 /** Parts of the pseudo checksum which are common to IPv4 and IPv6 */
 static u16_t
 inet_cksum_pseudo_base(struct pbuf *p, u8_t proto, u16_t proto_len, u32_t acc)
@@ -606,3 +777,101 @@ lwip_chksum_copy(void *dst, const void *src, u16_t len)
   return LWIP_CHKSUM(dst, len);
 }
 #endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 1) */
+
+#if (LWIP_CHKSUM_COPY_ALGORITHM == 2) /* Version #2 */
+/** Copy and checksum in a single pass: each 32-bit word is added to a 64-bit
+ * accumulator while it is in a register on its way to 'dst', so the source
+ * is only read once. The bulk is copied with SIMD instructions if
+ * LWIP_CHKSUM_ALGORITHM 5 found a vector unit. Needs u64_t.
+ */
+u16_t
+lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+  u8_t *pd = (u8_t *)dst;
+  const u8_t *ps = (const u8_t *)src;
+  int n = len;
+  u16_t t = 0;
+  u64_t sum = 0;
+  u32_t sum32;
+  /* source starts at odd byte address? */
+  int odd = ((mem_ptr_t)ps & 1);
+
+  if (odd && n > 0) {
+    ((u8_t *)&t)[1] = *ps;
+    *pd++ = *ps++;
+    n--;
+  }
+
+  /* get the source aligned to u32_t */
+  if (((mem_ptr_t)ps & 2) && n > 1) {
+    u16_t w = *(const u16_t *)(const void *)ps;
+    sum += w;
+    SMEMCPY(pd, &w, 2);
+    ps += 2;
+    pd += 2;
+    n -= 2;
+  }
+
+#ifdef LWIP_CHKSUM_SIMD_BLOCK
+  if (n >= LWIP_CHKSUM_SIMD_BLOCK) {
+    int blocks = n / LWIP_CHKSUM_SIMD_BLOCK;
+    sum += lwip_chksum_simd(pd, ps, blocks);
+    ps += blocks * LWIP_CHKSUM_SIMD_BLOCK;
+    pd += blocks * LWIP_CHKSUM_SIMD_BLOCK;
+    n -= blocks * LWIP_CHKSUM_SIMD_BLOCK;
+  }
+#endif /* LWIP_CHKSUM_SIMD_BLOCK */
+
+  /* the destination may be unaligned: store via SMEMCPY, which compilers
+     turn into plain (unaligned) stores */
+  while (n > 15) {
+    u32_t w[4];
+    SMEMCPY(w, ps, 16);
+    sum += w[0];
+    sum += w[1];
+    sum += w[2];
+    sum += w[3];
+    SMEMCPY(pd, w, 16);
+    ps += 16;
+    pd += 16;
+    n -= 16;
+  }
+  while (n > 3) {
+    u32_t w = *(const u32_t *)(const void *)ps;
+    sum += w;
+    SMEMCPY(pd, &w, 4);
+    ps += 4;
+    pd += 4;
+    n -= 4;
+  }
+  if (n > 1) {
+    u16_t w = *(const u16_t *)(const void *)ps;
+    sum += w;
+    SMEMCPY(pd, &w, 2);
+    ps += 2;
+    pd += 2;
+    n -= 2;
+  }
+
+  /* dangling tail byte remaining? */
+  if (n > 0) {
+    ((u8_t *)&t)[0] = *ps;
+    *pd = *ps;
+  }
+
+  sum += t;
+
+  /* Fold 64-bit sum to 32 bits, then to 16 bits */
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  sum32 = (u32_t)sum;
+  sum32 = FOLD_U32T(sum32);
+  sum32 = FOLD_U32T(sum32);
+
+  if (odd) {
+    sum32 = SWAP_BYTES_IN_WORD(sum32);
+  }
+
+  return (u16_t)sum32;
+}
+#endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
@@ -169,12 +169,54 @@ PACK_STRUCT_END
 #if (LWIP_TCP && LWIP_TCP_SACK_OUT && (LWIP_TCP_MAX_SACK_NUM < 1))
 #error "LWIP_TCP_MAX_SACK_NUM must be greater than 0"
 #endif
+#if (LWIP_TCP && LWIP_TCP_SACK_IN && !LWIP_TCP_SACK_OUT)
+#error "To use LWIP_TCP_SACK_IN, LWIP_TCP_SACK_OUT needs to be enabled"
+#endif
+#if (LWIP_TCP && LWIP_TCP_RTO_MS && !LWIP_TIMERS)
+#error "LWIP_TCP_RTO_MS needs LWIP_TIMERS"
+#endif
+#if (LWIP_TCP && LWIP_TCP_RACK_TLP && (!LWIP_TCP_RTO_MS || !LWIP_TCP_SACK_IN))
+#error "LWIP_TCP_RACK_TLP needs LWIP_TCP_RTO_MS and LWIP_TCP_SACK_IN"
+#endif
+#if (LWIP_TCP && LWIP_TCP_RTO_MS && ((TCP_RTO_MIN < 1) || (TCP_RTO_MAX < TCP_RTO_MIN) || (TCP_RTO_MAX > 0x7FFFFF)))
+#error "TCP_RTO_MIN and TCP_RTO_MAX must satisfy 1 <= TCP_RTO_MIN <= TCP_RTO_MAX <= 0x7FFFFF"
+#endif
+#if (LWIP_TCP_ZEROCOPY && (!LWIP_TCP || !LWIP_SUPPORT_CUSTOM_PBUF))
+#error "LWIP_TCP_ZEROCOPY needs LWIP_TCP and LWIP_SUPPORT_CUSTOM_PBUF"
+#endif
+#if (LWIP_TCP && LWIP_TCP_CC_CUBIC && (!LWIP_TCP_CC || !LWIP_HAVE_INT64))
+#error "To use LWIP_TCP_CC_CUBIC, LWIP_TCP_CC and u64_t (LWIP_HAVE_INT64) are needed"
+#endif
+#if (defined LWIP_CHKSUM_ALGORITHM && ((LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_ALGORITHM == 5)) && !LWIP_HAVE_INT64)
+#error "LWIP_CHKSUM_ALGORITHM 4 and 5 need u64_t (LWIP_HAVE_INT64)"
+#endif
+#if (defined LWIP_CHKSUM_COPY_ALGORITHM && (LWIP_CHKSUM_COPY_ALGORITHM == 2) && !LWIP_HAVE_INT64)
+#error "LWIP_CHKSUM_COPY_ALGORITHM 2 needs u64_t (LWIP_HAVE_INT64)"
+#endif
+#if (LWIP_TIMERS && LWIP_TIMERS_WHEEL && ((LWIP_TIMERS_WHEEL_SIZE & (LWIP_TIMERS_WHEEL_SIZE - 1)) || (LWIP_TIMERS_WHEEL_SIZE == 0) || (LWIP_TIMERS_WHEEL_SIZE > 0x10000)))
+#error "LWIP_TIMERS_WHEEL_SIZE must be a power of 2 and not larger than 65536"
+#endif
+#if (LWIP_UDP && LWIP_UDP_PCB_HASH && ((UDP_PCB_HASH_SIZE & (UDP_PCB_HASH_SIZE - 1)) || (UDP_PCB_HASH_SIZE == 0)))
+#error "UDP_PCB_HASH_SIZE must be a power of 2"
+#endif
+#if (LWIP_TCP && LWIP_TCP_PCB_HASH && ((TCP_PCB_HASH_SIZE & (TCP_PCB_HASH_SIZE - 1)) || (TCP_PCB_HASH_SIZE == 0)))
+#error "TCP_PCB_HASH_SIZE must be a power of 2"
+#endif
+#if (LWIP_TCP && LWIP_TCP_PCB_HASH && ((TCP_LISTEN_HASH_SIZE & (TCP_LISTEN_HASH_SIZE - 1)) || (TCP_LISTEN_HASH_SIZE == 0)))
+#error "TCP_LISTEN_HASH_SIZE must be a power of 2"
+#endif
+#if (LWIP_TCP && LWIP_TCP_PCB_TIMERS && ((TCP_PCB_TIMERS_WHEEL_SIZE & (TCP_PCB_TIMERS_WHEEL_SIZE - 1)) || (TCP_PCB_TIMERS_WHEEL_SIZE == 0)))
+#error "TCP_PCB_TIMERS_WHEEL_SIZE must be a power of 2"
+#endif
 #if (LWIP_NETIF_API && (NO_SYS==1))
 #error "If you want to use NETIF API, you have to define NO_SYS=0 in your lwipopts.h"
 #endif
 #if ((LWIP_SOCKET || LWIP_NETCONN) && (NO_SYS==1))
 #error "If you want to use Sequential API, you have to define NO_SYS=0 in your lwipopts.h"
 #endif
+#if (LWIP_SOCKET && LWIP_SOCKET_RECV_PBUF && !LWIP_TCP)
+#error "LWIP_SOCKET_RECV_PBUF needs LWIP_TCP"
+#endif
 #if (LWIP_PPP_API && (NO_SYS==1))
 #error "If you want to use PPP API, you have to define NO_SYS=0 in your lwipopts.h"
 #endif
@@ -202,9 +244,39 @@ PACK_STRUCT_END
 #if (MEM_USE_POOLS && !MEMP_USE_CUSTOM_POOLS)
 #error "MEM_USE_POOLS requires custom pools (MEMP_USE_CUSTOM_POOLS) to be enabled in your lwipopts.h"
 #endif
+#if (MEM_SIZE_CLASSES && (MEM_LIBC_MALLOC || MEM_USE_POOLS))
+#error "MEM_SIZE_CLASSES needs the lwIP heap, disable MEM_LIBC_MALLOC and MEM_USE_POOLS in your lwipopts.h"
+#endif
+#if (MEM_SIZE_CLASSES && ((MEM_SIZE_CLASS_MAX < 16) || (MEM_SIZE_CLASS_MAX > 32768) || (MEM_SIZE_CLASS_MAX & (MEM_SIZE_CLASS_MAX - 1))))
+#error "MEM_SIZE_CLASS_MAX must be a power of two between 16 and 32768 in your lwipopts.h"
+#endif
+#if (MEM_SIZE_CLASSES && ((MEM_SIZE_CLASS_SLAB_OBJS < 2) || (MEM_SIZE_CLASS_SLAB_OBJS * MEM_SIZE_CLASS_MAX > MEM_SIZE)))
+#error "MEM_SIZE_CLASS_SLAB_OBJS must be at least 2 and MEM_SIZE_CLASS_SLAB_OBJS * MEM_SIZE_CLASS_MAX must fit into MEM_SIZE in your lwipopts.h"
+#endif
 #if (PBUF_POOL_BUFSIZE <= MEM_ALIGNMENT)
 #error "PBUF_POOL_BUFSIZE must be greater than MEM_ALIGNMENT or the offset may take the full first pbuf"
 #endif
+#if PBUF_POOL_SIZE_CLASSES && ((PBUF_POOL_SMALL_BUFSIZE >= PBUF_POOL_BUFSIZE) || (PBUF_POOL_LARGE_BUFSIZE <= PBUF_POOL_BUFSIZE))
+#error "PBUF_POOL_SMALL_BUFSIZE must be smaller and PBUF_POOL_LARGE_BUFSIZE must be bigger than PBUF_POOL_BUFSIZE in your lwipopts.h"
+#endif
+#if PBUF_POOL_SIZE_CLASSES && (PBUF_POOL_SMALL_BUFSIZE <= (PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN + PBUF_IP_HLEN + PBUF_TRANSPORT_HLEN))
+#error "PBUF_POOL_SMALL_BUFSIZE must provide enough space for protocol headers in your lwipopts.h"
+#endif
+#if PBUF_POOL_SIZE_CLASSES && (PBUF_POOL_LARGE_BUFSIZE > 0xFFFF - 64)
+#error "PBUF_POOL_LARGE_BUFSIZE plus struct pbuf must fit into the u16_t pool element size in your lwipopts.h"
+#endif
+#if LWIP_TCPIP_BUSY_POLL && (NO_SYS || !LWIP_TIMERS)
+#error "LWIP_TCPIP_BUSY_POLL needs tcpip_thread (NO_SYS==0) and LWIP_TIMERS in your lwipopts.h"
+#endif
+#if LWIP_TCPIP_BUSY_POLL && (TCPIP_BUSY_POLL_BUDGET < 1)
+#error "TCPIP_BUSY_POLL_BUDGET must be at least 1 in your lwipopts.h"
+#endif
+#if TCPIP_STATS && !LWIP_TCPIP_BUSY_POLL
+#error "TCPIP_STATS needs LWIP_TCPIP_BUSY_POLL in your lwipopts.h"
+#endif
+#if PBUF_POOL_STATS && !PBUF_POOL_SIZE_CLASSES
+#error "PBUF_POOL_STATS needs PBUF_POOL_SIZE_CLASSES in your lwipopts.h"
+#endif
 #if (DNS_LOCAL_HOSTLIST && !DNS_LOCAL_HOSTLIST_IS_DYNAMIC && !(defined(DNS_LOCAL_HOSTLIST_INIT)))
 #error "you have to define define DNS_LOCAL_HOSTLIST_INIT {{'host1', 0x123}, {'host2', 0x234}} to initialize DNS_LOCAL_HOSTLIST"
 #endif
@@ -229,6 +301,9 @@ PACK_STRUCT_END
 #if LWIP_TCP && LWIP_NETIF_TX_SINGLE_PBUF && !TCP_OVERSIZE
 #error "LWIP_NETIF_TX_SINGLE_PBUF needs TCP_OVERSIZE enabled to create single-pbuf TCP packets"
 #endif
+#if LWIP_NETCONN_FASTPATH && !LWIP_TCPIP_CORE_LOCKING
+#error "LWIP_NETCONN_FASTPATH needs LWIP_TCPIP_CORE_LOCKING in your lwipopts.h"
+#endif
 #if LWIP_NETCONN && LWIP_TCP
 #if NETCONN_COPY != TCP_WRITE_FLAG_COPY
 #error "NETCONN_COPY != TCP_WRITE_FLAG_COPY"
@@ -288,7 +363,28 @@ PACK_STRUCT_END
 #ifdef LWIP_HOOK_MEMP_AVAILABLE
 #error "LWIP_HOOK_MEMP_AVAILABLE doesn't make sense with MEMP_MEM_MALLOC"
 #endif
+#if MEMP_CACHE
+#error "MEMP_CACHE doesn't make sense with MEMP_MEM_MALLOC"
+#endif
+#if MEMP_LOCKFREE
+#error "MEMP_LOCKFREE doesn't make sense with MEMP_MEM_MALLOC"
+#endif
 #endif /* MEMP_MEM_MALLOC */
+#if MEMP_LOCKFREE && !defined __GNUC__
+#error "MEMP_LOCKFREE needs __atomic builtins"
+#endif
+#if LWIP_PBUF_REF_ATOMIC && !defined __GNUC__ && (!defined LWIP_PBUF_REF_INC || !defined LWIP_PBUF_REF_DEC)
+#error "LWIP_PBUF_REF_ATOMIC needs __atomic builtins or LWIP_PBUF_REF_INC/LWIP_PBUF_REF_DEC defined by the port"
+#endif
+#if MEMP_LOCKFREE && MEMP_SANITY_CHECK
+#error "MEMP_SANITY_CHECK cannot walk the freelists with MEMP_LOCKFREE"
+#endif
+#if MEMP_CACHE && !defined LWIP_MEMP_THREAD_CACHE_GET
+#error "MEMP_CACHE needs LWIP_MEMP_THREAD_CACHE_GET() (see opt.h)"
+#endif
+#if MEMP_CACHE && ((MEMP_CACHE_BATCH < 1) || (MEMP_CACHE_BATCH > MEMP_CACHE_SIZE))
+#error "MEMP_CACHE_BATCH must be between 1 and MEMP_CACHE_SIZE"
+#endif
 
 /* TCP sanity checks */
 #if !LWIP_DISABLE_TCP_SANITY_CHECKS
@@ -357,6 +357,13 @@ struct mem {
   /** this keeps track of the user allocation size for guard checks */
   mem_size_t user_size;
 #endif
+#if MEM_SIZE_CLASSES
+  /** 0: heap block; MEM_CLASS_SLAB | (class + 1): heap block holding a slab;
+      class + 1: object in a slab (or'ed with MEM_CLASS_FREE while free) */
+  u8_t sclass;
+  /** index (-> ram[cnext]) of the next free object in the same slab */
+  mem_size_t cnext;
+#endif
 };
 
 /** All allocated blocks will be MIN_SIZE bytes big, at least!
@@ -509,6 +516,309 @@ plug_holes(struct mem *mem)
   }
 }
 
+#if MEM_SIZE_CLASSES
+/** the smallest size class */
+#define MEM_CLASS_MIN        16
+/** each power of two from MEM_CLASS_MIN on is split into 2 classes
+ * (16, 24, 32, 48, 64, ...), so less than 1/3 is wasted by rounding up.
+ * 23 classes are enough for MEM_SIZE_CLASS_MAX == 32768. */
+#define MEM_CLASS_STEPS      2
+#define MEM_CLASS_COUNT      23
+#define MEM_CLASS_SIZE(cls)  ((mem_size_t)LWIP_MEM_ALIGN_SIZE(((u32_t)MEM_CLASS_MIN << ((cls) / MEM_CLASS_STEPS)) + \
+                              ((cls) % MEM_CLASS_STEPS) * (((u32_t)MEM_CLASS_MIN / MEM_CLASS_STEPS) << ((cls) / MEM_CLASS_STEPS))))
+/** an object including its struct mem and overflow check regions */
+#define MEM_CLASS_OBJ_SIZE(cls) ((mem_size_t)(SIZEOF_STRUCT_MEM + MEM_CLASS_SIZE(cls) + MEM_SANITY_OVERHEAD))
+#define MEM_CLASS_FREE     0x80
+#define MEM_CLASS_SLAB       0x40
+
+/** A slab of objects of one size class. It is placed at the start of the data
+ * of a heap block and followed by the objects. All indices (-> ram[]) are
+ * MEM_SIZE_ALIGNED if unused. */
+struct mem_slab {
+  /** index of the next and previous slab of this class with free objects */
+  mem_size_t next;
+  mem_size_t prev;
+  /** index of the first free object */
+  mem_size_t free;
+  /** index of the first object that has never been allocated */
+  mem_size_t bump;
+  /** index of the end of the last object */
+  mem_size_t end;
+  /** number of allocated objects */
+  mem_size_t used;
+};
+#define SIZEOF_STRUCT_SLAB   LWIP_MEM_ALIGN_SIZE(sizeof(struct mem_slab))
+
+/** index (-> ram[]) of the first slab of each size class with free objects */
+static mem_size_t mem_class_slabs[MEM_CLASS_COUNT];
+
+/** Get the smallest size class holding 'size' bytes */
+static u8_t
+mem_class_index(mem_size_t size)
+{
+  u8_t shift = 0;
+  u32_t step;
+
+  if (size <= MEM_CLASS_MIN) {
+    return 0;
+  }
+  /* find the power of two below size... */
+  while (((u32_t)MEM_CLASS_MIN << (shift + 1)) < size) {
+    shift++;
+  }
+  /* ...and round up to the next step above it */
+  step = ((u32_t)MEM_CLASS_MIN / MEM_CLASS_STEPS) << shift;
+  return (u8_t)(shift * MEM_CLASS_STEPS + (size - ((u32_t)MEM_CLASS_MIN << shift) + step - 1) / step);
+}
+
+/** Get the data size of the heap block holding a slab of class 'cls' */
+static mem_size_t
+mem_slab_size(u8_t cls)
+{
+  mem_size_t obj_size = MEM_CLASS_OBJ_SIZE(cls);
+  return (mem_size_t)(SIZEOF_STRUCT_SLAB + MEM_SIZE_CLASS_SLAB_OBJS * obj_size);
+}
+
+/** Get the struct mem_slab in the heap block at index 'ptr' */
+static struct mem_slab *
+ptr_to_slab(mem_size_t ptr)
+{
+  return (struct mem_slab *)(void *)&ram[ptr + SIZEOF_STRUCT_MEM + MEM_SANITY_OFFSET];
+}
+
+static void
+mem_slab_link(u8_t cls, mem_size_t ptr)
+{
+  struct mem_slab *slab = ptr_to_slab(ptr);
+  slab->prev = MEM_SIZE_ALIGNED;
+  slab->next = mem_class_slabs[cls];
+  if (slab->next != MEM_SIZE_ALIGNED) {
+    ptr_to_slab(slab->next)->prev = ptr;
+  }
+  mem_class_slabs[cls] = ptr;
+}
+
+static void
+mem_slab_unlink(u8_t cls, mem_size_t ptr)
+{
+  struct mem_slab *slab = ptr_to_slab(ptr);
+  if (slab->prev != MEM_SIZE_ALIGNED) {
+    ptr_to_slab(slab->prev)->next = slab->next;
+  } else {
+    mem_class_slabs[cls] = slab->next;
+  }
+  if (slab->next != MEM_SIZE_ALIGNED) {
+    ptr_to_slab(slab->next)->prev = slab->prev;
+  }
+}
+
+/**
+ * Turn a newly allocated heap block into an empty slab of class 'cls'.
+ *
+ * This assumes access to the heap is protected by the calling function
+ * already.
+ */
+static void
+mem_slab_init(struct mem *mem, u8_t cls)
+{
+  mem_size_t ptr = mem_to_ptr(mem);
+  struct mem_slab *slab = ptr_to_slab(ptr);
+
+  mem->sclass = (u8_t)(MEM_CLASS_SLAB | (cls + 1));
+  slab->free = MEM_SIZE_ALIGNED;
+  slab->bump = (mem_size_t)(ptr + SIZEOF_STRUCT_MEM + MEM_SANITY_OFFSET + SIZEOF_STRUCT_SLAB);
+  slab->end = (mem_size_t)(ptr + SIZEOF_STRUCT_MEM + MEM_SANITY_OFFSET + mem_slab_size(cls));
+  slab->used = 0;
+  mem_slab_link(cls, ptr);
+}
+
+/**
+ * Allocate an object of class 'cls' from the first slab with free objects.
+ *
+ * @return the struct mem of the object or NULL if all slabs are full
+ *
+ * This assumes access to the heap is protected by the calling function
+ * already.
+ */
+static struct mem *
+mem_slab_alloc(u8_t cls)
+{
+  mem_size_t ptr = mem_class_slabs[cls];
+  struct mem_slab *slab;
+  struct mem *obj;
+
+  if (ptr == MEM_SIZE_ALIGNED) {
+    return NULL;
+  }
+  slab = ptr_to_slab(ptr);
+  if (slab->free != MEM_SIZE_ALIGNED) {
+    obj = ptr_to_mem(slab->free);
+    slab->free = obj->cnext;
+  } else {
+    obj = ptr_to_mem(slab->bump);
+    slab->bump = (mem_size_t)(slab->bump + MEM_CLASS_OBJ_SIZE(cls));
+    obj->prev = ptr;
+    obj->next = slab->bump;
+    obj->used = 1;
+  }
+  obj->sclass = (u8_t)(cls + 1);
+  slab->used++;
+  if ((slab->free == MEM_SIZE_ALIGNED) && (slab->bump == slab->end)) {
+    /* full: don't look at this slab until an object is freed */
+    mem_slab_unlink(cls, ptr);
+  }
+  MEM_STATS_INC_USED(used, MEM_CLASS_OBJ_SIZE(cls));
+  return obj;
+}
+
+/**
+ * Allocate the heap block for a new slab from the highest free block that is
+ * big enough, so that slabs collect at the end of the heap instead of splitting
+ * the free space below them, where the first-fit search places big blocks.
+ *
+ * @return the new heap block (not counted in the heap stats) or NULL if
+ *         no free block is big enough
+ *
+ * This assumes access to the heap is protected by the calling function
+ * already.
+ */
+static struct mem *
+mem_slab_heap_alloc(mem_size_t size)
+{
+  mem_size_t ptr, ptr2;
+  mem_size_t found = MEM_SIZE_ALIGNED;
+  struct mem *mem, *mem2;
+
+  for (ptr = mem_to_ptr(lfree); ptr < MEM_SIZE_ALIGNED; ptr = ptr_to_mem(ptr)->next) {
+    mem = ptr_to_mem(ptr);
+    if ((!mem->used) && (mem->next - (ptr + SIZEOF_STRUCT_MEM)) >= size) {
+      found = ptr;
+    }
+  }
+  if (found == MEM_SIZE_ALIGNED) {
+    return NULL;
+  }
+  mem = ptr_to_mem(found);
+  if (mem->next - (found + SIZEOF_STRUCT_MEM) >= (size + SIZEOF_STRUCT_MEM + MIN_SIZE_ALIGNED)) {
+    /* split: the slab goes to the end of the free block */
+    ptr2 = (mem_size_t)(mem->next - (SIZEOF_STRUCT_MEM + size));
+    mem2 = ptr_to_mem(ptr2);
+    mem2->used = 1;
+    mem2->next = mem->next;
+    mem2->prev = found;
+    mem->next = ptr2;
+    if (mem2->next != MEM_SIZE_ALIGNED) {
+      ptr_to_mem(mem2->next)->prev = ptr2;
+    }
+    return mem2;
+  }
+  /* near fit or exact fit: use the whole block */
+  mem->used = 1;
+  if (mem == lfree) {
+    while (lfree->used && lfree != ram_end) {
+      lfree = ptr_to_mem(lfree->next);
+    }
+  }
+  return mem;
+}
+
+/** Return the heap block of an empty slab to the heap */
+static void
+mem_slab_release(u8_t cls, mem_size_t ptr)
+{
+  struct mem *mem = ptr_to_mem(ptr);
+
+  mem_slab_unlink(cls, ptr);
+  mem->sclass = 0;
+  mem->used = 0;
+  if (mem < lfree) {
+    lfree = mem;
+  }
+  plug_holes(mem);
+}
+
+/** Check if a struct mem is an allocated object in a valid slab */
+static int
+mem_slab_obj_valid(struct mem *obj)
+{
+  mem_size_t ptr, first, obj_ptr;
+  u8_t cls;
+
+  if ((obj->sclass & (MEM_CLASS_FREE | MEM_CLASS_SLAB)) || (obj->sclass > MEM_CLASS_COUNT)) {
+    return 0;
+  }
+  cls = (u8_t)(obj->sclass - 1);
+  obj_ptr = mem_to_ptr(obj);
+  ptr = obj->prev;
+  if ((ptr >= obj_ptr) || (ptr_to_mem(ptr)->used != 1) ||
+      (ptr_to_mem(ptr)->sclass != (MEM_CLASS_SLAB | obj->sclass))) {
+    return 0;
+  }
+  first = (mem_size_t)(ptr + SIZEOF_STRUCT_MEM + MEM_SANITY_OFFSET + SIZEOF_STRUCT_SLAB);
+  if ((obj_ptr < first) || (obj_ptr >= ptr_to_slab(ptr)->bump) ||
+      (((obj_ptr - first) % MEM_CLASS_OBJ_SIZE(cls)) != 0)) {
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * Put an object back into its slab. The slab is returned to the heap when it
+ * is empty, unless it is the last slab of its class with free objects.
+ *
+ * This assumes access to the heap is protected by the calling function
+ * already.
+ */
+static void
+mem_slab_free(struct mem *obj)
+{
+  u8_t cls = (u8_t)(obj->sclass - 1);
+  mem_size_t ptr = obj->prev;
+  struct mem_slab *slab = ptr_to_slab(ptr);
+
+  if ((slab->free == MEM_SIZE_ALIGNED) && (slab->bump == slab->end)) {
+    /* was full */
+    mem_slab_link(cls, ptr);
+  }
+  obj->sclass |= MEM_CLASS_FREE;
+  obj->cnext = slab->free;
+  slab->free = mem_to_ptr(obj);
+  slab->used--;
+  MEM_STATS_DEC_USED(used, MEM_CLASS_OBJ_SIZE(cls));
+  if ((slab->used == 0) &&
+      ((slab->next != MEM_SIZE_ALIGNED) || (slab->prev != MEM_SIZE_ALIGNED))) {
+    mem_slab_release(cls, ptr);
+  }
+}
+
+/**
+ * Return all empty slabs to the heap.
+ *
+ * @return 1 if at least one slab was returned, 0 otherwise
+ *
+ * This assumes access to the heap is protected by the calling function
+ * already.
+ */
+static u8_t
+mem_slab_reclaim(void)
+{
+  u8_t cls;
+  u8_t ret = 0;
+  mem_size_t ptr, next;
+
+  for (cls = 0; cls < MEM_CLASS_COUNT; cls++) {
+    for (ptr = mem_class_slabs[cls]; ptr != MEM_SIZE_ALIGNED; ptr = next) {
+      next = ptr_to_slab(ptr)->next;
+      if (ptr_to_slab(ptr)->used == 0) {
+        mem_slab_release(cls, ptr);
+        ret = 1;
+      }
+    }
+  }
+  return ret;
+}
+#endif /* MEM_SIZE_CLASSES */
+
 /**
  * Zero the heap and initialize start, end and lowest-free
  */
@@ -537,6 +847,15 @@ mem_init(void)
   /* initialize the lowest-free pointer to the start of the heap */
   lfree = (struct mem *)(void *)ram;
 
+#if MEM_SIZE_CLASSES
+  {
+    u8_t cls;
+    for (cls = 0; cls < MEM_CLASS_COUNT; cls++) {
+      mem_class_slabs[cls] = MEM_SIZE_ALIGNED;
+    }
+  }
+#endif /* MEM_SIZE_CLASSES */
+
   MEM_STATS_AVAIL(avail, MEM_SIZE_ALIGNED);
 
   if (sys_mutex_new(&mem_mutex) != ERR_OK) {
@@ -657,6 +976,34 @@ mem_free(void *rmem)
     return;
   }
 
+#if MEM_SIZE_CLASSES
+  if (mem->sclass != 0) {
+    if (mem->sclass & MEM_CLASS_FREE) {
+      LWIP_MEM_ILLEGAL_FREE("mem_free: illegal memory: double free");
+      LWIP_MEM_FREE_UNPROTECT();
+      LWIP_DEBUGF(MEM_DEBUG | LWIP_DBG_LEVEL_SEVERE, ("mem_free: illegal memory: double free?\n"));
+      /* protect mem stats from concurrent access */
+      MEM_STATS_INC_LOCKED(illegal);
+      return;
+    }
+    if (!mem_slab_obj_valid(mem)) {
+      LWIP_MEM_ILLEGAL_FREE("mem_free: illegal memory: not in a slab");
+      LWIP_MEM_FREE_UNPROTECT();
+      LWIP_DEBUGF(MEM_DEBUG | LWIP_DBG_LEVEL_SEVERE, ("mem_free: illegal memory: not in a slab\n"));
+      /* protect mem stats from concurrent access */
+      MEM_STATS_INC_LOCKED(illegal);
+      return;
+    }
+    mem_slab_free(mem);
+    MEM_SANITY();
+#if LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT
+    mem_free_count = 1;
+#endif /* LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT */
+    LWIP_MEM_FREE_UNPROTECT();
+    return;
+  }
+#endif /* MEM_SIZE_CLASSES */
+
   if (!mem_link_valid(mem)) {
     LWIP_MEM_ILLEGAL_FREE("mem_free: illegal memory: non-linked: double free");
     LWIP_MEM_FREE_UNPROTECT();
@@ -746,6 +1093,15 @@ mem_trim(void *rmem, mem_size_t new_size)
     /* No change in size, simply return */
     return rmem;
   }
+#if MEM_SIZE_CLASSES
+  if (mem->sclass != 0) {
+    /* objects in a slab keep the size of their class */
+#if MEM_OVERFLOW_CHECK
+    mem_overflow_init_element(mem, new_size);
+#endif
+    return rmem;
+  }
+#endif /* MEM_SIZE_CLASSES */
 
   /* protect the heap from concurrent access */
   LWIP_MEM_FREE_PROTECT();
@@ -787,7 +1143,6 @@ mem_trim(void *rmem, mem_size_t new_size)
      *       region that couldn't hold data, but when mem->next gets freed,
      *       the 2 regions would be combined, resulting in more free memory */
     ptr2 = (mem_size_t)(ptr + SIZEOF_STRUCT_MEM + newsize);
-    LWIP_ASSERT("invalid next ptr", mem->next != MEM_SIZE_ALIGNED);
     mem2 = ptr_to_mem(ptr2);
     if (mem2 < lfree) {
       lfree = mem2;
@@ -835,6 +1190,9 @@ mem_malloc(mem_size_t size_in)
 #if LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT
   u8_t local_mem_free_count = 0;
 #endif /* LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT */
+#if MEM_SIZE_CLASSES
+  u8_t cls = MEM_CLASS_COUNT;
+#endif /* MEM_SIZE_CLASSES */
   LWIP_MEM_ALLOC_DECL_PROTECT();
 
   if (size_in == 0) {
@@ -848,6 +1206,14 @@ mem_malloc(mem_size_t size_in)
     /* every data block must be at least MIN_SIZE_ALIGNED long */
     size = MIN_SIZE_ALIGNED;
   }
+#if MEM_SIZE_CLASSES
+  if (size <= MEM_SIZE_CLASS_MAX) {
+    /* small objects come from a slab of their size class, the heap is
+       only searched for a new slab if all slabs of the class are full */
+    cls = mem_class_index(size);
+    size = mem_slab_size(cls);
+  }
+#endif /* MEM_SIZE_CLASSES */
 #if MEM_OVERFLOW_CHECK
   size += MEM_SANITY_REGION_BEFORE_ALIGNED + MEM_SANITY_REGION_AFTER_ALIGNED;
 #endif
@@ -858,6 +1224,40 @@ mem_malloc(mem_size_t size_in)
   /* protect the heap from concurrent access */
   sys_mutex_lock(&mem_mutex);
   LWIP_MEM_ALLOC_PROTECT();
+#if MEM_SIZE_CLASSES
+  if (cls < MEM_CLASS_COUNT) {
+    mem = mem_slab_alloc(cls);
+    if (mem == NULL) {
+      /* all slabs of this class are full, allocate a new one */
+      mem = mem_slab_heap_alloc(size);
+      if ((mem == NULL) && mem_slab_reclaim()) {
+        mem = mem_slab_heap_alloc(size);
+      }
+      if (mem != NULL) {
+#if MEM_OVERFLOW_CHECK
+        mem_overflow_init_element(mem, (mem_size_t)(size - MEM_SANITY_OVERHEAD));
+#endif
+        mem_slab_init(mem, cls);
+        mem = mem_slab_alloc(cls);
+      }
+    }
+    if (mem != NULL) {
+      LWIP_MEM_ALLOC_UNPROTECT();
+      sys_mutex_unlock(&mem_mutex);
+#if MEM_OVERFLOW_CHECK
+      mem_overflow_init_element(mem, size_in);
+#endif
+      MEM_SANITY();
+      return (u8_t *)mem + SIZEOF_STRUCT_MEM + MEM_SANITY_OFFSET;
+    }
+    MEM_STATS_INC(err);
+    LWIP_MEM_ALLOC_UNPROTECT();
+    sys_mutex_unlock(&mem_mutex);
+    LWIP_DEBUGF(MEM_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("mem_malloc: could not allocate %"S16_F" bytes\n", (s16_t)size_in));
+    return NULL;
+  }
+mem_malloc_retry:
+#endif /* MEM_SIZE_CLASSES */
 #if LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT
   /* run as long as a mem_free disturbed mem_malloc or mem_trim */
   do {
@@ -925,6 +1325,9 @@ mem_malloc(mem_size_t size_in)
           mem->used = 1;
           MEM_STATS_INC_USED(used, mem->next - mem_to_ptr(mem));
         }
+#if MEM_SIZE_CLASSES
+        mem->sclass = 0;
+#endif /* MEM_SIZE_CLASSES */
 #if LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT
 mem_malloc_adjust_lfree:
 #endif /* LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT */
@@ -968,6 +1371,12 @@ mem_malloc_adjust_lfree:
     /* if we got interrupted by a mem_free, try again */
   } while (local_mem_free_count != 0);
 #endif /* LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT */
+#if MEM_SIZE_CLASSES
+  /* out of heap: give the empty slabs back and try again */
+  if (mem_slab_reclaim()) {
+    goto mem_malloc_retry;
+  }
+#endif /* MEM_SIZE_CLASSES */
   MEM_STATS_INC(err);
   LWIP_MEM_ALLOC_UNPROTECT();
   sys_mutex_unlock(&mem_mutex);
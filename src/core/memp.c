@@ -165,6 +165,129 @@ memp_overflow_check_all(void)
 #endif /* MEMP_OVERFLOW_CHECK >= 2 */
 #endif /* MEMP_OVERFLOW_CHECK */
 
+#if MEMP_LOCKFREE
+/* The freelists are lock-free, the pool stats are updated atomically */
+#define MEMP_DECL_PROTECT(lev)
+#define MEMP_PROTECT(lev)
+#define MEMP_UNPROTECT(lev)
+
+#define MEMP_LF_OFFSET_MASK 0xFFFFFFFFUL
+#define MEMP_LF_TAG_ONE     (((u64_t)1) << 32)
+
+/** Get the first element of a freelist head */
+static struct memp *
+memp_lf_elem(const struct memp_desc *desc, u64_t head)
+{
+  u32_t off = (u32_t)(head & MEMP_LF_OFFSET_MASK);
+  if (off == 0) {
+    return NULL;
+  }
+  return (struct memp *)(void *)((u8_t *)LWIP_MEM_ALIGN(desc->base) + off - 1);
+}
+
+/** Create the freelist head replacing 'old' with 'memp' as first element */
+static u64_t
+memp_lf_head(const struct memp_desc *desc, const struct memp *memp, u64_t old)
+{
+  u64_t head = (old & ~(u64_t)MEMP_LF_OFFSET_MASK) + MEMP_LF_TAG_ONE;
+  if (memp != NULL) {
+    head |= (u32_t)((const u8_t *)memp - (u8_t *)LWIP_MEM_ALIGN(desc->base)) + 1;
+  }
+  return head;
+}
+
+/** Take the first element off a pool's freelist */
+static struct memp *
+memp_lf_pop(const struct memp_desc *desc)
+{
+  u64_t old = __atomic_load_n(desc->tab, __ATOMIC_ACQUIRE);
+  struct memp *memp;
+
+  do {
+    memp = memp_lf_elem(desc, old);
+    if (memp == NULL) {
+      return NULL;
+    }
+    /* if memp is taken (and written to) by another thread meanwhile, the
+       tag has changed and its stale 'next' is not installed */
+  } while (!__atomic_compare_exchange_n(desc->tab, &old, memp_lf_head(desc, memp->next, old),
+                                        1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+  return memp;
+}
+
+/** Put a chain of elements (linked through 'next') on a pool's freelist
+ * and return the element that was first before */
+static struct memp *
+memp_lf_push(const struct memp_desc *desc, struct memp *first, struct memp *last)
+{
+  u64_t old = __atomic_load_n(desc->tab, __ATOMIC_RELAXED);
+
+  do {
+    last->next = memp_lf_elem(desc, old);
+  } while (!__atomic_compare_exchange_n(desc->tab, &old, memp_lf_head(desc, first, old),
+                                        1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  return last->next;
+}
+#else /* MEMP_LOCKFREE */
+#define MEMP_DECL_PROTECT(lev) SYS_ARCH_DECL_PROTECT(lev)
+#define MEMP_PROTECT(lev)      SYS_ARCH_PROTECT(lev)
+#define MEMP_UNPROTECT(lev)    SYS_ARCH_UNPROTECT(lev)
+#endif /* MEMP_LOCKFREE */
+
+#if MEMP_STATS
+/** Count n elements taken from a pool and a failed allocation if 'failed'.
+ * Called with the pool protected unless MEMP_LOCKFREE. */
+static void
+memp_stats_taken(const struct memp_desc *desc, mem_size_t n, int failed)
+{
+#if MEMP_LOCKFREE
+  mem_size_t used = __atomic_add_fetch(&desc->stats->used, n, __ATOMIC_RELAXED);
+  mem_size_t max = __atomic_load_n(&desc->stats->max, __ATOMIC_RELAXED);
+
+  while ((used > max) &&
+         !__atomic_compare_exchange_n(&desc->stats->max, &max, used, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+  if (failed) {
+    __atomic_add_fetch(&desc->stats->err, 1, __ATOMIC_RELAXED);
+  }
+#else /* MEMP_LOCKFREE */
+  desc->stats->used = (mem_size_t)(desc->stats->used + n);
+  if (desc->stats->used > desc->stats->max) {
+    desc->stats->max = desc->stats->used;
+  }
+  if (failed) {
+    desc->stats->err++;
+  }
+#endif /* MEMP_LOCKFREE */
+}
+
+/** Count n elements returned to a pool */
+static void
+memp_stats_returned(const struct memp_desc *desc, mem_size_t n)
+{
+#if MEMP_LOCKFREE
+  __atomic_sub_fetch(&desc->stats->used, n, __ATOMIC_RELAXED);
+#else /* MEMP_LOCKFREE */
+  desc->stats->used = (mem_size_t)(desc->stats->used - n);
+#endif /* MEMP_LOCKFREE */
+}
+
+#if MEMP_CACHE
+/** Move the hit/miss counts of a thread cache to the pool stats */
+static void
+memp_stats_cache(const struct memp_desc *desc, STAT_COUNTER hit, STAT_COUNTER miss)
+{
+#if MEMP_LOCKFREE
+  __atomic_add_fetch(&desc->stats->cache_hit, hit, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&desc->stats->cache_miss, miss, __ATOMIC_RELAXED);
+#else /* MEMP_LOCKFREE */
+  desc->stats->cache_hit += hit;
+  desc->stats->cache_miss += miss;
+#endif /* MEMP_LOCKFREE */
+}
+#endif /* MEMP_CACHE */
+#endif /* MEMP_STATS */
+
 /**
  * Initialize custom memory pool.
  * Related functions: memp_malloc_pool, memp_free_pool
@@ -179,8 +302,8 @@ memp_init_pool(const struct memp_desc *desc)
 #else
   int i;
   struct memp *memp;
+  struct memp *first = NULL;
 
-  *desc->tab = NULL;
   memp = (struct memp *)LWIP_MEM_ALIGN(desc->base);
 #if MEMP_MEM_INIT
   /* force memset on pool memory */
@@ -192,8 +315,8 @@ memp_init_pool(const struct memp_desc *desc)
 #endif
   /* create a linked list of memp elements */
   for (i = 0; i < desc->num; ++i) {
-    memp->next = *desc->tab;
-    *desc->tab = memp;
+    memp->next = first;
+    first = memp;
 #if MEMP_OVERFLOW_CHECK
     memp_overflow_init_element(memp, desc);
 #endif /* MEMP_OVERFLOW_CHECK */
@@ -204,6 +327,11 @@ memp_init_pool(const struct memp_desc *desc)
 #endif
                                   );
   }
+#if MEMP_LOCKFREE
+  __atomic_store_n(desc->tab, memp_lf_head(desc, first, 0), __ATOMIC_SEQ_CST);
+#else /* MEMP_LOCKFREE */
+  *desc->tab = first;
+#endif /* MEMP_LOCKFREE */
 #if MEMP_STATS
   desc->stats->avail = desc->num;
 #endif /* MEMP_STATS */
@@ -248,15 +376,19 @@ do_memp_malloc_pool_fn(const struct memp_desc *desc, const char *file, const int
 #endif
 {
   struct memp *memp;
-  SYS_ARCH_DECL_PROTECT(old_level);
+  MEMP_DECL_PROTECT(old_level);
 
 #if MEMP_MEM_MALLOC
   memp = (struct memp *)mem_malloc(MEMP_SIZE + MEMP_ALIGN_SIZE(desc->size));
-  SYS_ARCH_PROTECT(old_level);
+  MEMP_PROTECT(old_level);
 #else /* MEMP_MEM_MALLOC */
-  SYS_ARCH_PROTECT(old_level);
+  MEMP_PROTECT(old_level);
 
+#if MEMP_LOCKFREE
+  memp = memp_lf_pop(desc);
+#else /* MEMP_LOCKFREE */
   memp = *desc->tab;
+#endif /* MEMP_LOCKFREE */
 #endif /* MEMP_MEM_MALLOC */
 
   if (memp != NULL) {
@@ -265,7 +397,9 @@ do_memp_malloc_pool_fn(const struct memp_desc *desc, const char *file, const int
     memp_overflow_check_element(memp, desc);
 #endif /* MEMP_OVERFLOW_CHECK */
 
+#if !MEMP_LOCKFREE
     *desc->tab = memp->next;
+#endif /* !MEMP_LOCKFREE */
 #if MEMP_OVERFLOW_CHECK
     memp->next = NULL;
 #endif /* MEMP_OVERFLOW_CHECK */
@@ -280,19 +414,16 @@ do_memp_malloc_pool_fn(const struct memp_desc *desc, const char *file, const int
     LWIP_ASSERT("memp_malloc: memp properly aligned",
                 ((mem_ptr_t)memp % MEM_ALIGNMENT) == 0);
 #if MEMP_STATS
-    desc->stats->used++;
-    if (desc->stats->used > desc->stats->max) {
-      desc->stats->max = desc->stats->used;
-    }
+    memp_stats_taken(desc, 1, 0);
 #endif
-    SYS_ARCH_UNPROTECT(old_level);
+    MEMP_UNPROTECT(old_level);
     /* cast through u8_t* to get rid of alignment warnings */
     return ((u8_t *)memp + MEMP_SIZE);
   } else {
 #if MEMP_STATS
-    desc->stats->err++;
+    memp_stats_taken(desc, 0, 1);
 #endif
-    SYS_ARCH_UNPROTECT(old_level);
+    MEMP_UNPROTECT(old_level);
     LWIP_DEBUGF(MEMP_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("memp_malloc: out of memory in pool %s\n", desc->desc));
   }
 
@@ -325,6 +456,206 @@ memp_malloc_pool_fn(const struct memp_desc *desc, const char *file, const int li
 #endif
 }
 
+#if MEMP_CACHE
+/** Only pools that are large compared to a cache are cached, so that the
+ * elements of small pools are not stranded in idle threads */
+#define MEMP_CACHED(desc) ((desc)->num >= 4 * MEMP_CACHE_SIZE)
+
+/**
+ * Initialize an empty thread cache.
+ *
+ * @param cache the cache of a new thread
+ */
+void
+memp_cache_init(struct memp_cache *cache)
+{
+  memset(cache, 0, sizeof(struct memp_cache));
+}
+
+/**
+ * Move up to MEMP_CACHE_BATCH elements from a pool to an empty thread cache.
+ */
+static void
+memp_cache_refill(struct memp_cache *cache, memp_t type)
+{
+  const struct memp_desc *desc = memp_pools[type];
+  struct memp *first, *last;
+  u16_t n = 0;
+  MEMP_DECL_PROTECT(old_level);
+
+  MEMP_PROTECT(old_level);
+#if MEMP_LOCKFREE
+  first = last = memp_lf_pop(desc);
+  if (first != NULL) {
+    for (n = 1; n < MEMP_CACHE_BATCH; n++) {
+      last->next = memp_lf_pop(desc);
+      if (last->next == NULL) {
+        break;
+      }
+      last = last->next;
+    }
+    last->next = NULL;
+  }
+#else /* MEMP_LOCKFREE */
+  first = last = *desc->tab;
+  if (first != NULL) {
+    for (n = 1; (n < MEMP_CACHE_BATCH) && (last->next != NULL); n++) {
+      last = last->next;
+    }
+    *desc->tab = last->next;
+    last->next = NULL;
+  }
+#endif /* MEMP_LOCKFREE */
+#if MEMP_STATS
+  memp_stats_taken(desc, n, n == 0);
+  memp_stats_cache(desc, cache->hit[type], cache->miss[type] + 1);
+  cache->hit[type] = 0;
+  cache->miss[type] = 0;
+#endif /* MEMP_STATS */
+  MEMP_UNPROTECT(old_level);
+
+  cache->free[type] = first;
+  cache->count[type] = n;
+  if (n == 0) {
+    LWIP_DEBUGF(MEMP_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("memp_malloc: out of memory in pool %s\n", desc->desc));
+  }
+}
+
+/**
+ * Move the first n elements of a thread cache back to their pool.
+ */
+static void
+memp_cache_drain(struct memp_cache *cache, memp_t type, u16_t n)
+{
+  const struct memp_desc *desc = memp_pools[type];
+  struct memp *first, *last;
+  u16_t i;
+#ifdef LWIP_HOOK_MEMP_AVAILABLE
+  struct memp *old_first;
+#endif
+  MEMP_DECL_PROTECT(old_level);
+
+  /* unlink the elements before locking the pool */
+  first = last = cache->free[type];
+  if (n > 0) {
+    for (i = 1; i < n; i++) {
+      last = last->next;
+    }
+    cache->free[type] = last->next;
+    cache->count[type] = (u16_t)(cache->count[type] - n);
+  }
+
+  MEMP_PROTECT(old_level);
+#if MEMP_LOCKFREE
+#ifdef LWIP_HOOK_MEMP_AVAILABLE
+  old_first = memp_lf_elem(desc, __atomic_load_n(desc->tab, __ATOMIC_SEQ_CST));
+#endif
+  if (n > 0) {
+    memp_lf_push(desc, first, last);
+  }
+#else /* MEMP_LOCKFREE */
+#ifdef LWIP_HOOK_MEMP_AVAILABLE
+  old_first = *desc->tab;
+#endif
+  if (n > 0) {
+    last->next = *desc->tab;
+    *desc->tab = first;
+  }
+#endif /* MEMP_LOCKFREE */
+#if MEMP_STATS
+  memp_stats_returned(desc, n);
+  memp_stats_cache(desc, cache->hit[type], cache->miss[type]);
+  cache->hit[type] = 0;
+  cache->miss[type] = 0;
+#endif /* MEMP_STATS */
+#if MEMP_SANITY_CHECK
+  LWIP_ASSERT("memp sanity", memp_sanity(desc));
+#endif /* MEMP_SANITY_CHECK */
+  MEMP_UNPROTECT(old_level);
+
+#ifdef LWIP_HOOK_MEMP_AVAILABLE
+  if ((old_first == NULL) && (n > 0)) {
+    LWIP_HOOK_MEMP_AVAILABLE(type);
+  }
+#endif
+}
+
+/**
+ * Return all elements of a thread cache to their pools (and add its hits
+ * and misses to the pool stats). Call this before a thread exits.
+ *
+ * @param cache the cache to empty
+ */
+void
+memp_cache_flush(struct memp_cache *cache)
+{
+  u16_t i;
+
+  for (i = 0; i < MEMP_MAX; i++) {
+    memp_cache_drain(cache, (memp_t)i, cache->count[i]);
+  }
+}
+
+static void *
+#if !MEMP_OVERFLOW_CHECK
+memp_cache_malloc(struct memp_cache *cache, memp_t type)
+#else
+memp_cache_malloc_fn(struct memp_cache *cache, memp_t type, const char *file, const int line)
+#endif
+{
+  struct memp *memp;
+
+  if (cache->count[type] == 0) {
+    memp_cache_refill(cache, type);
+    if (cache->count[type] == 0) {
+      return NULL;
+    }
+  }
+#if MEMP_STATS
+  else {
+    cache->hit[type]++;
+  }
+#endif /* MEMP_STATS */
+  memp = cache->free[type];
+  cache->free[type] = memp->next;
+  cache->count[type]--;
+#if MEMP_OVERFLOW_CHECK
+#if MEMP_OVERFLOW_CHECK == 1
+  memp_overflow_check_element(memp, memp_pools[type]);
+#endif /* MEMP_OVERFLOW_CHECK == 1 */
+  memp->next = NULL;
+  memp->file = file;
+  memp->line = line;
+#endif /* MEMP_OVERFLOW_CHECK */
+  LWIP_ASSERT("memp_malloc: memp properly aligned",
+              ((mem_ptr_t)memp % MEM_ALIGNMENT) == 0);
+  /* cast through u8_t* to get rid of alignment warnings */
+  return ((u8_t *)memp + MEMP_SIZE);
+}
+
+static void
+memp_cache_free(struct memp_cache *cache, memp_t type, void *mem)
+{
+  struct memp *memp;
+
+  LWIP_ASSERT("memp_free: mem properly aligned",
+              ((mem_ptr_t)mem % MEM_ALIGNMENT) == 0);
+
+  /* cast through void* to get rid of alignment warnings */
+  memp = (struct memp *)(void *)((u8_t *)mem - MEMP_SIZE);
+#if MEMP_OVERFLOW_CHECK == 1
+  memp_overflow_check_element(memp, memp_pools[type]);
+#endif /* MEMP_OVERFLOW_CHECK */
+
+  if (cache->count[type] >= MEMP_CACHE_SIZE) {
+    memp_cache_drain(cache, type, MEMP_CACHE_BATCH);
+  }
+  memp->next = cache->free[type];
+  cache->free[type] = memp;
+  cache->count[type]++;
+}
+#endif /* MEMP_CACHE */
+
 /**
  * Get an element from a specific pool.
  *
@@ -340,12 +671,26 @@ memp_malloc_fn(memp_t type, const char *file, const int line)
 #endif
 {
   void *memp;
+#if MEMP_CACHE
+  struct memp_cache *cache;
+#endif /* MEMP_CACHE */
   LWIP_ERROR("memp_malloc: type < MEMP_MAX", (type < MEMP_MAX), return NULL;);
 
 #if MEMP_OVERFLOW_CHECK >= 2
   memp_overflow_check_all();
 #endif /* MEMP_OVERFLOW_CHECK >= 2 */
 
+#if MEMP_CACHE
+  cache = LWIP_MEMP_THREAD_CACHE_GET();
+  if ((cache != NULL) && MEMP_CACHED(memp_pools[type])) {
+#if !MEMP_OVERFLOW_CHECK
+    return memp_cache_malloc(cache, type);
+#else
+    return memp_cache_malloc_fn(cache, type, file, line);
+#endif
+  }
+#endif /* MEMP_CACHE */
+
 #if !MEMP_OVERFLOW_CHECK
   memp = do_memp_malloc_pool(memp_pools[type]);
 #else
@@ -355,11 +700,91 @@ memp_malloc_fn(memp_t type, const char *file, const int line)
   return memp;
 }
 
+/**
+ * Get up to n elements from a specific pool, locking the pool only once.
+ *
+ * @param type the pool to get the elements from
+ * @param v array receiving the elements
+ * @param n number of elements wanted
+ *
+ * @return the number of elements stored to v (less than n if the pool
+ *         ran empty)
+ */
+u16_t
+memp_malloc_bulk(memp_t type, void **v, u16_t n)
+{
+  u16_t i;
+#if !MEMP_MEM_MALLOC && !MEMP_OVERFLOW_CHECK
+  const struct memp_desc *desc;
+  struct memp *memp;
+#if MEMP_CACHE
+  struct memp_cache *cache;
+#endif /* MEMP_CACHE */
+  MEMP_DECL_PROTECT(old_level);
+#endif /* !MEMP_MEM_MALLOC && !MEMP_OVERFLOW_CHECK */
+
+  LWIP_ERROR("memp_malloc_bulk: type < MEMP_MAX", (type < MEMP_MAX), return 0;);
+  LWIP_ERROR("memp_malloc_bulk: invalid array", (v != NULL) || (n == 0), return 0;);
+
+#if MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK
+  /* every element is allocated (or checked) on its own anyway */
+  for (i = 0; i < n; i++) {
+    v[i] = memp_malloc(type);
+    if (v[i] == NULL) {
+      break;
+    }
+  }
+  return i;
+#else /* MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK */
+  desc = memp_pools[type];
+#if MEMP_CACHE
+  cache = LWIP_MEMP_THREAD_CACHE_GET();
+  if ((cache != NULL) && MEMP_CACHED(desc)) {
+    for (i = 0; i < n; i++) {
+      v[i] = memp_cache_malloc(cache, type);
+      if (v[i] == NULL) {
+        break;
+      }
+    }
+    return i;
+  }
+#endif /* MEMP_CACHE */
+
+  MEMP_PROTECT(old_level);
+  for (i = 0; i < n; i++) {
+#if MEMP_LOCKFREE
+    memp = memp_lf_pop(desc);
+#else /* MEMP_LOCKFREE */
+    memp = *desc->tab;
+#endif /* MEMP_LOCKFREE */
+    if (memp == NULL) {
+      break;
+    }
+#if !MEMP_LOCKFREE
+    *desc->tab = memp->next;
+#endif /* !MEMP_LOCKFREE */
+    LWIP_ASSERT("memp_malloc: memp properly aligned",
+                ((mem_ptr_t)memp % MEM_ALIGNMENT) == 0);
+    /* cast through u8_t* to get rid of alignment warnings */
+    v[i] = ((u8_t *)memp + MEMP_SIZE);
+  }
+#if MEMP_STATS
+  memp_stats_taken(desc, i, i < n);
+#endif /* MEMP_STATS */
+  MEMP_UNPROTECT(old_level);
+
+  if (i < n) {
+    LWIP_DEBUGF(MEMP_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("memp_malloc: out of memory in pool %s\n", desc->desc));
+  }
+  return i;
+#endif /* MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK */
+}
+
 static void
 do_memp_free_pool(const struct memp_desc *desc, void *mem)
 {
   struct memp *memp;
-  SYS_ARCH_DECL_PROTECT(old_level);
+  MEMP_DECL_PROTECT(old_level);
 
   LWIP_ASSERT("memp_free: mem properly aligned",
               ((mem_ptr_t)mem % MEM_ALIGNMENT) == 0);
@@ -367,29 +792,33 @@ do_memp_free_pool(const struct memp_desc *desc, void *mem)
   /* cast through void* to get rid of alignment warnings */
   memp = (struct memp *)(void *)((u8_t *)mem - MEMP_SIZE);
 
-  SYS_ARCH_PROTECT(old_level);
+  MEMP_PROTECT(old_level);
 
 #if MEMP_OVERFLOW_CHECK == 1
   memp_overflow_check_element(memp, desc);
 #endif /* MEMP_OVERFLOW_CHECK */
 
 #if MEMP_STATS
-  desc->stats->used--;
+  memp_stats_returned(desc, 1);
 #endif
 
 #if MEMP_MEM_MALLOC
   LWIP_UNUSED_ARG(desc);
-  SYS_ARCH_UNPROTECT(old_level);
+  MEMP_UNPROTECT(old_level);
   mem_free(memp);
 #else /* MEMP_MEM_MALLOC */
+#if MEMP_LOCKFREE
+  memp_lf_push(desc, memp, memp);
+#else /* MEMP_LOCKFREE */
   memp->next = *desc->tab;
   *desc->tab = memp;
+#endif /* MEMP_LOCKFREE */
 
 #if MEMP_SANITY_CHECK
   LWIP_ASSERT("memp sanity", memp_sanity(desc));
 #endif /* MEMP_SANITY_CHECK */
 
-  SYS_ARCH_UNPROTECT(old_level);
+  MEMP_UNPROTECT(old_level);
 #endif /* !MEMP_MEM_MALLOC */
 }
 
@@ -422,6 +851,9 @@ memp_free(memp_t type, void *mem)
 #ifdef LWIP_HOOK_MEMP_AVAILABLE
   struct memp *old_first;
 #endif
+#if MEMP_CACHE
+  struct memp_cache *cache;
+#endif /* MEMP_CACHE */
 
   LWIP_ERROR("memp_free: type < MEMP_MAX", (type < MEMP_MAX), return;);
 
@@ -433,8 +865,20 @@ memp_free(memp_t type, void *mem)
   memp_overflow_check_all();
 #endif /* MEMP_OVERFLOW_CHECK >= 2 */
 
+#if MEMP_CACHE
+  cache = LWIP_MEMP_THREAD_CACHE_GET();
+  if ((cache != NULL) && MEMP_CACHED(memp_pools[type])) {
+    memp_cache_free(cache, type, mem);
+    return;
+  }
+#endif /* MEMP_CACHE */
+
 #ifdef LWIP_HOOK_MEMP_AVAILABLE
+#if MEMP_LOCKFREE
+  old_first = memp_lf_elem(memp_pools[type], __atomic_load_n(memp_pools[type]->tab, __ATOMIC_SEQ_CST));
+#else /* MEMP_LOCKFREE */
   old_first = *memp_pools[type]->tab;
+#endif /* MEMP_LOCKFREE */
 #endif
 
   do_memp_free_pool(memp_pools[type], mem);
@@ -445,3 +889,96 @@ memp_free(memp_t type, void *mem)
   }
 #endif
 }
+
+/**
+ * Put n elements back into their pool, locking the pool only once.
+ *
+ * @param type the pool where to put the elements
+ * @param v the elements to free (NULL entries are skipped)
+ * @param n number of entries in v
+ */
+void
+memp_free_bulk(memp_t type, void **v, u16_t n)
+{
+  u16_t i;
+#if !MEMP_MEM_MALLOC && !MEMP_OVERFLOW_CHECK
+  const struct memp_desc *desc;
+  struct memp *first, *last, *old_first;
+  u16_t count;
+#if MEMP_CACHE
+  struct memp_cache *cache;
+#endif /* MEMP_CACHE */
+  MEMP_DECL_PROTECT(old_level);
+#endif /* !MEMP_MEM_MALLOC && !MEMP_OVERFLOW_CHECK */
+
+  LWIP_ERROR("memp_free_bulk: type < MEMP_MAX", (type < MEMP_MAX), return;);
+  LWIP_ERROR("memp_free_bulk: invalid array", (v != NULL) || (n == 0), return;);
+
+#if MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK
+  for (i = 0; i < n; i++) {
+    memp_free(type, v[i]);
+  }
+#else /* MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK */
+  desc = memp_pools[type];
+#if MEMP_CACHE
+  cache = LWIP_MEMP_THREAD_CACHE_GET();
+  if ((cache != NULL) && MEMP_CACHED(desc)) {
+    for (i = 0; i < n; i++) {
+      if (v[i] != NULL) {
+        memp_cache_free(cache, type, v[i]);
+      }
+    }
+    return;
+  }
+#endif /* MEMP_CACHE */
+
+  /* link the elements before locking the pool */
+  first = last = NULL;
+  count = 0;
+  for (i = 0; i < n; i++) {
+    struct memp *memp;
+    if (v[i] == NULL) {
+      continue;
+    }
+    LWIP_ASSERT("memp_free: mem properly aligned",
+                ((mem_ptr_t)v[i] % MEM_ALIGNMENT) == 0);
+    /* cast through void* to get rid of alignment warnings */
+    memp = (struct memp *)(void *)((u8_t *)v[i] - MEMP_SIZE);
+    if (last == NULL) {
+      last = memp;
+    }
+    memp->next = first;
+    first = memp;
+    count++;
+  }
+  if (first == NULL) {
+    return;
+  }
+
+  MEMP_PROTECT(old_level);
+#if MEMP_LOCKFREE
+  old_first = memp_lf_push(desc, first, last);
+#else /* MEMP_LOCKFREE */
+  old_first = *desc->tab;
+  last->next = old_first;
+  *desc->tab = first;
+#endif /* MEMP_LOCKFREE */
+#if MEMP_STATS
+  memp_stats_returned(desc, count);
+#else /* MEMP_STATS */
+  LWIP_UNUSED_ARG(count);
+#endif /* MEMP_STATS */
+#if MEMP_SANITY_CHECK
+  LWIP_ASSERT("memp sanity", memp_sanity(desc));
+#endif /* MEMP_SANITY_CHECK */
+  MEMP_UNPROTECT(old_level);
+
+#ifdef LWIP_HOOK_MEMP_AVAILABLE
+  if (old_first == NULL) {
+    LWIP_HOOK_MEMP_AVAILABLE(type);
+  }
+#else /* LWIP_HOOK_MEMP_AVAILABLE */
+  LWIP_UNUSED_ARG(old_first);
+#endif /* LWIP_HOOK_MEMP_AVAILABLE */
+#endif /* MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK */
+}
@@ -240,6 +240,47 @@ netif_input(struct pbuf *p, struct netif *inp)
     return ip_input(p, inp);
 }
 
+#if LWIP_NETIF_LINKOUTPUT_SG
+/**
+ * @ingroup netif
+ * Send a link layer frame with netif->linkoutput_sg if the driver has set it,
+ * else with netif->linkoutput.
+ * Frames of more than LWIP_NETIF_SG_MAX_IOV pieces are always passed to
+ * netif->linkoutput, which drivers must provide in any case.
+ *
+ * @param netif the lwIP network interface on which to send the frame
+ * @param p the frame to send (the caller keeps its reference)
+ */
+err_t
+netif_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  struct netif_iovec iov[LWIP_NETIF_SG_MAX_IOV];
+  struct pbuf *q;
+  u16_t iovcnt = 0;
+
+  LWIP_ASSERT("netif_linkoutput: invalid netif", netif != NULL);
+  LWIP_ASSERT("netif_linkoutput: invalid pbuf", p != NULL);
+
+  if (netif->linkoutput_sg != NULL) {
+    for (q = p; q != NULL; q = q->next) {
+      if (q->len == 0) {
+        continue;
+      }
+      if (iovcnt == LWIP_NETIF_SG_MAX_IOV) {
+        break;
+      }
+      iov[iovcnt].base = q->payload;
+      iov[iovcnt].len = q->len;
+      iovcnt++;
+    }
+    if ((q == NULL) && (iovcnt > 0)) {
+      return netif->linkoutput_sg(netif, iov, iovcnt, p);
+    }
+  }
+  return netif->linkoutput(netif, p);
+}
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
+
 /**
  * @ingroup netif
  * Add a network interface to the list of lwIP netifs.
@@ -334,6 +375,12 @@ netif_add(struct netif *netif,
   }
   netif->output_ip6 = netif_null_output_ip6;
 #endif /* LWIP_IPV6 */
+#if LWIP_NETIF_LINKOUTPUT_SG
+  netif->linkoutput_sg = NULL;
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
+#if LWIP_TCPIP_BUSY_POLL
+  netif->rx_poll = NULL;
+#endif /* LWIP_TCPIP_BUSY_POLL */
   NETIF_SET_CHECKSUM_CTRL(netif, NETIF_CHECKSUM_ENABLE_ALL);
   netif->mtu = 0;
   netif->flags = 0;
@@ -1090,6 +1137,9 @@ netif_set_link_callback(struct netif *netif, netif_status_callback_fn link_callb
 #endif /* LWIP_NETIF_LINK_CALLBACK */
 
 #if ENABLE_LOOPBACK
+/** Number of undeliverable packets netif_poll() frees per batch */
+#define NETIF_POLL_FREE_BATCH 8
+
 /**
  * @ingroup netif
  * Send an IP packet to be received on the same netif (loopif-like).
@@ -1241,50 +1291,61 @@ netif_poll(struct netif *netif)
 
   LWIP_ASSERT("netif_poll: invalid netif", netif != NULL);
 
-  /* Get a packet from the list. With SYS_LIGHTWEIGHT_PROT=1, this is protected */
+  /* Take all queued packets off the list at once. With SYS_LIGHTWEIGHT_PROT=1,
+     this is protected */
   SYS_ARCH_PROTECT(lev);
   while (netif->loop_first != NULL) {
-    struct pbuf *in, *in_end;
+    struct pbuf *in, *in_end, *next;
+    struct pbuf *drop[NETIF_POLL_FREE_BATCH];
+    u16_t ndrop = 0;
+
+    next = netif->loop_first;
+    netif->loop_first = netif->loop_last = NULL;
+    SYS_ARCH_UNPROTECT(lev);
+
+    while (next != NULL) {
 #if LWIP_LOOPBACK_MAX_PBUFS
-    u8_t clen = 1;
+      u8_t clen = 1;
 #endif /* LWIP_LOOPBACK_MAX_PBUFS */
 
-    in = in_end = netif->loop_first;
-    while (in_end->len != in_end->tot_len) {
-      LWIP_ASSERT("bogus pbuf: len != tot_len but next == NULL!", in_end->next != NULL);
-      in_end = in_end->next;
+      in = in_end = next;
+      while (in_end->len != in_end->tot_len) {
+        LWIP_ASSERT("bogus pbuf: len != tot_len but next == NULL!", in_end->next != NULL);
+        in_end = in_end->next;
 #if LWIP_LOOPBACK_MAX_PBUFS
-      clen++;
+        clen++;
 #endif /* LWIP_LOOPBACK_MAX_PBUFS */
-    }
+      }
 #if LWIP_LOOPBACK_MAX_PBUFS
-    /* adjust the number of pbufs on queue */
-    LWIP_ASSERT("netif->loop_cnt_current underflow",
-                ((netif->loop_cnt_current - clen) < netif->loop_cnt_current));
-    netif->loop_cnt_current = (u16_t)(netif->loop_cnt_current - clen);
+      /* adjust the number of pbufs on queue: packets of the batch count
+         against LWIP_LOOPBACK_MAX_PBUFS until they are dequeued here */
+      SYS_ARCH_PROTECT(lev);
+      LWIP_ASSERT("netif->loop_cnt_current underflow",
+                  ((netif->loop_cnt_current - clen) < netif->loop_cnt_current));
+      netif->loop_cnt_current = (u16_t)(netif->loop_cnt_current - clen);
+      SYS_ARCH_UNPROTECT(lev);
 #endif /* LWIP_LOOPBACK_MAX_PBUFS */
-
-    /* 'in_end' now points to the last pbuf from 'in' */
-    if (in_end == netif->loop_last) {
-      /* this was the last pbuf in the list */
-      netif->loop_first = netif->loop_last = NULL;
-    } else {
-      /* pop the pbuf off the list */
-      netif->loop_first = in_end->next;
-      LWIP_ASSERT("should not be null since first != last!", netif->loop_first != NULL);
+      /* 'in_end' now points to the last pbuf from 'in':
+         de-queue the packet from its successors on the list. */
+      next = in_end->next;
+      in_end->next = NULL;
+
+      in->if_idx = netif_get_index(netif);
+
+      LINK_STATS_INC(link.recv);
+      MIB2_STATS_NETIF_ADD(stats_if, ifinoctets, in->tot_len);
+      MIB2_STATS_NETIF_INC(stats_if, ifinucastpkts);
+      /* loopback packets are always IP packets! */
+      if (ip_input(in, netif) != ERR_OK) {
+        drop[ndrop++] = in;
+        if (ndrop == NETIF_POLL_FREE_BATCH) {
+          pbuf_free_batch(drop, ndrop);
+          ndrop = 0;
+        }
+      }
     }
-    /* De-queue the pbuf from its successors on the 'loop_' list. */
-    in_end->next = NULL;
-    SYS_ARCH_UNPROTECT(lev);
-
-    in->if_idx = netif_get_index(netif);
-
-    LINK_STATS_INC(link.recv);
-    MIB2_STATS_NETIF_ADD(stats_if, ifinoctets, in->tot_len);
-    MIB2_STATS_NETIF_INC(stats_if, ifinucastpkts);
-    /* loopback packets are always IP packets! */
-    if (ip_input(in, netif) != ERR_OK) {
-      pbuf_free(in);
+    if (ndrop > 0) {
+      pbuf_free_batch(drop, ndrop);
     }
     SYS_ARCH_PROTECT(lev);
   }
@@ -87,6 +87,22 @@
 #include <string.h>
 
 #define SIZEOF_STRUCT_PBUF        LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf))
+/** Number of pool elements pbuf_alloc_bulk() and pbuf_free_batch() move
+    to/from memp per pool lock */
+#define PBUF_BULK_BATCH           16
+
+#if LWIP_PBUF_REF_ATOMIC
+#ifndef LWIP_PBUF_REF_INC
+/** Atomically increment p->ref and return the new count */
+#define LWIP_PBUF_REF_INC(p)      __atomic_add_fetch(&(p)->ref, 1, __ATOMIC_RELAXED)
+#endif
+#ifndef LWIP_PBUF_REF_DEC
+/** Atomically decrement p->ref and return the new count. Needs acquire/release
+    ordering so the thread freeing the pbuf sees all writes done through the
+    other references. */
+#define LWIP_PBUF_REF_DEC(p)      __atomic_sub_fetch(&(p)->ref, 1, __ATOMIC_ACQ_REL)
+#endif
+#endif /* LWIP_PBUF_REF_ATOMIC */
 /* Since the pool is created in memp, PBUF_POOL_BUFSIZE will be automatically
    aligned there. Therefore, PBUF_POOL_BUFSIZE_ALIGNED can be used here. */
 #define PBUF_POOL_BUFSIZE_ALIGNED LWIP_MEM_ALIGN_SIZE(PBUF_POOL_BUFSIZE)
@@ -188,6 +204,150 @@ pbuf_init_alloced_pbuf(struct pbuf *p, void *payload, u16_t tot_len, u16_t len,
   p->if_idx = NETIF_NO_INDEX;
 }
 
+#if PBUF_POOL_SIZE_CLASSES
+/** Pool, aligned buffer size and allocation source of a PBUF_POOL size class */
+struct pbuf_pool_class_desc {
+  memp_t pool;
+  u16_t bufsize;
+  u8_t alloc_src;
+};
+
+static const struct pbuf_pool_class_desc pbuf_pool_classes[PBUF_POOL_CLASS_COUNT] = {
+  { MEMP_PBUF_POOL_SMALL, LWIP_MEM_ALIGN_SIZE(PBUF_POOL_SMALL_BUFSIZE), PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_SMALL },
+  { MEMP_PBUF_POOL,       PBUF_POOL_BUFSIZE_ALIGNED,                    PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL },
+  { MEMP_PBUF_POOL_LARGE, LWIP_MEM_ALIGN_SIZE(PBUF_POOL_LARGE_BUFSIZE), PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_LARGE }
+};
+#endif /* PBUF_POOL_SIZE_CLASSES */
+
+/** Allocate a PBUF_POOL chain for 'length' bytes behind 'offset' header bytes
+ * from one memp pool whose elements carry 'bufsize' bytes of buffer.
+ * 'alloc_src' replaces the allocation source bits of PBUF_POOL.
+ * The caller reports an empty pool (PBUF_POOL_IS_EMPTY) if this fails.
+ */
+static struct pbuf *
+pbuf_alloc_pool_chain(u16_t offset, u16_t length, memp_t pool, u16_t bufsize, u8_t alloc_src)
+{
+  struct pbuf *p, *q, *last;
+  u16_t rem_len; /* remaining length */
+  pbuf_type type = (pbuf_type)((PBUF_POOL & ~PBUF_TYPE_ALLOC_SRC_MASK) | alloc_src);
+
+  p = NULL;
+  last = NULL;
+  rem_len = length;
+  do {
+    u16_t qlen;
+    q = (struct pbuf *)memp_malloc(pool);
+    if (q == NULL) {
+      /* free chain so far allocated */
+      if (p) {
+        pbuf_free(p);
+      }
+      /* bail out unsuccessfully */
+      return NULL;
+    }
+    qlen = LWIP_MIN(rem_len, (u16_t)(bufsize - LWIP_MEM_ALIGN_SIZE(offset)));
+    pbuf_init_alloced_pbuf(q, LWIP_MEM_ALIGN((void *)((u8_t *)q + SIZEOF_STRUCT_PBUF + offset)),
+                           rem_len, qlen, type, 0);
+    LWIP_ASSERT("pbuf_alloc: pbuf q->payload properly aligned",
+                ((mem_ptr_t)q->payload % MEM_ALIGNMENT) == 0);
+    LWIP_ASSERT("PBUF_POOL_BUFSIZE must be bigger than MEM_ALIGNMENT",
+                (bufsize - LWIP_MEM_ALIGN_SIZE(offset)) > 0 );
+    if (p == NULL) {
+      /* allocated head of pbuf chain (into p) */
+      p = q;
+    } else {
+      /* make previous pbuf point to this pbuf */
+      last->next = q;
+    }
+    last = q;
+    rem_len = (u16_t)(rem_len - qlen);
+    offset = 0;
+  } while (rem_len > 0);
+  return p;
+}
+
+#if PBUF_POOL_SIZE_CLASSES
+#if PBUF_POOL_STATS
+/** Account for 'count' pbufs taken from a size class. PBUF_POOL pbufs are
+ * allocated from driver/ISR context, too, so update the counters protected.
+ */
+static void
+pbuf_pool_stats_taken(int pool_class, u16_t count, u32_t req_bytes, u16_t bufsize, u8_t fallback)
+{
+  SYS_ARCH_DECL_PROTECT(old_level);
+  SYS_ARCH_PROTECT(old_level);
+  lwip_stats.pbuf_pool[pool_class].alloc = (STAT_COUNTER)(lwip_stats.pbuf_pool[pool_class].alloc + count);
+  PBUF_POOL_STATS_ADD(req_bytes, pool_class, req_bytes);
+  PBUF_POOL_STATS_ADD(buf_bytes, pool_class, (u32_t)count * bufsize);
+  if (fallback) {
+    PBUF_POOL_STATS_INC(fallback, pool_class);
+  }
+  SYS_ARCH_UNPROTECT(old_level);
+}
+#endif /* PBUF_POOL_STATS */
+
+/** Allocate a PBUF_POOL chain from one size class and account for it
+ * ('fallback' != 0 if the best-fit class was empty) */
+static struct pbuf *
+pbuf_alloc_pool_class(u16_t offset, u16_t length, int pool_class, u8_t fallback)
+{
+  const struct pbuf_pool_class_desc *desc = &pbuf_pool_classes[pool_class];
+  struct pbuf *p;
+
+  p = pbuf_alloc_pool_chain(offset, length, desc->pool, desc->bufsize, desc->alloc_src);
+#if PBUF_POOL_STATS
+  if (p != NULL) {
+    pbuf_pool_stats_taken(pool_class, pbuf_clen(p), length, desc->bufsize, fallback);
+  }
+#else /* PBUF_POOL_STATS */
+  LWIP_UNUSED_ARG(fallback);
+#endif /* PBUF_POOL_STATS */
+  return p;
+}
+
+/** Get the size class pbuf_alloc() uses for 'length' bytes behind 'offset'
+ * header bytes: the small class if the request fits into one small pbuf,
+ * else the default class (so chains keep their PBUF_POOL_BUFSIZE layout) */
+static int
+pbuf_pool_fit_class(u16_t offset, u16_t length)
+{
+  u32_t needed = (u32_t)LWIP_MEM_ALIGN_SIZE(offset) + length;
+
+  if (needed <= pbuf_pool_classes[PBUF_POOL_CLASS_SMALL].bufsize) {
+    return PBUF_POOL_CLASS_SMALL;
+  }
+  return PBUF_POOL_CLASS_DEFAULT;
+}
+
+/** Allocate a PBUF_POOL chain from the class returned by pbuf_pool_fit_class().
+ * If that class is empty and the request fits into one pbuf, bigger classes
+ * are tried. Smaller classes are never used: a request that fits into one
+ * buffer must not turn into a chain of smaller ones.
+ */
+static struct pbuf *
+pbuf_alloc_pool_fit(u16_t offset, u16_t length)
+{
+  struct pbuf *p;
+  int best, i;
+
+  best = pbuf_pool_fit_class(offset, length);
+  p = pbuf_alloc_pool_class(offset, length, best, 0);
+  if (p != NULL) {
+    return p;
+  }
+  if ((u32_t)LWIP_MEM_ALIGN_SIZE(offset) + length <= pbuf_pool_classes[best].bufsize) {
+    for (i = best + 1; i < PBUF_POOL_CLASS_COUNT; i++) {
+      p = pbuf_alloc_pool_class(offset, length, i, 1);
+      if (p != NULL) {
+        return p;
+      }
+    }
+  }
+  PBUF_POOL_IS_EMPTY();
+  return NULL;
+}
+#endif /* PBUF_POOL_SIZE_CLASSES */
+
 /**
  * @ingroup pbuf
  * Allocates a pbuf of the given type (possibly a chain for PBUF_POOL type).
@@ -216,6 +376,9 @@ pbuf_init_alloced_pbuf(struct pbuf *p, void *payload, u16_t tot_len, u16_t len,
  *             then pbuf_take should be called to copy the buffer.
  * - PBUF_POOL: the pbuf is allocated as a pbuf chain, with pbufs from
  *              the pbuf pool that is allocated during pbuf_init().
+ *              With PBUF_POOL_SIZE_CLASSES, requests that fit into one
+ *              small pbuf are served from the small class; everything else
+ *              uses PBUF_POOL_BUFSIZE pbufs as without size classes.
  *
  * @return the allocated pbuf. If multiple pbufs where allocated, this
  * is the first pbuf of a pbuf chain.
@@ -232,44 +395,20 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
     case PBUF_ROM:
       p = pbuf_alloc_reference(NULL, length, type);
       break;
-    case PBUF_POOL: {
-      struct pbuf *q, *last;
-      u16_t rem_len; /* remaining length */
-      p = NULL;
-      last = NULL;
-      rem_len = length;
-      do {
-        u16_t qlen;
-        q = (struct pbuf *)memp_malloc(MEMP_PBUF_POOL);
-        if (q == NULL) {
-          PBUF_POOL_IS_EMPTY();
-          /* free chain so far allocated */
-          if (p) {
-            pbuf_free(p);
-          }
-          /* bail out unsuccessfully */
-          return NULL;
-        }
-        qlen = LWIP_MIN(rem_len, (u16_t)(PBUF_POOL_BUFSIZE_ALIGNED - LWIP_MEM_ALIGN_SIZE(offset)));
-        pbuf_init_alloced_pbuf(q, LWIP_MEM_ALIGN((void *)((u8_t *)q + SIZEOF_STRUCT_PBUF + offset)),
-                               rem_len, qlen, type, 0);
-        LWIP_ASSERT("pbuf_alloc: pbuf q->payload properly aligned",
-                    ((mem_ptr_t)q->payload % MEM_ALIGNMENT) == 0);
-        LWIP_ASSERT("PBUF_POOL_BUFSIZE must be bigger than MEM_ALIGNMENT",
-                    (PBUF_POOL_BUFSIZE_ALIGNED - LWIP_MEM_ALIGN_SIZE(offset)) > 0 );
-        if (p == NULL) {
-          /* allocated head of pbuf chain (into p) */
-          p = q;
-        } else {
-          /* make previous pbuf point to this pbuf */
-          last->next = q;
-        }
-        last = q;
-        rem_len = (u16_t)(rem_len - qlen);
-        offset = 0;
-      } while (rem_len > 0);
+    case PBUF_POOL:
+#if PBUF_POOL_SIZE_CLASSES
+      p = pbuf_alloc_pool_fit(offset, length);
+#else /* PBUF_POOL_SIZE_CLASSES */
+      p = pbuf_alloc_pool_chain(offset, length, MEMP_PBUF_POOL, PBUF_POOL_BUFSIZE_ALIGNED,
+                                PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL);
+      if (p == NULL) {
+        PBUF_POOL_IS_EMPTY();
+      }
+#endif /* PBUF_POOL_SIZE_CLASSES */
+      if (p == NULL) {
+        return NULL;
+      }
       break;
-    }
     case PBUF_RAM: {
       u16_t payload_len = (u16_t)(LWIP_MEM_ALIGN_SIZE(offset) + LWIP_MEM_ALIGN_SIZE(length));
       mem_size_t alloc_len = (mem_size_t)(LWIP_MEM_ALIGN_SIZE(SIZEOF_STRUCT_PBUF) + payload_len);
@@ -299,6 +438,100 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
   return p;
 }
 
+#if PBUF_POOL_SIZE_CLASSES
+/**
+ * @ingroup pbuf
+ * Allocates a PBUF_POOL pbuf (chain) from an explicitly selected size class,
+ * e.g. for a driver that wants a whole jumbo frame in one pbuf or that fills
+ * the buffer in place up to a known size. Unlike pbuf_alloc(), there is no
+ * fallback to other classes.
+ *
+ * @param layer header size
+ * @param length size of the pbuf's payload
+ * @param pool_class size class to allocate the pbufs from
+ * @return the allocated pbuf (chain) or NULL if that class is exhausted
+ */
+struct pbuf *
+pbuf_alloc_pool(pbuf_layer layer, u16_t length, pbuf_pool_class pool_class)
+{
+  struct pbuf *p;
+  LWIP_ERROR("pbuf_alloc_pool: invalid pool class",
+             ((int)pool_class >= 0) && (pool_class < PBUF_POOL_CLASS_COUNT), return NULL;);
+  LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc_pool(length=%"U16_F", class=%d)\n", length, (int)pool_class));
+
+  p = pbuf_alloc_pool_class((u16_t)layer, length, (int)pool_class, 0);
+  if (p == NULL) {
+    PBUF_POOL_IS_EMPTY();
+  }
+  LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc_pool(length=%"U16_F") == %p\n", length, (void *)p));
+  return p;
+}
+#endif /* PBUF_POOL_SIZE_CLASSES */
+
+/**
+ * @ingroup pbuf
+ * Allocates n pbufs of the same layer, length and type, e.g. to refill a
+ * driver's RX ring. PBUF_POOL pbufs that fit into one pool buffer are taken
+ * from the pool in batches, locking it once per batch instead of once per
+ * pbuf; everything else is allocated with pbuf_alloc().
+ *
+ * @param layer header size
+ * @param length size of each pbuf's payload
+ * @param type type of the pbufs (see pbuf_alloc())
+ * @param v array receiving the pbufs
+ * @param n number of pbufs wanted
+ * @return the number of pbufs stored to v (less than n if memory ran out)
+ */
+u16_t
+pbuf_alloc_bulk(pbuf_layer layer, u16_t length, pbuf_type type, struct pbuf **v, u16_t n)
+{
+  u16_t offset = (u16_t)layer;
+  u16_t i = 0;
+
+  LWIP_ERROR("pbuf_alloc_bulk: invalid array", (v != NULL) || (n == 0), return 0;);
+
+  if (type == PBUF_POOL) {
+    void *mem[PBUF_BULK_BATCH];
+    u16_t want, got, j;
+#if PBUF_POOL_SIZE_CLASSES
+    int pool_class = pbuf_pool_fit_class(offset, length);
+    memp_t pool = pbuf_pool_classes[pool_class].pool;
+    u16_t bufsize = pbuf_pool_classes[pool_class].bufsize;
+    pbuf_type pool_type = (pbuf_type)((PBUF_POOL & ~PBUF_TYPE_ALLOC_SRC_MASK) |
+                                      pbuf_pool_classes[pool_class].alloc_src);
+#else /* PBUF_POOL_SIZE_CLASSES */
+    memp_t pool = MEMP_PBUF_POOL;
+    u16_t bufsize = PBUF_POOL_BUFSIZE_ALIGNED;
+    pbuf_type pool_type = PBUF_POOL;
+#endif /* PBUF_POOL_SIZE_CLASSES */
+
+    if ((u32_t)LWIP_MEM_ALIGN_SIZE(offset) + length <= bufsize) {
+      /* unchained pbufs: take the pool elements in batches */
+      do {
+        want = (u16_t)LWIP_MIN(n - i, PBUF_BULK_BATCH);
+        got = memp_malloc_bulk(pool, mem, want);
+        for (j = 0; j < got; j++) {
+          struct pbuf *q = (struct pbuf *)mem[j];
+          pbuf_init_alloced_pbuf(q, LWIP_MEM_ALIGN((void *)((u8_t *)q + SIZEOF_STRUCT_PBUF + offset)),
+                                 length, length, pool_type, 0);
+          v[i++] = q;
+        }
+#if PBUF_POOL_STATS
+        pbuf_pool_stats_taken(pool_class, got, (u32_t)got * length, bufsize, 0);
+#endif /* PBUF_POOL_STATS */
+      } while ((got == want) && (i < n));
+    }
+  }
+  /* chains, other types and whatever the pool could not serve */
+  for (; i < n; i++) {
+    v[i] = pbuf_alloc(layer, length, type);
+    if (v[i] == NULL) {
+      break;
+    }
+  }
+  return i;
+}
+
 /**
  * @ingroup pbuf
  * Allocates a pbuf for referenced data.
@@ -744,6 +977,12 @@ pbuf_free(struct pbuf *p)
    * obtain a zero reference count after decrementing*/
   while (p != NULL) {
     LWIP_PBUF_REF_T ref;
+#if LWIP_PBUF_REF_ATOMIC
+    /* decrease reference count (number of pointers to pbuf) */
+    ref = (LWIP_PBUF_REF_T)LWIP_PBUF_REF_DEC(p);
+    /* all pbufs in a chain are referenced at least once */
+    LWIP_ASSERT("pbuf_free: p->ref > 0", ref != (LWIP_PBUF_REF_T)-1);
+#else /* LWIP_PBUF_REF_ATOMIC */
     SYS_ARCH_DECL_PROTECT(old_level);
     /* Since decrementing ref cannot be guaranteed to be a single machine operation
      * we must protect it. We put the new ref into a local variable to prevent
@@ -754,6 +993,7 @@ pbuf_free(struct pbuf *p)
     /* decrease reference count (number of pointers to pbuf) */
     ref = --(p->ref);
     SYS_ARCH_UNPROTECT(old_level);
+#endif /* LWIP_PBUF_REF_ATOMIC */
     /* this pbuf is no longer referenced to? */
     if (ref == 0) {
       /* remember next pbuf in chain for next iteration */
@@ -772,6 +1012,12 @@ pbuf_free(struct pbuf *p)
         /* is this a pbuf from the pool? */
         if (alloc_src == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL) {
           memp_free(MEMP_PBUF_POOL, p);
+#if PBUF_POOL_SIZE_CLASSES
+        } else if (alloc_src == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_SMALL) {
+          memp_free(MEMP_PBUF_POOL_SMALL, p);
+        } else if (alloc_src == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_LARGE) {
+          memp_free(MEMP_PBUF_POOL_LARGE, p);
+#endif /* PBUF_POOL_SIZE_CLASSES */
           /* is this a ROM or RAM referencing pbuf? */
         } else if (alloc_src == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF) {
           memp_free(MEMP_PBUF, p);
@@ -799,6 +1045,109 @@ pbuf_free(struct pbuf *p)
   return count;
 }
 
+/**
+ * @ingroup pbuf
+ * Dereference n pbufs (chains) like pbuf_free() would, but drop all
+ * reference counts under one SYS_ARCH_PROTECT and give the deallocated
+ * pool pbufs back to their memp pool in batches.
+ *
+ * @param v the pbufs (chains) to free (NULL entries are skipped)
+ * @param n number of entries in v
+ * @return the total number of pbufs that were deallocated
+ */
+u16_t
+pbuf_free_batch(struct pbuf **v, u16_t n)
+{
+  struct pbuf *dead = NULL;
+  void *mem[PBUF_BULK_BATCH];
+  memp_t mem_type = MEMP_PBUF_POOL;
+  u16_t i, mem_count = 0, count = 0;
+#if !LWIP_PBUF_REF_ATOMIC
+  SYS_ARCH_DECL_PROTECT(old_level);
+#endif /* !LWIP_PBUF_REF_ATOMIC */
+
+  LWIP_ERROR("pbuf_free_batch: invalid array", (v != NULL) || (n == 0), return 0;);
+
+  /* drop the references of all chains, collecting the pbufs that are no
+     longer referenced (linked through their next pointers) */
+#if !LWIP_PBUF_REF_ATOMIC
+  SYS_ARCH_PROTECT(old_level);
+#endif /* !LWIP_PBUF_REF_ATOMIC */
+  for (i = 0; i < n; i++) {
+    struct pbuf *p = v[i];
+    while (p != NULL) {
+      struct pbuf *q;
+#if LWIP_PBUF_REF_ATOMIC
+      LWIP_PBUF_REF_T ref = (LWIP_PBUF_REF_T)LWIP_PBUF_REF_DEC(p);
+      /* all pbufs in a chain are referenced at least once */
+      LWIP_ASSERT("pbuf_free: p->ref > 0", ref != (LWIP_PBUF_REF_T)-1);
+      if (ref != 0) {
+        break;
+      }
+#else /* LWIP_PBUF_REF_ATOMIC */
+      /* all pbufs in a chain are referenced at least once */
+      LWIP_ASSERT("pbuf_free: p->ref > 0", p->ref > 0);
+      if (--(p->ref) != 0) {
+        break;
+      }
+#endif /* LWIP_PBUF_REF_ATOMIC */
+      q = p->next;
+      p->next = dead;
+      dead = p;
+      p = q;
+    }
+  }
+#if !LWIP_PBUF_REF_ATOMIC
+  SYS_ARCH_UNPROTECT(old_level);
+#endif /* !LWIP_PBUF_REF_ATOMIC */
+
+  while (dead != NULL) {
+    struct pbuf *p = dead;
+    u8_t alloc_src = pbuf_get_allocsrc(p);
+    memp_t type = MEMP_MAX;
+
+    dead = p->next;
+    count++;
+    LWIP_DEBUGF( PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_free_batch: deallocating %p\n", (void *)p));
+#if LWIP_SUPPORT_CUSTOM_PBUF
+    if ((p->flags & PBUF_FLAG_IS_CUSTOM) != 0) {
+      struct pbuf_custom *pc = (struct pbuf_custom *)p;
+      LWIP_ASSERT("pc->custom_free_function != NULL", pc->custom_free_function != NULL);
+      pc->custom_free_function(p);
+      continue;
+    }
+#endif /* LWIP_SUPPORT_CUSTOM_PBUF */
+    if (alloc_src == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL) {
+      type = MEMP_PBUF_POOL;
+#if PBUF_POOL_SIZE_CLASSES
+    } else if (alloc_src == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_SMALL) {
+      type = MEMP_PBUF_POOL_SMALL;
+    } else if (alloc_src == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_LARGE) {
+      type = MEMP_PBUF_POOL_LARGE;
+#endif /* PBUF_POOL_SIZE_CLASSES */
+    } else if (alloc_src == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF) {
+      type = MEMP_PBUF;
+    } else if (alloc_src == PBUF_TYPE_ALLOC_SRC_MASK_STD_HEAP) {
+      mem_free(p);
+    } else {
+      /* @todo: support freeing other types */
+      LWIP_ASSERT("invalid pbuf type", 0);
+    }
+    if (type != MEMP_MAX) {
+      if ((mem_count == PBUF_BULK_BATCH) || ((mem_count > 0) && (type != mem_type))) {
+        memp_free_bulk(mem_type, mem, mem_count);
+        mem_count = 0;
+      }
+      mem_type = type;
+      mem[mem_count++] = p;
+    }
+  }
+  if (mem_count > 0) {
+    memp_free_bulk(mem_type, mem, mem_count);
+  }
+  return count;
+}
+
 /**
  * Count number of pbufs in a chain
  *
@@ -830,8 +1179,14 @@ pbuf_ref(struct pbuf *p)
 {
   /* pbuf given? */
   if (p != NULL) {
+#if LWIP_PBUF_REF_ATOMIC
+    LWIP_PBUF_REF_T ref = (LWIP_PBUF_REF_T)LWIP_PBUF_REF_INC(p);
+    LWIP_ASSERT("pbuf ref overflow", ref > 0);
+    LWIP_UNUSED_ARG(ref);
+#else /* LWIP_PBUF_REF_ATOMIC */
     SYS_ARCH_SET(p->ref, (LWIP_PBUF_REF_T)(p->ref + 1));
     LWIP_ASSERT("pbuf ref overflow", p->ref > 0);
+#endif /* LWIP_PBUF_REF_ATOMIC */
   }
 }
 
@@ -1356,6 +1711,46 @@ pbuf_fill_chksum(struct pbuf *p, u16_t start_offset, const void *dataptr,
   *chksum = FOLD_U32T(acc);
   return ERR_OK;
 }
+
+/**
+ * Same as pbuf_take() but also returns the checksum of the data, which is
+ * generated while copying (LWIP_CHKSUM_COPY), so the data is only read once.
+ *
+ * @param buf pbuf to fill with data
+ * @param dataptr application supplied data buffer
+ * @param len length of the application supplied data buffer
+ * @param chksum returns the (non-inverted) checksum of the copied data, e.g.
+ *        for netbuf_set_chksum()
+ * @return ERR_OK if successful, ERR_MEM if the pbuf is not big enough
+ */
+err_t
+pbuf_take_chksum(struct pbuf *buf, const void *dataptr, u16_t len, u16_t *chksum)
+{
+  struct pbuf *p;
+  u16_t buf_copy_len;
+  u16_t copied_total = 0;
+  u32_t acc = 0;
+
+  LWIP_ERROR("pbuf_take_chksum: invalid buf", (buf != NULL), return ERR_ARG;);
+  LWIP_ERROR("pbuf_take_chksum: invalid dataptr", (dataptr != NULL), return ERR_ARG;);
+  LWIP_ERROR("pbuf_take_chksum: invalid chksum", (chksum != NULL), return ERR_ARG;);
+  LWIP_ERROR("pbuf_take_chksum: buf not large enough", (buf->tot_len >= len), return ERR_MEM;);
+
+  for (p = buf; copied_total < len; p = p->next) {
+    u16_t copy_chksum;
+    LWIP_ASSERT("pbuf_take_chksum: invalid pbuf", p != NULL);
+    buf_copy_len = (u16_t)LWIP_MIN(p->len, len - copied_total);
+    copy_chksum = LWIP_CHKSUM_COPY(p->payload, &((const u8_t *)dataptr)[copied_total], buf_copy_len);
+    if ((copied_total & 1) != 0) {
+      copy_chksum = SWAP_BYTES_IN_WORD(copy_chksum);
+    }
+    acc += copy_chksum;
+    acc = FOLD_U32T(acc);
+    copied_total = (u16_t)(copied_total + buf_copy_len);
+  }
+  *chksum = (u16_t)FOLD_U32T(acc);
+  return ERR_OK;
+}
 #endif /* LWIP_CHECKSUM_ON_COPY */
 
 /**
@@ -117,11 +117,47 @@ stats_display_memp(struct stats_mem *mem, int idx)
 {
   if (idx < MEMP_MAX) {
     stats_display_mem(mem, mem->name);
+#if MEMP_CACHE
+    LWIP_PLATFORM_DIAG(("\tcache_hit: %"STAT_COUNTER_F"\n\t", mem->cache_hit));
+    LWIP_PLATFORM_DIAG(("cache_miss: %"STAT_COUNTER_F"\n", mem->cache_miss));
+#endif /* MEMP_CACHE */
   }
 }
 #endif /* MEMP_STATS */
 #endif /* MEM_STATS || MEMP_STATS */
 
+#if PBUF_POOL_STATS
+void
+stats_display_pbuf_pool(struct stats_pbuf_pool *pool, int pool_class)
+{
+  static const char *const names[PBUF_POOL_CLASS_COUNT] = { "SMALL", "DEFAULT", "LARGE" };
+#if MEMP_STATS
+  static const memp_t pools[PBUF_POOL_CLASS_COUNT] = { MEMP_PBUF_POOL_SMALL, MEMP_PBUF_POOL, MEMP_PBUF_POOL_LARGE };
+  const struct stats_mem *mem;
+  u32_t size;
+#endif /* MEMP_STATS */
+
+  if ((pool_class < 0) || (pool_class >= PBUF_POOL_CLASS_COUNT)) {
+    return;
+  }
+  LWIP_PLATFORM_DIAG(("\nPBUF_POOL %s\n\t", names[pool_class]));
+  LWIP_PLATFORM_DIAG(("alloc: %"STAT_COUNTER_F"\n\t", pool->alloc));
+  LWIP_PLATFORM_DIAG(("fallback: %"STAT_COUNTER_F"\n\t", pool->fallback));
+  LWIP_PLATFORM_DIAG(("req_bytes: %"U32_F"\n\t", pool->req_bytes));
+#if MEMP_STATS
+  LWIP_PLATFORM_DIAG(("buf_bytes: %"U32_F"\n\t", pool->buf_bytes));
+  /* memory footprint: pool elements (struct pbuf included) in bytes */
+  mem = lwip_stats.memp[pools[pool_class]];
+  size = memp_pools[pools[pool_class]]->size;
+  LWIP_PLATFORM_DIAG(("footprint.used: %"U32_F"\n\t", (u32_t)(mem->used * size)));
+  LWIP_PLATFORM_DIAG(("footprint.max: %"U32_F"\n\t", (u32_t)(mem->max * size)));
+  LWIP_PLATFORM_DIAG(("footprint.total: %"U32_F"\n", (u32_t)(mem->avail * size)));
+#else /* MEMP_STATS */
+  LWIP_PLATFORM_DIAG(("buf_bytes: %"U32_F"\n", pool->buf_bytes));
+#endif /* MEMP_STATS */
+}
+#endif /* PBUF_POOL_STATS */
+
 #if SYS_STATS
 void
 stats_display_sys(struct stats_sys *sys)
@@ -139,6 +175,36 @@ stats_display_sys(struct stats_sys *sys)
 }
 #endif /* SYS_STATS */
 
+#if TCPIP_STATS
+void
+stats_display_tcpip(struct stats_tcpip *tcpip)
+{
+  /* share of polling rounds that found work, in percent */
+  u32_t poll = tcpip->poll;
+  u32_t hit = tcpip->poll_hit;
+  u32_t ratio = 0;
+
+  if (poll != 0) {
+#if LWIP_HAVE_INT64
+    ratio = (u32_t)(((u64_t)hit * 100) / poll);
+#else /* LWIP_HAVE_INT64 */
+    /* scale both down so that hit * 100 cannot overflow */
+    while (poll > 0xFFFFFFFFUL / 100) {
+      poll >>= 1;
+      hit >>= 1;
+    }
+    ratio = (hit * 100) / poll;
+#endif /* LWIP_HAVE_INT64 */
+  }
+
+  LWIP_PLATFORM_DIAG(("\nTCPIP\n\t"));
+  LWIP_PLATFORM_DIAG(("poll: %"STAT_COUNTER_F"\n\t", tcpip->poll));
+  LWIP_PLATFORM_DIAG(("poll_hit: %"STAT_COUNTER_F"\n\t", tcpip->poll_hit));
+  LWIP_PLATFORM_DIAG(("idle: %"STAT_COUNTER_F"\n\t", tcpip->idle));
+  LWIP_PLATFORM_DIAG(("hit_ratio: %"U32_F"%%\n", ratio));
+}
+#endif /* TCPIP_STATS */
+
 void
 stats_display(void)
 {
@@ -161,7 +227,13 @@ stats_display(void)
   for (i = 0; i < MEMP_MAX; i++) {
     MEMP_STATS_DISPLAY(i);
   }
+#if PBUF_POOL_STATS
+  for (i = 0; i < PBUF_POOL_CLASS_COUNT; i++) {
+    PBUF_POOL_STATS_DISPLAY(i);
+  }
+#endif /* PBUF_POOL_STATS */
   SYS_STATS_DISPLAY();
+  TCPIP_STATS_DISPLAY();
 }
 #endif /* LWIP_STATS_DISPLAY */
 
@@ -111,6 +111,8 @@
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
 #include "lwip/nd6.h"
+#include "lwip/sys.h"
+#include "lwip/timeouts.h"
 
 #include <string.h>
 
@@ -126,6 +128,9 @@
 #define TCP_ENSURE_LOCAL_PORT_RANGE(port) ((u16_t)(((port) & (u16_t)~TCP_LOCAL_PORT_RANGE_START) + TCP_LOCAL_PORT_RANGE_START))
 #endif
 
+/** Number of segments tcp_segs_free() frees per batch */
+#define TCP_SEGS_FREE_BATCH 8
+
 #if LWIP_TCP_KEEPALIVE
 #define TCP_KEEP_DUR(pcb)   ((pcb)->keep_cnt * (pcb)->keep_intvl)
 #define TCP_KEEP_INTVL(pcb) ((pcb)->keep_intvl)
@@ -184,12 +189,35 @@ struct tcp_pcb **const tcp_pcb_lists[] = {&tcp_listen_pcbs.pcbs, &tcp_bound_pcbs
 
 u8_t tcp_active_pcbs_changed;
 
+#if LWIP_TCP_PCB_HASH
+/** Active and TIME-WAIT pcbs hashed by their 4-tuple */
+static struct tcp_pcb *tcp_pcb_hash[TCP_PCB_HASH_SIZE];
+/** Listening pcbs hashed by their local port */
+static struct tcp_pcb_listen *tcp_listen_hash[TCP_LISTEN_HASH_SIZE];
+#endif /* LWIP_TCP_PCB_HASH */
+
+#if LWIP_TCP_PCB_TIMERS
+/** Active pcbs visited by every tcp_fasttmr() and tcp_slowtmr() run */
+static struct tcp_pcb *tcp_timer_pcbs;
+/** Idle active pcbs and TIME-WAIT pcbs, parked in the slot of their tmr_due */
+static struct tcp_pcb *tcp_timer_wheel[TCP_PCB_TIMERS_WHEEL_SIZE];
+#define TCP_TIMER_PCBS       tcp_timer_pcbs
+#define TCP_TIMER_NEXT(pcb)  ((pcb)->tmr_next)
+#else /* LWIP_TCP_PCB_TIMERS */
+#define TCP_TIMER_PCBS       tcp_active_pcbs
+#define TCP_TIMER_NEXT(pcb)  ((pcb)->next)
+#endif /* LWIP_TCP_PCB_TIMERS */
+
 /** Timer counter to handle calling slow-timer from tcp_tmr() */
 static u8_t tcp_timer;
 static u8_t tcp_timer_ctr;
 static u16_t tcp_new_port(void);
 
 static err_t tcp_close_shutdown_fin(struct tcp_pcb *pcb);
+#if LWIP_TCP_PCB_TIMERS
+static void tcp_pcb_timer_park(struct tcp_pcb *pcb);
+static void tcp_pcb_timers_expire(void);
+#endif /* LWIP_TCP_PCB_TIMERS */
 #if LWIP_TCP_PCB_NUM_EXT_ARGS
 static void tcp_ext_arg_invoke_callbacks_destroyed(struct tcp_pcb_ext_args *ext_args);
 #endif
@@ -411,6 +439,9 @@ tcp_close_shutdown_fin(struct tcp_pcb *pcb)
   err_t err;
   LWIP_ASSERT("pcb != NULL", pcb != NULL);
 
+  /* closing starts the FIN retransmission or a state timeout */
+  TCP_PCB_TIMER_ARM(pcb);
+
   switch (pcb->state) {
     case SYN_RCVD:
       err = tcp_send_fin(pcb);
@@ -521,6 +552,8 @@ tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx)
   if (pcb->state == LISTEN) {
     return ERR_CONN;
   }
+  /* TF_RXCLOSED starts the FIN-WAIT-2 timeout */
+  TCP_PCB_TIMER_ARM(pcb);
   if (shut_rx) {
     /* shut down the receive side: set a flag not to receive any more data... */
     tcp_set_flags(pcb, TF_RXCLOSED);
@@ -903,6 +936,9 @@ tcp_listen_with_backlog_and_err(struct tcp_pcb *pcb, u8_t backlog, err_t *err)
   if (pcb->local_port != 0) {
     TCP_RMV(&tcp_bound_pcbs, pcb);
   }
+#if LWIP_TCP_CC
+  lpcb->cc_ops = pcb->cc_ops;
+#endif /* LWIP_TCP_CC */
 #if LWIP_TCP_PCB_NUM_EXT_ARGS
   /* copy over ext_args to listening pcb  */
   memcpy(&lpcb->ext_args, &pcb->ext_args, sizeof(pcb->ext_args));
@@ -1185,18 +1221,304 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
   return ret;
 }
 
+/**
+ * Called when the retransmission timer of a pcb has expired: retransmit
+ * the unacknowledged segments, back off the RTO and reduce cwnd.
+ *
+ * @param pcb the pcb whose retransmission timer has expired
+ */
+static void
+tcp_rto_expired(struct tcp_pcb *pcb)
+{
+  /* If prepare phase fails but we have unsent data but no unacked data,
+     still execute the backoff calculations below, as this means we somehow
+     failed to send segment. */
+  if ((tcp_rexmit_rto_prepare(pcb) == ERR_OK) || ((pcb->unacked == NULL) && (pcb->unsent != NULL))) {
+    /* Double retransmission time-out unless we are trying to
+     * connect to somebody (i.e., we are in SYN_SENT). */
+    if (pcb->state != SYN_SENT) {
+      u8_t backoff_idx = LWIP_MIN(pcb->nrtx, sizeof(tcp_backoff) - 1);
+      pcb->rto = TCP_RTO_CALC(pcb, tcp_backoff[backoff_idx]);
+    }
+
+    /* Reset the retransmission timer. */
+    TCP_RTO_RESTART(pcb);
+
+    /* Reduce congestion window and ssthresh. */
+    TCP_CC_ON_RTO(pcb);
+    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: cwnd %"TCPWNDSIZE_F
+                                 " ssthresh %"TCPWNDSIZE_F"\n",
+                                 pcb->cwnd, pcb->ssthresh));
+    pcb->bytes_acked = 0;
+
+    /* The following needs to be called AFTER cwnd is set to one
+       mss - STJ */
+    tcp_rexmit_rto_commit(pcb);
+  }
+}
+
+#if LWIP_TCP_RTO_MS
+/** tcp_rto_timer() is scheduled */
+static u8_t tcp_rto_timer_active;
+/** sys_now() at which tcp_rto_timer() runs */
+static u32_t tcp_rto_timer_due;
+
+static void tcp_rto_timer(void *arg);
+
+/** Make sure tcp_rto_timer() runs no later than 'due' */
+static void
+tcp_rto_timer_arm(u32_t due)
+{
+  u32_t now;
+
+  if (tcp_rto_timer_active) {
+    if ((s32_t)(due - tcp_rto_timer_due) >= 0) {
+      /* runs early enough, it re-arms itself for later timeouts */
+      return;
+    }
+    sys_untimeout(tcp_rto_timer, NULL);
+  }
+  tcp_rto_timer_active = 1;
+  tcp_rto_timer_due = due;
+  now = sys_now();
+  sys_timeout(((s32_t)(due - now) > 0) ? (due - now) : 0, tcp_rto_timer, NULL);
+}
+
+/**
+ * (Re)start the retransmission timer of a pcb (LWIP_TCP_RTO_MS).
+ * A running timer is restarted by every ACK for new data, so this only
+ * records the start time; tcp_rto_timer() is re-armed lazily.
+ *
+ * @param pcb the pcb whose retransmission timer to start
+ */
+void
+tcp_rto_timer_start(struct tcp_pcb *pcb)
+{
+  pcb->rtime = 0;
+  pcb->rto_start = sys_now();
+  tcp_rto_timer_arm(pcb->rto_start + (u32_t)pcb->rto);
+}
+
+#if LWIP_TCP_RACK_TLP
+/**
+ * Start the RACK reordering timer or the loss probe timer of a pcb
+ * (only one of them runs at a time, RFC 8985 section 8).
+ *
+ * @param pcb the pcb whose timer to start
+ * @param timer TCP_RACK_REO_TIMER or TCP_RACK_PTO_TIMER
+ * @param ms timeout in milliseconds
+ */
+void
+tcp_rack_timer_start(struct tcp_pcb *pcb, u8_t timer, u32_t ms)
+{
+  pcb->rack_flags = (u8_t)((pcb->rack_flags & ~TCP_RACK_TIMERS) | timer);
+  pcb->rack_due = sys_now() + ms;
+  tcp_rto_timer_arm(pcb->rack_due);
+}
+#endif /* LWIP_TCP_RACK_TLP */
+
+/**
+ * One-shot timer for the earliest pending RTO: runs the expired
+ * retransmission timers (and RACK-TLP timers) and schedules itself for the
+ * next one.
+ */
+static void
+tcp_rto_timer(void *arg)
+{
+  struct tcp_pcb *pcb;
+  u32_t now = sys_now();
+  LWIP_UNUSED_ARG(arg);
+
+  tcp_rto_timer_active = 0;
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    u32_t due;
+#if LWIP_TCP_RACK_TLP
+    if (pcb->rack_flags & TCP_RACK_TIMERS) {
+      if ((s32_t)(now - pcb->rack_due) >= 0) {
+        tcp_rack_tlp_timeout(pcb);
+      } else {
+        tcp_rto_timer_arm(pcb->rack_due);
+      }
+    }
+#endif /* LWIP_TCP_RACK_TLP */
+    if ((pcb->rtime < 0) || (pcb->persist_backoff > 0) ||
+        (pcb->nrtx >= ((pcb->state == SYN_SENT) ? TCP_SYNMAXRTX : TCP_MAXRTX))) {
+      /* not running, or tcp_slowtmr() removes the pcb */
+      continue;
+    }
+    due = pcb->rto_start + (u32_t)pcb->rto;
+    if ((s32_t)(now - due) >= 0) {
+      LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_rto_timer: %"U32_F" ms pcb->rto %"S32_F"\n",
+                                  now - pcb->rto_start, pcb->rto));
+      tcp_rto_expired(pcb);
+      if ((pcb->rtime >= 0) && (pcb->rto_start != now)) {
+        /* nothing could be retransmitted: try again like tcp_slowtmr() would */
+        due = now + TCP_SLOW_INTERVAL;
+      } else {
+        continue;
+      }
+    }
+    tcp_rto_timer_arm(due);
+  }
+}
+#endif /* LWIP_TCP_RTO_MS */
+
+/**
+ * Runs the slow timers of one active pcb: retransmission, persist and
+ * keepalive timers, the out-of-sequence queue timeout and the FIN-WAIT-2,
+ * SYN-RCVD and LAST-ACK timeouts.
+ *
+ * @param pcb the active pcb to process
+ * @param pcb_reset set to 1 if a RST should be sent when removing the pcb
+ * @return != 0 if the pcb should be removed
+ */
+static u8_t
+tcp_slowtmr_pcb(struct tcp_pcb *pcb, u8_t *pcb_reset)
+{
+  u8_t pcb_remove = 0;
+  err_t err;
+
+  if (pcb->state == SYN_SENT && pcb->nrtx >= TCP_SYNMAXRTX) {
+    ++pcb_remove;
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: max SYN retries reached\n"));
+  } else if (pcb->nrtx >= TCP_MAXRTX) {
+    ++pcb_remove;
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: max DATA retries reached\n"));
+  } else {
+    if (pcb->persist_backoff > 0) {
+      LWIP_ASSERT("tcp_slowtimr: persist ticking with in-flight data", pcb->unacked == NULL);
+      LWIP_ASSERT("tcp_slowtimr: persist ticking with empty send buffer", pcb->unsent != NULL);
+      if (pcb->persist_probe >= TCP_MAXRTX) {
+        ++pcb_remove; /* max probes reached */
+      } else {
+        u8_t backoff_cnt = tcp_persist_backoff[pcb->persist_backoff - 1];
+        if (pcb->persist_cnt < backoff_cnt) {
+          pcb->persist_cnt++;
+        }
+        if (pcb->persist_cnt >= backoff_cnt) {
+          int next_slot = 1; /* increment timer to next slot */
+          /* If snd_wnd is zero, send 1 byte probes */
+          if (pcb->snd_wnd == 0) {
+            if (tcp_zero_window_probe(pcb) != ERR_OK) {
+              next_slot = 0; /* try probe again with current slot */
+            }
+            /* snd_wnd not fully closed, split unsent head and fill window */
+          } else {
+            if (tcp_split_unsent_seg(pcb, (u16_t)pcb->snd_wnd) == ERR_OK) {
+              if (tcp_output(pcb) == ERR_OK) {
+                /* sending will cancel persist timer, else retry with current slot */
+                next_slot = 0;
+              }
+            }
+          }
+          if (next_slot) {
+            pcb->persist_cnt = 0;
+            if (pcb->persist_backoff < sizeof(tcp_persist_backoff)) {
+              pcb->persist_backoff++;
+            }
+          }
+        }
+      }
+    } else {
+#if !LWIP_TCP_RTO_MS
+      /* Increase the retransmission timer if it is running */
+      if ((pcb->rtime >= 0) && (pcb->rtime < 0x7FFF)) {
+        ++pcb->rtime;
+      }
+
+      if (pcb->rtime >= pcb->rto) {
+        /* Time for a retransmission. */
+        LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_slowtmr: rtime %"S16_F
+                                    " pcb->rto %"S16_F"\n",
+                                    pcb->rtime, pcb->rto));
+        tcp_rto_expired(pcb);
+      }
+#endif /* !LWIP_TCP_RTO_MS (else the RTO is run by tcp_rto_timer()) */
+    }
+  }
+  /* Check if this PCB has stayed too long in FIN-WAIT-2 */
+  if (pcb->state == FIN_WAIT_2) {
+    /* If this PCB is in FIN_WAIT_2 because of SHUT_WR don't let it time out. */
+    if (pcb->flags & TF_RXCLOSED) {
+      /* PCB was fully closed (either through close() or SHUT_RDWR):
+         normal FIN-WAIT timeout handling. */
+      if ((u32_t)(tcp_ticks - pcb->tmr) >
+          TCP_FIN_WAIT_TIMEOUT / TCP_SLOW_INTERVAL) {
+        ++pcb_remove;
+        LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: removing pcb stuck in FIN-WAIT-2\n"));
+      }
+    }
+  }
+
+  /* Check if KEEPALIVE should be sent */
+  if (ip_get_option(pcb, SOF_KEEPALIVE) &&
+      ((pcb->state == ESTABLISHED) ||
+       (pcb->state == CLOSE_WAIT))) {
+    if ((u32_t)(tcp_ticks - pcb->tmr) >
+        (pcb->keep_idle + TCP_KEEP_DUR(pcb)) / TCP_SLOW_INTERVAL) {
+      LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: KEEPALIVE timeout. Aborting connection to "));
+      ip_addr_debug_print_val(TCP_DEBUG, pcb->remote_ip);
+      LWIP_DEBUGF(TCP_DEBUG, ("\n"));
+
+      ++pcb_remove;
+      *pcb_reset = 1;
+    } else if ((u32_t)(tcp_ticks - pcb->tmr) >
+               (pcb->keep_idle + pcb->keep_cnt_sent * TCP_KEEP_INTVL(pcb))
+               / TCP_SLOW_INTERVAL) {
+      err = tcp_keepalive(pcb);
+      if (err == ERR_OK) {
+        pcb->keep_cnt_sent++;
+      }
+    }
+  }
+
+  /* If this PCB has queued out of sequence data, but has been
+     inactive for too long, will drop the data (it will eventually
+     be retransmitted). */
+#if TCP_QUEUE_OOSEQ
+  if (pcb->ooseq != NULL &&
+      (tcp_ticks - pcb->tmr >= TCP_RTO_TICKS(pcb->rto) * TCP_OOSEQ_TIMEOUT)) {
+    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: dropping OOSEQ queued data\n"));
+    tcp_free_ooseq(pcb);
+  }
+#endif /* TCP_QUEUE_OOSEQ */
+
+  /* Check if this PCB has stayed too long in SYN-RCVD */
+  if (pcb->state == SYN_RCVD) {
+    if ((u32_t)(tcp_ticks - pcb->tmr) >
+        TCP_SYN_RCVD_TIMEOUT / TCP_SLOW_INTERVAL) {
+      ++pcb_remove;
+      LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: removing pcb stuck in SYN-RCVD\n"));
+    }
+  }
+
+  /* Check if this PCB has stayed too long in LAST-ACK */
+  if (pcb->state == LAST_ACK) {
+    if ((u32_t)(tcp_ticks - pcb->tmr) > 2 * TCP_MSL / TCP_SLOW_INTERVAL) {
+      ++pcb_remove;
+      LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: removing pcb stuck in LAST-ACK\n"));
+    }
+  }
+  return pcb_remove;
+}
+
 /**
  * Called every 500 ms and implements the retransmission timer and the timer that
  * removes PCBs that have been in TIME-WAIT for enough time. It also increments
  * various timers such as the inactivity timer in each PCB.
  *
+ * With LWIP_TCP_PCB_TIMERS, only pcbs on the timer list and pcbs whose parked
+ * timers are due in this tick are processed.
+ *
  * Automatically called from tcp_tmr().
  */
 void
 tcp_slowtmr(void)
 {
-  struct tcp_pcb *pcb, *prev;
-  tcpwnd_size_t eff_wnd;
+  struct tcp_pcb *pcb;
+#if !LWIP_TCP_PCB_TIMERS
+  struct tcp_pcb *prev;
+#endif /* !LWIP_TCP_PCB_TIMERS */
   u8_t pcb_remove;      /* flag if a PCB should be removed */
   u8_t pcb_reset;       /* flag if a RST should be sent when removing */
   err_t err;
@@ -1206,178 +1528,101 @@ tcp_slowtmr(void)
   ++tcp_ticks;
   ++tcp_timer_ctr;
 
+#if LWIP_TCP_PCB_TIMERS
+  /* Move parked pcbs due now back to the timer list, expire TIME-WAIT pcbs. */
+  tcp_pcb_timers_expire();
+
 tcp_slowtmr_start:
-  /* Steps through all of the active PCBs. */
-  prev = NULL;
-  pcb = tcp_active_pcbs;
-  if (pcb == NULL) {
-    LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: no active pcbs\n"));
-  }
+  /* Steps through all of the active PCBs on the timer list. */
+  pcb = tcp_timer_pcbs;
   while (pcb != NULL) {
+    struct tcp_pcb *next = pcb->tmr_next;
     LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: processing active pcb\n"));
     LWIP_ASSERT("tcp_slowtmr: active pcb->state != CLOSED\n", pcb->state != CLOSED);
     LWIP_ASSERT("tcp_slowtmr: active pcb->state != LISTEN\n", pcb->state != LISTEN);
     LWIP_ASSERT("tcp_slowtmr: active pcb->state != TIME-WAIT\n", pcb->state != TIME_WAIT);
     if (pcb->last_timer == tcp_timer_ctr) {
       /* skip this pcb, we have already processed it */
-      prev = pcb;
-      pcb = pcb->next;
+      pcb = next;
       continue;
     }
     pcb->last_timer = tcp_timer_ctr;
 
-    pcb_remove = 0;
     pcb_reset = 0;
+    pcb_remove = tcp_slowtmr_pcb(pcb, &pcb_reset);
 
-    if (pcb->state == SYN_SENT && pcb->nrtx >= TCP_SYNMAXRTX) {
-      ++pcb_remove;
-      LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: max SYN retries reached\n"));
-    } else if (pcb->nrtx >= TCP_MAXRTX) {
-      ++pcb_remove;
-      LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: max DATA retries reached\n"));
-    } else {
-      if (pcb->persist_backoff > 0) {
-        LWIP_ASSERT("tcp_slowtimr: persist ticking with in-flight data", pcb->unacked == NULL);
-        LWIP_ASSERT("tcp_slowtimr: persist ticking with empty send buffer", pcb->unsent != NULL);
-        if (pcb->persist_probe >= TCP_MAXRTX) {
-          ++pcb_remove; /* max probes reached */
-        } else {
-          u8_t backoff_cnt = tcp_persist_backoff[pcb->persist_backoff - 1];
-          if (pcb->persist_cnt < backoff_cnt) {
-            pcb->persist_cnt++;
-          }
-          if (pcb->persist_cnt >= backoff_cnt) {
-            int next_slot = 1; /* increment timer to next slot */
-            /* If snd_wnd is zero, send 1 byte probes */
-            if (pcb->snd_wnd == 0) {
-              if (tcp_zero_window_probe(pcb) != ERR_OK) {
-                next_slot = 0; /* try probe again with current slot */
-              }
-              /* snd_wnd not fully closed, split unsent head and fill window */
-            } else {
-              if (tcp_split_unsent_seg(pcb, (u16_t)pcb->snd_wnd) == ERR_OK) {
-                if (tcp_output(pcb) == ERR_OK) {
-                  /* sending will cancel persist timer, else retry with current slot */
-                  next_slot = 0;
-                }
-              }
-            }
-            if (next_slot) {
-              pcb->persist_cnt = 0;
-              if (pcb->persist_backoff < sizeof(tcp_persist_backoff)) {
-                pcb->persist_backoff++;
-              }
-            }
-          }
-        }
-      } else {
-        /* Increase the retransmission timer if it is running */
-        if ((pcb->rtime >= 0) && (pcb->rtime < 0x7FFF)) {
-          ++pcb->rtime;
-        }
+    /* If the PCB should be removed, do it. */
+    if (pcb_remove) {
+#if LWIP_CALLBACK_API
+      tcp_err_fn err_fn = pcb->errf;
+#endif /* LWIP_CALLBACK_API */
+      void *err_arg;
+      enum tcp_state last_state;
+      tcp_pcb_purge(pcb);
+      /* Remove PCB from tcp_active_pcbs list (and the timer list). */
+      TCP_RMV(&tcp_active_pcbs, pcb);
 
-        if (pcb->rtime >= pcb->rto) {
-          /* Time for a retransmission. */
-          LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_slowtmr: rtime %"S16_F
-                                      " pcb->rto %"S16_F"\n",
-                                      pcb->rtime, pcb->rto));
-          /* If prepare phase fails but we have unsent data but no unacked data,
-             still execute the backoff calculations below, as this means we somehow
-             failed to send segment. */
-          if ((tcp_rexmit_rto_prepare(pcb) == ERR_OK) || ((pcb->unacked == NULL) && (pcb->unsent != NULL))) {
-            /* Double retransmission time-out unless we are trying to
-             * connect to somebody (i.e., we are in SYN_SENT). */
-            if (pcb->state != SYN_SENT) {
-              u8_t backoff_idx = LWIP_MIN(pcb->nrtx, sizeof(tcp_backoff) - 1);
-              int calc_rto = ((pcb->sa >> 3) + pcb->sv) << tcp_backoff[backoff_idx];
-              pcb->rto = (s16_t)LWIP_MIN(calc_rto, 0x7FFF);
-            }
+      if (pcb_reset) {
+        tcp_rst(pcb, pcb->snd_nxt, pcb->rcv_nxt, &pcb->local_ip, &pcb->remote_ip,
+                pcb->local_port, pcb->remote_port);
+      }
 
-            /* Reset the retransmission timer. */
-            pcb->rtime = 0;
+      err_arg = pcb->callback_arg;
+      last_state = pcb->state;
+      tcp_free(pcb);
 
-            /* Reduce congestion window and ssthresh. */
-            eff_wnd = LWIP_MIN(pcb->cwnd, pcb->snd_wnd);
-            pcb->ssthresh = eff_wnd >> 1;
-            if (pcb->ssthresh < (tcpwnd_size_t)(pcb->mss << 1)) {
-              pcb->ssthresh = (tcpwnd_size_t)(pcb->mss << 1);
-            }
-            pcb->cwnd = pcb->mss;
-            LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: cwnd %"TCPWNDSIZE_F
-                                         " ssthresh %"TCPWNDSIZE_F"\n",
-                                         pcb->cwnd, pcb->ssthresh));
-            pcb->bytes_acked = 0;
-
-            /* The following needs to be called AFTER cwnd is set to one
-               mss - STJ */
-            tcp_rexmit_rto_commit(pcb);
-          }
-        }
+      tcp_active_pcbs_changed = 0;
+      TCP_EVENT_ERR(last_state, err_fn, err_arg, ERR_ABRT);
+      if (tcp_active_pcbs_changed) {
+        goto tcp_slowtmr_start;
       }
-    }
-    /* Check if this PCB has stayed too long in FIN-WAIT-2 */
-    if (pcb->state == FIN_WAIT_2) {
-      /* If this PCB is in FIN_WAIT_2 because of SHUT_WR don't let it time out. */
-      if (pcb->flags & TF_RXCLOSED) {
-        /* PCB was fully closed (either through close() or SHUT_RDWR):
-           normal FIN-WAIT timeout handling. */
-        if ((u32_t)(tcp_ticks - pcb->tmr) >
-            TCP_FIN_WAIT_TIMEOUT / TCP_SLOW_INTERVAL) {
-          ++pcb_remove;
-          LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: removing pcb stuck in FIN-WAIT-2\n"));
+    } else {
+      /* We check if we should poll the connection. */
+      err = ERR_OK;
+      ++pcb->polltmr;
+      if (pcb->polltmr >= pcb->pollinterval) {
+        pcb->polltmr = 0;
+        LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: polling application\n"));
+        tcp_active_pcbs_changed = 0;
+        TCP_EVENT_POLL(pcb, err);
+        if (tcp_active_pcbs_changed) {
+          goto tcp_slowtmr_start;
         }
-      }
-    }
-
-    /* Check if KEEPALIVE should be sent */
-    if (ip_get_option(pcb, SOF_KEEPALIVE) &&
-        ((pcb->state == ESTABLISHED) ||
-         (pcb->state == CLOSE_WAIT))) {
-      if ((u32_t)(tcp_ticks - pcb->tmr) >
-          (pcb->keep_idle + TCP_KEEP_DUR(pcb)) / TCP_SLOW_INTERVAL) {
-        LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: KEEPALIVE timeout. Aborting connection to "));
-        ip_addr_debug_print_val(TCP_DEBUG, pcb->remote_ip);
-        LWIP_DEBUGF(TCP_DEBUG, ("\n"));
-
-        ++pcb_remove;
-        ++pcb_reset;
-      } else if ((u32_t)(tcp_ticks - pcb->tmr) >
-                 (pcb->keep_idle + pcb->keep_cnt_sent * TCP_KEEP_INTVL(pcb))
-                 / TCP_SLOW_INTERVAL) {
-        err = tcp_keepalive(pcb);
+        /* if err == ERR_ABRT, 'pcb' is already deallocated */
         if (err == ERR_OK) {
-          pcb->keep_cnt_sent++;
+          tcp_output(pcb);
         }
       }
-    }
-
-    /* If this PCB has queued out of sequence data, but has been
-       inactive for too long, will drop the data (it will eventually
-       be retransmitted). */
-#if TCP_QUEUE_OOSEQ
-    if (pcb->ooseq != NULL &&
-        (tcp_ticks - pcb->tmr >= (u32_t)pcb->rto * TCP_OOSEQ_TIMEOUT)) {
-      LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: dropping OOSEQ queued data\n"));
-      tcp_free_ooseq(pcb);
-    }
-#endif /* TCP_QUEUE_OOSEQ */
-
-    /* Check if this PCB has stayed too long in SYN-RCVD */
-    if (pcb->state == SYN_RCVD) {
-      if ((u32_t)(tcp_ticks - pcb->tmr) >
-          TCP_SYN_RCVD_TIMEOUT / TCP_SLOW_INTERVAL) {
-        ++pcb_remove;
-        LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: removing pcb stuck in SYN-RCVD\n"));
+      if (err != ERR_ABRT) {
+        /* move the pcb to the wheel if none of its timers is running */
+        tcp_pcb_timer_park(pcb);
       }
     }
-
-    /* Check if this PCB has stayed too long in LAST-ACK */
-    if (pcb->state == LAST_ACK) {
-      if ((u32_t)(tcp_ticks - pcb->tmr) > 2 * TCP_MSL / TCP_SLOW_INTERVAL) {
-        ++pcb_remove;
-        LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: removing pcb stuck in LAST-ACK\n"));
-      }
+    pcb = next;
+  }
+#else /* LWIP_TCP_PCB_TIMERS */
+tcp_slowtmr_start:
+  /* Steps through all of the active PCBs. */
+  prev = NULL;
+  pcb = tcp_active_pcbs;
+  if (pcb == NULL) {
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: no active pcbs\n"));
+  }
+  while (pcb != NULL) {
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: processing active pcb\n"));
+    LWIP_ASSERT("tcp_slowtmr: active pcb->state != CLOSED\n", pcb->state != CLOSED);
+    LWIP_ASSERT("tcp_slowtmr: active pcb->state != LISTEN\n", pcb->state != LISTEN);
+    LWIP_ASSERT("tcp_slowtmr: active pcb->state != TIME-WAIT\n", pcb->state != TIME_WAIT);
+    if (pcb->last_timer == tcp_timer_ctr) {
+      /* skip this pcb, we have already processed it */
+      prev = pcb;
+      pcb = pcb->next;
+      continue;
     }
+    pcb->last_timer = tcp_timer_ctr;
+
+    pcb_reset = 0;
+    pcb_remove = tcp_slowtmr_pcb(pcb, &pcb_reset);
 
     /* If the PCB should be removed, do it. */
     if (pcb_remove) {
@@ -1389,6 +1634,7 @@ tcp_slowtmr_start:
       enum tcp_state last_state;
       tcp_pcb_purge(pcb);
       /* Remove PCB from tcp_active_pcbs list. */
+      TCP_PCB_HASH_RMV(&tcp_active_pcbs, pcb);
       if (prev != NULL) {
         LWIP_ASSERT("tcp_slowtmr: middle tcp != tcp_active_pcbs", pcb != tcp_active_pcbs);
         prev->next = pcb->next;
@@ -1455,6 +1701,7 @@ tcp_slowtmr_start:
       struct tcp_pcb *pcb2;
       tcp_pcb_purge(pcb);
       /* Remove PCB from tcp_tw_pcbs list. */
+      TCP_PCB_HASH_RMV(&tcp_tw_pcbs, pcb);
       if (prev != NULL) {
         LWIP_ASSERT("tcp_slowtmr: middle tcp != tcp_tw_pcbs", pcb != tcp_tw_pcbs);
         prev->next = pcb->next;
@@ -1471,6 +1718,7 @@ tcp_slowtmr_start:
       pcb = pcb->next;
     }
   }
+#endif /* LWIP_TCP_PCB_TIMERS */
 }
 
 /**
@@ -1487,7 +1735,8 @@ tcp_fasttmr(void)
   ++tcp_timer_ctr;
 
 tcp_fasttmr_start:
-  pcb = tcp_active_pcbs;
+  /* with LWIP_TCP_PCB_TIMERS, parked pcbs have nothing to do here */
+  pcb = TCP_TIMER_PCBS;
 
   while (pcb != NULL) {
     if (pcb->last_timer != tcp_timer_ctr) {
@@ -1507,7 +1756,7 @@ tcp_fasttmr_start:
         tcp_close_shutdown_fin(pcb);
       }
 
-      next = pcb->next;
+      next = TCP_TIMER_NEXT(pcb);
 
       /* If there is data which was previously "refused" by upper layer */
       if (pcb->refused_data != NULL) {
@@ -1520,7 +1769,7 @@ tcp_fasttmr_start:
       }
       pcb = next;
     } else {
-      pcb = pcb->next;
+      pcb = TCP_TIMER_NEXT(pcb);
     }
   }
 }
@@ -1611,11 +1860,29 @@ tcp_process_refused_data(struct tcp_pcb *pcb)
 void
 tcp_segs_free(struct tcp_seg *seg)
 {
+  /* free the pbufs and segments in batches to amortize the locking */
+  struct pbuf *p[TCP_SEGS_FREE_BATCH];
+  void *segs[TCP_SEGS_FREE_BATCH];
+  u16_t n = 0;
+
   while (seg != NULL) {
     struct tcp_seg *next = seg->next;
-    tcp_seg_free(seg);
+    p[n] = seg->p;
+#if TCP_DEBUG
+    seg->p = NULL;
+#endif /* TCP_DEBUG */
+    segs[n++] = seg;
+    if (n == TCP_SEGS_FREE_BATCH) {
+      pbuf_free_batch(p, n);
+      memp_free_bulk(MEMP_TCP_SEG, segs, n);
+      n = 0;
+    }
     seg = next;
   }
+  if (n > 0) {
+    pbuf_free_batch(p, n);
+    memp_free_bulk(MEMP_TCP_SEG, segs, n);
+  }
 }
 
 /**
@@ -1901,8 +2168,8 @@ tcp_alloc(u8_t prio)
     /* As initial send MSS, we use TCP_MSS but limit it to 536.
        The send MSS is updated when an MSS option is received. */
     pcb->mss = INITIAL_MSS;
-    pcb->rto = 3000 / TCP_SLOW_INTERVAL;
-    pcb->sv = 3000 / TCP_SLOW_INTERVAL;
+    pcb->rto = TCP_MS_TO_RTT(3000);
+    pcb->sv = TCP_MS_TO_RTT(3000);
     pcb->rtime = -1;
     pcb->cwnd = 1;
     pcb->tmr = tcp_ticks;
@@ -1915,6 +2182,10 @@ tcp_alloc(u8_t prio)
     connection is established. To avoid these complications, we set ssthresh to the
     largest effective cwnd (amount of in-flight data) that the sender can have. */
     pcb->ssthresh = TCP_SND_BUF;
+#if LWIP_TCP_CC
+    pcb->cc_ops = &tcp_cc_reno;
+    pcb->cc_ops->init(pcb);
+#endif /* LWIP_TCP_CC */
 
 #if LWIP_CALLBACK_API
     pcb->recv = tcp_recv_null;
@@ -2122,6 +2393,7 @@ tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval)
   LWIP_UNUSED_ARG(poll);
 #endif /* LWIP_CALLBACK_API */
   pcb->pollinterval = interval;
+  TCP_PCB_TIMER_ARM(pcb);
 }
 
 /**
@@ -2213,6 +2485,373 @@ tcp_pcb_remove(struct tcp_pcb **pcblist, struct tcp_pcb *pcb)
   LWIP_ASSERT("tcp_pcb_remove: tcp_pcbs_sane()", tcp_pcbs_sane());
 }
 
+#if LWIP_TCP_PCB_TIMERS
+/** Lower a due tick to 'due_new' if that is earlier */
+#define TCP_TIMER_DUE_MIN(due, due_new) do { \
+    if ((s32_t)((u32_t)(due_new) - (due)) < 0) { \
+      (due) = (u32_t)(due_new); \
+    } } while(0)
+
+/** Add a pcb to the front of the timer list or a wheel slot */
+static void
+tcp_pcb_timer_link(struct tcp_pcb **list, struct tcp_pcb *pcb)
+{
+  LWIP_ASSERT("tcp_pcb_timer_link: already linked", pcb->tmr_pprev == NULL);
+  pcb->tmr_next = *list;
+  if (pcb->tmr_next != NULL) {
+    pcb->tmr_next->tmr_pprev = &pcb->tmr_next;
+  }
+  *list = pcb;
+  pcb->tmr_pprev = list;
+}
+
+/** Remove a pcb from the timer list or the wheel slot it is on */
+static void
+tcp_pcb_timer_unlink(struct tcp_pcb *pcb)
+{
+  *pcb->tmr_pprev = pcb->tmr_next;
+  if (pcb->tmr_next != NULL) {
+    pcb->tmr_next->tmr_pprev = pcb->tmr_pprev;
+  }
+  pcb->tmr_next = NULL;
+  pcb->tmr_pprev = NULL;
+  pcb->tmr_wheel = 0;
+}
+
+/** Park a pcb on the wheel until tcp_ticks reaches 'due'. Pcbs are never
+ * parked for more than one turn of the wheel, so every pcb found in the slot
+ * of the current tick is due. */
+static void
+tcp_pcb_timer_wheel_add(struct tcp_pcb *pcb, u32_t due)
+{
+  if ((s32_t)(due - tcp_ticks) > TCP_PCB_TIMERS_WHEEL_SIZE) {
+    due = tcp_ticks + TCP_PCB_TIMERS_WHEEL_SIZE;
+  } else if ((s32_t)(due - tcp_ticks) < 1) {
+    due = tcp_ticks + 1;
+  }
+  tcp_pcb_timer_link(&tcp_timer_wheel[due & (TCP_PCB_TIMERS_WHEEL_SIZE - 1)], pcb);
+  pcb->tmr_due = due;
+  pcb->tmr_parked = tcp_ticks;
+  pcb->tmr_wheel = 1;
+}
+
+/** Move a parked active pcb back to the timer list.
+ * 'now' is the last tick that has been skipped while the pcb was parked. */
+static void
+tcp_pcb_timer_unpark(struct tcp_pcb *pcb, u32_t now)
+{
+  u32_t skipped = now - pcb->tmr_parked;
+
+  tcp_pcb_timer_unlink(pcb);
+  tcp_pcb_timer_link(&tcp_timer_pcbs, pcb);
+  /* catch up with the poll timer ticks missed while parked */
+  if (pcb->pollinterval > 0) {
+    pcb->polltmr = (u8_t)((pcb->polltmr + skipped) % pcb->pollinterval);
+  }
+}
+
+/** Called by TCP_REG: active pcbs start on the timer list, TIME-WAIT pcbs are
+ * parked until their 2*MSL timeout */
+void
+tcp_pcb_timer_add(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  if (pcbs == &tcp_active_pcbs) {
+    tcp_pcb_timer_link(&tcp_timer_pcbs, pcb);
+    pcb->tmr_wheel = 0;
+  } else if (pcbs == &tcp_tw_pcbs) {
+    tcp_pcb_timer_wheel_add(pcb, pcb->tmr + 2 * TCP_MSL / TCP_SLOW_INTERVAL + 1);
+  }
+}
+
+/** Called by TCP_RMV: take an active or TIME-WAIT pcb off the timer list or
+ * the wheel */
+void
+tcp_pcb_timer_remove(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  if (((pcbs == &tcp_active_pcbs) || (pcbs == &tcp_tw_pcbs)) &&
+      (pcb->tmr_pprev != NULL)) {
+    tcp_pcb_timer_unlink(pcb);
+  }
+}
+
+/** Wake up a parked active pcb so it is processed by the next tcp_fasttmr()
+ * and tcp_slowtmr() runs */
+void
+tcp_pcb_timer_arm(struct tcp_pcb *pcb)
+{
+  LWIP_ASSERT("tcp_pcb_timer_arm: invalid pcb", pcb != NULL);
+
+  if ((pcb->state != LISTEN) && (pcb->state != TIME_WAIT) && pcb->tmr_wheel) {
+    tcp_pcb_timer_unpark(pcb, tcp_ticks);
+    /* the current timer run (if any) has been accounted for by the catch-up */
+    pcb->last_timer = tcp_timer_ctr;
+  }
+}
+
+/** Called by tcp_slowtmr() after processing a pcb: park it on the wheel until
+ * its next timeout if none of its per-tick timers is running */
+static void
+tcp_pcb_timer_park(struct tcp_pcb *pcb)
+{
+  u32_t due = tcp_ticks + TCP_PCB_TIMERS_WHEEL_SIZE;
+
+  if ((pcb->rtime >= 0) || (pcb->persist_backoff > 0) ||
+      (pcb->flags & (TF_ACK_DELAY | TF_ACK_NOW | TF_CLOSEPEND)) ||
+      (pcb->refused_data != NULL) || (pcb->unsent != NULL) || (pcb->unacked != NULL)) {
+    return;
+  }
+#if LWIP_CALLBACK_API
+  if (pcb->poll != NULL)
+#endif /* LWIP_CALLBACK_API */
+  {
+    if (pcb->polltmr >= pcb->pollinterval) {
+      return;
+    }
+    TCP_TIMER_DUE_MIN(due, tcp_ticks + (u32_t)(pcb->pollinterval - pcb->polltmr));
+  }
+  /* the first tick at which each check in tcp_slowtmr_pcb() would trigger */
+  if ((pcb->state == FIN_WAIT_2) && (pcb->flags & TF_RXCLOSED)) {
+    TCP_TIMER_DUE_MIN(due, pcb->tmr + TCP_FIN_WAIT_TIMEOUT / TCP_SLOW_INTERVAL + 1);
+  }
+  if (ip_get_option(pcb, SOF_KEEPALIVE) &&
+      ((pcb->state == ESTABLISHED) || (pcb->state == CLOSE_WAIT))) {
+    TCP_TIMER_DUE_MIN(due, pcb->tmr + (pcb->keep_idle + pcb->keep_cnt_sent * TCP_KEEP_INTVL(pcb))
+                      / TCP_SLOW_INTERVAL + 1);
+  }
+#if TCP_QUEUE_OOSEQ
+  if (pcb->ooseq != NULL) {
+    TCP_TIMER_DUE_MIN(due, pcb->tmr + TCP_RTO_TICKS(pcb->rto) * TCP_OOSEQ_TIMEOUT);
+  }
+#endif /* TCP_QUEUE_OOSEQ */
+  if (pcb->state == SYN_RCVD) {
+    TCP_TIMER_DUE_MIN(due, pcb->tmr + TCP_SYN_RCVD_TIMEOUT / TCP_SLOW_INTERVAL + 1);
+  }
+  if (pcb->state == LAST_ACK) {
+    TCP_TIMER_DUE_MIN(due, pcb->tmr + 2 * TCP_MSL / TCP_SLOW_INTERVAL + 1);
+  }
+  if ((s32_t)(due - tcp_ticks) <= 1) {
+    /* due in the next tick anyway */
+    return;
+  }
+  tcp_pcb_timer_unlink(pcb);
+  tcp_pcb_timer_wheel_add(pcb, due);
+}
+
+/** Called by tcp_slowtmr() for every tick: wake up the active pcbs parked
+ * until this tick and remove expired TIME-WAIT pcbs */
+static void
+tcp_pcb_timers_expire(void)
+{
+  struct tcp_pcb *pcb = tcp_timer_wheel[tcp_ticks & (TCP_PCB_TIMERS_WHEEL_SIZE - 1)];
+
+  while (pcb != NULL) {
+    struct tcp_pcb *next = pcb->tmr_next;
+    LWIP_ASSERT("tcp_pcb_timers_expire: pcb not due", pcb->tmr_due == tcp_ticks);
+    if (pcb->state == TIME_WAIT) {
+      /* Check if this PCB has stayed long enough in TIME-WAIT */
+      if ((u32_t)(tcp_ticks - pcb->tmr) > 2 * TCP_MSL / TCP_SLOW_INTERVAL) {
+        tcp_pcb_purge(pcb);
+        TCP_RMV(&tcp_tw_pcbs, pcb);
+        tcp_free(pcb);
+      } else {
+        /* TIME-WAIT has been restarted by a retransmitted FIN */
+        tcp_pcb_timer_unlink(pcb);
+        tcp_pcb_timer_wheel_add(pcb, pcb->tmr + 2 * TCP_MSL / TCP_SLOW_INTERVAL + 1);
+      }
+    } else {
+      tcp_pcb_timer_unpark(pcb, tcp_ticks - 1);
+    }
+    pcb = next;
+  }
+}
+#endif /* LWIP_TCP_PCB_TIMERS */
+
+#if LWIP_TCP_PCB_HASH
+/** Fold an IP address into 32 bits for hashing (zone and type are ignored) */
+static u32_t
+tcp_pcb_hash_addr(const ip_addr_t *addr)
+{
+#if LWIP_IPV6
+  if (IP_IS_V6(addr)) {
+    const u32_t *a = ip_2_ip6(addr)->addr;
+    return a[0] ^ a[1] ^ a[2] ^ a[3];
+  }
+#endif /* LWIP_IPV6 */
+#if LWIP_IPV4
+  return ip4_addr_get_u32(ip_2_ip4(addr));
+#else /* LWIP_IPV4 */
+  return 0;
+#endif /* LWIP_IPV4 */
+}
+
+/** Calculate the tcp_pcb_hash bucket for a connection 4-tuple. The local
+ * address is left out since most connections share it. */
+static u32_t
+tcp_pcb_hash_idx(u16_t local_port, const ip_addr_t *remote_ip, u16_t remote_port)
+{
+  u32_t h = tcp_pcb_hash_addr(remote_ip) ^ (((u32_t)remote_port << 16) | local_port);
+  /* multiplicative hashing: the upper bits are the well mixed ones */
+  h *= 0x9E3779B1UL;
+  return (h >> 16) & (TCP_PCB_HASH_SIZE - 1);
+}
+
+#define TCP_LISTEN_HASH_IDX(port) ((u32_t)((port) ^ ((port) >> 8)) & (TCP_LISTEN_HASH_SIZE - 1))
+
+/**
+ * Add a pcb to the hash table belonging to the pcb list it has just been
+ * registered with. Called from TCP_REG. PCBs on the bound list are not
+ * indexed since tcp_input() never looks them up.
+ *
+ * @param pcbs the pcb list 'pcb' has been added to
+ * @param pcb the tcp_pcb to index
+ */
+void
+tcp_pcb_hash_add(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  if ((pcbs == &tcp_active_pcbs) || (pcbs == &tcp_tw_pcbs)) {
+    u32_t idx = tcp_pcb_hash_idx(pcb->local_port, &pcb->remote_ip, pcb->remote_port);
+    pcb->hash_next = tcp_pcb_hash[idx];
+    tcp_pcb_hash[idx] = pcb;
+  } else if (pcbs == &tcp_listen_pcbs.pcbs) {
+    struct tcp_pcb_listen *lpcb = (struct tcp_pcb_listen *)pcb;
+    u32_t idx = TCP_LISTEN_HASH_IDX(lpcb->local_port);
+    lpcb->hash_next = tcp_listen_hash[idx];
+    tcp_listen_hash[idx] = lpcb;
+  }
+}
+
+/**
+ * Remove a pcb from the hash table belonging to the pcb list it is about to
+ * be removed from. Called from TCP_RMV (i.e. before the 4-tuple is cleared).
+ *
+ * @param pcbs the pcb list 'pcb' is removed from
+ * @param pcb the tcp_pcb to remove from the index
+ */
+void
+tcp_pcb_hash_remove(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  if ((pcbs == &tcp_active_pcbs) || (pcbs == &tcp_tw_pcbs)) {
+    struct tcp_pcb **pp = &tcp_pcb_hash[tcp_pcb_hash_idx(pcb->local_port, &pcb->remote_ip, pcb->remote_port)];
+    for (; *pp != NULL; pp = &(*pp)->hash_next) {
+      if (*pp == pcb) {
+        *pp = pcb->hash_next;
+        pcb->hash_next = NULL;
+        return;
+      }
+    }
+    /* not found: like TCP_RMV, tolerate removing a pcb twice (e.g. a pcb
+       closed from within tcp_input() with tcp_trigger_input_pcb_close()) */
+  } else if (pcbs == &tcp_listen_pcbs.pcbs) {
+    struct tcp_pcb_listen *lpcb = (struct tcp_pcb_listen *)pcb;
+    struct tcp_pcb_listen **pp = &tcp_listen_hash[TCP_LISTEN_HASH_IDX(lpcb->local_port)];
+    for (; *pp != NULL; pp = &(*pp)->hash_next) {
+      if (*pp == lpcb) {
+        *pp = lpcb->hash_next;
+        lpcb->hash_next = NULL;
+        return;
+      }
+    }
+  }
+}
+
+/**
+ * Find the active or TIME-WAIT pcb matching a connection 4-tuple.
+ *
+ * @param local_ip local ip address of the connection
+ * @param local_port local port of the connection
+ * @param remote_ip remote ip address of the connection
+ * @param remote_port remote port of the connection
+ * @param inp netif the segment was received on
+ * @return the matching pcb (check pcb->state for TIME_WAIT) or NULL
+ */
+struct tcp_pcb *
+tcp_pcb_hash_lookup(const ip_addr_t *local_ip, u16_t local_port,
+                    const ip_addr_t *remote_ip, u16_t remote_port,
+                    struct netif *inp)
+{
+  struct tcp_pcb *pcb;
+  struct tcp_pcb *head = tcp_pcb_hash[tcp_pcb_hash_idx(local_port, remote_ip, remote_port)];
+
+  for (pcb = head; pcb != NULL; pcb = pcb->hash_next) {
+    /* check if PCB is bound to specific netif */
+    if ((pcb->netif_idx != NETIF_NO_INDEX) && (pcb->netif_idx != netif_get_index(inp))) {
+      continue;
+    }
+    if (pcb->remote_port == remote_port &&
+        pcb->local_port == local_port &&
+        ip_addr_cmp(&pcb->remote_ip, remote_ip) &&
+        ip_addr_cmp(&pcb->local_ip, local_ip)) {
+      if (pcb == head) {
+        /* found without walking the bucket */
+        TCP_STATS_INC(tcp.cachehit);
+      }
+      return pcb;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Find the listening pcb accepting connections to a local address and port.
+ * Same matching rules as the list walk in tcp_input(): an exact local IP
+ * match is preferred over an ANY match if SO_REUSE is enabled.
+ *
+ * @param local_ip destination address of the incoming segment
+ * @param local_port destination port of the incoming segment
+ * @param inp netif the segment was received on
+ * @return the matching listen pcb or NULL
+ */
+struct tcp_pcb_listen *
+tcp_listen_hash_lookup(const ip_addr_t *local_ip, u16_t local_port, struct netif *inp)
+{
+  struct tcp_pcb_listen *lpcb;
+  struct tcp_pcb_listen *head = tcp_listen_hash[TCP_LISTEN_HASH_IDX(local_port)];
+#if SO_REUSE
+  struct tcp_pcb_listen *lpcb_any = NULL;
+#endif /* SO_REUSE */
+
+  for (lpcb = head; lpcb != NULL; lpcb = lpcb->hash_next) {
+    /* check if PCB is bound to specific netif */
+    if ((lpcb->netif_idx != NETIF_NO_INDEX) && (lpcb->netif_idx != netif_get_index(inp))) {
+      continue;
+    }
+    if (lpcb->local_port == local_port) {
+      if (IP_IS_ANY_TYPE_VAL(lpcb->local_ip)) {
+        /* found an ANY TYPE (IPv4/IPv6) match */
+#if SO_REUSE
+        lpcb_any = lpcb;
+#else /* SO_REUSE */
+        break;
+#endif /* SO_REUSE */
+      } else if (IP_ADDR_PCB_VERSION_MATCH_EXACT(lpcb, local_ip)) {
+        if (ip_addr_cmp(&lpcb->local_ip, local_ip)) {
+          /* found an exact match */
+          break;
+        } else if (ip_addr_isany(&lpcb->local_ip)) {
+          /* found an ANY-match */
+#if SO_REUSE
+          lpcb_any = lpcb;
+#else /* SO_REUSE */
+          break;
+#endif /* SO_REUSE */
+        }
+      }
+    }
+  }
+#if SO_REUSE
+  if (lpcb == NULL) {
+    /* only pass to ANY if no specific local IP has been found */
+    lpcb = lpcb_any;
+  }
+#endif /* SO_REUSE */
+  if ((lpcb != NULL) && (lpcb == head)) {
+    /* found without walking the bucket */
+    TCP_STATS_INC(tcp.cachehit);
+  }
+  return lpcb;
+}
+#endif /* LWIP_TCP_PCB_HASH */
+
 /**
  * Calculates a new initial sequence number for new connections.
  *
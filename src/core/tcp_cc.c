@@ -0,0 +1,370 @@
+/**
+ * @file
+ * Transmission Control Protocol, congestion control
+ *
+ * The congestion control algorithms of TCP. The core calls these via the
+ * TCP_CC_* macros in tcp_priv.h: directly to the "reno" functions below with
+ * LWIP_TCP_CC==0, via the struct tcp_cc_ops of each pcb with LWIP_TCP_CC==1.
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_TCP /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/def.h"
+#include "lwip/sys.h"
+
+#include <string.h>
+
+/**
+ * Slow start (RFC 5681 with RFC 3465 byte counting), shared by all modules.
+ */
+static void
+tcp_cc_slow_start(struct tcp_pcb *pcb, tcpwnd_size_t acked)
+{
+  tcpwnd_size_t increase;
+  /* limit to 1 SMSS segment during period following RTO */
+  u8_t num_seg = (pcb->flags & TF_RTO) ? 1 : 2;
+  /* RFC 3465, section 2.2 Slow Start */
+  increase = LWIP_MIN(acked, (tcpwnd_size_t)(num_seg * pcb->mss));
+  TCP_WND_INC(pcb->cwnd, increase);
+  LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: slow start cwnd %"TCPWNDSIZE_F"\n", pcb->cwnd));
+}
+
+/**
+ * Reno: update cwnd when new data is acknowledged.
+ *
+ * @param pcb the tcp_pcb that received the ACK
+ * @param acked number of bytes newly acknowledged
+ */
+void
+tcp_reno_on_ack(struct tcp_pcb *pcb, tcpwnd_size_t acked)
+{
+  if (pcb->cwnd < pcb->ssthresh) {
+    tcp_cc_slow_start(pcb, acked);
+  } else {
+    /* RFC 3465, section 2.1 Congestion Avoidance */
+    TCP_WND_INC(pcb->bytes_acked, acked);
+    if (pcb->bytes_acked >= pcb->cwnd) {
+      pcb->bytes_acked = (tcpwnd_size_t)(pcb->bytes_acked - pcb->cwnd);
+      TCP_WND_INC(pcb->cwnd, pcb->mss);
+    }
+    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: congestion avoidance cwnd %"TCPWNDSIZE_F"\n", pcb->cwnd));
+  }
+}
+
+/**
+ * Reno: fast retransmit was triggered, set ssthresh to half of the data
+ * in flight (approximated by the minimum of cwnd and the send window).
+ *
+ * @param pcb the tcp_pcb that entered loss recovery
+ */
+void
+tcp_reno_on_dupack(struct tcp_pcb *pcb)
+{
+  /* Set ssthresh to half of the minimum of the current
+   * cwnd and the advertised window */
+  pcb->ssthresh = LWIP_MIN(pcb->cwnd, pcb->snd_wnd) / 2;
+
+  /* The minimum value for ssthresh should be 2 MSS */
+  if (pcb->ssthresh < (2U * pcb->mss)) {
+    LWIP_DEBUGF(TCP_FR_DEBUG,
+                ("tcp_receive: The minimum value for ssthresh %"TCPWNDSIZE_F
+                 " should be min 2 mss %"U16_F"...\n",
+                 pcb->ssthresh, (u16_t)(2 * pcb->mss)));
+    pcb->ssthresh = 2 * pcb->mss;
+  }
+}
+
+/**
+ * Reno: retransmission timeout, halve ssthresh and restart from one segment.
+ *
+ * @param pcb the tcp_pcb that timed out
+ */
+void
+tcp_reno_on_rto(struct tcp_pcb *pcb)
+{
+  tcpwnd_size_t eff_wnd;
+
+  /* Reduce congestion window and ssthresh. */
+  eff_wnd = LWIP_MIN(pcb->cwnd, pcb->snd_wnd);
+  pcb->ssthresh = eff_wnd >> 1;
+  if (pcb->ssthresh < (tcpwnd_size_t)(pcb->mss << 1)) {
+    pcb->ssthresh = (tcpwnd_size_t)(pcb->mss << 1);
+  }
+  pcb->cwnd = pcb->mss;
+}
+
+/**
+ * Reno: loss recovery is complete, deflate cwnd to ssthresh.
+ *
+ * @param pcb the tcp_pcb that left loss recovery
+ */
+void
+tcp_reno_on_recovery_exit(struct tcp_pcb *pcb)
+{
+  pcb->cwnd = pcb->ssthresh;
+}
+
+#if LWIP_TCP_CC
+
+static void
+tcp_reno_init(struct tcp_pcb *pcb)
+{
+  LWIP_UNUSED_ARG(pcb);
+}
+
+/** The default congestion control module */
+const struct tcp_cc_ops tcp_cc_reno = {
+  "reno",
+  tcp_reno_init,
+  tcp_reno_on_ack,
+  tcp_reno_on_dupack,
+  tcp_reno_on_rto,
+  tcp_reno_on_recovery_exit
+};
+
+#if LWIP_TCP_CC_CUBIC
+/*
+ * CUBIC (RFC 9438) in integer arithmetic. Time is counted in units of
+ * 1/1024 s since the start of the congestion avoidance epoch, windows in
+ * bytes. beta_cubic is 0.7 and C is 0.4 segments/s^3.
+ */
+
+/** Upper limit for |t - K| (1024 s): keeps the cube within 64 bits */
+#define TCP_CUBIC_MAX_DELTA  (1UL << 20)
+
+/** per-pcb CUBIC state, lives in pcb->cc_priv */
+struct tcp_cubic {
+  u32_t w_max;       /* cwnd just before the last congestion event */
+  u32_t origin;      /* cwnd the cubic function returns to at time K */
+  u32_t w_est;       /* Reno-friendly estimate of cwnd (RFC 9438 4.3) */
+  u32_t k;           /* time until the cubic function reaches origin */
+  u32_t epoch_start; /* sys_now() when the current epoch started */
+  u32_t in_epoch;    /* epoch_start is valid */
+};
+
+#define TCP_CUBIC(pcb) ((struct tcp_cubic *)(void *)(pcb)->cc_priv)
+
+/** Integer cube root (bitwise, from Hacker's Delight) */
+static u32_t
+tcp_cubic_cbrt(u64_t x)
+{
+  u64_t y = 0;
+  u64_t b;
+  int s;
+
+  for (s = 63; s >= 0; s -= 3) {
+    y <<= 1;
+    b = 3 * y * (y + 1) + 1;
+    if ((x >> s) >= b) {
+      x -= b << s;
+      y++;
+    }
+  }
+  return (u32_t)y;
+}
+
+static void
+tcp_cubic_init(struct tcp_pcb *pcb)
+{
+  LWIP_ASSERT("TCP_CC_PRIV_SIZE too small for CUBIC",
+              sizeof(struct tcp_cubic) <= sizeof(pcb->cc_priv));
+  memset(pcb->cc_priv, 0, sizeof(struct tcp_cubic));
+}
+
+/** Congestion event: remember W_max and reduce ssthresh by beta_cubic */
+static void
+tcp_cubic_loss(struct tcp_pcb *pcb)
+{
+  struct tcp_cubic *ca = TCP_CUBIC(pcb);
+  u32_t eff_wnd = LWIP_MIN(pcb->cwnd, pcb->snd_wnd);
+  u32_t ssthresh;
+
+  if (eff_wnd < ca->w_max) {
+    /* fast convergence: release bandwidth to new flows */
+    ca->w_max = (u32_t)(((u64_t)eff_wnd * 17) / 20);
+  } else {
+    ca->w_max = eff_wnd;
+  }
+  ca->in_epoch = 0;
+
+  ssthresh = (u32_t)(((u64_t)eff_wnd * 7) / 10);
+  if (ssthresh < 2U * pcb->mss) {
+    ssthresh = 2U * pcb->mss;
+  }
+  pcb->ssthresh = (tcpwnd_size_t)ssthresh;
+}
+
+static void
+tcp_cubic_on_ack(struct tcp_pcb *pcb, tcpwnd_size_t acked)
+{
+  struct tcp_cubic *ca = TCP_CUBIC(pcb);
+  u32_t cwnd, target, t, delta;
+  u64_t offs;
+
+  if (pcb->cwnd < pcb->ssthresh) {
+    tcp_cc_slow_start(pcb, acked);
+    return;
+  }
+  cwnd = pcb->cwnd;
+
+  if (!ca->in_epoch) {
+    ca->in_epoch = 1;
+    ca->epoch_start = sys_now();
+    if (cwnd < ca->w_max) {
+      /* K = cbrt((W_max - cwnd) / C) */
+      ca->k = tcp_cubic_cbrt((((u64_t)(ca->w_max - cwnd) << 30) / pcb->mss) * 5 / 2);
+      ca->origin = ca->w_max;
+    } else {
+      ca->k = 0;
+      ca->origin = cwnd;
+    }
+    ca->w_est = cwnd;
+  }
+
+  t = sys_now() - ca->epoch_start;
+  t = (t < (TCP_CUBIC_MAX_DELTA * 1000 / 1024)) ? ((t << 10) / 1000) : TCP_CUBIC_MAX_DELTA;
+  delta = (t < ca->k) ? (ca->k - t) : (t - ca->k);
+  if (delta > TCP_CUBIC_MAX_DELTA) {
+    delta = TCP_CUBIC_MAX_DELTA;
+  }
+  /* C * (t - K)^3, scaled from (1/1024 s)^3 and segments to bytes */
+  offs = ((((u64_t)delta * delta * delta) >> 20) * pcb->mss * 2 / 5) >> 10;
+  if (t < ca->k) {
+    target = (offs < ca->origin) ? (u32_t)(ca->origin - offs) : 0;
+  } else {
+    target = (offs < (u64_t)(0xffffffffUL - ca->origin)) ? (u32_t)(ca->origin + offs) : 0xffffffffUL;
+  }
+  /* grow by at most 50% per RTT */
+  if (target > cwnd + cwnd / 2) {
+    target = cwnd + cwnd / 2;
+  }
+
+  /* W_est grows by 3 * (1 - beta) / (1 + beta) = 9/17 segments per RTT */
+  ca->w_est += (u32_t)(((u64_t)pcb->mss * acked * 9) / ((u64_t)cwnd * 17));
+
+  if (target > cwnd) {
+    cwnd += (u32_t)(((u64_t)(target - cwnd) * acked) / cwnd);
+  }
+  if (ca->w_est > cwnd) {
+    /* Reno-friendly region */
+    cwnd = ca->w_est;
+  }
+  if (cwnd > (tcpwnd_size_t)-1) {
+    cwnd = (tcpwnd_size_t)-1;
+  }
+  pcb->cwnd = (tcpwnd_size_t)cwnd;
+  LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_cubic_on_ack: cwnd %"TCPWNDSIZE_F" target %"U32_F"\n", pcb->cwnd, target));
+}
+
+static void
+tcp_cubic_on_dupack(struct tcp_pcb *pcb)
+{
+  tcp_cubic_loss(pcb);
+}
+
+static void
+tcp_cubic_on_rto(struct tcp_pcb *pcb)
+{
+  tcp_cubic_loss(pcb);
+  pcb->cwnd = pcb->mss;
+}
+
+/** CUBIC congestion control module (RFC 9438) */
+const struct tcp_cc_ops tcp_cc_cubic = {
+  "cubic",
+  tcp_cubic_init,
+  tcp_cubic_on_ack,
+  tcp_cubic_on_dupack,
+  tcp_cubic_on_rto,
+  tcp_reno_on_recovery_exit
+};
+#endif /* LWIP_TCP_CC_CUBIC */
+
+static const struct tcp_cc_ops *const tcp_cc_modules[] = {
+  &tcp_cc_reno,
+#if LWIP_TCP_CC_CUBIC
+  &tcp_cc_cubic,
+#endif /* LWIP_TCP_CC_CUBIC */
+};
+
+/**
+ * @ingroup tcp_raw
+ * Find a built-in congestion control module by name.
+ *
+ * @param name module name, e.g. "reno" or "cubic"
+ * @return the module or NULL if not found
+ */
+const struct tcp_cc_ops *
+tcp_cc_find(const char *name)
+{
+  size_t i;
+
+  LWIP_ERROR("tcp_cc_find: invalid name", name != NULL, return NULL);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(tcp_cc_modules); i++) {
+    if (strcmp(tcp_cc_modules[i]->name, name) == 0) {
+      return tcp_cc_modules[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @ingroup tcp_raw
+ * Change the congestion control module of a pcb. This may be done at any
+ * time; the new module starts from the current cwnd and ssthresh.
+ * On a listening pcb, this sets the module of connections accepted later.
+ *
+ * @param pcb tcp_pcb (or listening pcb) to change
+ * @param ops the module to use (built-in modules are tcp_cc_reno and,
+ *            with LWIP_TCP_CC_CUBIC, tcp_cc_cubic)
+ */
+void
+tcp_set_cc(struct tcp_pcb *pcb, const struct tcp_cc_ops *ops)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("tcp_set_cc: invalid pcb", pcb != NULL, return);
+  LWIP_ERROR("tcp_set_cc: invalid ops", ops != NULL, return);
+
+  pcb->cc_ops = ops;
+  if (pcb->state != LISTEN) {
+    ops->init(pcb);
+  }
+}
+#endif /* LWIP_TCP_CC */
+
+#endif /* LWIP_TCP */
@@ -55,6 +55,7 @@
 #include "lwip/stats.h"
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
+#include "lwip/sys.h"
 #if LWIP_ND6_TCP_REACHABILITY_HINTS
 #include "lwip/nd6.h"
 #endif /* LWIP_ND6_TCP_REACHABILITY_HINTS */
@@ -85,6 +86,18 @@ static u8_t flags;
 static u8_t recv_flags;
 static struct pbuf *recv_data;
 
+#if LWIP_TCP_SACK_IN
+/** A SACK option holds at most 4 blocks (40 bytes of options) */
+#define TCP_SACK_IN_MAX_BLOCKS 4
+/* SACK blocks of the incoming segment (RFC 2018), parsed by tcp_parseopt() */
+static struct tcp_sack_range sack_blocks[TCP_SACK_IN_MAX_BLOCKS];
+static u8_t sack_num_blocks;
+#endif /* LWIP_TCP_SACK_IN */
+#if LWIP_TCP_RTO_MS && LWIP_TCP_TIMESTAMPS
+/* TSecr of the incoming segment (0 if none) */
+static u32_t tcphdr_tsecr;
+#endif /* LWIP_TCP_RTO_MS && LWIP_TCP_TIMESTAMPS */
+
 struct tcp_pcb *tcp_input_pcb;
 
 /* Forward declarations. */
@@ -104,6 +117,12 @@ static void tcp_remove_sacks_lt(struct tcp_pcb *pcb, u32_t seq);
 static void tcp_remove_sacks_gt(struct tcp_pcb *pcb, u32_t seq);
 #endif /* TCP_OOSEQ_BYTES_LIMIT || TCP_OOSEQ_PBUFS_LIMIT */
 #endif /* LWIP_TCP_SACK_OUT */
+#if LWIP_TCP_SACK_IN
+static void tcp_sack_mark(struct tcp_pcb *pcb);
+#endif /* LWIP_TCP_SACK_IN */
+#if LWIP_TCP_RACK_TLP
+static void tcp_tlp_ack(struct tcp_pcb *pcb);
+#endif /* LWIP_TCP_RACK_TLP */
 
 /**
  * The initial input processing of TCP. It verifies the TCP header, demultiplexes
@@ -117,12 +136,15 @@ static void tcp_remove_sacks_gt(struct tcp_pcb *pcb, u32_t seq);
 void
 tcp_input(struct pbuf *p, struct netif *inp)
 {
-  struct tcp_pcb *pcb, *prev;
+  struct tcp_pcb *pcb, *twpcb = NULL;
   struct tcp_pcb_listen *lpcb;
+#if !LWIP_TCP_PCB_HASH
+  struct tcp_pcb *prev;
 #if SO_REUSE
   struct tcp_pcb *lpcb_prev = NULL;
   struct tcp_pcb_listen *lpcb_any = NULL;
 #endif /* SO_REUSE */
+#endif /* !LWIP_TCP_PCB_HASH */
   u8_t hdrlen_bytes;
   err_t err;
 
@@ -245,8 +267,17 @@ tcp_input(struct pbuf *p, struct netif *inp)
 
   /* Demultiplex an incoming segment. First, we check if it is destined
      for an active connection. */
+#if LWIP_TCP_PCB_HASH
+  /* active and TIME-WAIT pcbs share one hash table */
+  pcb = tcp_pcb_hash_lookup(ip_current_dest_addr(), tcphdr->dest,
+                            ip_current_src_addr(), tcphdr->src,
+                            ip_data.current_input_netif);
+  if ((pcb != NULL) && (pcb->state == TIME_WAIT)) {
+    twpcb = pcb;
+    pcb = NULL;
+  }
+#else /* LWIP_TCP_PCB_HASH */
   prev = NULL;
-
   for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
     LWIP_ASSERT("tcp_input: active pcb->state != CLOSED", pcb->state != CLOSED);
     LWIP_ASSERT("tcp_input: active pcb->state != TIME-WAIT", pcb->state != TIME_WAIT);
@@ -279,41 +310,51 @@ tcp_input(struct pbuf *p, struct netif *inp)
     }
     prev = pcb;
   }
+#endif /* LWIP_TCP_PCB_HASH */
 
   if (pcb == NULL) {
     /* If it did not go to an active connection, we check the connections
        in the TIME-WAIT state. */
-    for (pcb = tcp_tw_pcbs; pcb != NULL; pcb = pcb->next) {
-      LWIP_ASSERT("tcp_input: TIME-WAIT pcb->state == TIME-WAIT", pcb->state == TIME_WAIT);
+#if !LWIP_TCP_PCB_HASH
+    for (twpcb = tcp_tw_pcbs; twpcb != NULL; twpcb = twpcb->next) {
+      LWIP_ASSERT("tcp_input: TIME-WAIT pcb->state == TIME-WAIT", twpcb->state == TIME_WAIT);
 
       /* check if PCB is bound to specific netif */
-      if ((pcb->netif_idx != NETIF_NO_INDEX) &&
-          (pcb->netif_idx != netif_get_index(ip_data.current_input_netif))) {
+      if ((twpcb->netif_idx != NETIF_NO_INDEX) &&
+          (twpcb->netif_idx != netif_get_index(ip_data.current_input_netif))) {
         continue;
       }
 
-      if (pcb->remote_port == tcphdr->src &&
-          pcb->local_port == tcphdr->dest &&
-          ip_addr_cmp(&pcb->remote_ip, ip_current_src_addr()) &&
-          ip_addr_cmp(&pcb->local_ip, ip_current_dest_addr())) {
-        /* We don't really care enough to move this PCB to the front
-           of the list since we are not very likely to receive that
-           many segments for connections in TIME-WAIT. */
-        LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_input: packed for TIME_WAITing connection.\n"));
+      if (twpcb->remote_port == tcphdr->src &&
+          twpcb->local_port == tcphdr->dest &&
+          ip_addr_cmp(&twpcb->remote_ip, ip_current_src_addr()) &&
+          ip_addr_cmp(&twpcb->local_ip, ip_current_dest_addr())) {
+        break;
+      }
+    }
+#endif /* !LWIP_TCP_PCB_HASH */
+    if (twpcb != NULL) {
+      /* We don't really care enough to move this PCB to the front
+         of the list since we are not very likely to receive that
+         many segments for connections in TIME-WAIT. */
+      LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_input: packed for TIME_WAITing connection.\n"));
 #ifdef LWIP_HOOK_TCP_INPACKET_PCB
-        if (LWIP_HOOK_TCP_INPACKET_PCB(pcb, tcphdr, tcphdr_optlen, tcphdr_opt1len,
-                                       tcphdr_opt2, p) == ERR_OK)
+      if (LWIP_HOOK_TCP_INPACKET_PCB(twpcb, tcphdr, tcphdr_optlen, tcphdr_opt1len,
+                                     tcphdr_opt2, p) == ERR_OK)
 #endif
-        {
-          tcp_timewait_input(pcb);
-        }
-        pbuf_free(p);
-        return;
+      {
+        tcp_timewait_input(twpcb);
       }
+      pbuf_free(p);
+      return;
     }
 
     /* Finally, if we still did not get a match, we check all PCBs that
        are LISTENing for incoming connections. */
+#if LWIP_TCP_PCB_HASH
+    lpcb = tcp_listen_hash_lookup(ip_current_dest_addr(), tcphdr->dest,
+                                  ip_data.current_input_netif);
+#else /* LWIP_TCP_PCB_HASH */
     prev = NULL;
     for (lpcb = tcp_listen_pcbs.listen_pcbs; lpcb != NULL; lpcb = lpcb->next) {
       /* check if PCB is bound to specific netif */
@@ -357,7 +398,9 @@ tcp_input(struct pbuf *p, struct netif *inp)
       prev = lpcb_prev;
     }
 #endif /* SO_REUSE */
+#endif /* LWIP_TCP_PCB_HASH */
     if (lpcb != NULL) {
+#if !LWIP_TCP_PCB_HASH
       /* Move this PCB to the front of the list so that subsequent
          lookups will be faster (we exploit locality in TCP segment
          arrivals). */
@@ -370,6 +413,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
       } else {
         TCP_STATS_INC(tcp.cachehit);
       }
+#endif /* !LWIP_TCP_PCB_HASH */
 
       LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_input: packed for LISTENing connection.\n"));
 #ifdef LWIP_HOOK_TCP_INPACKET_PCB
@@ -403,6 +447,8 @@ tcp_input(struct pbuf *p, struct netif *inp)
 #if TCP_INPUT_DEBUG
     tcp_debug_print_state(pcb->state);
 #endif /* TCP_INPUT_DEBUG */
+    /* any segment may (re)start one of the connection's timers */
+    TCP_PCB_TIMER_ARM(pcb);
 
     /* Set up a tcp_seg structure. */
     inseg.next = NULL;
@@ -696,6 +742,11 @@ tcp_listen_input(struct tcp_pcb_listen *pcb)
     /* inherit socket options */
     npcb->so_options = pcb->so_options & SOF_INHERITED;
     npcb->netif_idx = pcb->netif_idx;
+#if LWIP_TCP_CC
+    if (npcb->cc_ops != pcb->cc_ops) {
+      tcp_set_cc(npcb, pcb->cc_ops);
+    }
+#endif /* LWIP_TCP_CC */
     /* Register the new PCB so that we can begin receiving segments
        for it. */
     TCP_REG_ACTIVE(npcb);
@@ -897,7 +948,7 @@ tcp_process(struct tcp_pcb *pcb)
         if (pcb->unacked == NULL) {
           pcb->rtime = -1;
         } else {
-          pcb->rtime = 0;
+          TCP_RTO_RESTART(pcb);
           pcb->nrtx = 0;
         }
 
@@ -918,7 +969,7 @@ tcp_process(struct tcp_pcb *pcb)
           connection faster, but do not send more SYNs than we otherwise would
           have, or we might get caught in a loop on loopback interfaces. */
         if (pcb->nrtx < TCP_SYNMAXRTX) {
-          pcb->rtime = 0;
+          TCP_RTO_RESTART(pcb);
           tcp_rexmit_rto(pcb);
         }
       }
@@ -1116,6 +1167,11 @@ tcp_free_acked_segments(struct tcp_pcb *pcb, struct tcp_seg *seg_list, const cha
 
     pcb->snd_queuelen = (u16_t)(pcb->snd_queuelen - clen);
     recv_acked = (tcpwnd_size_t)(recv_acked + next->len);
+#if LWIP_TCP_RACK_TLP
+    if ((pcb->flags & TF_SACK) && !(next->flags & TF_SEG_SACKED)) {
+      tcp_rack_update(pcb, next);
+    }
+#endif /* LWIP_TCP_RACK_TLP */
     tcp_seg_free(next);
 
     LWIP_DEBUGF(TCP_QLEN_DEBUG, ("%"TCPWNDSIZE_F" (after freeing %s)\n",
@@ -1129,6 +1185,43 @@ tcp_free_acked_segments(struct tcp_pcb *pcb, struct tcp_seg *seg_list, const cha
   return seg_list;
 }
 
+/**
+ * Feeds a round-trip time sample into the smoothed RTT estimator and
+ * recalculates the retransmission time-out from it.
+ *
+ * @param pcb the tcp_pcb the sample was taken on
+ * @param m the measured round-trip time (ticks, or milliseconds with LWIP_TCP_RTO_MS)
+ */
+static void
+tcp_rtt_update(struct tcp_pcb *pcb, tcprtt_t m)
+{
+  LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: experienced rtt %"TCPRTT_F" (%"U32_F" msec).\n",
+                              m, (u32_t)TCP_RTT_TO_MS(m)));
+
+#if LWIP_TCP_RTO_MS
+  if (pcb->sa == 0) {
+    /* First measurement: SRTT = R, RTTVAR = R/2 (RFC 6298, 2.2), so the
+       RTO does not have to converge down from the initial 3 seconds */
+    pcb->sa = (tcprtt_t)(m << 3);
+    pcb->sv = (tcprtt_t)(m << 1);
+  } else
+#endif /* LWIP_TCP_RTO_MS */
+  {
+    /* This is taken directly from VJs original code in his paper */
+    m = (tcprtt_t)(m - (pcb->sa >> 3));
+    pcb->sa = (tcprtt_t)(pcb->sa + m);
+    if (m < 0) {
+      m = (tcprtt_t) - m;
+    }
+    m = (tcprtt_t)(m - (pcb->sv >> 2));
+    pcb->sv = (tcprtt_t)(pcb->sv + m);
+  }
+  pcb->rto = TCP_RTO_CALC(pcb, 0);
+
+  LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: RTO %"TCPRTT_F" (%"U32_F" milliseconds)\n",
+                              pcb->rto, (u32_t)TCP_RTT_TO_MS(pcb->rto)));
+}
+
 /**
  * Called by tcp_process. Checks if the given segment is an ACK for outstanding
  * data, and if so frees the memory of the buffered data. Next, it places the
@@ -1144,7 +1237,6 @@ tcp_free_acked_segments(struct tcp_pcb *pcb, struct tcp_seg *seg_list, const cha
 static void
 tcp_receive(struct tcp_pcb *pcb)
 {
-  s16_t m;
   u32_t right_wnd_edge;
 
   LWIP_ASSERT("tcp_receive: invalid pcb", pcb != NULL);
@@ -1177,6 +1269,12 @@ tcp_receive(struct tcp_pcb *pcb)
 #endif /* TCP_WND_DEBUG */
     }
 
+#if LWIP_TCP_SACK_IN
+    if (sack_num_blocks > 0) {
+      tcp_sack_mark(pcb);
+    }
+#endif /* LWIP_TCP_SACK_IN */
+
     /* (From Stevens TCP/IP Illustrated Vol II, p970.) Its only a
      * duplicate ack if:
      * 1) It doesn't ACK new data
@@ -1210,13 +1308,28 @@ tcp_receive(struct tcp_pcb *pcb)
               if ((u8_t)(pcb->dupacks + 1) > pcb->dupacks) {
                 ++pcb->dupacks;
               }
-              if (pcb->dupacks > 3) {
-                /* Inflate the congestion window */
-                TCP_WND_INC(pcb->cwnd, pcb->mss);
-              }
-              if (pcb->dupacks >= 3) {
-                /* Do fast retransmit (checked via TF_INFR, not via dupacks count) */
-                tcp_rexmit_fast(pcb);
+#if LWIP_TCP_SACK_IN
+              if (pcb->flags & TF_SACK) {
+                if (pcb->flags & TF_INFR) {
+                  /* SACK based loss recovery: retransmit what is lost now */
+                  tcp_rexmit_sack(pcb);
+                } else if ((pcb->dupacks >= 3) ||
+                           ((pcb->unacked != NULL) && (tcp_sack_lost_end(pcb) != pcb->lastack))) {
+                  /* RFC 6675: start loss recovery after 3 dupacks or as soon as
+                     enough data is SACKed to consider the first segment lost */
+                  tcp_rexmit_fast(pcb);
+                }
+              } else
+#endif /* LWIP_TCP_SACK_IN */
+              {
+                if (pcb->dupacks > 3) {
+                  /* Inflate the congestion window */
+                  TCP_WND_INC(pcb->cwnd, pcb->mss);
+                }
+                if (pcb->dupacks >= 3) {
+                  /* Do fast retransmit (checked via TF_INFR, not via dupacks count) */
+                  tcp_rexmit_fast(pcb);
+                }
               }
             }
           }
@@ -1225,13 +1338,24 @@ tcp_receive(struct tcp_pcb *pcb)
     } else if (TCP_SEQ_BETWEEN(ackno, pcb->lastack + 1, pcb->snd_nxt)) {
       /* We come here when the ACK acknowledges new data. */
       tcpwnd_size_t acked;
-
+      u8_t in_recovery = 0;
+
+#if LWIP_TCP_SACK_IN
+      if (TCP_SACK_RECOVERY(pcb) && TCP_SEQ_LT(ackno, pcb->sack_recover)) {
+        /* Partial ACK: SACK based loss recovery (RFC 6675) only ends when
+           all data outstanding at its start is acknowledged. */
+        in_recovery = 1;
+      } else
+#endif /* LWIP_TCP_SACK_IN */
       /* Reset the "IN Fast Retransmit" flag, since we are no longer
          in fast retransmit. Also reset the congestion window to the
          slow start threshold. */
       if (pcb->flags & TF_INFR) {
+#if LWIP_TCP_SACK_IN
+        tcp_sack_recovery_done(pcb);
+#endif /* LWIP_TCP_SACK_IN */
         tcp_clear_flags(pcb, TF_INFR);
-        pcb->cwnd = pcb->ssthresh;
+        TCP_CC_ON_RECOVERY_EXIT(pcb);
         pcb->bytes_acked = 0;
       }
 
@@ -1239,7 +1363,7 @@ tcp_receive(struct tcp_pcb *pcb)
       pcb->nrtx = 0;
 
       /* Reset the retransmission time-out. */
-      pcb->rto = (s16_t)((pcb->sa >> 3) + pcb->sv);
+      pcb->rto = TCP_RTO_CALC(pcb, 0);
 
       /* Record how much data this ACK acks */
       acked = (tcpwnd_size_t)(ackno - pcb->lastack);
@@ -1250,24 +1374,8 @@ tcp_receive(struct tcp_pcb *pcb)
 
       /* Update the congestion control variables (cwnd and
          ssthresh). */
-      if (pcb->state >= ESTABLISHED) {
-        if (pcb->cwnd < pcb->ssthresh) {
-          tcpwnd_size_t increase;
-          /* limit to 1 SMSS segment during period following RTO */
-          u8_t num_seg = (pcb->flags & TF_RTO) ? 1 : 2;
-          /* RFC 3465, section 2.2 Slow Start */
-          increase = LWIP_MIN(acked, (tcpwnd_size_t)(num_seg * pcb->mss));
-          TCP_WND_INC(pcb->cwnd, increase);
-          LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: slow start cwnd %"TCPWNDSIZE_F"\n", pcb->cwnd));
-        } else {
-          /* RFC 3465, section 2.1 Congestion Avoidance */
-          TCP_WND_INC(pcb->bytes_acked, acked);
-          if (pcb->bytes_acked >= pcb->cwnd) {
-            pcb->bytes_acked = (tcpwnd_size_t)(pcb->bytes_acked - pcb->cwnd);
-            TCP_WND_INC(pcb->cwnd, pcb->mss);
-          }
-          LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: congestion avoidance cwnd %"TCPWNDSIZE_F"\n", pcb->cwnd));
-        }
+      if ((pcb->state >= ESTABLISHED) && !in_recovery) {
+        TCP_CC_ON_ACK(pcb, acked);
       }
       LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_receive: ACK for %"U32_F", unacked->seqno %"U32_F":%"U32_F"\n",
                                     ackno,
@@ -1292,9 +1400,16 @@ tcp_receive(struct tcp_pcb *pcb)
       if (pcb->unacked == NULL) {
         pcb->rtime = -1;
       } else {
-        pcb->rtime = 0;
+        TCP_RTO_RESTART(pcb);
       }
 
+#if LWIP_TCP_SACK_IN
+      if (in_recovery) {
+        /* continue retransmitting the holes the receiver reports */
+        tcp_rexmit_sack(pcb);
+      }
+#endif /* LWIP_TCP_SACK_IN */
+
       pcb->polltmr = 0;
 
 #if TCP_OVERSIZE
@@ -1335,32 +1450,37 @@ tcp_receive(struct tcp_pcb *pcb)
     LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: pcb->rttest %"U32_F" rtseq %"U32_F" ackno %"U32_F"\n",
                                 pcb->rttest, pcb->rtseq, ackno));
 
+#if LWIP_TCP_RTO_MS && LWIP_TCP_TIMESTAMPS
+    /* With timestamps, every ACK for new data echoes the send time of the
+       segment that triggered it, retransmitted or not (RFC 7323). The gains
+       in tcp_rtt_update() are made for one sample per RTT, so only the first
+       ACK beyond rtseq is sampled and rtseq then moves to the end of the
+       current flight (RFC 7323, Appendix G). */
+    if ((pcb->flags & TF_TIMESTAMP) && (tcphdr_tsecr != 0) && (recv_acked > 0) &&
+        ((s32_t)(sys_now() - tcphdr_tsecr) >= 0)) {
+      if (TCP_SEQ_LT(pcb->rtseq, ackno)) {
+        tcp_rtt_update(pcb, (tcprtt_t)(sys_now() - tcphdr_tsecr));
+        pcb->rtseq = pcb->snd_nxt;
+        pcb->rttest = 0;
+      }
+    } else
+#endif /* LWIP_TCP_RTO_MS && LWIP_TCP_TIMESTAMPS */
     /* RTT estimation calculations. This is done by checking if the
        incoming segment acknowledges the segment we use to take a
        round-trip time measurement. */
     if (pcb->rttest && TCP_SEQ_LT(pcb->rtseq, ackno)) {
       /* diff between this shouldn't exceed 32K since this are tcp timer ticks
-         and a round-trip shouldn't be that long... */
-      m = (s16_t)(tcp_ticks - pcb->rttest);
-
-      LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: experienced rtt %"U16_F" ticks (%"U16_F" msec).\n",
-                                  m, (u16_t)(m * TCP_SLOW_INTERVAL)));
-
-      /* This is taken directly from VJs original code in his paper */
-      m = (s16_t)(m - (pcb->sa >> 3));
-      pcb->sa = (s16_t)(pcb->sa + m);
-      if (m < 0) {
-        m = (s16_t) - m;
-      }
-      m = (s16_t)(m - (pcb->sv >> 2));
-      pcb->sv = (s16_t)(pcb->sv + m);
-      pcb->rto = (s16_t)((pcb->sa >> 3) + pcb->sv);
-
-      LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: RTO %"U16_F" (%"U16_F" milliseconds)\n",
-                                  pcb->rto, (u16_t)(pcb->rto * TCP_SLOW_INTERVAL)));
-
+         (or 2^31 milliseconds) and a round-trip shouldn't be that long... */
+      tcp_rtt_update(pcb, (tcprtt_t)(TCP_RTT_NOW() - pcb->rttest));
       pcb->rttest = 0;
     }
+
+#if LWIP_TCP_RACK_TLP
+    if (pcb->flags & TF_SACK) {
+      tcp_tlp_ack(pcb);
+      tcp_rack_detect_loss(pcb);
+    }
+#endif /* LWIP_TCP_RACK_TLP */
   }
 
   /* If the incoming segment contains data, we must process it
@@ -1913,6 +2033,13 @@ tcp_parseopt(struct tcp_pcb *pcb)
 
   LWIP_ASSERT("tcp_parseopt: invalid pcb", pcb != NULL);
 
+#if LWIP_TCP_SACK_IN
+  sack_num_blocks = 0;
+#endif /* LWIP_TCP_SACK_IN */
+#if LWIP_TCP_RTO_MS && LWIP_TCP_TIMESTAMPS
+  tcphdr_tsecr = 0;
+#endif /* LWIP_TCP_RTO_MS && LWIP_TCP_TIMESTAMPS */
+
   /* Parse the TCP MSS option, if present. */
   if (tcphdr_optlen != 0) {
     for (tcp_optidx = 0; tcp_optidx < tcphdr_optlen; ) {
@@ -1986,8 +2113,17 @@ tcp_parseopt(struct tcp_pcb *pcb)
           } else if (TCP_SEQ_BETWEEN(pcb->ts_lastacksent, seqno, seqno + tcplen)) {
             pcb->ts_recent = lwip_ntohl(tsval);
           }
+#if LWIP_TCP_RTO_MS
+          /* Keep the echoed timestamp: it is our own sys_now() at send time */
+          tsval = tcp_get_next_optbyte();
+          tsval |= (tcp_get_next_optbyte() << 8);
+          tsval |= (tcp_get_next_optbyte() << 16);
+          tsval |= (tcp_get_next_optbyte() << 24);
+          tcphdr_tsecr = lwip_ntohl(tsval);
+#else /* LWIP_TCP_RTO_MS */
           /* Advance to next option (6 bytes already read) */
           tcp_optidx += LWIP_TCP_OPT_LEN_TS - 6;
+#endif /* LWIP_TCP_RTO_MS */
           break;
 #endif /* LWIP_TCP_TIMESTAMPS */
 #if LWIP_TCP_SACK_OUT
@@ -2005,6 +2141,34 @@ tcp_parseopt(struct tcp_pcb *pcb)
           }
           break;
 #endif /* LWIP_TCP_SACK_OUT */
+#if LWIP_TCP_SACK_IN
+        case LWIP_TCP_OPT_SACK:
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK\n"));
+          data = tcp_get_next_optbyte();
+          if ((data < 10) || (((data - 2) & 7) != 0) || (tcp_optidx - 2 + data) > tcphdr_optlen) {
+            /* Bad length */
+            LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+            return;
+          }
+          /* TCP SACK option with valid length: 8 bytes (left and right edge) per block */
+          for (data = (u8_t)(data - 2); data > 0; data = (u8_t)(data - 8)) {
+            u32_t left = 0, right = 0;
+            u8_t i;
+            for (i = 0; i < 4; i++) {
+              left = (left << 8) | tcp_get_next_optbyte();
+            }
+            for (i = 0; i < 4; i++) {
+              right = (right << 8) | tcp_get_next_optbyte();
+            }
+            /* only use SACKs if we negotiated them */
+            if ((pcb->flags & TF_SACK) && (sack_num_blocks < TCP_SACK_IN_MAX_BLOCKS)) {
+              sack_blocks[sack_num_blocks].left = left;
+              sack_blocks[sack_num_blocks].right = right;
+              sack_num_blocks++;
+            }
+          }
+          break;
+#endif /* LWIP_TCP_SACK_IN */
         default:
           LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: other\n"));
           data = tcp_get_next_optbyte();
@@ -2028,6 +2192,82 @@ tcp_trigger_input_pcb_close(void)
   recv_flags |= TF_CLOSED;
 }
 
+#if LWIP_TCP_SACK_IN
+/**
+ * Called by tcp_receive() to mark the unacked segments that are completely
+ * covered by a SACK block of the incoming segment.
+ *
+ * @param pcb the tcp_pcb for which a segment arrived
+ */
+static void
+tcp_sack_mark(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+  u8_t i;
+
+  for (i = 0; i < sack_num_blocks; i++) {
+    u32_t left = sack_blocks[i].left;
+    u32_t right = sack_blocks[i].right;
+
+    /* ignore D-SACKs (RFC 2883) and invalid blocks */
+    if (TCP_SEQ_GEQ(left, right) || TCP_SEQ_LEQ(right, ackno) ||
+        TCP_SEQ_GT(right, pcb->snd_nxt)) {
+      LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_sack_mark: ignoring %"U32_F":%"U32_F"\n", left, right));
+      continue;
+    }
+    for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+      u32_t seg_seqno = lwip_ntohl(seg->tcphdr->seqno);
+      if (TCP_SEQ_GEQ(seg_seqno, right)) {
+        break;
+      }
+      if (TCP_SEQ_GEQ(seg_seqno, left) && TCP_SEQ_LEQ(seg_seqno + TCP_TCPLEN(seg), right)) {
+#if LWIP_TCP_RACK_TLP
+        if (!(seg->flags & TF_SEG_SACKED)) {
+          tcp_rack_update(pcb, seg);
+        }
+#endif /* LWIP_TCP_RACK_TLP */
+        seg->flags |= TF_SEG_SACKED;
+      }
+    }
+  }
+}
+#endif /* LWIP_TCP_SACK_IN */
+
+#if LWIP_TCP_RACK_TLP
+/**
+ * Called by tcp_receive() to end a tail loss probe episode (RFC 8985 7.4).
+ * If the probe retransmitted the last segment and the ACKs show that it
+ * repaired a loss, cwnd is reduced as after a fast recovery.
+ *
+ * @param pcb the tcp_pcb for which an ACK arrived
+ */
+static void
+tcp_tlp_ack(struct tcp_pcb *pcb)
+{
+  if (!(pcb->rack_flags & TCP_TLP_INFLIGHT) || TCP_SEQ_LT(ackno, pcb->tlp_end_seq)) {
+    return;
+  }
+  if (!(pcb->rack_flags & TCP_TLP_REXMIT) ||
+      ((sack_num_blocks > 0) && TCP_SEQ_LEQ(sack_blocks[0].right, ackno) &&
+       TCP_SEQ_LEQ(sack_blocks[0].right, pcb->tlp_end_seq))) {
+    /* the probe sent new data, or a D-SACK reports that the original and
+       the probe arrived: there was no loss */
+  } else if (TCP_SEQ_GT(ackno, pcb->tlp_end_seq)) {
+    /* data sent after the probe is ACKed, so the probe repaired a loss */
+    LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_tlp_ack: loss repaired by the probe\n"));
+    if (!(pcb->flags & TF_INFR)) {
+      TCP_CC_ON_DUPACK(pcb);
+      TCP_CC_ON_RECOVERY_EXIT(pcb);
+    }
+  } else if ((recv_acked > 0) || (tcplen > 0) || (sack_num_blocks > 0)) {
+    /* ACK for the probe: it may have repaired a loss, wait for more */
+    return;
+  }
+  /* else: a pure duplicate ACK, both the original and the probe arrived */
+  pcb->rack_flags &= (u8_t)~(TCP_TLP_INFLIGHT | TCP_TLP_REXMIT);
+}
+#endif /* LWIP_TCP_RACK_TLP */
+
 #if LWIP_TCP_SACK_OUT
 /**
  * Called by tcp_receive() to add new SACK entry.
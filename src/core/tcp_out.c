@@ -74,7 +74,7 @@
 #include "lwip/stats.h"
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
-#if LWIP_TCP_TIMESTAMPS
+#if LWIP_TCP_TIMESTAMPS || LWIP_TCP_RTO_MS
 #include "lwip/sys.h"
 #endif
 
@@ -126,6 +126,13 @@
 
 /* Forward declarations.*/
 static err_t tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif);
+static err_t tcp_write_data(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, struct pbuf *ref);
+#if LWIP_TCP_SACK_IN
+static u32_t tcp_sack_pipe(const struct tcp_pcb *pcb, u32_t lost_end);
+#endif /* LWIP_TCP_SACK_IN */
+#if LWIP_TCP_RACK_TLP
+static s32_t tcp_rack_remaining(const struct tcp_pcb *pcb, const struct tcp_seg *seg, u32_t now);
+#endif /* LWIP_TCP_RACK_TLP */
 
 /* tcp_route: common code that returns a fixed bound netif or calls ip_route */
 static struct netif *
@@ -347,6 +354,54 @@ tcp_write_checks(struct tcp_pcb *pcb, u16_t len)
   return ERR_OK;
 }
 
+#if LWIP_TCP_ZEROCOPY
+/** Free-callback of the pbufs created by tcp_data_pbuf_alloc() for
+ * tcp_write_ref(): drops their reference on the caller's pbuf. */
+static void
+tcp_ref_pbuf_free(struct pbuf *p)
+{
+  struct tcp_ref_pbuf *rp = (struct tcp_ref_pbuf *)p;
+  LWIP_ASSERT("rp != NULL", rp != NULL);
+  pbuf_free(rp->ref);
+  memp_free(MEMP_TCP_REF_PBUF, rp);
+}
+#endif /* LWIP_TCP_ZEROCOPY */
+
+/** Allocate a pbuf referencing (not copying) non-volatile data.
+ *
+ * @param layer pbuf layer passed to pbuf_alloc()
+ * @param data the data to reference
+ * @param len length of the data
+ * @param ref if not NULL, the returned pbuf holds a reference on this pbuf
+ *            until it is freed (tcp_write_ref())
+ */
+static struct pbuf *
+tcp_data_pbuf_alloc(pbuf_layer layer, const void *data, u16_t len, struct pbuf *ref)
+{
+  struct pbuf *p;
+#if LWIP_TCP_ZEROCOPY
+  if (ref != NULL) {
+    struct tcp_ref_pbuf *rp = (struct tcp_ref_pbuf *)memp_malloc(MEMP_TCP_REF_PBUF);
+    if (rp == NULL) {
+      return NULL;
+    }
+    rp->pc.custom_free_function = tcp_ref_pbuf_free;
+    rp->ref = ref;
+    p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_ROM, &rp->pc, LWIP_CONST_CAST(void *, data), len);
+    LWIP_ASSERT("tcp_data_pbuf_alloc: custom pbuf fits", p != NULL);
+    pbuf_ref(ref);
+    return p;
+  }
+#else /* LWIP_TCP_ZEROCOPY */
+  LWIP_UNUSED_ARG(ref);
+#endif /* LWIP_TCP_ZEROCOPY */
+  p = pbuf_alloc(layer, len, PBUF_ROM);
+  if (p != NULL) {
+    ((struct pbuf_rom *)p)->payload = data;
+  }
+  return p;
+}
+
 /**
  * @ingroup tcp_raw
  * Write data for sending (but does not send it immediately).
@@ -388,6 +443,42 @@ tcp_write_checks(struct tcp_pcb *pcb, u16_t len)
  */
 err_t
 tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
+{
+  return tcp_write_data(pcb, arg, len, apiflags, NULL);
+}
+
+#if LWIP_TCP_ZEROCOPY
+/**
+ * @ingroup tcp_raw
+ * Write data for sending by reference, like tcp_write() without
+ * TCP_WRITE_FLAG_COPY, and get notified once the stack is done with it.
+ *
+ * Every pbuf created to point into the data holds a reference on 'ref'.
+ * Pass a custom pbuf (see pbuf_alloced_custom(), it may have a length of 0)
+ * and drop your own reference after this call: its custom_free_function is
+ * called once the data is not referenced anymore, i.e. when all of it has
+ * been ACKed or the connection has been aborted. The data must not change
+ * until then.
+ *
+ * @param pcb Protocol control block for the TCP connection to enqueue data for.
+ * @param arg Pointer to the data to be enqueued for sending.
+ * @param len Data length in bytes
+ * @param apiflags TCP_WRITE_FLAG_MORE or 0 (TCP_WRITE_FLAG_COPY is ignored)
+ * @param ref pbuf to keep referenced while the data is in use
+ * @return ERR_OK if enqueued, another err_t on error (no reference is kept)
+ */
+err_t
+tcp_write_ref(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, struct pbuf *ref)
+{
+  LWIP_ERROR("tcp_write_ref: invalid ref", ref != NULL, return ERR_ARG);
+  return tcp_write_data(pcb, arg, len, (u8_t)(apiflags & ~TCP_WRITE_FLAG_COPY), ref);
+}
+#endif /* LWIP_TCP_ZEROCOPY */
+
+/** Implementation of tcp_write() and tcp_write_ref(): enqueue data with the
+ * pbufs referencing it holding a reference on 'ref' (if not NULL) */
+static err_t
+tcp_write_data(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, struct pbuf *ref)
 {
   struct pbuf *concat_p = NULL;
   struct tcp_seg *last_unsent = NULL, *seg = NULL, *prev_seg = NULL, *queue = NULL;
@@ -433,6 +524,7 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
   if (err != ERR_OK) {
     return err;
   }
+  TCP_PCB_TIMER_ARM(pcb);
   queuelen = pcb->snd_queuelen;
 
 #if LWIP_TCP_TIMESTAMPS
@@ -556,18 +648,18 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
         /* If the last unsent pbuf is of type PBUF_ROM, try to extend it. */
         struct pbuf *p;
         for (p = last_unsent->p; p->next != NULL; p = p->next);
-        if (((p->type_internal & (PBUF_TYPE_FLAG_STRUCT_DATA_CONTIGUOUS | PBUF_TYPE_FLAG_DATA_VOLATILE)) == 0) &&
+        if ((ref == NULL) &&
+            ((p->type_internal & (PBUF_TYPE_FLAG_STRUCT_DATA_CONTIGUOUS | PBUF_TYPE_FLAG_DATA_VOLATILE)) == 0) &&
             (const u8_t *)p->payload + p->len == (const u8_t *)arg) {
           LWIP_ASSERT("tcp_write: ROM pbufs cannot be oversized", pos == 0);
           extendlen = seglen;
         } else {
-          if ((concat_p = pbuf_alloc(PBUF_RAW, seglen, PBUF_ROM)) == NULL) {
+          /* reference the non-volatile payload data */
+          if ((concat_p = tcp_data_pbuf_alloc(PBUF_RAW, (const u8_t *)arg + pos, seglen, ref)) == NULL) {
             LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
                         ("tcp_write: could not allocate memory for zero-copy pbuf\n"));
             goto memerr;
           }
-          /* reference the non-volatile payload data */
-          ((struct pbuf_rom *)concat_p)->payload = (const u8_t *)arg + pos;
           queuelen += pbuf_clen(concat_p);
         }
 #if TCP_CHECKSUM_ON_COPY
@@ -624,7 +716,8 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 #if TCP_OVERSIZE
       LWIP_ASSERT("oversize == 0", oversize == 0);
 #endif /* TCP_OVERSIZE */
-      if ((p2 = pbuf_alloc(PBUF_TRANSPORT, seglen, PBUF_ROM)) == NULL) {
+      /* reference the non-volatile payload data */
+      if ((p2 = tcp_data_pbuf_alloc(PBUF_TRANSPORT, (const u8_t *)arg + pos, seglen, ref)) == NULL) {
         LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("tcp_write: could not allocate memory for zero-copy pbuf\n"));
         goto memerr;
       }
@@ -636,8 +729,6 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
         chksum = SWAP_BYTES_IN_WORD(chksum);
       }
 #endif /* TCP_CHECKSUM_ON_COPY */
-      /* reference the non-volatile payload data */
-      ((struct pbuf_rom *)p2)->payload = (const u8_t *)arg + pos;
 
       /* Second, allocate a pbuf for the headers. */
       if ((p = pbuf_alloc(PBUF_TRANSPORT, optlen, PBUF_RAM)) == NULL) {
@@ -1240,6 +1331,9 @@ tcp_output(struct tcp_pcb *pcb)
   u32_t wnd, snd_nxt;
   err_t err;
   struct netif *netif;
+#if LWIP_TCP_RACK_TLP
+  u8_t sent_new = 0;
+#endif /* LWIP_TCP_RACK_TLP */
 #if TCP_CWND_DEBUG
   s16_t i = 0;
 #endif /* TCP_CWND_DEBUG */
@@ -1250,6 +1344,8 @@ tcp_output(struct tcp_pcb *pcb)
   /* pcb->state LISTEN not allowed here */
   LWIP_ASSERT("don't call tcp_output for listen-pcbs",
               pcb->state != LISTEN);
+  /* sending may start the retransmission or persist timer */
+  TCP_PCB_TIMER_ARM(pcb);
 
   /* First, check if we are invoked by the TCP input processing
      code. If so, we do not output anything. Instead, we rely on the
@@ -1260,6 +1356,17 @@ tcp_output(struct tcp_pcb *pcb)
   }
 
   wnd = LWIP_MIN(pcb->snd_wnd, pcb->cwnd);
+#if LWIP_TCP_SACK_IN
+  if (TCP_SACK_RECOVERY(pcb)) {
+    /* RFC 6675: cwnd limits the data in the pipe, not all data since lastack,
+       so SACKed and lost segments make room for new data */
+    u32_t flight = pcb->snd_nxt - pcb->lastack;
+    u32_t pipe = tcp_sack_pipe(pcb, tcp_sack_lost_end(pcb));
+    if (pipe < flight) {
+      wnd = LWIP_MIN(pcb->snd_wnd, pcb->cwnd + (flight - pipe));
+    }
+  }
+#endif /* LWIP_TCP_SACK_IN */
 
   seg = pcb->unsent;
 
@@ -1373,6 +1480,9 @@ tcp_output(struct tcp_pcb *pcb)
     snd_nxt = lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg);
     if (TCP_SEQ_LT(pcb->snd_nxt, snd_nxt)) {
       pcb->snd_nxt = snd_nxt;
+#if LWIP_TCP_RACK_TLP
+      sent_new = 1;
+#endif /* LWIP_TCP_RACK_TLP */
     }
     /* put segment on unacknowledged list if length > 0 */
     if (TCP_TCPLEN(seg) > 0) {
@@ -1413,6 +1523,12 @@ tcp_output(struct tcp_pcb *pcb)
     pcb->unsent_oversize = 0;
   }
 #endif /* TCP_OVERSIZE */
+#if LWIP_TCP_RACK_TLP
+  if (sent_new && !(pcb->rack_flags & TCP_RACK_REO_TIMER)) {
+    /* a tail loss probe follows the last new data (RFC 8985 7.2) */
+    tcp_rack_tlp_schedule(pcb);
+  }
+#endif /* LWIP_TCP_RACK_TLP */
 
 output_done:
   tcp_clear_flags(pcb, TF_NAGLEMEMERR);
@@ -1532,11 +1648,20 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
   /* Set retransmission timer running if it is not currently enabled
      This must be set before checking the route. */
   if (pcb->rtime < 0) {
-    pcb->rtime = 0;
-  }
-
-  if (pcb->rttest == 0) {
-    pcb->rttest = tcp_ticks;
+    TCP_RTO_RESTART(pcb);
+  }
+#if LWIP_TCP_RACK_TLP
+  seg->xmit_time = sys_now();
+#endif /* LWIP_TCP_RACK_TLP */
+
+  if ((pcb->rttest == 0)
+#if LWIP_TCP_RTO_MS
+      /* Karn's algorithm: don't time retransmissions, their ACK is ambiguous
+         (tick resolution hides this, milliseconds do not) */
+      && (pcb->nrtx == 0) && !TCP_SEQ_LT(lwip_ntohl(seg->tcphdr->seqno), pcb->snd_nxt)
+#endif /* LWIP_TCP_RTO_MS */
+     ) {
+    pcb->rttest = TCP_RTT_NOW();
     pcb->rtseq = lwip_ntohl(seg->tcphdr->seqno);
 
     LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_output_segment: rtseq %"U32_F"\n", pcb->rtseq));
@@ -1652,6 +1777,28 @@ tcp_rexmit_rto_prepare(struct tcp_pcb *pcb)
     LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_rexmit_rto: segment busy\n"));
     return ERR_VAL;
   }
+#if LWIP_TCP_SACK_IN
+  if (pcb->flags & TF_SACK) {
+    struct tcp_seg *sack_seg;
+    /* The receiver may have discarded SACKed data, so everything is sent
+       again and loss recovery ends (RFC 2018, section 8) */
+    for (sack_seg = pcb->unacked; sack_seg != NULL; sack_seg = sack_seg->next) {
+      sack_seg->flags &= (u8_t)~TF_SEG_SACKED;
+    }
+    tcp_sack_recovery_done(pcb);
+    tcp_clear_flags(pcb, TF_INFR);
+  }
+#endif /* LWIP_TCP_SACK_IN */
+#if LWIP_TCP_RACK_TLP
+  {
+    struct tcp_seg *rack_seg;
+    for (rack_seg = pcb->unacked; rack_seg != NULL; rack_seg = rack_seg->next) {
+      rack_seg->flags |= TF_SEG_REXMITTED;
+    }
+    /* the RTO ends a loss probe episode and stops the RACK timers */
+    pcb->rack_flags &= (u8_t)~(TCP_RACK_TIMERS | TCP_TLP_INFLIGHT | TCP_TLP_REXMIT);
+  }
+#endif /* LWIP_TCP_RACK_TLP */
   /* concatenate unsent queue after unacked queue */
   seg->next = pcb->unsent;
 #if TCP_OVERSIZE_DBGCHECK
@@ -1714,26 +1861,18 @@ tcp_rexmit_rto(struct tcp_pcb *pcb)
 }
 
 /**
- * Requeue the first unacked segment for retransmission
- *
- * Called by tcp_receive() for fast retransmit.
+ * Move an unacked segment to the (sorted) unsent queue for retransmission
  *
- * @param pcb the tcp_pcb for which to retransmit the first unacked segment
+ * @param pcb the tcp_pcb the segment belongs to
+ * @param unacked_seg pointer to the link to the segment in the unacked queue
+ * @return ERR_OK if the segment was moved, ERR_VAL if it is still in use
  */
-err_t
-tcp_rexmit(struct tcp_pcb *pcb)
+static err_t
+tcp_rexmit_requeue(struct tcp_pcb *pcb, struct tcp_seg **unacked_seg)
 {
-  struct tcp_seg *seg;
+  struct tcp_seg *seg = *unacked_seg;
   struct tcp_seg **cur_seg;
 
-  LWIP_ASSERT("tcp_rexmit: invalid pcb", pcb != NULL);
-
-  if (pcb->unacked == NULL) {
-    return ERR_VAL;
-  }
-
-  seg = pcb->unacked;
-
   /* Give up if the segment is still referenced by the netif driver
      due to deferred transmission. */
   if (tcp_output_segment_busy(seg)) {
@@ -1741,9 +1880,9 @@ tcp_rexmit(struct tcp_pcb *pcb)
     return ERR_VAL;
   }
 
-  /* Move the first unacked segment to the unsent queue */
+  /* Move the unacked segment to the unsent queue */
   /* Keep the unsent queue sorted. */
-  pcb->unacked = seg->next;
+  *unacked_seg = seg->next;
 
   cur_seg = &(pcb->unsent);
   while (*cur_seg &&
@@ -1759,15 +1898,41 @@ tcp_rexmit(struct tcp_pcb *pcb)
   }
 #endif /* TCP_OVERSIZE */
 
+  /* Don't take any rtt measurements after retransmitting. */
+  pcb->rttest = 0;
+#if LWIP_TCP_RACK_TLP
+  seg->flags |= TF_SEG_REXMITTED;
+#endif /* LWIP_TCP_RACK_TLP */
+
+  MIB2_STATS_INC(mib2.tcpretranssegs);
+  return ERR_OK;
+}
+
+/**
+ * Requeue the first unacked segment for retransmission
+ *
+ * Called by tcp_receive() for fast retransmit.
+ *
+ * @param pcb the tcp_pcb for which to retransmit the first unacked segment
+ */
+err_t
+tcp_rexmit(struct tcp_pcb *pcb)
+{
+  LWIP_ASSERT("tcp_rexmit: invalid pcb", pcb != NULL);
+
+  if (pcb->unacked == NULL) {
+    return ERR_VAL;
+  }
+
+  if (tcp_rexmit_requeue(pcb, &pcb->unacked) != ERR_OK) {
+    return ERR_VAL;
+  }
+
   if (pcb->nrtx < 0xFF) {
     ++pcb->nrtx;
   }
 
-  /* Don't take any rtt measurements after retransmitting. */
-  pcb->rttest = 0;
-
   /* Do the actual retransmission. */
-  MIB2_STATS_INC(mib2.tcpretranssegs);
   /* No need to call tcp_output: we are always called from tcp_input()
      and thus tcp_output directly returns. */
   return ERR_OK;
@@ -1792,27 +1957,401 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
                  (u16_t)pcb->dupacks, pcb->lastack,
                  lwip_ntohl(pcb->unacked->tcphdr->seqno)));
     if (tcp_rexmit(pcb) == ERR_OK) {
-      /* Set ssthresh to half of the minimum of the current
-       * cwnd and the advertised window */
-      pcb->ssthresh = LWIP_MIN(pcb->cwnd, pcb->snd_wnd) / 2;
-
-      /* The minimum value for ssthresh should be 2 MSS */
-      if (pcb->ssthresh < (2U * pcb->mss)) {
-        LWIP_DEBUGF(TCP_FR_DEBUG,
-                    ("tcp_receive: The minimum value for ssthresh %"TCPWNDSIZE_F
-                     " should be min 2 mss %"U16_F"...\n",
-                     pcb->ssthresh, (u16_t)(2 * pcb->mss)));
-        pcb->ssthresh = 2 * pcb->mss;
+      /* Reduce ssthresh, cwnd is set from it below */
+      TCP_CC_ON_DUPACK(pcb);
+
+#if LWIP_TCP_SACK_IN
+      if (pcb->flags & TF_SACK) {
+        /* RFC 6675: the pipe estimate replaces window inflation */
+        pcb->cwnd = pcb->ssthresh;
+        pcb->sack_recover = pcb->snd_nxt;
+        /* the retransmitted segment is now the first unsent one */
+        pcb->unsent->flags |= TF_SEG_SACK_REXMIT;
+      } else
+#endif /* LWIP_TCP_SACK_IN */
+      {
+        pcb->cwnd = pcb->ssthresh + 3 * pcb->mss;
       }
-
-      pcb->cwnd = pcb->ssthresh + 3 * pcb->mss;
       tcp_set_flags(pcb, TF_INFR);
 
       /* Reset the retransmission timer to prevent immediate rto retransmissions */
-      pcb->rtime = 0;
+      TCP_RTO_RESTART(pcb);
+
+#if LWIP_TCP_SACK_IN
+      if (pcb->flags & TF_SACK) {
+        /* retransmit other holes that already count as lost */
+        tcp_rexmit_sack(pcb);
+      }
+#endif /* LWIP_TCP_SACK_IN */
+    }
+  }
+}
+
+#if LWIP_TCP_SACK_IN
+/** Number of SACKed segments above a hole that mark it as lost (DupThresh) */
+#define TCP_SACK_DUPTHRESH 3
+
+/**
+ * Find the end of the data that counts as lost (RFC 6675 IsLost()):
+ * unacked data is lost if TCP_SACK_DUPTHRESH segments or more than
+ * (TCP_SACK_DUPTHRESH - 1) * mss bytes above it have been SACKed.
+ * SACKed segments are counted instead of discontiguous SACKed ranges.
+ * With LWIP_TCP_RACK_TLP, segments that RACK considers lost count as well.
+ *
+ * @param pcb the tcp_pcb to check
+ * @return sequence number following the highest lost segment (pcb->lastack
+ *         if nothing is lost)
+ */
+u32_t
+tcp_sack_lost_end(const struct tcp_pcb *pcb)
+{
+  const struct tcp_seg *seg;
+  u32_t sacked_bytes = 0;
+  u32_t sacked_segs = 0;
+  u32_t lost_end = pcb->lastack;
+#if LWIP_TCP_RACK_TLP
+  u32_t now = sys_now();
+#endif /* LWIP_TCP_RACK_TLP */
+
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    if (seg->flags & TF_SEG_SACKED) {
+      sacked_bytes += seg->len;
+      sacked_segs++;
+    }
+  }
+  /* walk up until the data SACKed above a segment does not mark it lost */
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    if (seg->flags & TF_SEG_SACKED) {
+      sacked_bytes -= seg->len;
+      sacked_segs--;
+    } else if ((sacked_segs >= TCP_SACK_DUPTHRESH) ||
+               (sacked_bytes > (u32_t)(TCP_SACK_DUPTHRESH - 1) * pcb->mss)
+#if LWIP_TCP_RACK_TLP
+               || (tcp_rack_remaining(pcb, seg, now) <= 0)
+#endif /* LWIP_TCP_RACK_TLP */
+              ) {
+      lost_end = lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg);
+#if LWIP_TCP_RACK_TLP
+    } else if (seg->flags & TF_SEG_SACK_REXMIT) {
+      /* a retransmission is sent later than the segments above it,
+         which may be lost nevertheless */
+      continue;
+#endif /* LWIP_TCP_RACK_TLP */
+    } else {
+      break;
     }
   }
+  return lost_end;
+}
+
+/**
+ * Estimate the data in flight (RFC 6675 SetPipe()): unacked data that is
+ * neither SACKed nor lost, plus data retransmitted during this recovery and
+ * lost data queued on unsent for retransmission.
+ */
+static u32_t
+tcp_sack_pipe(const struct tcp_pcb *pcb, u32_t lost_end)
+{
+  const struct tcp_seg *seg;
+  u32_t pipe = 0;
+#if LWIP_TCP_RACK_TLP
+  u32_t now = sys_now();
+#endif /* LWIP_TCP_RACK_TLP */
+
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    if ((seg->flags & TF_SEG_SACKED) == 0) {
+      if (TCP_SEQ_GT(lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg), lost_end)) {
+        pipe += seg->len;
+      }
+      if ((seg->flags & TF_SEG_SACK_REXMIT)
+#if LWIP_TCP_RACK_TLP
+          /* a lost retransmission has left the network as well */
+          && (tcp_rack_remaining(pcb, seg, now) > 0)
+#endif /* LWIP_TCP_RACK_TLP */
+         ) {
+        pipe += seg->len;
+      }
+    }
+  }
+  for (seg = pcb->unsent; (seg != NULL) && TCP_SEQ_LT(lwip_ntohl(seg->tcphdr->seqno), pcb->snd_nxt);
+       seg = seg->next) {
+    pipe += seg->len;
+  }
+  return pipe;
+}
+
+/**
+ * Retransmit lost segments during SACK based loss recovery (RFC 6675
+ * NextSeg() rule 1) as long as cwnd allows it. Segments that were SACKed or
+ * already retransmitted are skipped. New data is sent by tcp_output(), which
+ * limits it by the pipe estimate (rule 2).
+ *
+ * Called by tcp_receive() for each ACK received during loss recovery.
+ *
+ * @param pcb the tcp_pcb in SACK based loss recovery
+ */
+void
+tcp_rexmit_sack(struct tcp_pcb *pcb)
+{
+  struct tcp_seg **cur_seg;
+  u32_t lost_end, pipe;
+#if LWIP_TCP_RACK_TLP
+  u32_t now = sys_now();
+#endif /* LWIP_TCP_RACK_TLP */
+
+  LWIP_ASSERT("tcp_rexmit_sack: invalid pcb", pcb != NULL);
+
+  lost_end = tcp_sack_lost_end(pcb);
+  pipe = tcp_sack_pipe(pcb, lost_end);
+  cur_seg = &pcb->unacked;
+  while ((*cur_seg != NULL) && (pipe + pcb->mss <= pcb->cwnd)) {
+    struct tcp_seg *seg = *cur_seg;
+    if (TCP_SEQ_GT(lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg), lost_end)) {
+      break;
+    }
+    if (((seg->flags & (TF_SEG_SACKED | TF_SEG_SACK_REXMIT)) == 0)
+#if LWIP_TCP_RACK_TLP
+        /* RACK detects lost retransmissions, too */
+        || (((seg->flags & TF_SEG_SACKED) == 0) && (tcp_rack_remaining(pcb, seg, now) <= 0))
+#endif /* LWIP_TCP_RACK_TLP */
+       ) {
+      LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_rexmit_sack: retransmit %"U32_F"\n",
+                                 lwip_ntohl(seg->tcphdr->seqno)));
+      if (tcp_rexmit_requeue(pcb, cur_seg) != ERR_OK) {
+        break;
+      }
+      seg->flags |= TF_SEG_SACK_REXMIT;
+      pipe += seg->len;
+    } else {
+      cur_seg = &seg->next;
+    }
+  }
+}
+
+/**
+ * Leave SACK based loss recovery: forget which segments were retransmitted
+ * during this recovery.
+ *
+ * @param pcb the tcp_pcb leaving loss recovery
+ */
+void
+tcp_sack_recovery_done(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    seg->flags &= (u8_t)~TF_SEG_SACK_REXMIT;
+  }
+  for (seg = pcb->unsent; seg != NULL; seg = seg->next) {
+    seg->flags &= (u8_t)~TF_SEG_SACK_REXMIT;
+  }
+}
+#endif /* LWIP_TCP_SACK_IN */
+
+#if LWIP_TCP_RACK_TLP
+/** tcp_rack_remaining() for segments sent after the last delivered one */
+#define TCP_RACK_NOT_LOST 0x7FFFFFFF
+
+/**
+ * RACK (RFC 8985 6.2 step 2): remember the most recently sent segment that
+ * was delivered. Called for every segment that is newly ACKed or SACKed.
+ *
+ * @param pcb the tcp_pcb the segment belongs to
+ * @param seg the delivered segment
+ */
+void
+tcp_rack_update(struct tcp_pcb *pcb, const struct tcp_seg *seg)
+{
+  u32_t rtt = sys_now() - seg->xmit_time;
+  u32_t end_seq = lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg);
+
+  if ((seg->flags & TF_SEG_REXMITTED) && (rtt < pcb->rack_min_rtt)) {
+    /* too fast for the retransmission: the original was delivered */
+    return;
+  }
+  if ((pcb->rack_min_rtt == 0) || (rtt < pcb->rack_min_rtt)) {
+    pcb->rack_min_rtt = rtt;
+  }
+  pcb->rack_rtt = rtt;
+  if (!(pcb->rack_flags & TCP_RACK_VALID) ||
+      ((s32_t)(seg->xmit_time - pcb->rack_xmit_ts) > 0) ||
+      ((seg->xmit_time == pcb->rack_xmit_ts) && TCP_SEQ_GT(end_seq, pcb->rack_end_seq))) {
+    pcb->rack_xmit_ts = seg->xmit_time;
+    pcb->rack_end_seq = end_seq;
+    pcb->rack_flags |= TCP_RACK_VALID;
+  }
+}
+
+/**
+ * RACK (RFC 8985 6.2 step 5): an unacked segment is lost when it was sent
+ * before the most recently delivered segment and is not delivered within
+ * one RTT plus the reordering window after being sent.
+ *
+ * @return milliseconds until the segment is considered lost (<= 0 if it is
+ *         lost now), or TCP_RACK_NOT_LOST
+ */
+static s32_t
+tcp_rack_remaining(const struct tcp_pcb *pcb, const struct tcp_seg *seg, u32_t now)
+{
+  s32_t sent_before = (s32_t)(pcb->rack_xmit_ts - seg->xmit_time);
+  u32_t reo_wnd;
+
+  if (!(pcb->rack_flags & TCP_RACK_VALID) || (sent_before < 0) ||
+      ((sent_before == 0) &&
+       TCP_SEQ_GEQ(lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg), pcb->rack_end_seq))) {
+    return TCP_RACK_NOT_LOST;
+  }
+  /* reordering window: a quarter of the minimum RTT, at most SRTT, but at
+     least one clock tick since sys_now() cannot order sends within one ms */
+  reo_wnd = LWIP_MIN(pcb->rack_min_rtt / 4, (u32_t)(pcb->sa >> 3));
+  reo_wnd = LWIP_MAX(reo_wnd, 1);
+  return (s32_t)(seg->xmit_time + pcb->rack_rtt + reo_wnd - now);
+}
+
+/**
+ * RACK loss detection, called after every ACK and when the reordering timer
+ * expires: start or continue loss recovery if segments are lost, then arm
+ * the reordering timer for the segment that is considered lost next, or
+ * the loss probe timer if there is none.
+ *
+ * @param pcb the tcp_pcb (with TF_SACK) to check
+ */
+void
+tcp_rack_detect_loss(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+  s32_t reo_timeout = TCP_RACK_NOT_LOST;
+  u32_t now;
+
+  pcb->rack_flags &= (u8_t)~TCP_RACK_TIMERS;
+  if ((pcb->unacked == NULL) || (pcb->flags & TF_RTO)) {
+    /* nothing in flight, or everything is sent again after an RTO */
+    return;
+  }
+  if (tcp_sack_lost_end(pcb) != pcb->lastack) {
+    if (pcb->flags & TF_INFR) {
+      tcp_rexmit_sack(pcb);
+    } else {
+      tcp_rexmit_fast(pcb);
+    }
+  }
+  now = sys_now();
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    if ((seg->flags & TF_SEG_SACKED) == 0) {
+      s32_t remaining = tcp_rack_remaining(pcb, seg, now);
+      if ((remaining > 0) && (remaining < reo_timeout)) {
+        reo_timeout = remaining;
+      }
+    }
+  }
+  if (reo_timeout != TCP_RACK_NOT_LOST) {
+    tcp_rack_timer_start(pcb, TCP_RACK_REO_TIMER, (u32_t)reo_timeout);
+  } else {
+    tcp_rack_tlp_schedule(pcb);
+  }
+}
+
+/**
+ * Arm the loss probe timer (RFC 8985 7.2): 2 * SRTT after the last new data
+ * or ACK, plus the worst case delayed ACK time if a single segment is in
+ * flight, but not later than the RTO.
+ *
+ * @param pcb the tcp_pcb that sent new data or received an ACK
+ */
+void
+tcp_rack_tlp_schedule(struct tcp_pcb *pcb)
+{
+  u32_t pto;
+  s32_t rto_left;
+
+  if (!(pcb->flags & TF_SACK) || (pcb->flags & (TF_INFR | TF_RTO)) ||
+      (pcb->state < ESTABLISHED) || (pcb->unacked == NULL) || (pcb->nrtx != 0) ||
+      (pcb->sa == 0) || (pcb->rack_flags & TCP_TLP_INFLIGHT)) {
+    /* not in the open state, or no RTT sample yet */
+    return;
+  }
+  pto = (u32_t)(pcb->sa >> 2);
+  if (pcb->unacked->next == NULL) {
+    pto += TCP_TLP_WCDELACK;
+  }
+  rto_left = (s32_t)(pcb->rto_start + (u32_t)pcb->rto - sys_now());
+  if (rto_left <= 0) {
+    return;
+  }
+  tcp_rack_timer_start(pcb, TCP_RACK_PTO_TIMER, LWIP_MIN(pto, (u32_t)rto_left));
+}
+
+/**
+ * Send a tail loss probe (RFC 8985 7.3): new data if the receive window
+ * allows it, else the last segment sent. The probe is sent regardless of
+ * cwnd and the Nagle algorithm.
+ *
+ * @param pcb the tcp_pcb whose loss probe timer expired
+ */
+static void
+tcp_rack_tlp_send(struct tcp_pcb *pcb)
+{
+  struct tcp_seg **tail;
+  tcpwnd_size_t cwnd = pcb->cwnd;
+  tcpflags_t nodelay = (tcpflags_t)(pcb->flags & TF_NODELAY);
+  u32_t probe_end;
+
+  if (!(pcb->flags & TF_SACK) || (pcb->flags & (TF_INFR | TF_RTO)) ||
+      (pcb->unacked == NULL) || (pcb->nrtx != 0) || (pcb->rack_flags & TCP_TLP_INFLIGHT)) {
+    return;
+  }
+  if ((pcb->unsent != NULL) &&
+      TCP_SEQ_LEQ(lwip_ntohl(pcb->unsent->tcphdr->seqno) + TCP_TCPLEN(pcb->unsent),
+                  pcb->lastack + pcb->snd_wnd)) {
+    probe_end = lwip_ntohl(pcb->unsent->tcphdr->seqno) + TCP_TCPLEN(pcb->unsent);
+  } else {
+    tail = &pcb->unacked;
+    while ((*tail)->next != NULL) {
+      tail = &(*tail)->next;
+    }
+    probe_end = lwip_ntohl((*tail)->tcphdr->seqno) + TCP_TCPLEN(*tail);
+    if (tcp_rexmit_requeue(pcb, tail) != ERR_OK) {
+      return;
+    }
+    pcb->rack_flags |= TCP_TLP_REXMIT;
+  }
+  LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_rack_tlp_send: probe up to %"U32_F"\n", probe_end));
+
+  pcb->rack_flags |= TCP_TLP_INFLIGHT;
+  if (pcb->cwnd < probe_end - pcb->lastack) {
+    pcb->cwnd = (tcpwnd_size_t)(probe_end - pcb->lastack);
+  }
+  tcp_set_flags(pcb, TF_NODELAY);
+  tcp_output(pcb);
+  pcb->cwnd = cwnd;
+  if (!nodelay) {
+    tcp_clear_flags(pcb, TF_NODELAY);
+  }
+  pcb->tlp_end_seq = pcb->snd_nxt;
+  /* the RTO is counted from the probe */
+  TCP_RTO_RESTART(pcb);
+}
+
+/**
+ * Called by tcp_rto_timer() when the RACK reordering timer or the loss
+ * probe timer of a pcb expires.
+ *
+ * @param pcb the tcp_pcb whose timer expired
+ */
+void
+tcp_rack_tlp_timeout(struct tcp_pcb *pcb)
+{
+  u8_t timer = (u8_t)(pcb->rack_flags & TCP_RACK_TIMERS);
+
+  pcb->rack_flags &= (u8_t)~TCP_RACK_TIMERS;
+  if (timer & TCP_RACK_REO_TIMER) {
+    tcp_rack_detect_loss(pcb);
+    tcp_output(pcb);
+  } else {
+    tcp_rack_tlp_send(pcb);
+  }
 }
+#endif /* LWIP_TCP_RACK_TLP */
 
 static struct pbuf *
 tcp_output_alloc_header_common(u32_t ackno, u16_t optlen, u16_t datalen,
@@ -61,6 +61,8 @@
 #include "lwip/sys.h"
 #include "lwip/pbuf.h"
 
+#include <string.h>
+
 #if LWIP_DEBUG_TIMERNAMES
 #define HANDLER(x) x, #x
 #else /* LWIP_DEBUG_TIMERNAMES */
@@ -118,12 +120,29 @@ const int lwip_num_cyclic_timers = LWIP_ARRAYSIZE(lwip_cyclic_timers);
 
 #if LWIP_TIMERS && !LWIP_TIMERS_CUSTOM
 
+#if LWIP_TIMERS_WHEEL
+#define TIMERS_WHEEL_MASK (LWIP_TIMERS_WHEEL_SIZE - 1)
+
+/** Timing wheel: slot (time & TIMERS_WHEEL_MASK) holds the timeouts due at
+ * that time (modulo LWIP_TIMERS_WHEEL_SIZE), sorted by due time. The 'prev'
+ * pointer of the first timeout in a slot points to the last one. */
+static struct sys_timeo *timeouts_wheel[LWIP_TIMERS_WHEEL_SIZE];
+/** Timeouts hashed by handler and arg for sys_untimeout() */
+static struct sys_timeo *timeouts_hash[LWIP_TIMERS_WHEEL_SIZE];
+/** The timeout due next or NULL if not known (yet) */
+static struct sys_timeo *next_timeout;
+/** No timeout is due before this time */
+static u32_t timeouts_wheel_time;
+/** Number of timeouts in the wheel */
+static u32_t timeouts_wheel_count;
+#else /* LWIP_TIMERS_WHEEL */
 /** The one and only timeout list */
 static struct sys_timeo *next_timeout;
+#endif /* LWIP_TIMERS_WHEEL */
 
 static u32_t current_timeout_due_time;
 
-#if LWIP_TESTMODE
+#if LWIP_TESTMODE && !LWIP_TIMERS_WHEEL
 struct sys_timeo**
 sys_timeouts_get_next_timeout(void)
 {
@@ -176,6 +195,158 @@ tcp_timer_needed(void)
 }
 #endif /* LWIP_TCP */
 
+#if LWIP_TIMERS_WHEEL
+static u32_t
+timeouts_hash_idx(sys_timeout_handler handler, void *arg)
+{
+  u32_t h = (u32_t)(mem_ptr_t)handler ^ (u32_t)((mem_ptr_t)arg >> 2);
+  /* multiplicative hashing: the upper bits are the well mixed ones */
+  h *= 0x9E3779B1UL;
+  return (h >> 16) & TIMERS_WHEEL_MASK;
+}
+
+/** Insert a timeout into its wheel slot and its hash bucket */
+static void
+timeouts_wheel_add(struct sys_timeo *timeout)
+{
+  struct sys_timeo **slot = &timeouts_wheel[timeout->time & TIMERS_WHEEL_MASK];
+  struct sys_timeo *head = *slot;
+  u32_t idx;
+
+  if (head == NULL) {
+    timeout->next = NULL;
+    timeout->prev = timeout;
+    *slot = timeout;
+  } else {
+    /* search backwards from the slot's tail since new timeouts are mostly
+       due after the ones already in the slot; insert after equal times so
+       that timeouts due at the same time are called in the order added */
+    struct sys_timeo *t = head->prev;
+    while (TIME_LESS_THAN(timeout->time, t->time)) {
+      if (t == head) {
+        t = NULL;
+        break;
+      }
+      t = t->prev;
+    }
+    if (t == NULL) {
+      /* new first timeout of this slot */
+      timeout->next = head;
+      timeout->prev = head->prev;
+      head->prev = timeout;
+      *slot = timeout;
+    } else {
+      timeout->next = t->next;
+      timeout->prev = t;
+      if (t->next != NULL) {
+        t->next->prev = timeout;
+      } else {
+        head->prev = timeout;
+      }
+      t->next = timeout;
+    }
+  }
+
+  idx = timeouts_hash_idx(timeout->h, timeout->arg);
+  timeout->hash_next = timeouts_hash[idx];
+  timeouts_hash[idx] = timeout;
+
+  if (timeouts_wheel_count++ == 0) {
+    timeouts_wheel_time = timeout->time;
+    next_timeout = timeout;
+  } else if (TIME_LESS_THAN(timeout->time, timeouts_wheel_time)) {
+    timeouts_wheel_time = timeout->time;
+    next_timeout = timeout;
+  } else if ((next_timeout != NULL) && TIME_LESS_THAN(timeout->time, next_timeout->time)) {
+    next_timeout = timeout;
+  }
+}
+
+/** Unlink a timeout from its wheel slot only */
+static void
+timeouts_wheel_unlink(struct sys_timeo *timeout)
+{
+  struct sys_timeo **slot = &timeouts_wheel[timeout->time & TIMERS_WHEEL_MASK];
+  struct sys_timeo *head = *slot;
+
+  if (timeout == head) {
+    *slot = timeout->next;
+    if (timeout->next != NULL) {
+      timeout->next->prev = timeout->prev;
+    }
+  } else {
+    timeout->prev->next = timeout->next;
+    if (timeout->next != NULL) {
+      timeout->next->prev = timeout->prev;
+    } else {
+      head->prev = timeout->prev;
+    }
+  }
+}
+
+/**
+ * Remove a timeout from the wheel.
+ *
+ * @param timeout the timeout to remove
+ * @param hash_prev the pointer pointing to 'timeout' in its hash bucket
+ *                  or NULL to search for it
+ */
+static void
+timeouts_wheel_remove(struct sys_timeo *timeout, struct sys_timeo **hash_prev)
+{
+  timeouts_wheel_unlink(timeout);
+
+  if (hash_prev == NULL) {
+    hash_prev = &timeouts_hash[timeouts_hash_idx(timeout->h, timeout->arg)];
+    while ((*hash_prev != NULL) && (*hash_prev != timeout)) {
+      hash_prev = &(*hash_prev)->hash_next;
+    }
+  }
+  LWIP_ASSERT("timeouts_wheel_remove: timeout not in hash bucket", *hash_prev == timeout);
+  *hash_prev = timeout->hash_next;
+
+  timeouts_wheel_count--;
+  if (timeout == next_timeout) {
+    next_timeout = NULL;
+  }
+}
+
+/**
+ * Find the timeout due next. The first timeout of a slot is the earliest
+ * in that slot, so starting at timeouts_wheel_time, the first slot whose
+ * first timeout is due in the current wheel revolution holds the timeout
+ * due next. If there is none, the earliest of all slots' first timeouts is.
+ *
+ * @return the timeout due next or NULL if there are no timeouts
+ */
+static struct sys_timeo *
+timeouts_wheel_next(void)
+{
+  u32_t i;
+  struct sys_timeo *t;
+
+  if ((next_timeout != NULL) || (timeouts_wheel_count == 0)) {
+    return next_timeout;
+  }
+  for (i = 0; i < LWIP_TIMERS_WHEEL_SIZE; i++) {
+    u32_t time = (u32_t)(timeouts_wheel_time + i);
+    t = timeouts_wheel[time & TIMERS_WHEEL_MASK];
+    if (t != NULL) {
+      if (t->time == time) {
+        next_timeout = t;
+        break;
+      }
+      if ((next_timeout == NULL) || TIME_LESS_THAN(t->time, next_timeout->time)) {
+        next_timeout = t;
+      }
+    }
+  }
+  LWIP_ASSERT("timeouts_wheel_next: timeout missing", next_timeout != NULL);
+  timeouts_wheel_time = next_timeout->time;
+  return next_timeout;
+}
+#endif /* LWIP_TIMERS_WHEEL */
+
 static void
 #if LWIP_DEBUG_TIMERNAMES
 sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg, const char *handler_name)
@@ -183,7 +354,10 @@ sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg, const ch
 sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg)
 #endif
 {
-  struct sys_timeo *timeout, *t;
+  struct sys_timeo *timeout;
+#if !LWIP_TIMERS_WHEEL
+  struct sys_timeo *t;
+#endif /* !LWIP_TIMERS_WHEEL */
 
   timeout = (struct sys_timeo *)memp_malloc(MEMP_SYS_TIMEOUT);
   if (timeout == NULL) {
@@ -202,6 +376,9 @@ sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg)
                              (void *)timeout, abs_time, handler_name, (void *)arg));
 #endif /* LWIP_DEBUG_TIMERNAMES */
 
+#if LWIP_TIMERS_WHEEL
+  timeouts_wheel_add(timeout);
+#else /* LWIP_TIMERS_WHEEL */
   if (next_timeout == NULL) {
     next_timeout = timeout;
     return;
@@ -218,6 +395,7 @@ sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg)
       }
     }
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /**
@@ -316,10 +494,33 @@ sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
 void
 sys_untimeout(sys_timeout_handler handler, void *arg)
 {
-  struct sys_timeo *prev_t, *t;
+  struct sys_timeo *t;
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo **pt, **match;
+#else /* LWIP_TIMERS_WHEEL */
+  struct sys_timeo *prev_t;
+#endif /* LWIP_TIMERS_WHEEL */
 
   LWIP_ASSERT_CORE_LOCKED();
 
+#if LWIP_TIMERS_WHEEL
+  /* find the matching timeout that is due first */
+  match = NULL;
+  for (pt = &timeouts_hash[timeouts_hash_idx(handler, arg)]; *pt != NULL; pt = &(*pt)->hash_next) {
+    t = *pt;
+    if ((t->h == handler) && (t->arg == arg)) {
+      /* newer timeouts come first: on equal times, keep the older one */
+      if ((match == NULL) || !TIME_LESS_THAN((*match)->time, t->time)) {
+        match = pt;
+      }
+    }
+  }
+  if (match != NULL) {
+    t = *match;
+    timeouts_wheel_remove(t, match);
+    memp_free(MEMP_SYS_TIMEOUT, t);
+  }
+#else /* LWIP_TIMERS_WHEEL */
   if (next_timeout == NULL) {
     return;
   }
@@ -337,6 +538,7 @@ sys_untimeout(sys_timeout_handler handler, void *arg)
       return;
     }
   }
+#endif /* LWIP_TIMERS_WHEEL */
   return;
 }
 
@@ -365,7 +567,11 @@ sys_check_timeouts(void)
 
     PBUF_CHECK_FREE_OOSEQ();
 
+#if LWIP_TIMERS_WHEEL
+    tmptimeout = timeouts_wheel_next();
+#else /* LWIP_TIMERS_WHEEL */
     tmptimeout = next_timeout;
+#endif /* LWIP_TIMERS_WHEEL */
     if (tmptimeout == NULL) {
       return;
     }
@@ -375,7 +581,11 @@ sys_check_timeouts(void)
     }
 
     /* Timeout has expired */
+#if LWIP_TIMERS_WHEEL
+    timeouts_wheel_remove(tmptimeout, NULL);
+#else /* LWIP_TIMERS_WHEEL */
     next_timeout = tmptimeout->next;
+#endif /* LWIP_TIMERS_WHEEL */
     handler = tmptimeout->h;
     arg = tmptimeout->arg;
     current_timeout_due_time = tmptimeout->time;
@@ -406,6 +616,40 @@ sys_restart_timeouts(void)
   u32_t now;
   u32_t base;
   struct sys_timeo *t;
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo *list, **list_tail;
+  u32_t i;
+
+  if (timeouts_wheel_next() == NULL) {
+    return;
+  }
+
+  now = sys_now();
+  base = next_timeout->time;
+
+  /* the slots change with the times, so take all timeouts out of the wheel
+     and put them back in (the hash buckets stay the same) */
+  list = NULL;
+  list_tail = &list;
+  for (i = 0; i < LWIP_TIMERS_WHEEL_SIZE; i++) {
+    /* keep the slot order so that equal times stay in the order added */
+    *list_tail = timeouts_wheel[i];
+    for (t = timeouts_wheel[i]; t != NULL; t = t->next) {
+      list_tail = &t->next;
+    }
+    timeouts_wheel[i] = NULL;
+  }
+  /* timeouts_wheel_add() re-adds to the hash buckets, too */
+  memset(timeouts_hash, 0, sizeof(timeouts_hash));
+  timeouts_wheel_count = 0;
+  next_timeout = NULL;
+  while (list != NULL) {
+    t = list;
+    list = t->next;
+    t->time = (t->time - base) + now;
+    timeouts_wheel_add(t);
+  }
+#else /* LWIP_TIMERS_WHEEL */
 
   if (next_timeout == NULL) {
     return;
@@ -417,6 +661,7 @@ sys_restart_timeouts(void)
   for (t = next_timeout; t != NULL; t = t->next) {
     t->time = (t->time - base) + now;
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /** Return the time left before the next timeout is due. If no timeouts are
@@ -429,9 +674,15 @@ sys_timeouts_sleeptime(void)
 
   LWIP_ASSERT_CORE_LOCKED();
 
+#if LWIP_TIMERS_WHEEL
+  if (timeouts_wheel_next() == NULL) {
+    return SYS_TIMEOUTS_SLEEPTIME_INFINITE;
+  }
+#else /* LWIP_TIMERS_WHEEL */
   if (next_timeout == NULL) {
     return SYS_TIMEOUTS_SLEEPTIME_INFINITE;
   }
+#endif /* LWIP_TIMERS_WHEEL */
   now = sys_now();
   if (TIME_LESS_THAN(next_timeout->time, now)) {
     return 0;
@@ -80,6 +80,27 @@ static u16_t udp_port = UDP_LOCAL_PORT_RANGE_START;
 /* exported in udp.h (was static) */
 struct udp_pcb *udp_pcbs;
 
+#if LWIP_UDP_PCB_HASH
+/* Hash index of connected pcbs (by local port, remote address and port) */
+static struct udp_pcb *udp_pcb_hash[UDP_PCB_HASH_SIZE];
+/* Hash index of all other pcbs on udp_pcbs (by local port only) */
+static struct udp_pcb *udp_port_hash[UDP_PCB_HASH_SIZE];
+
+#define UDP_PORT_HASH_IDX(port) ((u32_t)((port) ^ ((port) >> 8)) & (UDP_PCB_HASH_SIZE - 1))
+
+/** Connected pcbs go to udp_pcb_hash, unless connected to the any address */
+#define UDP_PCB_IS_HASH_CONNECTED(pcb) ((((pcb)->flags & UDP_FLAGS_CONNECTED) != 0) && \
+                                        !ip_addr_isany_val((pcb)->remote_ip))
+
+static void udp_pcb_hash_add(struct udp_pcb *pcb);
+static u8_t udp_pcb_hash_remove(struct udp_pcb *pcb);
+#define UDP_PCB_HASH_ADD(pcb) udp_pcb_hash_add(pcb)
+#define UDP_PCB_HASH_RMV(pcb) udp_pcb_hash_remove(pcb)
+#else /* LWIP_UDP_PCB_HASH */
+#define UDP_PCB_HASH_ADD(pcb)
+#define UDP_PCB_HASH_RMV(pcb)
+#endif /* LWIP_UDP_PCB_HASH */
+
 /**
  * Initialize this module.
  */
@@ -178,6 +199,173 @@ udp_input_local_match(struct udp_pcb *pcb, struct netif *inp, u8_t broadcast)
   return 0;
 }
 
+#if LWIP_UDP_PCB_HASH
+/** Fold an IP address into 32 bits for hashing */
+static u32_t
+udp_pcb_hash_addr(const ip_addr_t *addr)
+{
+#if LWIP_IPV6
+  if (IP_IS_V6(addr)) {
+    const u32_t *a = ip_2_ip6(addr)->addr;
+    return a[0] ^ a[1] ^ a[2] ^ a[3];
+  }
+#endif /* LWIP_IPV6 */
+#if LWIP_IPV4
+  return ip4_addr_get_u32(ip_2_ip4(addr));
+#else /* LWIP_IPV4 */
+  return 0;
+#endif /* LWIP_IPV4 */
+}
+
+/** Calculate the udp_pcb_hash bucket for a connected pcb */
+static u32_t
+udp_pcb_hash_idx(u16_t local_port, const ip_addr_t *remote_ip, u16_t remote_port)
+{
+  u32_t h = udp_pcb_hash_addr(remote_ip) ^ (((u32_t)remote_port << 16) | local_port);
+  /* multiplicative hashing: the upper bits are the well mixed ones */
+  h *= 0x9E3779B1UL;
+  return (h >> 16) & (UDP_PCB_HASH_SIZE - 1);
+}
+
+/**
+ * Return the hash bucket 'pcb' belongs to with its current addresses
+ * and flags.
+ */
+static struct udp_pcb **
+udp_pcb_hash_bucket(struct udp_pcb *pcb)
+{
+  if (UDP_PCB_IS_HASH_CONNECTED(pcb)) {
+    return &udp_pcb_hash[udp_pcb_hash_idx(pcb->local_port, &pcb->remote_ip, pcb->remote_port)];
+  }
+  return &udp_port_hash[UDP_PORT_HASH_IDX(pcb->local_port)];
+}
+
+/**
+ * Index a pcb that is on udp_pcbs. Must be called after every change of
+ * local port, remote address/port or UDP_FLAGS_CONNECTED.
+ *
+ * @param pcb the udp_pcb to index
+ */
+static void
+udp_pcb_hash_add(struct udp_pcb *pcb)
+{
+  struct udp_pcb **bucket = udp_pcb_hash_bucket(pcb);
+  /* insert at the front like udp_pcbs, so that udp_input() still prefers
+     the most recently bound of several unconnected pcbs */
+  pcb->hash_next = *bucket;
+  *bucket = pcb;
+}
+
+/**
+ * Remove a pcb from the hash index. Must be called before changing any of
+ * the fields the index is keyed by.
+ *
+ * @param pcb the udp_pcb to remove from the index
+ * @return 1 if the pcb was indexed, 0 if not (e.g. not bound yet)
+ */
+static u8_t
+udp_pcb_hash_remove(struct udp_pcb *pcb)
+{
+  struct udp_pcb **pp;
+  for (pp = udp_pcb_hash_bucket(pcb); *pp != NULL; pp = &(*pp)->hash_next) {
+    if (*pp == pcb) {
+      *pp = pcb->hash_next;
+      pcb->hash_next = NULL;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Find a pcb connected to the source of the current input packet.
+ *
+ * @param dest destination port of the datagram
+ * @param src source port of the datagram
+ * @param inp network interface on which the datagram was received
+ * @param broadcast 1 if his is an IPv4 broadcast (see udp_input_local_match())
+ * @return the matching pcb or NULL
+ */
+static struct udp_pcb *
+udp_pcb_hash_lookup(u16_t dest, u16_t src, struct netif *inp, u8_t broadcast)
+{
+  struct udp_pcb *pcb;
+  const ip_addr_t *src_ip = ip_current_src_addr();
+  struct udp_pcb *head = udp_pcb_hash[udp_pcb_hash_idx(dest, src_ip, src)];
+
+  for (pcb = head; pcb != NULL; pcb = pcb->hash_next) {
+    if ((pcb->local_port == dest) && (pcb->remote_port == src) &&
+        ip_addr_cmp(&pcb->remote_ip, src_ip) &&
+        (udp_input_local_match(pcb, inp, broadcast) != 0)) {
+      if (pcb == head) {
+        /* found without walking the bucket */
+        UDP_STATS_INC(udp.cachehit);
+      }
+      return pcb;
+    }
+  }
+  return NULL;
+}
+#endif /* LWIP_UDP_PCB_HASH */
+
+/** Check one pcb against the current input datagram in udp_input()
+ *
+ * @param pcb pcb to check
+ * @param inp network interface on which the datagram was received
+ * @param broadcast 1 if this is an IPv4 broadcast (global or subnet-only), 0 otherwise
+ * @param dest destination port of the datagram
+ * @param src source port of the datagram
+ * @param uncon_pcb best unconnected pcb matching the destination so far, updated
+ * @return 1 if pcb is connected to the source of the datagram, 0 otherwise
+ */
+static u8_t
+udp_input_pcb_match(struct udp_pcb *pcb, struct netif *inp, u8_t broadcast,
+                    u16_t dest, u16_t src, struct udp_pcb **uncon_pcb)
+{
+  /* print the PCB local and remote address */
+  LWIP_DEBUGF(UDP_DEBUG, ("pcb ("));
+  ip_addr_debug_print_val(UDP_DEBUG, pcb->local_ip);
+  LWIP_DEBUGF(UDP_DEBUG, (", %"U16_F") <-- (", pcb->local_port));
+  ip_addr_debug_print_val(UDP_DEBUG, pcb->remote_ip);
+  LWIP_DEBUGF(UDP_DEBUG, (", %"U16_F")\n", pcb->remote_port));
+
+  /* compare PCB local addr+port to UDP destination addr+port */
+  if ((pcb->local_port == dest) &&
+      (udp_input_local_match(pcb, inp, broadcast) != 0)) {
+    if ((pcb->flags & UDP_FLAGS_CONNECTED) == 0) {
+      if (*uncon_pcb == NULL) {
+        /* the first unconnected matching PCB */
+        *uncon_pcb = pcb;
+#if LWIP_IPV4
+      } else if (broadcast && ip4_current_dest_addr()->addr == IPADDR_BROADCAST) {
+        /* global broadcast address (only valid for IPv4; match was checked before) */
+        if (!IP_IS_V4_VAL((*uncon_pcb)->local_ip) || !ip4_addr_cmp(ip_2_ip4(&(*uncon_pcb)->local_ip), netif_ip4_addr(inp))) {
+          /* uncon_pcb does not match the input netif, check this pcb */
+          if (IP_IS_V4_VAL(pcb->local_ip) && ip4_addr_cmp(ip_2_ip4(&pcb->local_ip), netif_ip4_addr(inp))) {
+            /* better match */
+            *uncon_pcb = pcb;
+          }
+        }
+#endif /* LWIP_IPV4 */
+      }
+#if SO_REUSE
+      else if (!ip_addr_isany(&pcb->local_ip)) {
+        /* prefer specific IPs over catch-all */
+        *uncon_pcb = pcb;
+      }
+#endif /* SO_REUSE */
+    }
+
+    /* compare PCB remote addr+port to UDP source addr+port */
+    if ((pcb->remote_port == src) &&
+        (ip_addr_isany_val(pcb->remote_ip) ||
+         ip_addr_cmp(&pcb->remote_ip, ip_current_src_addr()))) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
 /**
  * Process an incoming UDP datagram.
  *
@@ -194,7 +382,10 @@ void
 udp_input(struct pbuf *p, struct netif *inp)
 {
   struct udp_hdr *udphdr;
-  struct udp_pcb *pcb, *prev;
+  struct udp_pcb *pcb;
+#if !LWIP_UDP_PCB_HASH
+  struct udp_pcb *prev;
+#endif /* !LWIP_UDP_PCB_HASH */
   struct udp_pcb *uncon_pcb;
   u16_t src, dest;
   u8_t broadcast;
@@ -243,68 +434,41 @@ udp_input(struct pbuf *p, struct netif *inp)
   ip_addr_debug_print_val(UDP_DEBUG, *ip_current_src_addr());
   LWIP_DEBUGF(UDP_DEBUG, (", %"U16_F")\n", lwip_ntohs(udphdr->src)));
 
-  pcb = NULL;
-  prev = NULL;
   uncon_pcb = NULL;
+#if LWIP_UDP_PCB_HASH
+  /* Look up a pcb connected to the source first. If there is none, check
+   * the pcbs bound to the destination port like the list walk below does. */
+  pcb = udp_pcb_hash_lookup(dest, src, inp, broadcast);
+  if (pcb == NULL) {
+    for (pcb = udp_port_hash[UDP_PORT_HASH_IDX(dest)]; pcb != NULL; pcb = pcb->hash_next) {
+      if (udp_input_pcb_match(pcb, inp, broadcast, dest, src, &uncon_pcb)) {
+        break;
+      }
+    }
+  }
+#else /* LWIP_UDP_PCB_HASH */
+  prev = NULL;
   /* Iterate through the UDP pcb list for a matching pcb.
    * 'Perfect match' pcbs (connected to the remote port & ip address) are
    * preferred. If no perfect match is found, the first unconnected pcb that
    * matches the local port and ip address gets the datagram. */
   for (pcb = udp_pcbs; pcb != NULL; pcb = pcb->next) {
-    /* print the PCB local and remote address */
-    LWIP_DEBUGF(UDP_DEBUG, ("pcb ("));
-    ip_addr_debug_print_val(UDP_DEBUG, pcb->local_ip);
-    LWIP_DEBUGF(UDP_DEBUG, (", %"U16_F") <-- (", pcb->local_port));
-    ip_addr_debug_print_val(UDP_DEBUG, pcb->remote_ip);
-    LWIP_DEBUGF(UDP_DEBUG, (", %"U16_F")\n", pcb->remote_port));
-
-    /* compare PCB local addr+port to UDP destination addr+port */
-    if ((pcb->local_port == dest) &&
-        (udp_input_local_match(pcb, inp, broadcast) != 0)) {
-      if ((pcb->flags & UDP_FLAGS_CONNECTED) == 0) {
-        if (uncon_pcb == NULL) {
-          /* the first unconnected matching PCB */
-          uncon_pcb = pcb;
-#if LWIP_IPV4
-        } else if (broadcast && ip4_current_dest_addr()->addr == IPADDR_BROADCAST) {
-          /* global broadcast address (only valid for IPv4; match was checked before) */
-          if (!IP_IS_V4_VAL(uncon_pcb->local_ip) || !ip4_addr_cmp(ip_2_ip4(&uncon_pcb->local_ip), netif_ip4_addr(inp))) {
-            /* uncon_pcb does not match the input netif, check this pcb */
-            if (IP_IS_V4_VAL(pcb->local_ip) && ip4_addr_cmp(ip_2_ip4(&pcb->local_ip), netif_ip4_addr(inp))) {
-              /* better match */
-              uncon_pcb = pcb;
-            }
-          }
-#endif /* LWIP_IPV4 */
-        }
-#if SO_REUSE
-        else if (!ip_addr_isany(&pcb->local_ip)) {
-          /* prefer specific IPs over catch-all */
-          uncon_pcb = pcb;
-        }
-#endif /* SO_REUSE */
-      }
-
-      /* compare PCB remote addr+port to UDP source addr+port */
-      if ((pcb->remote_port == src) &&
-          (ip_addr_isany_val(pcb->remote_ip) ||
-           ip_addr_cmp(&pcb->remote_ip, ip_current_src_addr()))) {
-        /* the first fully matching PCB */
-        if (prev != NULL) {
-          /* move the pcb to the front of udp_pcbs so that is
-             found faster next time */
-          prev->next = pcb->next;
-          pcb->next = udp_pcbs;
-          udp_pcbs = pcb;
-        } else {
-          UDP_STATS_INC(udp.cachehit);
-        }
-        break;
+    if (udp_input_pcb_match(pcb, inp, broadcast, dest, src, &uncon_pcb)) {
+      /* the first fully matching PCB */
+      if (prev != NULL) {
+        /* move the pcb to the front of udp_pcbs so that is
+           found faster next time */
+        prev->next = pcb->next;
+        pcb->next = udp_pcbs;
+        udp_pcbs = pcb;
+      } else {
+        UDP_STATS_INC(udp.cachehit);
       }
+      break;
     }
-
     prev = pcb;
   }
+#endif /* LWIP_UDP_PCB_HASH */
   /* no fully matching pcb found? then look for an unconnected pcb */
   if (pcb == NULL) {
     pcb = uncon_pcb;
@@ -1014,6 +1178,7 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
     }
   }
 
+  UDP_PCB_HASH_RMV(pcb);
   ip_addr_set_ipaddr(&pcb->local_ip, ipaddr);
 
   pcb->local_port = port;
@@ -1024,6 +1189,7 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
     pcb->next = udp_pcbs;
     udp_pcbs = pcb;
   }
+  UDP_PCB_HASH_ADD(pcb);
   LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("udp_bind: bound to "));
   ip_addr_debug_print_val(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, pcb->local_ip);
   LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, (", port %"U16_F")\n", pcb->local_port));
@@ -1088,6 +1254,7 @@ udp_connect(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
     }
   }
 
+  UDP_PCB_HASH_RMV(pcb);
   ip_addr_set_ipaddr(&pcb->remote_ip, ipaddr);
 #if LWIP_IPV6 && LWIP_IPV6_SCOPES
   /* If the given IP address should have a zone but doesn't, assign one now,
@@ -1109,13 +1276,16 @@ udp_connect(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
   /* Insert UDP PCB into the list of active UDP PCBs. */
   for (ipcb = udp_pcbs; ipcb != NULL; ipcb = ipcb->next) {
     if (pcb == ipcb) {
-      /* already on the list, just return */
-      return ERR_OK;
+      /* already on the list */
+      break;
     }
   }
-  /* PCB not yet on the list, add PCB now */
-  pcb->next = udp_pcbs;
-  udp_pcbs = pcb;
+  if (ipcb == NULL) {
+    /* PCB not yet on the list, add PCB now */
+    pcb->next = udp_pcbs;
+    udp_pcbs = pcb;
+  }
+  UDP_PCB_HASH_ADD(pcb);
   return ERR_OK;
 }
 
@@ -1129,10 +1299,18 @@ udp_connect(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
 void
 udp_disconnect(struct udp_pcb *pcb)
 {
+#if LWIP_UDP_PCB_HASH
+  u8_t hashed;
+#endif /* LWIP_UDP_PCB_HASH */
+
   LWIP_ASSERT_CORE_LOCKED();
 
   LWIP_ERROR("udp_disconnect: invalid pcb", pcb != NULL, return);
 
+#if LWIP_UDP_PCB_HASH
+  hashed = udp_pcb_hash_remove(pcb);
+#endif /* LWIP_UDP_PCB_HASH */
+
   /* reset remote address association */
 #if LWIP_IPV4 && LWIP_IPV6
   if (IP_IS_ANY_TYPE_VAL(pcb->local_ip)) {
@@ -1147,6 +1325,11 @@ udp_disconnect(struct udp_pcb *pcb)
   pcb->netif_idx = NETIF_NO_INDEX;
   /* mark PCB as unconnected */
   udp_clear_flags(pcb, UDP_FLAGS_CONNECTED);
+#if LWIP_UDP_PCB_HASH
+  if (hashed) {
+    udp_pcb_hash_add(pcb);
+  }
+#endif /* LWIP_UDP_PCB_HASH */
 }
 
 /**
@@ -1189,6 +1372,7 @@ udp_remove(struct udp_pcb *pcb)
   LWIP_ERROR("udp_remove: invalid pcb", pcb != NULL, return);
 
   mib2_udp_unbind(pcb);
+  UDP_PCB_HASH_RMV(pcb);
   /* pcb to be removed is first in list? */
   if (udp_pcbs == pcb) {
     /* make list start at 2nd pcb */
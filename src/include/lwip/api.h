@@ -344,6 +344,10 @@ err_t   netconn_write_partly(struct netconn *conn, const void *dataptr, size_t s
                              u8_t apiflags, size_t *bytes_written);
 err_t   netconn_write_vectors_partly(struct netconn *conn, struct netvector *vectors, u16_t vectorcnt,
                                      u8_t apiflags, size_t *bytes_written);
+#if LWIP_TCP_ZEROCOPY
+err_t   netconn_write_ref(struct netconn *conn, const void *dataptr, size_t size,
+                          u8_t apiflags, struct pbuf *ref, size_t *bytes_written);
+#endif /* LWIP_TCP_ZEROCOPY */
 /** @ingroup netconn_tcp */
 #define netconn_write(conn, dataptr, size, apiflags) \
           netconn_write_partly(conn, dataptr, size, apiflags, NULL)
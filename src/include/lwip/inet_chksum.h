@@ -57,6 +57,7 @@
     as u16_t */
 # ifndef LWIP_CHKSUM_COPY
 #  define LWIP_CHKSUM_COPY(dst, src, len) lwip_chksum_copy(dst, src, len)
+/* 1: MEMCPY, then LWIP_CHKSUM; 2: copy and sum in a single pass (needs u64_t) */
 #  ifndef LWIP_CHKSUM_COPY_ALGORITHM
 #   define LWIP_CHKSUM_COPY_ALGORITHM 1
 #  endif /* LWIP_CHKSUM_COPY_ALGORITHM */
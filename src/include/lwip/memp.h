@@ -97,7 +97,7 @@ extern const struct memp_desc* const memp_pools[MEMP_MAX];
     \
   LWIP_MEMPOOL_DECLARE_STATS_INSTANCE(memp_stats_ ## name) \
     \
-  static struct memp *memp_tab_ ## name; \
+  static memp_freelist_t memp_tab_ ## name; \
     \
   const struct memp_desc memp_ ## name = { \
     DECLARE_LWIP_MEMPOOL_DESC(desc) \
@@ -147,6 +147,25 @@ void *memp_malloc_fn(memp_t type, const char* file, const int line);
 void *memp_malloc(memp_t type);
 #endif
 void  memp_free(memp_t type, void *mem);
+u16_t memp_malloc_bulk(memp_t type, void **v, u16_t n);
+void  memp_free_bulk(memp_t type, void **v, u16_t n);
+
+#if MEMP_CACHE
+/** Free elements of the built-in pools kept by one thread, see MEMP_CACHE */
+struct memp_cache {
+  /** singly linked lists of cached elements */
+  struct memp *free[MEMP_MAX];
+  u16_t count[MEMP_MAX];
+#if MEMP_STATS
+  /** hits and misses not yet added to the pool stats */
+  u32_t hit[MEMP_MAX];
+  u32_t miss[MEMP_MAX];
+#endif /* MEMP_STATS */
+};
+
+void  memp_cache_init(struct memp_cache *cache);
+void  memp_cache_flush(struct memp_cache *cache);
+#endif /* MEMP_CACHE */
 
 #ifdef __cplusplus
 }
@@ -213,6 +213,36 @@ typedef err_t (*netif_output_ip6_fn)(struct netif *netif, struct pbuf *p,
  * @param p The packet to send (raw ethernet packet)
  */
 typedef err_t (*netif_linkoutput_fn)(struct netif *netif, struct pbuf *p);
+#if LWIP_NETIF_LINKOUTPUT_SG
+/** One contiguous piece of an outgoing frame, see @ref netif_linkoutput_sg_fn */
+struct netif_iovec {
+  const void *base;
+  u16_t len;
+};
+/** Function prototype for netif->linkoutput_sg functions. Like
+ * netif_linkoutput_fn, but the frame is passed as the list of its pieces so
+ * that the driver can gather it without copying.
+ *
+ * @param netif The netif which shall send a packet
+ * @param iov The pieces of the frame in order, starting with the link header
+ * @param iovcnt Number of entries in iov (1 to LWIP_NETIF_SG_MAX_IOV)
+ * @param p The pbuf chain the pieces point into. Take a reference with
+ *          pbuf_ref() if the pieces are still needed after returning.
+ */
+typedef err_t (*netif_linkoutput_sg_fn)(struct netif *netif,
+       const struct netif_iovec *iov, u16_t iovcnt, struct pbuf *p);
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
+#if LWIP_TCPIP_BUSY_POLL
+/** Function prototype for netif->rx_poll functions. Called by tcpip_thread
+ * with the core locked while it busy-polls (LWIP_TCPIP_BUSY_POLL). Pass the
+ * frames the hardware has received so far to the stack, e.g. directly to
+ * ethernet_input(), without waiting for more.
+ *
+ * @param netif The netif to poll
+ * @return the number of frames received, 0 if there were none
+ */
+typedef u16_t (*netif_rx_poll_fn)(struct netif *netif);
+#endif /* LWIP_TCPIP_BUSY_POLL */
 /** Function prototype for netif status- or link-callback functions. */
 typedef void (*netif_status_callback_fn)(struct netif *netif);
 #if LWIP_IPV4 && LWIP_IGMP
@@ -306,6 +336,16 @@ struct netif {
    *  to send a packet on the interface. This function outputs
    *  the pbuf as-is on the link medium. */
   netif_linkoutput_fn linkoutput;
+#if LWIP_NETIF_LINKOUTPUT_SG
+  /** Optional scatter-gather variant of linkoutput. If set, it is used
+   *  instead of linkoutput for frames of up to LWIP_NETIF_SG_MAX_IOV pieces. */
+  netif_linkoutput_sg_fn linkoutput_sg;
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
+#if LWIP_TCPIP_BUSY_POLL
+  /** Optional: called by tcpip_thread to poll for received frames before it
+   *  blocks waiting for messages. */
+  netif_rx_poll_fn rx_poll;
+#endif /* LWIP_TCPIP_BUSY_POLL */
 #if LWIP_IPV6
   /** This function is called by the IPv6 module when it wants
    *  to send a packet on the interface. This function typically
@@ -518,6 +558,12 @@ void netif_poll_all(void);
 
 err_t netif_input(struct pbuf *p, struct netif *inp);
 
+#if LWIP_NETIF_LINKOUTPUT_SG
+err_t netif_linkoutput(struct netif *netif, struct pbuf *p);
+#else /* LWIP_NETIF_LINKOUTPUT_SG */
+#define netif_linkoutput(netif, p) ((netif)->linkoutput((netif), (p)))
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
+
 #if LWIP_IPV6
 /** @ingroup netif_ip6 */
 #define netif_ip_addr6(netif, i)  ((const ip_addr_t*)(&((netif)->ip6_addr[i])))
@@ -120,6 +120,29 @@
 #if !defined LWIP_TIMERS_CUSTOM || defined __DOXYGEN__
 #define LWIP_TIMERS_CUSTOM              0
 #endif
+
+/**
+ * LWIP_TIMERS_WHEEL==1: Keep the timeouts created by sys_timeout() in a
+ * hashed timing wheel (one slot per millisecond) instead of one sorted list.
+ * sys_timeout() and sys_untimeout() then no longer have to walk all pending
+ * timeouts, which helps when there are many of them (e.g. lots of DHCP, DNS,
+ * mDNS or application timers). Costs 2 * LWIP_TIMERS_WHEEL_SIZE pointers of
+ * RAM plus 2 pointers per timeout.
+ */
+#if !defined LWIP_TIMERS_WHEEL || defined __DOXYGEN__
+#define LWIP_TIMERS_WHEEL               0
+#endif
+
+/**
+ * LWIP_TIMERS_WHEEL_SIZE: Number of slots of the timing wheel and of buckets
+ * of the hash table used by sys_untimeout() (only used if LWIP_TIMERS_WHEEL==1).
+ * Must be a power of 2. Timeouts that are due more than this many milliseconds
+ * in the future share slots with earlier ones, so this should be in the order
+ * of the number of pending timeouts.
+ */
+#if !defined LWIP_TIMERS_WHEEL_SIZE || defined __DOXYGEN__
+#define LWIP_TIMERS_WHEEL_SIZE          256
+#endif
 /**
  * @}
  */
@@ -318,6 +341,50 @@
 #define MEMP_SANITY_CHECK               0
 #endif
 
+/**
+ * MEMP_CACHE==1: Put a per-thread cache of free elements in front of each
+ * built-in pool, so that memp_malloc() and memp_free() only lock the pool to
+ * move MEMP_CACHE_BATCH elements at once. Pools with less than
+ * 4 * MEMP_CACHE_SIZE elements are not cached.
+ * ATTENTION: a thread-local cache is needed:
+ * - LWIP_MEMP_THREAD_CACHE_GET() returning the struct memp_cache* of the
+ *   calling thread, or NULL for threads (or interrupts) without a cache.
+ *   Caches must be initialized with memp_cache_init() and returned to the
+ *   pools with memp_cache_flush() before a thread exits.
+ * Cached elements count as used in the pool stats.
+ */
+#if !defined MEMP_CACHE || defined __DOXYGEN__
+#define MEMP_CACHE                      0
+#endif
+
+/**
+ * MEMP_CACHE_SIZE: the maximum number of free elements of each pool in a
+ * thread cache.
+ */
+#if !defined MEMP_CACHE_SIZE || defined __DOXYGEN__
+#define MEMP_CACHE_SIZE                 16
+#endif
+
+/**
+ * MEMP_CACHE_BATCH: the number of elements moved between a thread cache and
+ * its pool when the cache is empty or full.
+ */
+#if !defined MEMP_CACHE_BATCH || defined __DOXYGEN__
+#define MEMP_CACHE_BATCH                (MEMP_CACHE_SIZE / 2)
+#endif
+
+/**
+ * MEMP_LOCKFREE==1: Use lock-free stacks instead of SYS_ARCH_PROTECT for the
+ * freelists of all pools, so that memp_malloc() and memp_free() never block
+ * each other. The freelist head keeps an ABA tag next to the first element
+ * in one 64-bit word, which is updated with the GCC/clang __atomic builtins,
+ * so this needs a target with lock-free 64-bit compare-and-swap.
+ * Pool stats (MEMP_STATS) are then updated with __atomic builtins, too.
+ */
+#if !defined MEMP_LOCKFREE || defined __DOXYGEN__
+#define MEMP_LOCKFREE                   0
+#endif
+
 /**
  * MEM_OVERFLOW_CHECK: mem overflow protection reserves a configurable
  * amount of bytes before and after each heap allocation chunk and fills
@@ -357,6 +424,45 @@
 #define MEM_USE_POOLS_TRY_BIGGER_POOL   0
 #endif
 
+/**
+ * MEM_SIZE_CLASSES==1: allocate small objects from slabs instead of searching
+ * the first-fit heap. Requests up to MEM_SIZE_CLASS_MAX bytes are rounded up
+ * to a power of two or the midpoint between two (16, 24, 32, 48, 64, ...
+ * bytes). Each of these size classes takes its objects from slabs of
+ * MEM_SIZE_CLASS_SLAB_OBJS objects, which are allocated from the heap when all
+ * slabs of the class are full and returned to it when they are empty (except
+ * for the last one of each class, which is only returned when the heap runs
+ * out of memory).
+ * This makes mem_malloc() and mem_free() O(1) for small objects. Slabs are
+ * taken from the highest free block that is big enough, bigger allocations
+ * are still served first-fit from the lowest one.
+ * With LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT, the search for the free block
+ * of a new slab runs without re-enabling interrupts.
+ * mem_trim() does not shrink objects in a slab (they are small anyway), but
+ * still returns the same pointer.
+ * Heap stats count the objects, not the slabs.
+ */
+#if !defined MEM_SIZE_CLASSES || defined __DOXYGEN__
+#define MEM_SIZE_CLASSES                0
+#endif
+
+/**
+ * MEM_SIZE_CLASS_MAX: the biggest object allocated from a slab if
+ * MEM_SIZE_CLASSES is enabled (must be a power of two, at most 32768).
+ */
+#if !defined MEM_SIZE_CLASS_MAX || defined __DOXYGEN__
+#define MEM_SIZE_CLASS_MAX              256
+#endif
+
+/**
+ * MEM_SIZE_CLASS_SLAB_OBJS: the number of objects in a slab if
+ * MEM_SIZE_CLASSES is enabled. Bigger slabs need to be allocated from the heap
+ * less often, but keep more memory in partly used slabs.
+ */
+#if !defined MEM_SIZE_CLASS_SLAB_OBJS || defined __DOXYGEN__
+#define MEM_SIZE_CLASS_SLAB_OBJS        8
+#endif
+
 /**
  * MEMP_USE_CUSTOM_POOLS==1: whether to include a user file lwippools.h
  * that defines additional pools beyond the "standard" ones required
@@ -452,6 +558,15 @@
 #define MEMP_NUM_TCP_SEG                16
 #endif
 
+/**
+ * MEMP_NUM_TCP_REF_PBUF: the number of pbufs simultaneously referencing data
+ * passed to tcp_write_ref() (about one per queued segment of such data).
+ * (requires the LWIP_TCP_ZEROCOPY option)
+ */
+#if !defined MEMP_NUM_TCP_REF_PBUF || defined __DOXYGEN__
+#define MEMP_NUM_TCP_REF_PBUF           MEMP_NUM_TCP_SEG
+#endif
+
 /**
  * MEMP_NUM_ALTCP_PCB: the number of simultaneously active altcp layer pcbs.
  * (requires the LWIP_ALTCP option)
@@ -505,7 +620,7 @@
  * The number of sys timeouts used by the core stack (not apps)
  * The default number of timeouts is calculated here for all enabled modules.
  */
-#define LWIP_NUM_SYS_TIMEOUT_INTERNAL   (LWIP_TCP + IP_REASSEMBLY + LWIP_ARP + (2*LWIP_DHCP) + LWIP_AUTOIP + LWIP_IGMP + LWIP_DNS + PPP_NUM_TIMEOUTS + (LWIP_IPV6 * (1 + LWIP_IPV6_REASS + LWIP_IPV6_MLD)))
+#define LWIP_NUM_SYS_TIMEOUT_INTERNAL   (LWIP_TCP + (LWIP_TCP && LWIP_TCP_RTO_MS) + IP_REASSEMBLY + LWIP_ARP + (2*LWIP_DHCP) + LWIP_AUTOIP + LWIP_IGMP + LWIP_DNS + PPP_NUM_TIMEOUTS + (LWIP_IPV6 * (1 + LWIP_IPV6_REASS + LWIP_IPV6_MLD)))
 
 /**
  * MEMP_NUM_SYS_TIMEOUT: the number of simultaneously active timeouts.
@@ -532,6 +647,16 @@
 #define MEMP_NUM_NETCONN                4
 #endif
 
+/**
+ * MEMP_NUM_SOCKET_ZEROCOPY: the number of MSG_ZEROCOPY sends whose data
+ * may simultaneously be referenced by the stack, over all sockets. When
+ * they are used up, further MSG_ZEROCOPY sends copy the data.
+ * (requires the LWIP_SOCKET and LWIP_TCP_ZEROCOPY options)
+ */
+#if !defined MEMP_NUM_SOCKET_ZEROCOPY || defined __DOXYGEN__
+#define MEMP_NUM_SOCKET_ZEROCOPY        8
+#endif
+
 /**
  * MEMP_NUM_SELECT_CB: the number of struct lwip_select_cb.
  * (Only needed if you have LWIP_MPU_COMPATIBLE==1 and use the socket API.
@@ -559,6 +684,15 @@
 #define MEMP_NUM_TCPIP_MSG_INPKT        8
 #endif
 
+/**
+ * MEMP_NUM_TCPIP_MSG_INPKT_BATCH: the number of messages used by
+ * tcpip_input_batch(), each carrying up to TCPIP_INPUT_BATCH_MAX packets.
+ * (only needed if you use tcpip.c with LWIP_TCPIP_INPUT_BATCH)
+ */
+#if !defined MEMP_NUM_TCPIP_MSG_INPKT_BATCH || defined __DOXYGEN__
+#define MEMP_NUM_TCPIP_MSG_INPKT_BATCH  4
+#endif
+
 /**
  * MEMP_NUM_NETDB: the number of concurrently running lwip_addrinfo() calls
  * (before freeing the corresponding memory using lwip_freeaddrinfo()).
@@ -582,6 +716,22 @@
 #define PBUF_POOL_SIZE                  16
 #endif
 
+/**
+ * PBUF_POOL_SMALL_SIZE: the number of buffers in the small pbuf pool
+ * (only used if PBUF_POOL_SIZE_CLASSES==1).
+ */
+#if !defined PBUF_POOL_SMALL_SIZE || defined __DOXYGEN__
+#define PBUF_POOL_SMALL_SIZE            16
+#endif
+
+/**
+ * PBUF_POOL_LARGE_SIZE: the number of buffers in the large pbuf pool
+ * (only used if PBUF_POOL_SIZE_CLASSES==1).
+ */
+#if !defined PBUF_POOL_LARGE_SIZE || defined __DOXYGEN__
+#define PBUF_POOL_LARGE_SIZE            2
+#endif
+
 /** MEMP_NUM_API_MSG: the number of concurrently active calls to various
  * socket, netconn, and tcpip functions
  */
@@ -1239,6 +1389,26 @@
 #if !defined LWIP_NETBUF_RECVINFO || defined __DOXYGEN__
 #define LWIP_NETBUF_RECVINFO            0
 #endif
+
+/**
+ * LWIP_UDP_PCB_HASH==1: Index bound UDP pcbs in hash tables so that
+ * udp_input() does not have to check every pcb on udp_pcbs. Connected pcbs
+ * are hashed by local port and remote address/port and looked up first,
+ * all others are hashed by local port only. Each pcb grows by one pointer.
+ * The udp.cachehit statistic then counts connected lookups that matched the
+ * first pcb of their bucket.
+ */
+#if !defined LWIP_UDP_PCB_HASH || defined __DOXYGEN__
+#define LWIP_UDP_PCB_HASH               0
+#endif
+
+/**
+ * UDP_PCB_HASH_SIZE: Number of buckets in each of the two UDP pcb hash tables
+ * (only used if LWIP_UDP_PCB_HASH==1). Must be a power of 2.
+ */
+#if !defined UDP_PCB_HASH_SIZE || defined __DOXYGEN__
+#define UDP_PCB_HASH_SIZE               32
+#endif
 /**
  * @}
  */
@@ -1321,6 +1491,84 @@
 #define LWIP_TCP_MAX_SACK_NUM           4
 #endif
 
+/**
+ * LWIP_TCP_SACK_IN==1: TCP will process selective acknowledgements (SACKs)
+ * received from the remote host and use them for loss recovery (RFC 6675):
+ * SACKed segments are not retransmitted during fast recovery, and holes
+ * below enough SACKed data are retransmitted without waiting for an RTO.
+ * The SACK_PERM option is negotiated by LWIP_TCP_SACK_OUT, which must be
+ * enabled, too.
+ */
+#if !defined LWIP_TCP_SACK_IN || defined __DOXYGEN__
+#define LWIP_TCP_SACK_IN                0
+#endif
+
+/**
+ * LWIP_TCP_CC==1: Make TCP congestion control pluggable. Every pcb points
+ * to a struct tcp_cc_ops that the core calls on new ACKs, fast retransmit,
+ * retransmission timeouts and at the end of loss recovery. The module can be
+ * changed per pcb with tcp_set_cc() or per socket with the TCP_CONGESTION
+ * socket option. New pcbs use "reno" (the built-in RFC 5681 algorithm),
+ * accepted pcbs the module of their listening pcb.
+ * With LWIP_TCP_CC==0, "reno" is always used and called directly.
+ */
+#if !defined LWIP_TCP_CC || defined __DOXYGEN__
+#define LWIP_TCP_CC                     0
+#endif
+
+/**
+ * LWIP_TCP_CC_CUBIC==1: Include the "cubic" congestion control module
+ * (RFC 9438). Its window growth does not depend on the RTT, so it fills
+ * paths with a large bandwidth-delay product much faster than "reno".
+ * Needs LWIP_TCP_CC and 64-bit integer support (u64_t).
+ */
+#if !defined LWIP_TCP_CC_CUBIC || defined __DOXYGEN__
+#define LWIP_TCP_CC_CUBIC               0
+#endif
+
+/**
+ * LWIP_TCP_RTO_MS==1: Measure round-trip times and run the retransmission
+ * timer in milliseconds (sys_now()) instead of TCP_SLOW_INTERVAL ticks, so the
+ * RTO follows the actual RTT on fast paths instead of being a multiple of
+ * 500 ms. Retransmission timeouts are run from a one-shot timeout scheduled
+ * for the earliest pending RTO, which needs LWIP_TIMERS.
+ * With LWIP_TCP_TIMESTAMPS, every ACK for new data that echoes a timestamp
+ * gives an RTT sample (RFC 7323), not only one timed segment per RTT.
+ */
+#if !defined LWIP_TCP_RTO_MS || defined __DOXYGEN__
+#define LWIP_TCP_RTO_MS                 0
+#endif
+
+/**
+ * TCP_RTO_MIN: Lower bound of the retransmission timeout in milliseconds
+ * (LWIP_TCP_RTO_MS only). Should not be less than the delayed ACK timeout of
+ * the peers, or a single outstanding segment is retransmitted spuriously.
+ */
+#if !defined TCP_RTO_MIN || defined __DOXYGEN__
+#define TCP_RTO_MIN                     200
+#endif
+
+/**
+ * TCP_RTO_MAX: Upper bound of the retransmission timeout (including
+ * exponential backoff) in milliseconds (LWIP_TCP_RTO_MS only).
+ */
+#if !defined TCP_RTO_MAX || defined __DOXYGEN__
+#define TCP_RTO_MAX                     60000
+#endif
+
+/**
+ * LWIP_TCP_RACK_TLP==1: Detect lost segments by the time they were sent
+ * (RACK) and send a tail loss probe (TLP) when ACKs stop arriving (RFC 8985).
+ * A lost tail segment of a short flow is then recovered after about two RTTs
+ * instead of waiting for the retransmission timeout, and lost
+ * retransmissions are detected without a timeout as well.
+ * Used on connections that negotiated SACK; needs LWIP_TCP_SACK_IN and
+ * LWIP_TCP_RTO_MS.
+ */
+#if !defined LWIP_TCP_RACK_TLP || defined __DOXYGEN__
+#define LWIP_TCP_RACK_TLP               0
+#endif
+
 /**
  * TCP_MSS: TCP Maximum segment size. (default is 536, a conservative default,
  * you might want to increase this.)
@@ -1459,6 +1707,19 @@
 #define TCP_OVERSIZE                    TCP_MSS
 #endif
 
+/**
+ * LWIP_TCP_ZEROCOPY==1: Support sending application data by reference with
+ * a notification once the stack does not use it anymore: tcp_write_ref(),
+ * netconn_write_ref() and the MSG_ZEROCOPY flag of lwip_send().
+ * Every pbuf pointing into the data holds a reference on a (custom) pbuf
+ * given by the caller, whose custom_free_function is called when the last
+ * of them is freed, i.e. once all the data has been ACKed (or the
+ * connection was aborted).
+ */
+#if !defined LWIP_TCP_ZEROCOPY || defined __DOXYGEN__
+#define LWIP_TCP_ZEROCOPY               0
+#endif
+
 /**
  * LWIP_TCP_TIMESTAMPS==1: support the TCP timestamp option.
  * The timestamp option is currently only used to help remote hosts, it is not
@@ -1518,6 +1779,61 @@
 #define LWIP_TCP_PCB_NUM_EXT_ARGS       0
 #endif
 
+/**
+ * LWIP_TCP_PCB_HASH==1: Index active and TIME-WAIT pcbs in a hash table keyed
+ * by the connection 4-tuple and listening pcbs in a table keyed by local port.
+ * tcp_input() then looks up the pcb for an incoming segment in (nearly)
+ * constant time instead of walking all pcb lists. Useful when handling many
+ * concurrent connections. Each pcb grows by one pointer. The tcp.cachehit
+ * statistic then counts lookups that matched the first pcb of their bucket.
+ */
+#if !defined LWIP_TCP_PCB_HASH || defined __DOXYGEN__
+#define LWIP_TCP_PCB_HASH               0
+#endif
+
+/**
+ * TCP_PCB_HASH_SIZE: Number of buckets in the hash table for active and
+ * TIME-WAIT pcbs (only used if LWIP_TCP_PCB_HASH==1). Must be a power of 2.
+ */
+#if !defined TCP_PCB_HASH_SIZE || defined __DOXYGEN__
+#define TCP_PCB_HASH_SIZE               64
+#endif
+
+/**
+ * TCP_LISTEN_HASH_SIZE: Number of buckets in the hash table for listening
+ * pcbs (only used if LWIP_TCP_PCB_HASH==1). Must be a power of 2.
+ */
+#if !defined TCP_LISTEN_HASH_SIZE || defined __DOXYGEN__
+#define TCP_LISTEN_HASH_SIZE            16
+#endif
+
+/**
+ * LWIP_TCP_PCB_TIMERS==1: Schedule TCP timers per pcb instead of sweeping all
+ * active and TIME-WAIT pcbs from every tcp_fasttmr()/tcp_slowtmr() run.
+ * Only pcbs with a running retransmission or persist timer, a pending delayed
+ * ACK/FIN, unsent or refused data are visited on every tick. Idle pcbs are
+ * parked on a timing wheel until their next keepalive, poll, state or
+ * TIME-WAIT timeout is due (or any activity on the connection wakes them up),
+ * so timer cost scales with due events instead of the number of connections.
+ * Each pcb grows by two pointers, two u32_t and one u8_t.
+ * Raw API applications changing keepalive settings of an idle pcb directly
+ * may see the change take effect up to TCP_PCB_TIMERS_WHEEL_SIZE slow timer
+ * ticks late.
+ */
+#if !defined LWIP_TCP_PCB_TIMERS || defined __DOXYGEN__
+#define LWIP_TCP_PCB_TIMERS             0
+#endif
+
+/**
+ * TCP_PCB_TIMERS_WHEEL_SIZE: Number of slots (in slow timer ticks) of the
+ * timing wheel idle pcbs are parked on (only used if LWIP_TCP_PCB_TIMERS==1).
+ * This is also the longest time a pcb stays parked before its timers are
+ * checked again. Must be a power of 2.
+ */
+#if !defined TCP_PCB_TIMERS_WHEEL_SIZE || defined __DOXYGEN__
+#define TCP_PCB_TIMERS_WHEEL_SIZE       256
+#endif
+
 /** LWIP_ALTCP==1: enable the altcp API.
  * altcp is an abstraction layer that prevents applications linking against the
  * tcp.h functions but provides the same functionality. It is used to e.g. add
@@ -1587,6 +1903,41 @@
 #define PBUF_POOL_BUFSIZE               LWIP_MEM_ALIGN_SIZE(TCP_MSS+40+PBUF_LINK_ENCAPSULATION_HLEN+PBUF_LINK_HLEN)
 #endif
 
+/**
+ * PBUF_POOL_SIZE_CLASSES==1: Back PBUF_POOL pbufs with three pools instead of
+ * one: a small pool (PBUF_POOL_SMALL_BUFSIZE), the default pool
+ * (PBUF_POOL_BUFSIZE) and a large pool (PBUF_POOL_LARGE_BUFSIZE).
+ * pbuf_alloc() serves requests that fit into one small pbuf from the small
+ * pool, so ACKs do not tie up a full-sized buffer; everything else is
+ * allocated from the default pool with the usual PBUF_POOL_BUFSIZE chain
+ * layout. If the chosen pool is empty, a request that fits into one pbuf is
+ * served from a bigger pool, never split into a chain of smaller pbufs.
+ * Drivers can request a class explicitly with pbuf_alloc_pool() (e.g. the
+ * large pool for jumbo frames).
+ */
+#if !defined PBUF_POOL_SIZE_CLASSES || defined __DOXYGEN__
+#define PBUF_POOL_SIZE_CLASSES          0
+#endif
+
+/**
+ * PBUF_POOL_SMALL_BUFSIZE: the size of each pbuf in the small pbuf pool
+ * (only used if PBUF_POOL_SIZE_CLASSES==1). Must be smaller than
+ * PBUF_POOL_BUFSIZE.
+ */
+#if !defined PBUF_POOL_SMALL_BUFSIZE || defined __DOXYGEN__
+#define PBUF_POOL_SMALL_BUFSIZE         LWIP_MEM_ALIGN_SIZE(256)
+#endif
+
+/**
+ * PBUF_POOL_LARGE_BUFSIZE: the size of each pbuf in the large pbuf pool
+ * (only used if PBUF_POOL_SIZE_CLASSES==1). Must be bigger than
+ * PBUF_POOL_BUFSIZE. The default holds a 9000 byte jumbo frame including
+ * link headers.
+ */
+#if !defined PBUF_POOL_LARGE_BUFSIZE || defined __DOXYGEN__
+#define PBUF_POOL_LARGE_BUFSIZE         LWIP_MEM_ALIGN_SIZE(9000+PBUF_LINK_ENCAPSULATION_HLEN+PBUF_LINK_HLEN)
+#endif
+
 /**
  * LWIP_PBUF_REF_T: Refcount type in pbuf.
  * Default width of u8_t can be increased if 255 refs are not enough for you.
@@ -1595,6 +1946,22 @@
 #define LWIP_PBUF_REF_T                 u8_t
 #endif
 
+/**
+ * LWIP_PBUF_REF_ATOMIC==1: Update the pbuf reference count with atomic
+ * read-modify-write operations instead of SYS_ARCH_SET/SYS_ARCH_PROTECT.
+ * This takes the global critical section out of pbuf_ref() and pbuf_free(),
+ * which helps when one pbuf is handed to many consumers at once (e.g.
+ * bridgeif flooding or multicast delivery to many sockets) on SMP targets.
+ * The operations default to the GCC/clang __atomic builtins; other compilers
+ * must define LWIP_PBUF_REF_INC(p) and LWIP_PBUF_REF_DEC(p) to atomically
+ * increment/decrement p->ref and return the new value.
+ * Consider a wider LWIP_PBUF_REF_T (u16_t or u32_t) together with this when
+ * fanning out a single pbuf to more than 255 users.
+ */
+#if !defined LWIP_PBUF_REF_ATOMIC || defined __DOXYGEN__
+#define LWIP_PBUF_REF_ATOMIC            0
+#endif
+
 /**
  * LWIP_PBUF_CUSTOM_DATA: Store private data on pbufs (e.g. timestamps)
  * This extends struct pbuf so user can store custom data on every pbuf.
@@ -1705,6 +2072,26 @@
 #define LWIP_NETIF_TX_SINGLE_PBUF       0
 #endif /* LWIP_NETIF_TX_SINGLE_PBUF */
 
+/**
+ * LWIP_NETIF_LINKOUTPUT_SG==1: Support the optional netif->linkoutput_sg
+ * callback. Drivers that can gather a frame from several buffers (writev(),
+ * scatter-gather DMA) set it to get outgoing frames as an array of
+ * the payloads of the pbuf chain (the link header being the first entry)
+ * instead of copying the chain into one buffer in netif->linkoutput.
+ * netif->linkoutput must still be set, it is used for longer chains.
+ */
+#if !defined LWIP_NETIF_LINKOUTPUT_SG || defined __DOXYGEN__
+#define LWIP_NETIF_LINKOUTPUT_SG        0
+#endif
+
+/**
+ * LWIP_NETIF_SG_MAX_IOV: Maximum number of pieces passed to
+ * netif->linkoutput_sg. Longer pbuf chains are sent with netif->linkoutput.
+ */
+#if !defined LWIP_NETIF_SG_MAX_IOV || defined __DOXYGEN__
+#define LWIP_NETIF_SG_MAX_IOV           16
+#endif
+
 /**
  * LWIP_NUM_NETIF_CLIENT_DATA: Number of clients that may store
  * data in client_data member array of struct netif (max. 256).
@@ -1830,6 +2217,46 @@
 #define LWIP_TCPIP_THREAD_ALIVE()
 #endif
 
+/**
+ * LWIP_TCPIP_INPUT_BATCH==1: Enable tcpip_input_batch() to pass a burst of
+ * received packets to the stack with one message (and one mbox post) instead
+ * of one per packet. The burst is processed as a whole before timers are
+ * checked again.
+ */
+#if !defined LWIP_TCPIP_INPUT_BATCH || defined __DOXYGEN__
+#define LWIP_TCPIP_INPUT_BATCH          0
+#endif
+
+/**
+ * TCPIP_INPUT_BATCH_MAX: The maximum number of packets passed to
+ * tcpip_input_batch() at once.
+ */
+#if !defined TCPIP_INPUT_BATCH_MAX || defined __DOXYGEN__
+#define TCPIP_INPUT_BATCH_MAX           32
+#endif
+
+/**
+ * LWIP_TCPIP_BUSY_POLL==1: Before tcpip_thread blocks on its mbox, let it poll
+ * the mbox and the rx_poll functions of the netifs (see
+ * @ref netif_rx_poll_fn) for up to TCPIP_BUSY_POLL_BUDGET rounds, like
+ * SO_BUSY_POLL. Messages and packets arriving meanwhile are handled without
+ * waking up the thread, at the cost of CPU time: only useful if tcpip_thread
+ * has a CPU core of its own. Needs LWIP_TIMERS.
+ */
+#if !defined LWIP_TCPIP_BUSY_POLL || defined __DOXYGEN__
+#define LWIP_TCPIP_BUSY_POLL            0
+#endif
+
+/**
+ * TCPIP_BUSY_POLL_BUDGET: The number of polling rounds before tcpip_thread
+ * blocks (LWIP_TCPIP_BUSY_POLL==1). The core lock is released and taken again
+ * in every round, and due timers are only handled once a round found work or
+ * the budget ran out.
+ */
+#if !defined TCPIP_BUSY_POLL_BUDGET || defined __DOXYGEN__
+#define TCPIP_BUSY_POLL_BUDGET          1000
+#endif
+
 /**
  * SLIPIF_THREAD_NAME: The name assigned to the slipif_loop thread.
  */
@@ -1968,6 +2395,18 @@
 #if !defined LWIP_NETCONN_FULLDUPLEX || defined __DOXYGEN__
 #define LWIP_NETCONN_FULLDUPLEX         0
 #endif
+
+/** LWIP_NETCONN_FASTPATH==1: Let netconn_send() (UDP and RAW), netconn_write*()
+ * (TCP) and the receive window update after netconn_recv*() (TCP) call into the
+ * core directly with the core locked instead of passing an api_msg to
+ * lwip_netconn_do_*(). This shortens lwip_send(), lwip_sendto() and
+ * lwip_recv(). A TCP write only takes the direct path if it has one vector that
+ * fits into the send buffer; otherwise (and on pending errors) it takes the
+ * regular path, which blocks if needed. Needs LWIP_TCPIP_CORE_LOCKING.
+ */
+#if !defined LWIP_NETCONN_FASTPATH || defined __DOXYGEN__
+#define LWIP_NETCONN_FASTPATH           0
+#endif
 /**
  * @}
  */
@@ -2136,6 +2575,15 @@
 #if !defined LWIP_SOCKET_POLL || defined __DOXYGEN__
 #define LWIP_SOCKET_POLL                1
 #endif
+
+/**
+ * LWIP_SOCKET_RECV_PBUF==1: Enable lwip_recv_pbuf() and lwip_recv_pbuf_free()
+ * to receive TCP data as pbuf chains without copying it. The receive window
+ * is only re-opened once the application frees the chain.
+ */
+#if !defined LWIP_SOCKET_RECV_PBUF || defined __DOXYGEN__
+#define LWIP_SOCKET_RECV_PBUF           0
+#endif
 /**
  * @}
  */
@@ -2239,6 +2687,15 @@
 #define MEMP_STATS                      (MEMP_MEM_MALLOC == 0)
 #endif
 
+/**
+ * PBUF_POOL_STATS==1: Enable per size class PBUF_POOL stats (allocations,
+ * fallbacks and requested vs. reserved bytes). Only used if
+ * PBUF_POOL_SIZE_CLASSES==1.
+ */
+#if !defined PBUF_POOL_STATS || defined __DOXYGEN__
+#define PBUF_POOL_STATS                 PBUF_POOL_SIZE_CLASSES
+#endif
+
 /**
  * SYS_STATS==1: Enable system stats (sem and mbox counts, etc).
  */
@@ -2246,6 +2703,15 @@
 #define SYS_STATS                       (NO_SYS == 0)
 #endif
 
+/**
+ * TCPIP_STATS==1: Enable tcpip_thread busy-poll stats (polling rounds, rounds
+ * that found work and times the thread went idle). Only used if
+ * LWIP_TCPIP_BUSY_POLL==1.
+ */
+#if !defined TCPIP_STATS || defined __DOXYGEN__
+#define TCPIP_STATS                     LWIP_TCPIP_BUSY_POLL
+#endif
+
 /**
  * IP6_STATS==1: Enable IPv6 stats.
  */
@@ -2300,7 +2766,9 @@
 #define TCP_STATS                       0
 #define MEM_STATS                       0
 #define MEMP_STATS                      0
+#define PBUF_POOL_STATS                 0
 #define SYS_STATS                       0
+#define TCPIP_STATS                     0
 #define LWIP_STATS_DISPLAY              0
 #define IP6_STATS                       0
 #define ICMP6_STATS                     0
@@ -52,7 +52,7 @@ extern "C" {
  * Currently, the pbuf_custom code is only needed for one specific configuration
  * of IP_FRAG, unless required by external driver/application code. */
 #ifndef LWIP_SUPPORT_CUSTOM_PBUF
-#define LWIP_SUPPORT_CUSTOM_PBUF ((IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF) || (LWIP_IPV6 && LWIP_IPV6_FRAG))
+#define LWIP_SUPPORT_CUSTOM_PBUF ((IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF) || (LWIP_IPV6 && LWIP_IPV6_FRAG) || LWIP_TCP_ZEROCOPY)
 #endif
 
 /** @ingroup pbuf
@@ -121,7 +121,9 @@ typedef enum {
  * to be queued, it must be copied/duplicated. */
 #define PBUF_TYPE_FLAG_DATA_VOLATILE                0x40
 /** 4 bits are reserved for 16 allocation sources (e.g. heap, pool1, pool2, etc)
- * Internally, we use: 0=heap, 1=MEMP_PBUF, 2=MEMP_PBUF_POOL -> 13 types free*/
+ * Internally, we use: 0=heap, 1=MEMP_PBUF, 2=MEMP_PBUF_POOL -> 13 types free
+ * (with PBUF_POOL_SIZE_CLASSES, 3=MEMP_PBUF_POOL_SMALL, 4=MEMP_PBUF_POOL_LARGE
+ * -> 11 types free) */
 #define PBUF_TYPE_ALLOC_SRC_MASK                    0x0F
 /** Indicates this pbuf is used for RX (if not set, indicates use for TX).
  * This information can be used to keep some spare RX buffers e.g. for
@@ -133,8 +135,15 @@ typedef enum {
 #define PBUF_TYPE_ALLOC_SRC_MASK_STD_HEAP           0x00
 #define PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF      0x01
 #define PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL 0x02
+#if PBUF_POOL_SIZE_CLASSES
+#define PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_SMALL 0x03
+#define PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_LARGE 0x04
+/** First pbuf allocation type for applications */
+#define PBUF_TYPE_ALLOC_SRC_MASK_APP_MIN            0x05
+#else /* PBUF_POOL_SIZE_CLASSES */
 /** First pbuf allocation type for applications */
 #define PBUF_TYPE_ALLOC_SRC_MASK_APP_MIN            0x03
+#endif /* PBUF_POOL_SIZE_CLASSES */
 /** Last pbuf allocation type for applications */
 #define PBUF_TYPE_ALLOC_SRC_MASK_APP_MAX            PBUF_TYPE_ALLOC_SRC_MASK
 
@@ -167,6 +176,23 @@ typedef enum {
   PBUF_POOL = (PBUF_ALLOC_FLAG_RX | PBUF_TYPE_FLAG_STRUCT_DATA_CONTIGUOUS | PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL)
 } pbuf_type;
 
+#if PBUF_POOL_SIZE_CLASSES
+/**
+ * @ingroup pbuf
+ * Size classes of PBUF_POOL pbufs (see @ref PBUF_POOL_SIZE_CLASSES)
+ */
+typedef enum {
+  /** PBUF_POOL_SMALL_BUFSIZE buffers, e.g. for ACKs and other small frames */
+  PBUF_POOL_CLASS_SMALL,
+  /** PBUF_POOL_BUFSIZE buffers (the classic PBUF_POOL) */
+  PBUF_POOL_CLASS_DEFAULT,
+  /** PBUF_POOL_LARGE_BUFSIZE buffers, e.g. for jumbo frames */
+  PBUF_POOL_CLASS_LARGE,
+  /** Number of size classes, not a valid class */
+  PBUF_POOL_CLASS_COUNT
+} pbuf_pool_class;
+#endif /* PBUF_POOL_SIZE_CLASSES */
+
 
 /** indicates this packet's data should be immediately passed to the application */
 #define PBUF_FLAG_PUSH      0x01U
@@ -274,6 +300,10 @@ void pbuf_free_ooseq(void);
 
 struct pbuf *pbuf_alloc(pbuf_layer l, u16_t length, pbuf_type type);
 struct pbuf *pbuf_alloc_reference(void *payload, u16_t length, pbuf_type type);
+u16_t pbuf_alloc_bulk(pbuf_layer l, u16_t length, pbuf_type type, struct pbuf **v, u16_t n);
+#if PBUF_POOL_SIZE_CLASSES
+struct pbuf *pbuf_alloc_pool(pbuf_layer l, u16_t length, pbuf_pool_class pool_class);
+#endif /* PBUF_POOL_SIZE_CLASSES */
 #if LWIP_SUPPORT_CUSTOM_PBUF
 struct pbuf *pbuf_alloced_custom(pbuf_layer l, u16_t length, pbuf_type type,
                                  struct pbuf_custom *p, void *payload_mem,
@@ -282,7 +312,16 @@ struct pbuf *pbuf_alloced_custom(pbuf_layer l, u16_t length, pbuf_type type,
 void pbuf_realloc(struct pbuf *p, u16_t size);
 #define pbuf_get_allocsrc(p)          ((p)->type_internal & PBUF_TYPE_ALLOC_SRC_MASK)
 #define pbuf_match_allocsrc(p, type)  (pbuf_get_allocsrc(p) == ((type) & PBUF_TYPE_ALLOC_SRC_MASK))
+#if PBUF_POOL_SIZE_CLASSES
+#define pbuf_allocsrc_is_pool(src)    (((src) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL) || \
+                                       ((src) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_SMALL) || \
+                                       ((src) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_LARGE))
+/* pbufs of every size class match PBUF_POOL */
+#define pbuf_match_type(p, type)      (pbuf_match_allocsrc(p, type) || \
+                                       (((type) == PBUF_POOL) && pbuf_allocsrc_is_pool(pbuf_get_allocsrc(p))))
+#else /* PBUF_POOL_SIZE_CLASSES */
 #define pbuf_match_type(p, type)      pbuf_match_allocsrc(p, type)
+#endif /* PBUF_POOL_SIZE_CLASSES */
 u8_t pbuf_header(struct pbuf *p, s16_t header_size);
 u8_t pbuf_header_force(struct pbuf *p, s16_t header_size);
 u8_t pbuf_add_header(struct pbuf *p, size_t header_size_increment);
@@ -291,6 +330,7 @@ u8_t pbuf_remove_header(struct pbuf *p, size_t header_size);
 struct pbuf *pbuf_free_header(struct pbuf *q, u16_t size);
 void pbuf_ref(struct pbuf *p);
 u8_t pbuf_free(struct pbuf *p);
+u16_t pbuf_free_batch(struct pbuf **v, u16_t n);
 u16_t pbuf_clen(const struct pbuf *p);
 void pbuf_cat(struct pbuf *head, struct pbuf *tail);
 void pbuf_chain(struct pbuf *head, struct pbuf *tail);
@@ -306,6 +346,7 @@ struct pbuf *pbuf_clone(pbuf_layer l, pbuf_type type, struct pbuf *p);
 #if LWIP_CHECKSUM_ON_COPY
 err_t pbuf_fill_chksum(struct pbuf *p, u16_t start_offset, const void *dataptr,
                        u16_t len, u16_t *chksum);
+err_t pbuf_take_chksum(struct pbuf *buf, const void *dataptr, u16_t len, u16_t *chksum);
 #endif /* LWIP_CHECKSUM_ON_COPY */
 #if LWIP_TCP && TCP_QUEUE_OOSEQ && LWIP_WND_SCALE
 void pbuf_split_64k(struct pbuf *p, struct pbuf **rest);
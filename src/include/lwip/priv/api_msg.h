@@ -115,6 +115,11 @@ struct api_msg {
       /** offset into total length/output of bytes written when err == ERR_OK */
       size_t offset;
       u8_t apiflags;
+#if LWIP_TCP_ZEROCOPY
+      /** pbuf to keep referenced while the data is in use (tcp_write_ref())
+          or NULL */
+      struct pbuf *ref;
+#endif /* LWIP_TCP_ZEROCOPY */
 #if LWIP_SO_SNDTIMEO
       u32_t time_started;
 #endif /* LWIP_SO_SNDTIMEO */
@@ -216,6 +221,15 @@ void lwip_netconn_do_join_leave_group_netif(void *m);
 void lwip_netconn_do_gethostbyname(void *arg);
 #endif /* LWIP_DNS */
 
+err_t lwip_netconn_send_netbuf(struct netconn *conn, struct netbuf *buf);
+#if LWIP_TCP
+void lwip_netconn_tcp_recved(struct netconn *conn, size_t len);
+#if LWIP_NETCONN_FASTPATH
+err_t lwip_netconn_write_fast(struct netconn *conn, const void *dataptr, u16_t len,
+                              u8_t apiflags, struct pbuf *ref);
+#endif /* LWIP_NETCONN_FASTPATH */
+#endif /* LWIP_TCP */
+
 struct netconn* netconn_alloc(enum netconn_type t, netconn_callback callback);
 void netconn_free(struct netconn *conn);
 
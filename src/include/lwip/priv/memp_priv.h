@@ -104,6 +104,15 @@ typedef enum {
 #define MEMP_POOL_LAST   ((memp_t) MEMP_POOL_HELPER_LAST)
 #endif /* MEM_USE_POOLS && MEMP_USE_CUSTOM_POOLS */
 
+#if MEMP_LOCKFREE
+/** Freelist head of a lock-free pool: byte offset + 1 of the first free
+ * element (0: empty) in the low 32 bits, an ABA tag in the high 32 bits.
+ * Only accessed through the __atomic builtins in memp.c. */
+typedef u64_t memp_freelist_t;
+#else /* MEMP_LOCKFREE */
+typedef struct memp *memp_freelist_t;
+#endif /* MEMP_LOCKFREE */
+
 /** Memory pool descriptor */
 struct memp_desc {
 #if defined(LWIP_DEBUG) || MEMP_OVERFLOW_CHECK || LWIP_STATS_DISPLAY
@@ -126,7 +135,7 @@ struct memp_desc {
   u8_t *base;
 
   /** First free element of each pool. Elements form a linked list. */
-  struct memp **tab;
+  memp_freelist_t *tab;
 #endif /* MEMP_MEM_MALLOC */
 };
 
@@ -50,6 +50,9 @@ LWIP_MEMPOOL(UDP_PCB,        MEMP_NUM_UDP_PCB,         sizeof(struct udp_pcb),
 LWIP_MEMPOOL(TCP_PCB,        MEMP_NUM_TCP_PCB,         sizeof(struct tcp_pcb),        "TCP_PCB")
 LWIP_MEMPOOL(TCP_PCB_LISTEN, MEMP_NUM_TCP_PCB_LISTEN,  sizeof(struct tcp_pcb_listen), "TCP_PCB_LISTEN")
 LWIP_MEMPOOL(TCP_SEG,        MEMP_NUM_TCP_SEG,         sizeof(struct tcp_seg),        "TCP_SEG")
+#if LWIP_TCP_ZEROCOPY
+LWIP_MEMPOOL(TCP_REF_PBUF,   MEMP_NUM_TCP_REF_PBUF,    sizeof(struct tcp_ref_pbuf),   "TCP_REF_PBUF")
+#endif /* LWIP_TCP_ZEROCOPY */
 #endif /* LWIP_TCP */
 
 #if LWIP_ALTCP && LWIP_TCP
@@ -67,6 +70,9 @@ LWIP_MEMPOOL(FRAG_PBUF,      MEMP_NUM_FRAG_PBUF,       sizeof(struct pbuf_custom
 LWIP_MEMPOOL(NETBUF,         MEMP_NUM_NETBUF,          sizeof(struct netbuf),         "NETBUF")
 LWIP_MEMPOOL(NETCONN,        MEMP_NUM_NETCONN,         sizeof(struct netconn),        "NETCONN")
 #endif /* LWIP_NETCONN || LWIP_SOCKET */
+#if LWIP_SOCKET && LWIP_TCP_ZEROCOPY
+LWIP_MEMPOOL(SOCKET_ZEROCOPY, MEMP_NUM_SOCKET_ZEROCOPY, sizeof(struct lwip_sock_zerocopy), "SOCKET_ZEROCOPY")
+#endif /* LWIP_SOCKET && LWIP_TCP_ZEROCOPY */
 
 #if NO_SYS==0
 LWIP_MEMPOOL(TCPIP_MSG_API,  MEMP_NUM_TCPIP_MSG_API,   sizeof(struct tcpip_msg),      "TCPIP_MSG_API")
@@ -87,6 +93,9 @@ LWIP_MEMPOOL(NETIFAPI_MSG,   MEMP_NUM_NETIFAPI_MSG,    sizeof(struct netifapi_ms
 #endif /* LWIP_MPU_COMPATIBLE */
 #if !LWIP_TCPIP_CORE_LOCKING_INPUT
 LWIP_MEMPOOL(TCPIP_MSG_INPKT,MEMP_NUM_TCPIP_MSG_INPKT, sizeof(struct tcpip_msg),      "TCPIP_MSG_INPKT")
+#if LWIP_TCPIP_INPUT_BATCH
+LWIP_MEMPOOL(TCPIP_MSG_INPKT_BATCH, MEMP_NUM_TCPIP_MSG_INPKT_BATCH, sizeof(struct tcpip_msg) + TCPIP_INPUT_BATCH_MAX * sizeof(struct pbuf *), "TCPIP_MSG_INPKT_BATCH")
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 #endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
 #endif /* NO_SYS==0 */
 
@@ -132,6 +141,10 @@ LWIP_MEMPOOL(MLD6_GROUP,     MEMP_NUM_MLD6_GROUP,      sizeof(struct mld_group),
  */
 LWIP_MEMPOOL(PBUF,           MEMP_NUM_PBUF,            sizeof(struct pbuf),           "PBUF_REF/ROM")
 LWIP_PBUF_MEMPOOL(PBUF_POOL, PBUF_POOL_SIZE,           PBUF_POOL_BUFSIZE,             "PBUF_POOL")
+#if PBUF_POOL_SIZE_CLASSES
+LWIP_PBUF_MEMPOOL(PBUF_POOL_SMALL, PBUF_POOL_SMALL_SIZE, PBUF_POOL_SMALL_BUFSIZE,     "PBUF_POOL_SMALL")
+LWIP_PBUF_MEMPOOL(PBUF_POOL_LARGE, PBUF_POOL_LARGE_SIZE, PBUF_POOL_LARGE_BUFSIZE,     "PBUF_POOL_LARGE")
+#endif /* PBUF_POOL_SIZE_CLASSES */
 
 
 /*
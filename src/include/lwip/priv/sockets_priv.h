@@ -89,8 +89,28 @@ struct lwip_sock {
 #define LWIP_SOCK_FD_FREE_TCP  1
 #define LWIP_SOCK_FD_FREE_FREE 2
 #endif
+#if LWIP_TCP_ZEROCOPY
+  /** number of MSG_ZEROCOPY sends whose data is not referenced anymore */
+  u32_t zerocopy_done;
+  /** incremented each time the socket is allocated, so completions of a
+      previous user of this socket are not counted */
+  u16_t zerocopy_gen;
+#endif /* LWIP_TCP_ZEROCOPY */
 };
 
+#if LWIP_TCP_ZEROCOPY
+/** The pbuf passed to netconn_write_ref() for a MSG_ZEROCOPY send. It is
+ * freed when the stack does not reference the data anymore. */
+struct lwip_sock_zerocopy {
+  /** 'base class' */
+  struct pbuf_custom pc;
+  /** the socket to report the completion to */
+  struct lwip_sock *sock;
+  /** sock->zerocopy_gen at the time of the send */
+  u16_t gen;
+};
+#endif /* LWIP_TCP_ZEROCOPY */
+
 #ifndef set_errno
 #define set_errno(err) do { if (err) { errno = (err); } } while(0)
 #endif
@@ -85,7 +85,47 @@ err_t            tcp_rexmit_rto_prepare(struct tcp_pcb *pcb);
 void             tcp_rexmit_rto_commit(struct tcp_pcb *pcb);
 void             tcp_rexmit_rto  (struct tcp_pcb *pcb);
 void             tcp_rexmit_fast (struct tcp_pcb *pcb);
+#if LWIP_TCP_SACK_IN
+void             tcp_rexmit_sack (struct tcp_pcb *pcb);
+u32_t            tcp_sack_lost_end(const struct tcp_pcb *pcb);
+void             tcp_sack_recovery_done(struct tcp_pcb *pcb);
+/** In SACK based loss recovery (RFC 6675)? */
+#define TCP_SACK_RECOVERY(pcb) (((pcb)->flags & (TF_INFR | TF_SACK)) == (TF_INFR | TF_SACK))
+#endif /* LWIP_TCP_SACK_IN */
+#if LWIP_TCP_RACK_TLP
+/* pcb->rack_flags */
+#define TCP_RACK_VALID      0x01U /* rack_xmit_ts/rack_end_seq/rack_rtt are set */
+#define TCP_RACK_REO_TIMER  0x02U /* rack_due is the reordering timer */
+#define TCP_RACK_PTO_TIMER  0x04U /* rack_due is the loss probe timer */
+#define TCP_TLP_INFLIGHT    0x08U /* a loss probe was sent, tlp_end_seq is valid */
+#define TCP_TLP_REXMIT      0x10U /* the loss probe was a retransmission */
+#define TCP_RACK_TIMERS     (TCP_RACK_REO_TIMER | TCP_RACK_PTO_TIMER)
+/** Worst case delayed ACK time added to the probe timeout for a single
+    segment in flight (RFC 8985, WCDelAckT) */
+#define TCP_TLP_WCDELACK    200
+void             tcp_rack_detect_loss(struct tcp_pcb *pcb);
+void             tcp_rack_tlp_schedule(struct tcp_pcb *pcb);
+void             tcp_rack_tlp_timeout(struct tcp_pcb *pcb);
+void             tcp_rack_timer_start(struct tcp_pcb *pcb, u8_t timer, u32_t ms);
+#endif /* LWIP_TCP_RACK_TLP */
 u32_t            tcp_update_rcv_ann_wnd(struct tcp_pcb *pcb);
+
+/* Congestion control (tcp_cc.c) */
+void             tcp_reno_on_ack(struct tcp_pcb *pcb, tcpwnd_size_t acked);
+void             tcp_reno_on_dupack(struct tcp_pcb *pcb);
+void             tcp_reno_on_rto(struct tcp_pcb *pcb);
+void             tcp_reno_on_recovery_exit(struct tcp_pcb *pcb);
+#if LWIP_TCP_CC
+#define TCP_CC_ON_ACK(pcb, acked)       (pcb)->cc_ops->on_ack(pcb, acked)
+#define TCP_CC_ON_DUPACK(pcb)           (pcb)->cc_ops->on_dupack(pcb)
+#define TCP_CC_ON_RTO(pcb)              (pcb)->cc_ops->on_rto(pcb)
+#define TCP_CC_ON_RECOVERY_EXIT(pcb)    (pcb)->cc_ops->on_recovery_exit(pcb)
+#else /* LWIP_TCP_CC */
+#define TCP_CC_ON_ACK(pcb, acked)       tcp_reno_on_ack(pcb, acked)
+#define TCP_CC_ON_DUPACK(pcb)           tcp_reno_on_dupack(pcb)
+#define TCP_CC_ON_RTO(pcb)              tcp_reno_on_rto(pcb)
+#define TCP_CC_ON_RECOVERY_EXIT(pcb)    tcp_reno_on_recovery_exit(pcb)
+#endif /* LWIP_TCP_CC */
 err_t            tcp_process_refused_data(struct tcp_pcb *pcb);
 
 /**
@@ -270,14 +310,33 @@ struct tcp_seg {
                                                checksummed into 'chksum' */
 #define TF_SEG_OPTS_WND_SCALE   (u8_t)0x08U /* Include WND SCALE option (only used in SYN segments) */
 #define TF_SEG_OPTS_SACK_PERM   (u8_t)0x10U /* Include SACK Permitted option (only used in SYN segments) */
+#define TF_SEG_SACKED           (u8_t)0x20U /* Segment was SACKed by the remote host (LWIP_TCP_SACK_IN) */
+#define TF_SEG_SACK_REXMIT      (u8_t)0x40U /* Segment was retransmitted during the current
+                                               SACK based loss recovery (LWIP_TCP_SACK_IN) */
+#define TF_SEG_REXMITTED        (u8_t)0x80U /* Segment was retransmitted (LWIP_TCP_RACK_TLP) */
+#if LWIP_TCP_RACK_TLP
+  u32_t xmit_time;         /* sys_now() when the segment was last sent */
+#endif /* LWIP_TCP_RACK_TLP */
   struct tcp_hdr *tcphdr;  /* the TCP header */
 };
 
+#if LWIP_TCP_ZEROCOPY
+/** A custom pbuf pointing into data passed to tcp_write_ref(). It holds a
+ * reference on the caller's pbuf until it is freed. */
+struct tcp_ref_pbuf {
+  /** 'base class' */
+  struct pbuf_custom pc;
+  /** the pbuf passed to tcp_write_ref() */
+  struct pbuf *ref;
+};
+#endif /* LWIP_TCP_ZEROCOPY */
+
 #define LWIP_TCP_OPT_EOL        0
 #define LWIP_TCP_OPT_NOP        1
 #define LWIP_TCP_OPT_MSS        2
 #define LWIP_TCP_OPT_WS         3
 #define LWIP_TCP_OPT_SACK_PERM  4
+#define LWIP_TCP_OPT_SACK       5
 #define LWIP_TCP_OPT_TS         8
 
 #define LWIP_TCP_OPT_LEN_MSS    4
@@ -310,6 +369,30 @@ struct tcp_seg {
 /** This returns a TCP header option for MSS in an u32_t */
 #define TCP_BUILD_MSS_OPTION(mss) lwip_htonl(0x02040000 | ((mss) & 0xFFFF))
 
+#if LWIP_TCP_RTO_MS
+#define TCPRTT_F           S32_F
+/* RTT measurements and the RTO are in milliseconds */
+#define TCP_RTT_NOW()      sys_now()
+#define TCP_MS_TO_RTT(ms)  (ms)
+#define TCP_RTT_TO_MS(rtt) (rtt)
+/* in slow timer ticks, rounded up */
+#define TCP_RTO_TICKS(rto) (((u32_t)(rto) + TCP_SLOW_INTERVAL - 1) / TCP_SLOW_INTERVAL)
+/* bounded to [TCP_RTO_MIN..TCP_RTO_MAX] before and after the backoff (RFC 6298) */
+#define TCP_RTO_BOUND(rto) LWIP_MIN(LWIP_MAX((rto), TCP_RTO_MIN), TCP_RTO_MAX)
+#define TCP_RTO_CALC(pcb, shift) ((tcprtt_t)LWIP_MIN(TCP_RTO_BOUND(((pcb)->sa >> 3) + (pcb)->sv) << (shift), TCP_RTO_MAX))
+void tcp_rto_timer_start(struct tcp_pcb *pcb);
+/** (Re)start the retransmission timer */
+#define TCP_RTO_RESTART(pcb) tcp_rto_timer_start(pcb)
+#else /* LWIP_TCP_RTO_MS */
+#define TCPRTT_F           S16_F
+#define TCP_RTT_NOW()      tcp_ticks
+#define TCP_MS_TO_RTT(ms)  ((ms) / TCP_SLOW_INTERVAL)
+#define TCP_RTT_TO_MS(rtt) ((rtt) * TCP_SLOW_INTERVAL)
+#define TCP_RTO_TICKS(rto) ((u32_t)(rto))
+#define TCP_RTO_CALC(pcb, shift) ((tcprtt_t)LWIP_MIN((((pcb)->sa >> 3) + (pcb)->sv) << (shift), 0x7FFF))
+#define TCP_RTO_RESTART(pcb) (pcb)->rtime = 0
+#endif /* LWIP_TCP_RTO_MS */
+
 #if LWIP_WND_SCALE
 #define TCPWNDSIZE_F       U32_F
 #define TCPWND_MAX         0xFFFFFFFFU
@@ -349,6 +432,41 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
    3) All PCBs in the tcp_listen_pcbs list is in LISTEN state.
    4) All PCBs in the tcp_tw_pcbs list is in TIME-WAIT state.
 */
+#if LWIP_TCP_PCB_HASH
+/* Hash table lookup for tcp_input(), maintained by TCP_REG and TCP_RMV
+   alongside the active, TIME-WAIT and listen lists. */
+void tcp_pcb_hash_add(struct tcp_pcb **pcbs, struct tcp_pcb *pcb);
+void tcp_pcb_hash_remove(struct tcp_pcb **pcbs, struct tcp_pcb *pcb);
+struct tcp_pcb *tcp_pcb_hash_lookup(const ip_addr_t *local_ip, u16_t local_port,
+                                    const ip_addr_t *remote_ip, u16_t remote_port,
+                                    struct netif *inp);
+struct tcp_pcb_listen *tcp_listen_hash_lookup(const ip_addr_t *local_ip, u16_t local_port,
+                                              struct netif *inp);
+#define TCP_PCB_HASH_ADD(pcbs, npcb) tcp_pcb_hash_add(pcbs, npcb)
+#define TCP_PCB_HASH_RMV(pcbs, npcb) tcp_pcb_hash_remove(pcbs, npcb)
+#else /* LWIP_TCP_PCB_HASH */
+#define TCP_PCB_HASH_ADD(pcbs, npcb)
+#define TCP_PCB_HASH_RMV(pcbs, npcb)
+#endif /* LWIP_TCP_PCB_HASH */
+
+#if LWIP_TCP_PCB_TIMERS
+/* Per-pcb timer scheduling, maintained by TCP_REG and TCP_RMV for the active
+   and TIME-WAIT lists: active pcbs start on the timer list visited by every
+   tcp_fasttmr()/tcp_slowtmr() run, TIME-WAIT pcbs are parked on the wheel. */
+void tcp_pcb_timer_add(struct tcp_pcb **pcbs, struct tcp_pcb *pcb);
+void tcp_pcb_timer_remove(struct tcp_pcb **pcbs, struct tcp_pcb *pcb);
+/* Move a parked active pcb back to the timer list. Must be called whenever
+   something may start one of its timers (sending, receiving, closing...). */
+void tcp_pcb_timer_arm(struct tcp_pcb *pcb);
+#define TCP_PCB_TIMER_ADD(pcbs, npcb) tcp_pcb_timer_add(pcbs, npcb)
+#define TCP_PCB_TIMER_RMV(pcbs, npcb) tcp_pcb_timer_remove(pcbs, npcb)
+#define TCP_PCB_TIMER_ARM(pcb)        tcp_pcb_timer_arm(pcb)
+#else /* LWIP_TCP_PCB_TIMERS */
+#define TCP_PCB_TIMER_ADD(pcbs, npcb)
+#define TCP_PCB_TIMER_RMV(pcbs, npcb)
+#define TCP_PCB_TIMER_ARM(pcb)
+#endif /* LWIP_TCP_PCB_TIMERS */
+
 /* Define two macros, TCP_REG and TCP_RMV that registers a TCP PCB
    with a PCB list or removes a PCB from a list, respectively. */
 #ifndef TCP_DEBUG_PCB_LISTS
@@ -367,6 +485,8 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
                             (npcb)->next = *(pcbs); \
                             LWIP_ASSERT("TCP_REG: npcb->next != npcb", (npcb)->next != (npcb)); \
                             *(pcbs) = (npcb); \
+                            TCP_PCB_HASH_ADD(pcbs, npcb); \
+                            TCP_PCB_TIMER_ADD(pcbs, npcb); \
                             LWIP_ASSERT("TCP_REG: tcp_pcbs sane", tcp_pcbs_sane()); \
               tcp_timer_needed(); \
                             } while(0)
@@ -374,6 +494,8 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
                             struct tcp_pcb *tcp_tmp_pcb; \
                             LWIP_ASSERT("TCP_RMV: pcbs != NULL", *(pcbs) != NULL); \
                             LWIP_DEBUGF(TCP_DEBUG, ("TCP_RMV: removing %p from %p\n", (void *)(npcb), (void *)(*(pcbs)))); \
+                            TCP_PCB_HASH_RMV(pcbs, npcb); \
+                            TCP_PCB_TIMER_RMV(pcbs, npcb); \
                             if(*(pcbs) == (npcb)) { \
                                *(pcbs) = (*pcbs)->next; \
                             } else for (tcp_tmp_pcb = *(pcbs); tcp_tmp_pcb != NULL; tcp_tmp_pcb = tcp_tmp_pcb->next) { \
@@ -393,11 +515,15 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
   do {                                             \
     (npcb)->next = *pcbs;                          \
     *(pcbs) = (npcb);                              \
+    TCP_PCB_HASH_ADD(pcbs, npcb);                  \
+    TCP_PCB_TIMER_ADD(pcbs, npcb);                 \
     tcp_timer_needed();                            \
   } while (0)
 
 #define TCP_RMV(pcbs, npcb)                        \
   do {                                             \
+    TCP_PCB_HASH_RMV(pcbs, npcb);                  \
+    TCP_PCB_TIMER_RMV(pcbs, npcb);                 \
     if(*(pcbs) == (npcb)) {                        \
       (*(pcbs)) = (*pcbs)->next;                   \
     }                                              \
@@ -444,6 +570,9 @@ void tcp_pcb_remove(struct tcp_pcb **pcblist, struct tcp_pcb *pcb);
 void tcp_segs_free(struct tcp_seg *seg);
 void tcp_seg_free(struct tcp_seg *seg);
 struct tcp_seg *tcp_seg_copy(struct tcp_seg *seg);
+#if LWIP_TCP_RACK_TLP
+void tcp_rack_update(struct tcp_pcb *pcb, const struct tcp_seg *seg);
+#endif /* LWIP_TCP_RACK_TLP */
 
 #define tcp_ack(pcb)                               \
   do {                                             \
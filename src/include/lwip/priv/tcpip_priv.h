@@ -117,6 +117,9 @@ enum tcpip_msg_type {
 #endif /* !LWIP_TCPIP_CORE_LOCKING */
 #if !LWIP_TCPIP_CORE_LOCKING_INPUT
   TCPIP_MSG_INPKT,
+#if LWIP_TCPIP_INPUT_BATCH
+  TCPIP_MSG_INPKT_BATCH,
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 #endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
 #if LWIP_TCPIP_TIMEOUT && LWIP_TIMERS
   TCPIP_MSG_TIMEOUT,
@@ -146,6 +149,14 @@ struct tcpip_msg {
       struct netif *netif;
       netif_input_fn input_fn;
     } inp;
+#if LWIP_TCPIP_INPUT_BATCH
+    /* the packets follow the message, see TCPIP_MSG_INPKT_BATCH_PKTS() */
+    struct {
+      struct netif *netif;
+      netif_input_fn input_fn;
+      u16_t count;
+    } inp_batch;
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 #endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
     struct {
       tcpip_callback_fn function;
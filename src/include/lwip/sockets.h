@@ -223,6 +223,7 @@ struct ifreq {
 #define SO_CONTIMEO     0x1009 /* Unimplemented: connect timeout */
 #define SO_NO_CHECK     0x100a /* don't create UDP checksum */
 #define SO_BINDTODEVICE 0x100b /* bind to device */
+#define SO_ZEROCOPY_DONE 0x100c /* get the number of MSG_ZEROCOPY sends whose data the stack has released (u32_t) */
 
 /*
  * Structure used for manipulating linger option.
@@ -267,6 +268,7 @@ struct linger {
 #define MSG_DONTWAIT   0x08    /* Nonblocking i/o for this operation only */
 #define MSG_MORE       0x10    /* Sender will send more */
 #define MSG_NOSIGNAL   0x20    /* Uninmplemented: Requests not to send the SIGPIPE signal if an attempt to send is made on a stream-oriented socket that is no longer connected. */
+#define MSG_ZEROCOPY   0x40    /* TCP send without copying (LWIP_TCP_ZEROCOPY): the data must not change until the send is counted by SO_ZEROCOPY_DONE */
 
 
 /*
@@ -285,6 +287,7 @@ struct linger {
 #define TCP_KEEPIDLE   0x03    /* set pcb->keep_idle  - Same as TCP_KEEPALIVE, but use seconds for get/setsockopt */
 #define TCP_KEEPINTVL  0x04    /* set pcb->keep_intvl - Use seconds for get/setsockopt */
 #define TCP_KEEPCNT    0x05    /* set pcb->keep_cnt   - Use number of probes sent for get/setsockopt */
+#define TCP_CONGESTION 0x06    /* set/get the congestion control module by name (string), needs LWIP_TCP_CC */
 #endif /* LWIP_TCP */
 
 #if LWIP_IPV6
@@ -607,6 +610,10 @@ int lwip_select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptse
 #if LWIP_SOCKET_POLL
 int lwip_poll(struct pollfd *fds, nfds_t nfds, int timeout);
 #endif
+#if LWIP_SOCKET_RECV_PBUF
+ssize_t lwip_recv_pbuf(int s, struct pbuf **p, int flags);
+int lwip_recv_pbuf_free(int s, struct pbuf *p);
+#endif /* LWIP_SOCKET_RECV_PBUF */
 int lwip_ioctl(int s, long cmd, void *argp);
 int lwip_fcntl(int s, int cmd, int val);
 const char *lwip_inet_ntop(int af, const void *src, char *dst, socklen_t size);
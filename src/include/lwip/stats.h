@@ -41,6 +41,7 @@
 
 #include "lwip/mem.h"
 #include "lwip/memp.h"
+#include "lwip/pbuf.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -104,8 +105,28 @@ struct stats_mem {
   mem_size_t used;
   mem_size_t max;
   STAT_COUNTER illegal;
+#if MEMP_CACHE
+  /** memp_malloc() calls served from a thread cache without locking */
+  STAT_COUNTER cache_hit;
+  /** memp_malloc() calls that had to refill a thread cache */
+  STAT_COUNTER cache_miss;
+#endif /* MEMP_CACHE */
 };
 
+#if PBUF_POOL_STATS
+/** PBUF_POOL size class stats */
+struct stats_pbuf_pool {
+  /** pbufs taken from this class */
+  STAT_COUNTER alloc;
+  /** pbufs taken from this class because the best-fit class was empty */
+  STAT_COUNTER fallback;
+  /** payload bytes requested for pbufs of this class */
+  u32_t req_bytes;
+  /** buffer bytes handed out for them (req_bytes plus unused tail) */
+  u32_t buf_bytes;
+};
+#endif /* PBUF_POOL_STATS */
+
 /** System element stats */
 struct stats_syselem {
   STAT_COUNTER used;
@@ -120,6 +141,18 @@ struct stats_sys {
   struct stats_syselem mbox;
 };
 
+#if TCPIP_STATS
+/** tcpip_thread busy-poll stats */
+struct stats_tcpip {
+  /** polling rounds */
+  STAT_COUNTER poll;
+  /** polling rounds that fetched a message or received frames */
+  STAT_COUNTER poll_hit;
+  /** times the polling budget ran out and tcpip_thread blocked */
+  STAT_COUNTER idle;
+};
+#endif /* TCPIP_STATS */
+
 /** SNMP MIB2 stats */
 struct stats_mib2 {
   /* IP */
@@ -270,10 +303,18 @@ struct stats_ {
   /** Internal memory pools */
   struct stats_mem *memp[MEMP_MAX];
 #endif
+#if PBUF_POOL_STATS
+  /** PBUF_POOL size classes */
+  struct stats_pbuf_pool pbuf_pool[PBUF_POOL_CLASS_COUNT];
+#endif
 #if SYS_STATS
   /** System */
   struct stats_sys sys;
 #endif
+#if TCPIP_STATS
+  /** tcpip_thread busy-polling */
+  struct stats_tcpip tcpip;
+#endif
 #if IP6_STATS
   /** IPv6 */
   struct stats_proto ip6;
@@ -409,6 +450,16 @@ void stats_init(void);
 #define MEMP_STATS_GET(x, i) 0
 #endif
 
+#if PBUF_POOL_STATS
+#define PBUF_POOL_STATS_INC(x, c) STATS_INC(pbuf_pool[c].x)
+#define PBUF_POOL_STATS_ADD(x, c, y) lwip_stats.pbuf_pool[c].x += (u32_t)(y)
+#define PBUF_POOL_STATS_DISPLAY(c) stats_display_pbuf_pool(&lwip_stats.pbuf_pool[c], c)
+#else
+#define PBUF_POOL_STATS_INC(x, c)
+#define PBUF_POOL_STATS_ADD(x, c, y)
+#define PBUF_POOL_STATS_DISPLAY(c)
+#endif
+
 #if SYS_STATS
 #define SYS_STATS_INC(x) STATS_INC(sys.x)
 #define SYS_STATS_DEC(x) STATS_DEC(sys.x)
@@ -421,6 +472,14 @@ void stats_init(void);
 #define SYS_STATS_DISPLAY()
 #endif
 
+#if TCPIP_STATS
+#define TCPIP_STATS_INC(x) STATS_INC(x)
+#define TCPIP_STATS_DISPLAY() stats_display_tcpip(&lwip_stats.tcpip)
+#else
+#define TCPIP_STATS_INC(x)
+#define TCPIP_STATS_DISPLAY()
+#endif
+
 #if IP6_STATS
 #define IP6_STATS_INC(x) STATS_INC(x)
 #define IP6_STATS_DISPLAY() stats_display_proto(&lwip_stats.ip6, "IPv6")
@@ -474,14 +533,22 @@ void stats_display_proto(struct stats_proto *proto, const char *name);
 void stats_display_igmp(struct stats_igmp *igmp, const char *name);
 void stats_display_mem(struct stats_mem *mem, const char *name);
 void stats_display_memp(struct stats_mem *mem, int index);
+#if PBUF_POOL_STATS
+void stats_display_pbuf_pool(struct stats_pbuf_pool *pool, int pool_class);
+#endif /* PBUF_POOL_STATS */
 void stats_display_sys(struct stats_sys *sys);
+#if TCPIP_STATS
+void stats_display_tcpip(struct stats_tcpip *tcpip);
+#endif /* TCPIP_STATS */
 #else /* LWIP_STATS_DISPLAY */
 #define stats_display()
 #define stats_display_proto(proto, name)
 #define stats_display_igmp(igmp, name)
 #define stats_display_mem(mem, name)
 #define stats_display_memp(mem, index)
+#define stats_display_pbuf_pool(pool, pool_class)
 #define stats_display_sys(sys)
+#define stats_display_tcpip(tcpip)
 #endif /* LWIP_STATS_DISPLAY */
 
 #ifdef __cplusplus
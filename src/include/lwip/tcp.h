@@ -191,6 +191,30 @@ struct tcp_ext_arg_callbacks {
 
 #define LWIP_TCP_PCB_NUM_EXT_ARG_ID_INVALID 0xFF
 
+#if LWIP_TCP_CC
+/** Maximum length of a congestion control module name (TCP_CONGESTION) */
+#define TCP_CC_NAME_MAX  16
+/** Number of u32_t in each pcb reserved for the congestion control module */
+#define TCP_CC_PRIV_SIZE 6
+
+/** A congestion control module, see @ref LWIP_TCP_CC */
+struct tcp_cc_ops {
+  /** name for tcp_cc_find() and the TCP_CONGESTION socket option */
+  const char *name;
+  /** the module was attached to a pcb: initialize pcb->cc_priv */
+  void (*init)(struct tcp_pcb *pcb);
+  /** new data was acknowledged outside of loss recovery: grow cwnd */
+  void (*on_ack)(struct tcp_pcb *pcb, tcpwnd_size_t acked);
+  /** fast retransmit after duplicate ACKs (or SACKs): set ssthresh, cwnd is
+   * then derived from it by the loss recovery algorithm */
+  void (*on_dupack)(struct tcp_pcb *pcb);
+  /** retransmission timeout: set ssthresh and cwnd */
+  void (*on_rto)(struct tcp_pcb *pcb);
+  /** all data outstanding when loss recovery started was acknowledged: set cwnd */
+  void (*on_recovery_exit)(struct tcp_pcb *pcb);
+};
+#endif /* LWIP_TCP_CC */
+
 #if LWIP_TCP_PCB_NUM_EXT_ARGS
 /* This is the structure for ext args in tcp pcbs (used as array) */
 struct tcp_pcb_ext_args {
@@ -203,6 +227,20 @@ struct tcp_pcb_ext_args {
 #define TCP_PCB_EXTARGS
 #endif
 
+#if LWIP_TCP_PCB_HASH
+/* Chaining pointer for the pcb lookup hash tables (see LWIP_TCP_PCB_HASH) */
+#define TCP_PCB_HASH_NEXT(type) type *hash_next;
+#else
+#define TCP_PCB_HASH_NEXT(type)
+#endif
+
+#if LWIP_TCP_CC
+/* Congestion control module, on listening pcbs the one accepted pcbs inherit */
+#define TCP_PCB_CC const struct tcp_cc_ops *cc_ops;
+#else
+#define TCP_PCB_CC
+#endif
+
 typedef u16_t tcpflags_t;
 #define TCP_ALLFLAGS 0xffffU
 
@@ -211,8 +249,10 @@ typedef u16_t tcpflags_t;
  */
 #define TCP_PCB_COMMON(type) \
   type *next; /* for the linked list */ \
+  TCP_PCB_HASH_NEXT(type) \
   void *callback_arg; \
   TCP_PCB_EXTARGS \
+  TCP_PCB_CC \
   enum tcp_state state; /* TCP state */ \
   u8_t prio; \
   /* ports are in host byte order */ \
@@ -278,6 +318,14 @@ struct tcp_pcb {
   u8_t polltmr, pollinterval;
   u8_t last_timer;
   u32_t tmr;
+#if LWIP_TCP_PCB_TIMERS
+  /* timer list or timing wheel slot this pcb is on (see LWIP_TCP_PCB_TIMERS) */
+  struct tcp_pcb *tmr_next;
+  struct tcp_pcb **tmr_pprev;
+  u32_t tmr_due;    /* tcp_ticks when a parked pcb must be checked again */
+  u32_t tmr_parked; /* tcp_ticks when the pcb was parked */
+  u8_t tmr_wheel;   /* 1 if parked on the timing wheel, 0 if on the timer list */
+#endif /* LWIP_TCP_PCB_TIMERS */
 
   /* receiver variables */
   u32_t rcv_nxt;   /* next seqno expected */
@@ -296,21 +344,41 @@ struct tcp_pcb {
 
   u16_t mss;   /* maximum segment size */
 
-  /* RTT (round trip time) estimation variables */
-  u32_t rttest; /* RTT estimate in 500ms ticks */
+  /* RTT (round trip time) estimation variables
+     (in 500ms ticks, or milliseconds with LWIP_TCP_RTO_MS) */
+  u32_t rttest; /* time the timed segment was sent */
   u32_t rtseq;  /* sequence number being timed */
-  s16_t sa, sv; /* @see "Congestion Avoidance and Control" by Van Jacobson and Karels */
+  tcprtt_t sa, sv; /* @see "Congestion Avoidance and Control" by Van Jacobson and Karels */
 
-  s16_t rto;    /* retransmission time-out (in ticks of TCP_SLOW_INTERVAL) */
+  tcprtt_t rto; /* retransmission time-out (in ticks of TCP_SLOW_INTERVAL, or ms) */
+#if LWIP_TCP_RTO_MS
+  u32_t rto_start; /* sys_now() when the retransmission timer was (re)started */
+#endif /* LWIP_TCP_RTO_MS */
   u8_t nrtx;    /* number of retransmissions */
 
   /* fast retransmit/recovery */
   u8_t dupacks;
   u32_t lastack; /* Highest acknowledged seqno. */
+#if LWIP_TCP_SACK_IN
+  u32_t sack_recover; /* snd_nxt when SACK based loss recovery started (RFC 6675 RecoveryPoint) */
+#endif /* LWIP_TCP_SACK_IN */
+#if LWIP_TCP_RACK_TLP
+  /* RACK-TLP (RFC 8985), times are sys_now() milliseconds */
+  u32_t rack_xmit_ts;  /* send time of the most recently sent segment that was delivered */
+  u32_t rack_end_seq;  /* end of that segment */
+  u32_t rack_rtt;      /* RTT of the latest RACK sample */
+  u32_t rack_min_rtt;  /* minimum RTT, the reordering window is a fraction of it */
+  u32_t rack_due;      /* expiry of the reordering or loss probe timer */
+  u32_t tlp_end_seq;   /* snd_nxt after the loss probe was sent */
+  u8_t rack_flags;
+#endif /* LWIP_TCP_RACK_TLP */
 
   /* congestion avoidance/control variables */
   tcpwnd_size_t cwnd;
   tcpwnd_size_t ssthresh;
+#if LWIP_TCP_CC
+  u32_t cc_priv[TCP_CC_PRIV_SIZE]; /* state of the congestion control module */
+#endif /* LWIP_TCP_CC */
 
   /* first byte following last rto byte */
   u32_t rto_end;
@@ -472,6 +540,10 @@ err_t            tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx);
 
 err_t            tcp_write   (struct tcp_pcb *pcb, const void *dataptr, u16_t len,
                               u8_t apiflags);
+#if LWIP_TCP_ZEROCOPY
+err_t            tcp_write_ref(struct tcp_pcb *pcb, const void *dataptr, u16_t len,
+                               u8_t apiflags, struct pbuf *ref);
+#endif /* LWIP_TCP_ZEROCOPY */
 
 void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
 
@@ -491,6 +563,16 @@ void tcp_ext_arg_set(struct tcp_pcb *pcb, u8_t id, void *arg);
 void *tcp_ext_arg_get(const struct tcp_pcb *pcb, u8_t id);
 #endif
 
+#if LWIP_TCP_CC
+extern const struct tcp_cc_ops tcp_cc_reno;
+#if LWIP_TCP_CC_CUBIC
+extern const struct tcp_cc_ops tcp_cc_cubic;
+#endif /* LWIP_TCP_CC_CUBIC */
+const struct tcp_cc_ops *tcp_cc_find(const char *name);
+void             tcp_set_cc  (struct tcp_pcb *pcb, const struct tcp_cc_ops *ops);
+#define          tcp_get_cc(pcb) ((pcb)->cc_ops)
+#endif /* LWIP_TCP_CC */
+
 #ifdef __cplusplus
 }
 #endif
@@ -53,6 +53,12 @@ typedef u32_t tcpwnd_size_t;
 typedef u16_t tcpwnd_size_t;
 #endif
 
+#if LWIP_TCP_RTO_MS
+typedef s32_t tcprtt_t;
+#else
+typedef s16_t tcprtt_t;
+#endif
+
 enum tcp_state {
   CLOSED      = 0,
   LISTEN      = 1,
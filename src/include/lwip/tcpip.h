@@ -58,9 +58,20 @@ extern sys_mutex_t lock_tcpip_core;
 /** Unlock lwIP core mutex (needs @ref LWIP_TCPIP_CORE_LOCKING 1) */
 #define UNLOCK_TCPIP_CORE()   sys_mutex_unlock(&lock_tcpip_core)
 #endif /* LOCK_TCPIP_CORE */
+#if !defined LOCK_TCPIP_CORE_SHARED || defined __DOXYGEN__
+/** Lock lwIP core for read-only access (needs @ref LWIP_TCPIP_CORE_LOCKING 1).
+ * A port may map this to the read side of a reader-writer lock so that
+ * read-mostly calls like getsockopt() don't serialize against each other;
+ * by default it takes the core lock exclusively. Must not be nested. */
+#define LOCK_TCPIP_CORE_SHARED()    LOCK_TCPIP_CORE()
+/** Unlock lwIP core after read-only access (needs @ref LWIP_TCPIP_CORE_LOCKING 1) */
+#define UNLOCK_TCPIP_CORE_SHARED()  UNLOCK_TCPIP_CORE()
+#endif /* LOCK_TCPIP_CORE_SHARED */
 #else /* LWIP_TCPIP_CORE_LOCKING */
 #define LOCK_TCPIP_CORE()
 #define UNLOCK_TCPIP_CORE()
+#define LOCK_TCPIP_CORE_SHARED()
+#define UNLOCK_TCPIP_CORE_SHARED()
 #endif /* LWIP_TCPIP_CORE_LOCKING */
 
 struct pbuf;
@@ -78,6 +89,10 @@ void   tcpip_init(tcpip_init_done_fn tcpip_init_done, void *arg);
 
 err_t  tcpip_inpkt(struct pbuf *p, struct netif *inp, netif_input_fn input_fn);
 err_t  tcpip_input(struct pbuf *p, struct netif *inp);
+#if LWIP_TCPIP_INPUT_BATCH
+err_t  tcpip_inpkt_batch(struct pbuf **p, u16_t count, struct netif *inp, netif_input_fn input_fn);
+err_t  tcpip_input_batch(struct pbuf **p, u16_t count, struct netif *inp);
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 
 err_t  tcpip_try_callback(tcpip_callback_fn function, void *ctx);
 err_t  tcpip_callback(tcpip_callback_fn function, void *ctx);
@@ -92,6 +92,12 @@ typedef void (* sys_timeout_handler)(void *arg);
 
 struct sys_timeo {
   struct sys_timeo *next;
+#if LWIP_TIMERS_WHEEL
+  /** previous timeout in the same wheel slot (the slot's head points to its tail) */
+  struct sys_timeo *prev;
+  /** next timeout in the same sys_untimeout() hash bucket */
+  struct sys_timeo *hash_next;
+#endif /* LWIP_TIMERS_WHEEL */
   u32_t time;
   sys_timeout_handler h;
   void *arg;
@@ -115,7 +121,9 @@ void sys_check_timeouts(void);
 u32_t sys_timeouts_sleeptime(void);
 
 #if LWIP_TESTMODE
+#if !LWIP_TIMERS_WHEEL
 struct sys_timeo** sys_timeouts_get_next_timeout(void);
+#endif /* !LWIP_TIMERS_WHEEL */
 void lwip_cyclic_timer(void *arg);
 #endif
 
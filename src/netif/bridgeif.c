@@ -257,7 +257,7 @@ bridgeif_send_to_port(bridgeif_private_t *br, struct pbuf *p, u8_t dstport_idx)
         if (netif_get_index(portif) != p->if_idx) {
           if (netif_is_link_up(portif)) {
             LWIP_DEBUGF(BRIDGEIF_FW_DEBUG, ("br -> flood(%p:%d) -> %d\n", (void *)p, p->if_idx, netif_get_index(portif)));
-            return portif->linkoutput(portif, p);
+            return netif_linkoutput(portif, p);
           }
         }
       }
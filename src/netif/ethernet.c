@@ -254,7 +254,7 @@ free_and_return:
 
 /**
  * @ingroup ethernet
- * Send an ethernet packet on the network using netif->linkoutput().
+ * Send an ethernet packet on the network using netif_linkoutput().
  * The ethernet header is filled in before sending.
  *
  * @see LWIP_HOOK_VLAN_SET
@@ -317,7 +317,7 @@ ethernet_output(struct netif * netif, struct pbuf * p,
               ("ethernet_output: sending packet %p\n", (void *)p));
 
   /* send the packet */
-  return netif->linkoutput(netif, p);
+  return netif_linkoutput(netif, p);
 
 pbuf_header_failed:
   LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_LEVEL_SERIOUS,
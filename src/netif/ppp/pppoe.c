@@ -741,7 +741,7 @@ pppoe_output(struct pppoe_softc *sc, struct pbuf *pb)
       sc->sc_dest.addr[0], sc->sc_dest.addr[1], sc->sc_dest.addr[2], sc->sc_dest.addr[3], sc->sc_dest.addr[4], sc->sc_dest.addr[5],
       pb->tot_len));
 
-  res = sc->sc_ethif->linkoutput(sc->sc_ethif, pb);
+  res = netif_linkoutput(sc->sc_ethif, pb);
 
   pbuf_free(pb);
 
@@ -1055,7 +1055,7 @@ pppoe_send_padt(struct netif *outgoing_if, u_int session, const u8_t *dest)
   p = (u8_t*)(ethhdr + 1);
   PPPOE_ADD_HEADER(p, PPPOE_CODE_PADT, session, 0);
 
-  res = outgoing_if->linkoutput(outgoing_if, pb);
+  res = netif_linkoutput(outgoing_if, pb);
 
   pbuf_free(pb);
 
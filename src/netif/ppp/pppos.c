@@ -165,6 +165,14 @@ ppp_get_fcs(u8_t byte)
 #define PPPOS_UNPROTECT(lev)
 #endif /* PPP_INPROC_IRQ_SAFE */
 
+/* Input and output buffers are filled in place up to PBUF_POOL_BUFSIZE,
+ * so they must not come from a smaller PBUF_POOL size class. */
+#if PBUF_POOL_SIZE_CLASSES
+#define PPPOS_POOL_ALLOC(len) pbuf_alloc_pool(PBUF_RAW, (len), PBUF_POOL_CLASS_DEFAULT)
+#else /* PBUF_POOL_SIZE_CLASSES */
+#define PPPOS_POOL_ALLOC(len) pbuf_alloc(PBUF_RAW, (len), PBUF_POOL)
+#endif /* PBUF_POOL_SIZE_CLASSES */
+
 
 /*
  * Create a new PPP connection using the given serial I/O device.
@@ -210,7 +218,7 @@ pppos_write(ppp_pcb *ppp, void *ctx, struct pbuf *p)
   /* Grab an output buffer. Using PBUF_POOL here for tx is ok since the pbuf
      gets freed by 'pppos_output_last' before this function returns and thus
      cannot starve rx. */
-  nb = pbuf_alloc(PBUF_RAW, 0, PBUF_POOL);
+  nb = PPPOS_POOL_ALLOC(0);
   if (nb == NULL) {
     PPPDEBUG(LOG_WARNING, ("pppos_write[%d]: alloc fail\n", ppp->netif->num));
     LINK_STATS_INC(link.memerr);
@@ -261,7 +269,7 @@ pppos_netif_output(ppp_pcb *ppp, void *ctx, struct pbuf *pb, u16_t protocol)
   /* Grab an output buffer. Using PBUF_POOL here for tx is ok since the pbuf
      gets freed by 'pppos_output_last' before this function returns and thus
      cannot starve rx. */
-  nb = pbuf_alloc(PBUF_RAW, 0, PBUF_POOL);
+  nb = PPPOS_POOL_ALLOC(0);
   if (nb == NULL) {
     PPPDEBUG(LOG_WARNING, ("pppos_netif_output[%d]: alloc fail\n", ppp->netif->num));
     LINK_STATS_INC(link.memerr);
@@ -672,7 +680,7 @@ pppos_input(ppp_pcb *ppp, u8_t *s, int l)
               pbuf_alloc_len = PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN;
             }
 #endif /* IP_FORWARD || LWIP_IPV6_FORWARD */
-            next_pbuf = pbuf_alloc(PBUF_RAW, pbuf_alloc_len, PBUF_POOL);
+            next_pbuf = PPPOS_POOL_ALLOC(pbuf_alloc_len);
             if (next_pbuf == NULL) {
               /* No free buffers.  Drop the input packet and let the
                * higher layers deal with it.  Continue processing
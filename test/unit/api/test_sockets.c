@@ -828,6 +828,291 @@ cleanup:
 }
 END_TEST
 
+#if LWIP_TCP_CC
+START_TEST(test_sockets_tcp_congestion)
+{
+  int s, ret;
+  char name[TCP_CC_NAME_MAX];
+  socklen_t len;
+  LWIP_UNUSED_ARG(_i);
+
+  s = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  fail_unless(s >= 0);
+
+  len = sizeof(name);
+  ret = lwip_getsockopt(s, IPPROTO_TCP, TCP_CONGESTION, name, &len);
+  fail_unless(ret == 0);
+  fail_unless(len == sizeof("reno"));
+  fail_unless(!strcmp(name, "reno"));
+
+#if LWIP_TCP_CC_CUBIC
+  /* the name need not be NUL-terminated */
+  ret = lwip_setsockopt(s, IPPROTO_TCP, TCP_CONGESTION, "cubic", 5);
+  fail_unless(ret == 0);
+  len = sizeof(name);
+  ret = lwip_getsockopt(s, IPPROTO_TCP, TCP_CONGESTION, name, &len);
+  fail_unless(ret == 0);
+  fail_unless(!strcmp(name, "cubic"));
+#endif /* LWIP_TCP_CC_CUBIC */
+
+  ret = lwip_setsockopt(s, IPPROTO_TCP, TCP_CONGESTION, "unknown", sizeof("unknown"));
+  fail_unless(ret == -1);
+  fail_unless(errno == ENOENT);
+
+  ret = lwip_close(s);
+  fail_unless(ret == 0);
+}
+END_TEST
+#endif /* LWIP_TCP_CC */
+
+#if LWIP_TCP_ZEROCOPY || LWIP_SOCKET_RECV_PBUF || LWIP_NETCONN_FASTPATH
+/** Set up a TCP connection over loopback: returns the listening socket, the
+ * (nonblocking) client socket and the accepted socket */
+static void
+test_sockets_tcp_connect(int *sl, int *sact, int *spass)
+{
+  int ret, arg;
+  struct sockaddr_in sa_listen;
+
+  memset(&sa_listen, 0, sizeof(sa_listen));
+  sa_listen.sin_family = AF_INET;
+  sa_listen.sin_port = PP_HTONS(1234);
+  sa_listen.sin_addr.s_addr = PP_HTONL(INADDR_LOOPBACK);
+
+  *sl = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  fail_unless(*sl >= 0);
+  ret = lwip_bind(*sl, (struct sockaddr *)&sa_listen, sizeof(sa_listen));
+  fail_unless(ret == 0);
+  ret = lwip_listen(*sl, 0);
+  fail_unless(ret == 0);
+
+  *sact = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  fail_unless(*sact >= 0);
+  arg = 1;
+  ret = lwip_ioctl(*sact, FIONBIO, &arg);
+  fail_unless(ret == 0);
+  ret = lwip_connect(*sact, (struct sockaddr *)&sa_listen, sizeof(sa_listen));
+  fail_unless(ret == -1);
+  fail_unless(errno == EINPROGRESS);
+  while (tcpip_thread_poll_one());
+  *spass = lwip_accept(*sl, NULL, NULL);
+  fail_unless(*spass >= 0);
+}
+#endif /* LWIP_TCP_ZEROCOPY || LWIP_SOCKET_RECV_PBUF || LWIP_NETCONN_FASTPATH */
+
+#if LWIP_TCP_ZEROCOPY
+static u8_t test_sockets_zerocopy_buf[2 * TCP_MSS];
+
+START_TEST(test_sockets_tcp_zerocopy)
+{
+  int sl, sact, spass;
+  int ret;
+  u32_t done;
+  socklen_t len;
+  size_t rcvd;
+  char rxbuf[TCP_MSS];
+  LWIP_UNUSED_ARG(_i);
+
+  test_sockets_tcp_connect(&sl, &sact, &spass);
+
+  len = sizeof(done);
+  ret = lwip_getsockopt(sact, SOL_SOCKET, SO_ZEROCOPY_DONE, &done, &len);
+  fail_unless(ret == 0);
+  fail_unless(done == 0);
+
+  ret = lwip_send(sact, test_sockets_zerocopy_buf, sizeof(test_sockets_zerocopy_buf), MSG_ZEROCOPY);
+  fail_unless(ret == sizeof(test_sockets_zerocopy_buf));
+  /* the buffer is still referenced by the unacked segments */
+  ret = lwip_getsockopt(sact, SOL_SOCKET, SO_ZEROCOPY_DONE, &done, &len);
+  fail_unless(ret == 0);
+  fail_unless(done == 0);
+  fail_unless(MEMP_STATS_GET(used, MEMP_SOCKET_ZEROCOPY) == 1);
+
+  /* deliver the data, the second full segment is ACKed immediately */
+  while (tcpip_thread_poll_one());
+  rcvd = 0;
+  while (rcvd < sizeof(test_sockets_zerocopy_buf)) {
+    ret = lwip_recv(spass, rxbuf, sizeof(rxbuf), 0);
+    fail_unless(ret > 0);
+    rcvd += (size_t)ret;
+  }
+  while (tcpip_thread_poll_one());
+  ret = lwip_getsockopt(sact, SOL_SOCKET, SO_ZEROCOPY_DONE, &done, &len);
+  fail_unless(ret == 0);
+  fail_unless(done == 1);
+  fail_unless(MEMP_STATS_GET(used, MEMP_SOCKET_ZEROCOPY) == 0);
+
+  ret = lwip_close(sl);
+  fail_unless(ret == 0);
+  ret = lwip_close(sact);
+  fail_unless(ret == 0);
+  ret = lwip_close(spass);
+  fail_unless(ret == 0);
+}
+END_TEST
+
+/* A send completing after its socket was closed must not be counted for the
+ * next user of that socket, even if that one gets the same netconn */
+START_TEST(test_sockets_tcp_zerocopy_reuse)
+{
+  int sl, sact, spass, snew;
+  int ret;
+  u32_t done;
+  socklen_t len;
+  size_t rcvd;
+  char rxbuf[TCP_MSS];
+  LWIP_UNUSED_ARG(_i);
+
+  test_sockets_tcp_connect(&sl, &sact, &spass);
+
+  ret = lwip_send(sact, test_sockets_zerocopy_buf, sizeof(test_sockets_zerocopy_buf), MSG_ZEROCOPY);
+  fail_unless(ret == sizeof(test_sockets_zerocopy_buf));
+  /* close with the data still unacked, then reuse the socket */
+  ret = lwip_close(sact);
+  fail_unless(ret == 0);
+  snew = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  fail_unless(snew == sact);
+  fail_unless(MEMP_STATS_GET(used, MEMP_SOCKET_ZEROCOPY) == 1);
+
+  while (tcpip_thread_poll_one());
+  rcvd = 0;
+  while (rcvd < sizeof(test_sockets_zerocopy_buf)) {
+    ret = lwip_recv(spass, rxbuf, sizeof(rxbuf), 0);
+    fail_unless(ret > 0);
+    rcvd += (size_t)ret;
+  }
+  while (tcpip_thread_poll_one());
+  fail_unless(MEMP_STATS_GET(used, MEMP_SOCKET_ZEROCOPY) == 0);
+  len = sizeof(done);
+  ret = lwip_getsockopt(snew, SOL_SOCKET, SO_ZEROCOPY_DONE, &done, &len);
+  fail_unless(ret == 0);
+  fail_unless(done == 0);
+
+  ret = lwip_close(sl);
+  fail_unless(ret == 0);
+  ret = lwip_close(snew);
+  fail_unless(ret == 0);
+  ret = lwip_close(spass);
+  fail_unless(ret == 0);
+}
+END_TEST
+#endif /* LWIP_TCP_ZEROCOPY */
+
+#if LWIP_SOCKET_RECV_PBUF
+START_TEST(test_sockets_tcp_recv_pbuf)
+{
+  int sl, sact, spass;
+  ssize_t ret;
+  struct pbuf *p;
+  struct tcp_pcb *pcb;
+  char rxbuf[2];
+  LWIP_UNUSED_ARG(_i);
+
+  test_sockets_tcp_connect(&sl, &sact, &spass);
+  pcb = lwip_socket_dbg_get_socket(spass)->conn->pcb.tcp;
+  fail_unless(pcb->rcv_wnd == TCP_WND);
+
+  ret = lwip_send(sact, "hello", 5, 0);
+  fail_unless(ret == 5);
+  while (tcpip_thread_poll_one());
+
+  /* a partial copy leaves the rest for lwip_recv_pbuf() */
+  ret = lwip_recv(spass, rxbuf, sizeof(rxbuf), 0);
+  fail_unless(ret == 2);
+  fail_unless(pcb->rcv_wnd == TCP_WND - 3);
+  ret = lwip_recv_pbuf(spass, &p, 0);
+  fail_unless(ret == 3);
+  fail_unless(p != NULL);
+  fail_unless(p->tot_len == 3);
+  fail_unless(pbuf_memcmp(p, 0, "llo", 3) == 0);
+  /* the window opens only once the chain is released */
+  fail_unless(pcb->rcv_wnd == TCP_WND - 3);
+  ret = lwip_recv_pbuf_free(spass, p);
+  fail_unless(ret == 0);
+  fail_unless(pcb->rcv_wnd == TCP_WND);
+
+  ret = lwip_recv_pbuf(spass, &p, MSG_DONTWAIT);
+  fail_unless(ret == -1);
+  fail_unless(errno == EWOULDBLOCK);
+  fail_unless(p == NULL);
+
+  /* end of stream */
+  ret = lwip_close(sact);
+  fail_unless(ret == 0);
+  while (tcpip_thread_poll_one());
+  ret = lwip_recv_pbuf(spass, &p, 0);
+  fail_unless(ret == 0);
+  fail_unless(p == NULL);
+
+  ret = lwip_close(sl);
+  fail_unless(ret == 0);
+  ret = lwip_close(spass);
+  fail_unless(ret == 0);
+}
+END_TEST
+#endif /* LWIP_SOCKET_RECV_PBUF */
+
+#if LWIP_NETCONN_FASTPATH
+/** Check that nonblocking sends that fit are written directly and the rest
+ * still takes the regular path (partial write, then EWOULDBLOCK) */
+START_TEST(test_sockets_tcp_fastpath)
+{
+  int sl, sact, spass;
+  ssize_t ret;
+  size_t sent, rcvd;
+  struct tcp_pcb *pcb_act, *pcb_pass;
+  u8_t txbuf[1000];
+  u8_t rxbuf[TCP_MSS];
+  int i, loops;
+  LWIP_UNUSED_ARG(_i);
+
+  test_sockets_tcp_connect(&sl, &sact, &spass);
+  pcb_act = lwip_socket_dbg_get_socket(sact)->conn->pcb.tcp;
+  pcb_pass = lwip_socket_dbg_get_socket(spass)->conn->pcb.tcp;
+  for (i = 0; i < (int)sizeof(txbuf); i++) {
+    txbuf[i] = (u8_t)i;
+  }
+
+  sent = 0;
+  for (i = 0; i < TCP_SND_BUF / (int)sizeof(txbuf); i++) {
+    ret = lwip_send(sact, txbuf, sizeof(txbuf), MSG_DONTWAIT);
+    fail_unless(ret == sizeof(txbuf));
+    sent += (size_t)ret;
+  }
+  ret = lwip_send(sact, txbuf, sizeof(txbuf), MSG_DONTWAIT);
+  fail_unless(ret == TCP_SND_BUF % sizeof(txbuf));
+  sent += (size_t)ret;
+  fail_unless(tcp_sndbuf(pcb_act) == 0);
+  ret = lwip_send(sact, txbuf, sizeof(txbuf), MSG_DONTWAIT);
+  fail_unless(ret == -1);
+  fail_unless(errno == EWOULDBLOCK);
+
+  rcvd = 0;
+  for (loops = 0; (rcvd < sent) && (loops < 100); loops++) {
+    while (tcpip_thread_poll_one());
+    ret = lwip_recv(spass, rxbuf, sizeof(rxbuf), MSG_DONTWAIT);
+    if (ret > 0) {
+      for (i = 0; i < ret; i++) {
+        fail_unless(rxbuf[i] == (u8_t)((rcvd + (size_t)i) % sizeof(txbuf)));
+      }
+      rcvd += (size_t)ret;
+    }
+  }
+  fail_unless(rcvd == sent);
+  while (tcpip_thread_poll_one());
+  fail_unless(pcb_pass->rcv_wnd == TCP_WND);
+  fail_unless(tcp_sndbuf(pcb_act) == TCP_SND_BUF);
+
+  ret = lwip_close(sl);
+  fail_unless(ret == 0);
+  ret = lwip_close(sact);
+  fail_unless(ret == 0);
+  ret = lwip_close(spass);
+  fail_unless(ret == 0);
+}
+END_TEST
+#endif /* LWIP_NETCONN_FASTPATH */
+
 /** Create the suite including all tests for this module */
 Suite *
 sockets_suite(void)
@@ -838,6 +1123,19 @@ sockets_suite(void)
     TESTFUNC(test_sockets_msgapis),
     TESTFUNC(test_sockets_select),
     TESTFUNC(test_sockets_recv_after_rst),
+#if LWIP_TCP_CC
+    TESTFUNC(test_sockets_tcp_congestion),
+#endif /* LWIP_TCP_CC */
+#if LWIP_TCP_ZEROCOPY
+    TESTFUNC(test_sockets_tcp_zerocopy),
+    TESTFUNC(test_sockets_tcp_zerocopy_reuse),
+#endif /* LWIP_TCP_ZEROCOPY */
+#if LWIP_SOCKET_RECV_PBUF
+    TESTFUNC(test_sockets_tcp_recv_pbuf),
+#endif /* LWIP_SOCKET_RECV_PBUF */
+#if LWIP_NETCONN_FASTPATH
+    TESTFUNC(test_sockets_tcp_fastpath),
+#endif /* LWIP_NETCONN_FASTPATH */
   };
   return create_suite("SOCKETS", tests, sizeof(tests)/sizeof(testfunc), sockets_setup, sockets_teardown);
 }
@@ -0,0 +1,205 @@
+#include "test_tcpip.h"
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcpip_priv.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+
+#if LWIP_TCPIP_INPUT_BATCH || LWIP_TCPIP_BUSY_POLL
+
+/* Setups/teardown functions */
+
+static void
+tcpip_setup(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+tcpip_teardown(void)
+{
+  while (tcpip_thread_poll_one());
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/** Create an IPv4 TCP packet from 10.0.0.src:sport to 10.0.0.1:80, optionally
+ * with an Ethernet header. 'id' is stored as IP id, 'frag' as flags/offset. */
+static struct pbuf *
+test_tcpip_ip4_packet(int eth, u8_t src, u16_t sport, u16_t id, u16_t frag)
+{
+  u16_t off = eth ? SIZEOF_ETH_HDR : 0;
+  struct pbuf *p = pbuf_alloc(PBUF_RAW, (u16_t)(off + IP_HLEN + 4), PBUF_RAM);
+  u8_t *b;
+
+  fail_unless(p != NULL);
+  b = (u8_t *)p->payload;
+  memset(b, 0, p->len);
+  if (eth) {
+    b[off - 2] = (u8_t)(ETHTYPE_IP >> 8);
+    b[off - 1] = (u8_t)ETHTYPE_IP;
+  }
+  b[off] = 0x45;
+  b[off + 4] = (u8_t)(id >> 8);
+  b[off + 5] = (u8_t)id;
+  b[off + 6] = (u8_t)(frag >> 8);
+  b[off + 7] = (u8_t)frag;
+  b[off + 9] = IP_PROTO_TCP;
+  b[off + 12] = 10;
+  b[off + 15] = src;
+  b[off + 16] = 10;
+  b[off + 19] = 1;
+  b[off + IP_HLEN] = (u8_t)(sport >> 8);
+  b[off + IP_HLEN + 1] = (u8_t)sport;
+  b[off + IP_HLEN + 3] = 80;
+  return p;
+}
+
+static u16_t test_tcpip_last_id[2];
+static int test_tcpip_input_count;
+
+static err_t
+test_tcpip_input_fn(struct pbuf *p, struct netif *inp)
+{
+  const u8_t *b = (const u8_t *)p->payload;
+  u16_t id = (u16_t)((b[4] << 8) | b[5]);
+  u16_t flow = (u16_t)(b[IP_HLEN + 1] & 1);
+  LWIP_UNUSED_ARG(inp);
+
+  /* packets of a flow are processed in order */
+  fail_unless(id == test_tcpip_last_id[flow] + 1);
+  test_tcpip_last_id[flow] = id;
+  test_tcpip_input_count++;
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+#if LWIP_TCPIP_BUSY_POLL
+/* frames the test driver has "received" and not yet passed up */
+static u16_t test_tcpip_rx_pending;
+static u16_t test_tcpip_rx_id;
+
+static err_t
+test_tcpip_netif_init(struct netif *netif)
+{
+  LWIP_UNUSED_ARG(netif);
+  return ERR_OK;
+}
+
+static u16_t
+test_tcpip_rx_poll(struct netif *netif)
+{
+  u16_t count = test_tcpip_rx_pending;
+  for (; test_tcpip_rx_pending > 0; test_tcpip_rx_pending--) {
+    test_tcpip_rx_id++;
+    fail_unless(test_tcpip_input_fn(test_tcpip_ip4_packet(0, 2, 1000, test_tcpip_rx_id, 0), netif) == ERR_OK);
+  }
+  return count;
+}
+#endif /* LWIP_TCPIP_BUSY_POLL */
+
+/* Test functions */
+
+#if LWIP_TCPIP_INPUT_BATCH
+/** Check that tcpip_inpkt_batch() passes a burst with one message and keeps
+ * the order of packets per flow */
+START_TEST(test_tcpip_input_batch)
+{
+  struct netif ipif;
+  struct pbuf *pkts[TCPIP_INPUT_BATCH_MAX];
+  u16_t i, count = 0;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&ipif, 0, sizeof(ipif));
+  memset(test_tcpip_last_id, 0, sizeof(test_tcpip_last_id));
+  test_tcpip_input_count = 0;
+
+  for (i = 1; i <= 8; i++) {
+    pkts[count++] = test_tcpip_ip4_packet(0, 2, 1000, i, 0);
+    pkts[count++] = test_tcpip_ip4_packet(0, 3, 1001, i, 0);
+  }
+  fail_unless(tcpip_inpkt_batch(pkts, TCPIP_INPUT_BATCH_MAX + 1, &ipif, test_tcpip_input_fn) == ERR_ARG);
+  fail_unless(tcpip_inpkt_batch(pkts, count, &ipif, test_tcpip_input_fn) == ERR_OK);
+  for (i = 0; i < count; i++) {
+    fail_unless(pkts[i] == NULL);
+  }
+#if !LWIP_TCPIP_CORE_LOCKING_INPUT
+  fail_unless(MEMP_STATS_GET(used, MEMP_TCPIP_MSG_INPKT) == 0);
+  fail_unless(MEMP_STATS_GET(used, MEMP_TCPIP_MSG_INPKT_BATCH) == 1);
+#endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
+
+  while (tcpip_thread_poll_one());
+  fail_unless(test_tcpip_input_count == 16);
+  fail_unless(test_tcpip_last_id[0] == 8);
+  fail_unless(test_tcpip_last_id[1] == 8);
+#if !LWIP_TCPIP_CORE_LOCKING_INPUT
+  fail_unless(MEMP_STATS_GET(used, MEMP_TCPIP_MSG_INPKT_BATCH) == 0);
+#endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
+}
+END_TEST
+#endif /* LWIP_TCPIP_INPUT_BATCH */
+
+#if LWIP_TCPIP_BUSY_POLL
+/** Check that polling calls netif->rx_poll and counts the rounds that found
+ * work */
+START_TEST(test_tcpip_busy_poll)
+{
+  struct netif netif;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(test_tcpip_last_id, 0, sizeof(test_tcpip_last_id));
+  test_tcpip_input_count = 0;
+  test_tcpip_rx_id = 0;
+  memset(&lwip_stats.tcpip, 0, sizeof(lwip_stats.tcpip));
+  fail_unless(netif_add_noaddr(&netif, NULL, test_tcpip_netif_init, test_tcpip_input_fn) == &netif);
+  netif.rx_poll = test_tcpip_rx_poll;
+
+  /* nothing queued, nothing received */
+  fail_unless(!tcpip_thread_poll_one());
+  fail_unless(lwip_stats.tcpip.poll == 1);
+  fail_unless(lwip_stats.tcpip.poll_hit == 0);
+
+  test_tcpip_rx_pending = 3;
+  fail_unless(tcpip_thread_poll_one());
+  fail_unless(test_tcpip_input_count == 3);
+  fail_unless(test_tcpip_last_id[0] == 3);
+  fail_unless(lwip_stats.tcpip.poll == 2);
+  fail_unless(lwip_stats.tcpip.poll_hit == 1);
+
+  fail_unless(!tcpip_thread_poll_one());
+  fail_unless(lwip_stats.tcpip.poll == 3);
+  fail_unless(lwip_stats.tcpip.poll_hit == 1);
+
+  netif_remove(&netif);
+}
+END_TEST
+#endif /* LWIP_TCPIP_BUSY_POLL */
+
+/** Create the suite including all tests for this module */
+Suite *
+tcpip_suite(void)
+{
+  testfunc tests[] = {
+#if LWIP_TCPIP_INPUT_BATCH
+    TESTFUNC(test_tcpip_input_batch),
+#endif /* LWIP_TCPIP_INPUT_BATCH */
+#if LWIP_TCPIP_BUSY_POLL
+    TESTFUNC(test_tcpip_busy_poll),
+#endif /* LWIP_TCPIP_BUSY_POLL */
+  };
+  return create_suite("TCPIP", tests, sizeof(tests)/sizeof(testfunc), tcpip_setup, tcpip_teardown);
+}
+
+#else /* LWIP_TCPIP_INPUT_BATCH || LWIP_TCPIP_BUSY_POLL */
+
+Suite *
+tcpip_suite(void)
+{
+  return create_suite("TCPIP", NULL, 0, NULL, NULL);
+}
+#endif /* LWIP_TCPIP_INPUT_BATCH || LWIP_TCPIP_BUSY_POLL */
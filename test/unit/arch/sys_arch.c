@@ -43,6 +43,9 @@
 #include <string.h>
 
 u32_t lwip_sys_now;
+#if MEMP_CACHE
+struct memp_cache *lwip_sys_memp_cache;
+#endif /* MEMP_CACHE */
 
 u32_t
 sys_jiffies(void)
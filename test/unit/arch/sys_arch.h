@@ -68,5 +68,12 @@ void test_sys_arch_wait_callback(test_sys_arch_waiting_fn waiting_fn);
 /* current time */
 extern u32_t lwip_sys_now;
 
+#if MEMP_CACHE
+struct memp_cache;
+/* memp cache of the (only) thread, NULL: memp_malloc() is not cached */
+extern struct memp_cache *lwip_sys_memp_cache;
+#define LWIP_MEMP_THREAD_CACHE_GET() lwip_sys_memp_cache
+#endif /* MEMP_CACHE */
+
 #endif /* LWIP_HDR_TEST_SYS_ARCH_H */
 
@@ -0,0 +1,228 @@
+#include "test_inet_chksum.h"
+
+#include "lwip/inet_chksum.h"
+#include "lwip/pbuf.h"
+#include "lwip/memp.h"
+#include "lwip/def.h"
+
+#define TEST_BUFSIZE 0x10000
+#define TEST_MAX_OFFSET 8
+
+static u8_t test_src[TEST_BUFSIZE + TEST_MAX_OFFSET];
+static u8_t test_dst[TEST_BUFSIZE + TEST_MAX_OFFSET];
+static u32_t test_seed;
+
+/* Setups/teardown functions */
+
+static void
+inet_chksum_setup(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+inet_chksum_teardown(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* reproducible pseudo random numbers */
+static u32_t
+test_rand(void)
+{
+  test_seed = test_seed * 1103515245UL + 12345UL;
+  return test_seed >> 8;
+}
+
+static void
+test_fill_random(u8_t *buf, size_t len)
+{
+  size_t i;
+  for (i = 0; i < len; i++) {
+    buf[i] = (u8_t)test_rand();
+  }
+}
+
+/* RFC 1071 reference: sum big endian 16-bit words octet by octet */
+static u16_t
+test_ref_chksum(const u8_t *data, size_t len)
+{
+  u32_t acc = 0;
+  size_t i;
+
+  for (i = 0; i + 1 < len; i += 2) {
+    acc += ((u32_t)data[i] << 8) | data[i + 1];
+  }
+  if (len & 1) {
+    acc += (u32_t)data[len - 1] << 8;
+  }
+  while (acc >> 16) {
+    acc = (acc >> 16) + (acc & 0xffff);
+  }
+  /* same byte order as LWIP_CHKSUM(): the sum as stored in the header */
+  return lwip_htons((u16_t)acc);
+}
+
+static void
+test_check_range(size_t offset, size_t len)
+{
+  /* inet_chksum() returns the inverted sum */
+  u16_t sum = (u16_t)~inet_chksum(&test_src[offset], (u16_t)len);
+  u16_t ref = test_ref_chksum(&test_src[offset], len);
+  fail_unless(sum == ref, "offset %d len %d", (int)offset, (int)len);
+}
+
+/* Test functions */
+
+/** Compare inet_chksum() against the reference for all alignments and lengths
+ * in the range where implementations switch between head, bulk and tail code */
+START_TEST(test_inet_chksum_lengths)
+{
+  size_t offset, len;
+  LWIP_UNUSED_ARG(_i);
+
+  test_seed = 1;
+  test_fill_random(test_src, sizeof(test_src));
+  for (offset = 0; offset < TEST_MAX_OFFSET; offset++) {
+    for (len = 0; len <= 300; len++) {
+      test_check_range(offset, len);
+    }
+    test_check_range(offset, 1500);
+    test_check_range(offset, TEST_BUFSIZE - 1);
+  }
+}
+END_TEST
+
+/** Compare inet_chksum() against the reference for random data, alignments and
+ * lengths, including all-ones data which produces the most carries */
+START_TEST(test_inet_chksum_random)
+{
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_seed = 2;
+  for (i = 0; i < 200; i++) {
+    size_t offset = test_rand() % TEST_MAX_OFFSET;
+    size_t len = test_rand() % TEST_BUFSIZE;
+    if (i % 4 == 0) {
+      memset(test_src, (i % 8 == 0) ? 0xff : 0x00, sizeof(test_src));
+    } else {
+      test_fill_random(test_src, offset + len);
+    }
+    test_check_range(offset, len);
+  }
+}
+END_TEST
+
+/** Check inet_chksum_pbuf() over chains with odd and even pbuf lengths */
+START_TEST(test_inet_chksum_pbuf_chain)
+{
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_seed = 3;
+  test_fill_random(test_src, sizeof(test_src));
+  for (i = 0; i < 100; i++) {
+    struct pbuf *p = NULL;
+    size_t total = 0;
+    u16_t sum;
+    int n, num = 1 + (int)(test_rand() % 6);
+
+    for (n = 0; n < num; n++) {
+      u16_t len = (u16_t)(1 + test_rand() % 700);
+      struct pbuf *q = pbuf_alloc(PBUF_RAW, len, PBUF_REF);
+      fail_unless(q != NULL);
+      if (q == NULL) {
+        break;
+      }
+      q->payload = &test_src[total + (size_t)n];
+      total += len;
+      if (p == NULL) {
+        p = q;
+      } else {
+        pbuf_cat(p, q);
+      }
+      /* the reference sums the same bytes contiguously */
+      memmove(&test_dst[total - len], q->payload, len);
+    }
+    sum = (u16_t)~inet_chksum_pbuf(p);
+    fail_unless(sum == test_ref_chksum(test_dst, total));
+    pbuf_free(p);
+  }
+}
+END_TEST
+
+#if LWIP_CHKSUM_COPY_ALGORITHM
+/** Check lwip_chksum_copy() copies correctly and returns the checksum */
+START_TEST(test_inet_chksum_copy)
+{
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_seed = 4;
+  test_fill_random(test_src, sizeof(test_src));
+  for (i = 0; i < 200; i++) {
+    size_t src_offset = test_rand() % TEST_MAX_OFFSET;
+    size_t dst_offset = test_rand() % TEST_MAX_OFFSET;
+    u16_t len = (u16_t)(test_rand() % ((i < 100) ? 100 : TEST_BUFSIZE));
+    u16_t chksum;
+
+    memset(test_dst, 0, sizeof(test_dst));
+    chksum = lwip_chksum_copy(&test_dst[dst_offset], &test_src[src_offset], len);
+    fail_unless(memcmp(&test_dst[dst_offset], &test_src[src_offset], len) == 0);
+    fail_unless(chksum == test_ref_chksum(&test_src[src_offset], len));
+    /* nothing written outside the destination range */
+    fail_unless((dst_offset == 0) || (test_dst[dst_offset - 1] == 0));
+    fail_unless(test_dst[dst_offset + len] == 0);
+  }
+}
+END_TEST
+#endif /* LWIP_CHKSUM_COPY_ALGORITHM */
+
+#if LWIP_CHECKSUM_ON_COPY
+/** Check pbuf_take_chksum() copies into pbuf chains and returns the checksum */
+START_TEST(test_inet_chksum_pbuf_take)
+{
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_seed = 5;
+  test_fill_random(test_src, sizeof(test_src));
+  for (i = 0; i < 100; i++) {
+    size_t src_offset = test_rand() % TEST_MAX_OFFSET;
+    u16_t len = (u16_t)(1 + test_rand() % 5000);
+    u16_t chksum = 0;
+    err_t err;
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+    fail_unless(p != NULL);
+    if (p == NULL) {
+      break;
+    }
+    err = pbuf_take_chksum(p, &test_src[src_offset], len, &chksum);
+    fail_unless(err == ERR_OK);
+    fail_unless(pbuf_memcmp(p, 0, &test_src[src_offset], len) == 0);
+    fail_unless(chksum == test_ref_chksum(&test_src[src_offset], len),
+                "len %d", (int)len);
+    pbuf_free(p);
+  }
+}
+END_TEST
+#endif /* LWIP_CHECKSUM_ON_COPY */
+
+/** Create the suite including all tests for this module */
+Suite *
+inet_chksum_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_inet_chksum_lengths),
+    TESTFUNC(test_inet_chksum_random),
+    TESTFUNC(test_inet_chksum_pbuf_chain),
+#if LWIP_CHKSUM_COPY_ALGORITHM
+    TESTFUNC(test_inet_chksum_copy),
+#endif /* LWIP_CHKSUM_COPY_ALGORITHM */
+#if LWIP_CHECKSUM_ON_COPY
+    TESTFUNC(test_inet_chksum_pbuf_take)
+#endif /* LWIP_CHECKSUM_ON_COPY */
+  };
+  return create_suite("INET_CHKSUM", tests, sizeof(tests)/sizeof(testfunc), inet_chksum_setup, inet_chksum_teardown);
+}
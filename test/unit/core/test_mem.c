@@ -210,6 +210,137 @@ START_TEST(test_mem_double_free)
 }
 END_TEST
 
+#if MEM_SIZE_CLASSES
+/** Freed blocks are reused for requests of the same size class */
+START_TEST(test_mem_size_classes)
+{
+  u8_t *p1, *p2, *p3;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(lwip_stats.mem.used == 0);
+
+  p1 = (u8_t *)mem_malloc(33);
+  fail_unless(p1 != NULL);
+  mem_free(p1);
+  fail_unless(lwip_stats.mem.used == 0);
+
+  /* 33 and 48 bytes are both in the 48 byte class */
+  p2 = (u8_t *)mem_malloc(48);
+  fail_unless(p2 == p1);
+  memset(p2, 0xff, 48);
+  /* 49 bytes are not */
+  p3 = (u8_t *)mem_malloc(49);
+  fail_unless(p3 != NULL);
+  fail_unless(p3 != p1);
+
+  mem_free(p2);
+  mem_free(p3);
+  fail_unless(lwip_stats.mem.used == 0);
+  fail_unless(lwip_stats.mem.illegal == 0);
+}
+END_TEST
+
+/** mem_trim keeps objects in a slab and shrinks big blocks */
+START_TEST(test_mem_size_classes_trim)
+{
+  u8_t *p1, *p2;
+  mem_size_t used;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(lwip_stats.mem.used == 0);
+
+  p1 = (u8_t *)mem_malloc(200);
+  fail_unless(p1 != NULL);
+  p2 = (u8_t *)mem_malloc(MEM_SIZE_CLASS_MAX * 4);
+  fail_unless(p2 != NULL);
+  used = lwip_stats.mem.used;
+
+  fail_unless(mem_trim(p1, 20) == p1);
+  fail_unless(lwip_stats.mem.used == used);
+  fail_unless(mem_trim(p2, 20) == p2);
+  fail_unless(lwip_stats.mem.used < used);
+
+  mem_free(p1);
+  mem_free(p2);
+  fail_unless(lwip_stats.mem.used == 0);
+  fail_unless(lwip_stats.mem.illegal == 0);
+}
+END_TEST
+
+/** Small objects don't fragment the heap between big blocks */
+START_TEST(test_mem_size_classes_fragmentation)
+{
+#define FRAG_NUM   8
+#define FRAG_BIG   1000
+  void *small[FRAG_NUM], *big[FRAG_NUM];
+  void *p;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(lwip_stats.mem.used == 0);
+
+  for (i = 0; i < FRAG_NUM; i++) {
+    small[i] = mem_malloc(40);
+    fail_unless(small[i] != NULL);
+    big[i] = mem_malloc(FRAG_BIG);
+    fail_unless(big[i] != NULL);
+  }
+  for (i = 0; i < FRAG_NUM; i++) {
+    mem_free(big[i]);
+  }
+  /* the freed big blocks are adjacent: the small objects are in one slab */
+  p = mem_malloc(FRAG_NUM * FRAG_BIG);
+  fail_unless(p != NULL);
+  mem_free(p);
+
+  for (i = 0; i < FRAG_NUM; i++) {
+    mem_free(small[i]);
+  }
+  fail_unless(lwip_stats.mem.used == 0);
+}
+END_TEST
+
+/** Empty slabs are returned to the heap when it runs out of memory */
+START_TEST(test_mem_size_classes_reclaim)
+{
+  void *first = NULL;
+  void *p;
+  int num = 0;
+  int cls;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(lwip_stats.mem.used == 0);
+  fail_unless(lwip_stats.mem.err == 0);
+
+  /* leave an empty slab in some size classes */
+  for (cls = 16; cls <= MEM_SIZE_CLASS_MAX; cls *= 2) {
+    p = mem_malloc((mem_size_t)cls);
+    fail_unless(p != NULL);
+    mem_free(p);
+  }
+  fail_unless(lwip_stats.mem.used == 0);
+
+  /* fill the heap with big blocks, chained through their first bytes */
+  while ((p = mem_malloc(MEM_SIZE_CLASS_MAX * 2)) != NULL) {
+    *(void **)p = first;
+    first = p;
+    num++;
+  }
+  fail_unless(num > 0);
+  fail_unless(lwip_stats.mem.err == 1);
+  fail_unless(lwip_stats.mem.used + MEM_SIZE_CLASS_MAX * 2 > MEM_SIZE - MEM_SIZE_CLASS_MAX * MEM_SIZE_CLASS_SLAB_OBJS);
+
+  while (first != NULL) {
+    p = first;
+    first = *(void **)p;
+    mem_free(p);
+  }
+  fail_unless(lwip_stats.mem.used == 0);
+  lwip_stats.mem.err = 0;
+}
+END_TEST
+#endif /* MEM_SIZE_CLASSES */
+
 /** Create the suite including all tests for this module */
 Suite *
 mem_suite(void)
@@ -218,7 +349,13 @@ mem_suite(void)
     TESTFUNC(test_mem_one),
     TESTFUNC(test_mem_random),
     TESTFUNC(test_mem_invalid_free),
-    TESTFUNC(test_mem_double_free)
+    TESTFUNC(test_mem_double_free),
+#if MEM_SIZE_CLASSES
+    TESTFUNC(test_mem_size_classes),
+    TESTFUNC(test_mem_size_classes_trim),
+    TESTFUNC(test_mem_size_classes_fragmentation),
+    TESTFUNC(test_mem_size_classes_reclaim),
+#endif /* MEM_SIZE_CLASSES */
   };
   return create_suite("MEM", tests, sizeof(tests)/sizeof(testfunc), mem_setup, mem_teardown);
 }
@@ -0,0 +1,235 @@
+#include "test_memp.h"
+
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+#include "arch/sys_arch.h"
+
+#if !LWIP_STATS || !MEMP_STATS
+#error "This tests needs MEMP-statistics enabled"
+#endif
+
+/* Setups/teardown functions */
+
+static void
+memp_setup(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+memp_teardown(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+
+/* Test functions */
+
+/** Allocate all elements of a pool and check stats */
+START_TEST(test_memp_one)
+{
+  struct stats_mem *stats = lwip_stats.memp[MEMP_UDP_PCB];
+  void *elems[MEMP_NUM_UDP_PCB];
+  STAT_COUNTER err = stats->err;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < MEMP_NUM_UDP_PCB; i++) {
+    elems[i] = memp_malloc(MEMP_UDP_PCB);
+    fail_unless(elems[i] != NULL);
+    fail_unless(stats->used == i + 1);
+  }
+  fail_unless(stats->max >= MEMP_NUM_UDP_PCB);
+  fail_unless(memp_malloc(MEMP_UDP_PCB) == NULL);
+  fail_unless(stats->err == err + 1);
+
+  for (i = 0; i < MEMP_NUM_UDP_PCB; i++) {
+    memp_free(MEMP_UDP_PCB, elems[i]);
+  }
+  fail_unless(stats->used == 0);
+  stats->err = err;
+}
+END_TEST
+
+/** Allocate and free a pool in bulk, including running it empty */
+START_TEST(test_memp_bulk)
+{
+  struct stats_mem *stats = lwip_stats.memp[MEMP_UDP_PCB];
+  void *elems[MEMP_NUM_UDP_PCB + 1];
+  STAT_COUNTER err = stats->err;
+  u16_t n;
+  int i, j;
+  LWIP_UNUSED_ARG(_i);
+
+  n = memp_malloc_bulk(MEMP_UDP_PCB, elems, 2);
+  fail_unless(n == 2);
+  fail_unless(stats->used == 2);
+  fail_unless(elems[0] != elems[1]);
+
+  /* only the rest of the pool is handed out */
+  n = memp_malloc_bulk(MEMP_UDP_PCB, &elems[2], MEMP_NUM_UDP_PCB - 1);
+  fail_unless(n == MEMP_NUM_UDP_PCB - 2);
+  fail_unless(stats->used == MEMP_NUM_UDP_PCB);
+  fail_unless(stats->err == err + 1);
+  for (i = 0; i < MEMP_NUM_UDP_PCB; i++) {
+    for (j = i + 1; j < MEMP_NUM_UDP_PCB; j++) {
+      fail_unless(elems[i] != elems[j]);
+    }
+  }
+
+  /* NULL entries are skipped */
+  elems[MEMP_NUM_UDP_PCB] = NULL;
+  memp_free_bulk(MEMP_UDP_PCB, &elems[1], MEMP_NUM_UDP_PCB);
+  fail_unless(stats->used == 1);
+  memp_free_bulk(MEMP_UDP_PCB, elems, 1);
+  fail_unless(stats->used == 0);
+
+  /* all elements can be allocated one by one again */
+  for (i = 0; i < MEMP_NUM_UDP_PCB; i++) {
+    elems[i] = memp_malloc(MEMP_UDP_PCB);
+    fail_unless(elems[i] != NULL);
+  }
+  for (i = 0; i < MEMP_NUM_UDP_PCB; i++) {
+    memp_free(MEMP_UDP_PCB, elems[i]);
+  }
+  stats->err = err;
+}
+END_TEST
+
+#if MEMP_CACHE
+/** Allocate and free through a thread cache and check that the pool is only
+ * touched in batches */
+START_TEST(test_memp_cache)
+{
+  struct memp_cache cache;
+  struct stats_mem *stats = lwip_stats.memp[MEMP_PBUF_POOL];
+  void *elems[2 * MEMP_CACHE_SIZE];
+  void *pcb;
+  STAT_COUNTER hit, miss;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(memp_pools[MEMP_PBUF_POOL]->num >= 4 * MEMP_CACHE_SIZE);
+  hit = stats->cache_hit;
+  miss = stats->cache_miss;
+  memp_cache_init(&cache);
+  lwip_sys_memp_cache = &cache;
+
+  /* the first allocation takes a batch from the pool */
+  elems[0] = memp_malloc(MEMP_PBUF_POOL);
+  fail_unless(elems[0] != NULL);
+  fail_unless(cache.count[MEMP_PBUF_POOL] == MEMP_CACHE_BATCH - 1);
+  fail_unless(stats->used == MEMP_CACHE_BATCH);
+  fail_unless(stats->cache_miss == miss + 1);
+
+  /* the rest of the batch is served from the cache */
+  for (i = 1; i < MEMP_CACHE_BATCH; i++) {
+    elems[i] = memp_malloc(MEMP_PBUF_POOL);
+    fail_unless(elems[i] != NULL);
+  }
+  fail_unless(cache.count[MEMP_PBUF_POOL] == 0);
+  fail_unless(stats->used == MEMP_CACHE_BATCH);
+  fail_unless(stats->cache_hit == hit);
+
+  /* the next refill adds the hits to the pool stats */
+  for (; i < 2 * MEMP_CACHE_SIZE; i++) {
+    elems[i] = memp_malloc(MEMP_PBUF_POOL);
+    fail_unless(elems[i] != NULL);
+  }
+  fail_unless(stats->used == 2 * MEMP_CACHE_SIZE);
+  fail_unless(stats->cache_miss == miss + (2 * MEMP_CACHE_SIZE) / MEMP_CACHE_BATCH);
+  fail_unless(stats->cache_hit == hit + (2 * MEMP_CACHE_SIZE) - (2 * MEMP_CACHE_SIZE) / MEMP_CACHE_BATCH - (MEMP_CACHE_BATCH - 1));
+
+  /* a full cache returns a batch to the pool */
+  for (i = 0; i < 2 * MEMP_CACHE_SIZE; i++) {
+    memp_free(MEMP_PBUF_POOL, elems[i]);
+    fail_unless(cache.count[MEMP_PBUF_POOL] <= MEMP_CACHE_SIZE);
+  }
+  fail_unless(cache.count[MEMP_PBUF_POOL] > MEMP_CACHE_SIZE - MEMP_CACHE_BATCH);
+  fail_unless(stats->used == cache.count[MEMP_PBUF_POOL]);
+
+  /* small pools are not cached */
+  pcb = memp_malloc(MEMP_TCP_PCB);
+  fail_unless(pcb != NULL);
+  fail_unless(cache.count[MEMP_TCP_PCB] == 0);
+  fail_unless(lwip_stats.memp[MEMP_TCP_PCB]->used == 1);
+  memp_free(MEMP_TCP_PCB, pcb);
+  fail_unless(cache.count[MEMP_TCP_PCB] == 0);
+  fail_unless(lwip_stats.memp[MEMP_TCP_PCB]->used == 0);
+
+  /* flushing returns everything */
+  memp_cache_flush(&cache);
+  lwip_sys_memp_cache = NULL;
+  fail_unless(cache.count[MEMP_PBUF_POOL] == 0);
+  fail_unless(cache.free[MEMP_PBUF_POOL] == NULL);
+  fail_unless(stats->used == 0);
+  fail_unless(stats->cache_hit == hit + 2 * MEMP_CACHE_SIZE - (2 * MEMP_CACHE_SIZE) / MEMP_CACHE_BATCH);
+}
+END_TEST
+
+/** Check that a thread cache gives back what it got when the pool runs empty */
+START_TEST(test_memp_cache_empty)
+{
+  struct memp_cache cache;
+  struct stats_mem *stats = lwip_stats.memp[MEMP_PBUF_POOL];
+  u16_t num = memp_pools[MEMP_PBUF_POOL]->num;
+  void *first = NULL;
+  void *p;
+  STAT_COUNTER err = stats->err;
+  u16_t n = 0;
+  LWIP_UNUSED_ARG(_i);
+
+  memp_cache_init(&cache);
+  lwip_sys_memp_cache = &cache;
+
+  /* chain all elements through their first pointer */
+  while ((p = memp_malloc(MEMP_PBUF_POOL)) != NULL) {
+    *(void **)p = first;
+    first = p;
+    n++;
+  }
+  fail_unless(n == num);
+  fail_unless(stats->err == err + 1);
+  fail_unless(stats->used == num);
+
+  while (first != NULL) {
+    p = first;
+    first = *(void **)p;
+    memp_free(MEMP_PBUF_POOL, p);
+  }
+  fail_unless(cache.count[MEMP_PBUF_POOL] <= MEMP_CACHE_SIZE);
+  memp_cache_flush(&cache);
+  lwip_sys_memp_cache = NULL;
+  fail_unless(stats->used == 0);
+
+  /* all elements can be allocated without a cache again */
+  for (n = 0; n < num; n++) {
+    p = memp_malloc(MEMP_PBUF_POOL);
+    fail_unless(p != NULL);
+    *(void **)p = first;
+    first = p;
+  }
+  while (first != NULL) {
+    p = first;
+    first = *(void **)p;
+    memp_free(MEMP_PBUF_POOL, p);
+  }
+  stats->err = err;
+}
+END_TEST
+#endif /* MEMP_CACHE */
+
+/** Create the suite including all tests for this module */
+Suite *
+memp_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_memp_one),
+    TESTFUNC(test_memp_bulk),
+#if MEMP_CACHE
+    TESTFUNC(test_memp_cache),
+    TESTFUNC(test_memp_cache_empty)
+#endif /* MEMP_CACHE */
+  };
+  return create_suite("MEMP", tests, sizeof(tests)/sizeof(testfunc), memp_setup, memp_teardown);
+}
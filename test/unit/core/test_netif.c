@@ -57,6 +57,42 @@ testif_init(struct netif *netif)
   return ERR_OK;
 }
 
+#if LWIP_NETIF_LINKOUTPUT_SG
+static int tx_ctr;
+static int tx_sg_ctr;
+static u16_t tx_sg_iovcnt;
+static u8_t tx_sg_frame[1600];
+static u16_t tx_sg_len;
+
+static err_t
+testif_tx_count_func(struct netif *netif, struct pbuf *p)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(p);
+  tx_ctr++;
+  return ERR_OK;
+}
+
+static err_t
+testif_tx_sg_func(struct netif *netif, const struct netif_iovec *iov, u16_t iovcnt, struct pbuf *p)
+{
+  u16_t i;
+  LWIP_UNUSED_ARG(netif);
+
+  tx_sg_ctr++;
+  tx_sg_iovcnt = iovcnt;
+  tx_sg_len = 0;
+  for (i = 0; i < iovcnt; i++) {
+    fail_unless(iov[i].len > 0);
+    fail_unless(tx_sg_len + iov[i].len <= sizeof(tx_sg_frame));
+    memcpy(&tx_sg_frame[tx_sg_len], iov[i].base, iov[i].len);
+    tx_sg_len = (u16_t)(tx_sg_len + iov[i].len);
+  }
+  fail_unless(tx_sg_len == p->tot_len);
+  return ERR_OK;
+}
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
+
 #define MAX_NSC_REASON_IDX 10
 static netif_nsc_reason_t expected_reasons;
 static int callback_ctr;
@@ -215,13 +251,83 @@ START_TEST(test_netif_extcallbacks)
 }
 END_TEST
 
+#if LWIP_NETIF_LINKOUTPUT_SG
+START_TEST(test_netif_linkoutput_sg)
+{
+  static const struct eth_addr src = {{0x02, 0x03, 0x04, 0x05, 0x06, 0x07}};
+  static const struct eth_addr dst = {{0x02, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e}};
+  static u8_t data[LWIP_NETIF_SG_MAX_IOV + 1];
+  ip4_addr_t addr;
+  struct pbuf *p, *q;
+  u8_t frame[sizeof(tx_sg_frame)];
+  int i, n;
+  LWIP_UNUSED_ARG(_i);
+
+  IP4_ADDR(&addr, 0, 0, 0, 0);
+  netif_add(&net_test, &addr, &addr, &addr, &net_test, testif_init, ethernet_input);
+  net_test.linkoutput = testif_tx_count_func;
+  net_test.linkoutput_sg = testif_tx_sg_func;
+  tx_ctr = 0;
+  tx_sg_ctr = 0;
+  for (i = 0; i < (int)sizeof(data); i++) {
+    data[i] = (u8_t)i;
+  }
+
+  /* the ethernet header is sent from the header pbuf, the data by reference */
+  p = pbuf_alloc(PBUF_LINK, 10, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0xaa, p->len);
+  q = pbuf_alloc(PBUF_RAW, 0, PBUF_REF);
+  fail_unless(q != NULL);
+  pbuf_cat(p, q);
+  q = pbuf_alloc(PBUF_RAW, sizeof(data), PBUF_REF);
+  fail_unless(q != NULL);
+  q->payload = data;
+  pbuf_cat(p, q);
+  fail_unless(ethernet_output(&net_test, p, &src, &dst, ETHTYPE_IP) == ERR_OK);
+  fail_unless(tx_sg_ctr == 1);
+  fail_unless(tx_ctr == 0);
+  /* the empty pbuf is skipped */
+  fail_unless(tx_sg_iovcnt == 2);
+  fail_unless(tx_sg_len == SIZEOF_ETH_HDR + 10 + sizeof(data));
+  fail_unless(pbuf_copy_partial(p, frame, p->tot_len, 0) == p->tot_len);
+  fail_unless(memcmp(frame, tx_sg_frame, tx_sg_len) == 0);
+  fail_unless(memcmp(tx_sg_frame, &dst, ETH_HWADDR_LEN) == 0);
+  pbuf_free(p);
+
+  /* the header and LWIP_NETIF_SG_MAX_IOV - 1 data pieces just fit, one more
+     piece goes to linkoutput */
+  for (n = LWIP_NETIF_SG_MAX_IOV - 1; n <= LWIP_NETIF_SG_MAX_IOV; n++) {
+    p = pbuf_alloc(PBUF_LINK, 0, PBUF_RAM);
+    fail_unless(p != NULL);
+    for (i = 0; i < n; i++) {
+      q = pbuf_alloc(PBUF_RAW, 1, PBUF_REF);
+      fail_unless(q != NULL);
+      q->payload = &data[i];
+      pbuf_cat(p, q);
+    }
+    fail_unless(ethernet_output(&net_test, p, &src, &dst, ETHTYPE_IP) == ERR_OK);
+    pbuf_free(p);
+  }
+  fail_unless(tx_sg_ctr == 2);
+  fail_unless(tx_sg_iovcnt == LWIP_NETIF_SG_MAX_IOV);
+  fail_unless(tx_ctr == 1);
+
+  netif_remove(&net_test);
+}
+END_TEST
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
+
 
 /** Create the suite including all tests for this module */
 Suite *
 netif_suite(void)
 {
   testfunc tests[] = {
-    TESTFUNC(test_netif_extcallbacks)
+    TESTFUNC(test_netif_extcallbacks),
+#if LWIP_NETIF_LINKOUTPUT_SG
+    TESTFUNC(test_netif_linkoutput_sg),
+#endif /* LWIP_NETIF_LINKOUTPUT_SG */
   };
   return create_suite("NETIF", tests, sizeof(tests)/sizeof(testfunc), netif_setup, netif_teardown);
 }
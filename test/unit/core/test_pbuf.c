@@ -2,6 +2,8 @@
 
 #include "lwip/pbuf.h"
 #include "lwip/stats.h"
+#include "lwip/def.h"
+#include "lwip/tcpip.h"
 
 #if !LWIP_STATS || !MEM_STATS ||!MEMP_STATS
 #error "This tests needs MEM- and MEMP-statistics enabled"
@@ -255,6 +257,288 @@ START_TEST(test_pbuf_get_put_at_edge)
 }
 END_TEST
 
+/* pbuf_free_batch() drops one reference per entry, like pbuf_free() */
+START_TEST(test_pbuf_free_batch)
+{
+  struct pbuf *v[5];
+  struct pbuf *shared;
+  LWIP_UNUSED_ARG(_i);
+
+  v[0] = pbuf_alloc(PBUF_RAW, 100, PBUF_POOL);
+  v[1] = pbuf_alloc(PBUF_RAW, 100, PBUF_RAM);
+  v[2] = pbuf_alloc(PBUF_RAW, 100, PBUF_REF);
+  v[3] = NULL;
+  v[4] = pbuf_alloc(PBUF_RAW, 100, PBUF_POOL);
+  fail_unless((v[0] != NULL) && (v[1] != NULL) && (v[2] != NULL) && (v[4] != NULL));
+  /* a chain sharing its tail with another one */
+  shared = pbuf_alloc(PBUF_RAW, 100, PBUF_POOL);
+  fail_unless(shared != NULL);
+  pbuf_ref(shared);
+  pbuf_cat(v[0], shared);
+  pbuf_cat(v[4], shared);
+
+  fail_unless(pbuf_free_batch(v, 5) == 5);
+  fail_unless(lwip_stats.mem.used == 0);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF) == 0);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL) == 0);
+
+  /* a chain still referenced elsewhere is only dereferenced */
+  v[0] = pbuf_alloc(PBUF_RAW, 100, PBUF_POOL);
+  fail_unless(v[0] != NULL);
+  pbuf_ref(v[0]);
+  fail_unless(pbuf_free_batch(v, 1) == 0);
+  fail_unless(v[0]->ref == 1);
+  fail_unless(pbuf_free_batch(v, 1) == 1);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL) == 0);
+}
+END_TEST
+
+/* many references to one pbuf (fan-out) only free it with the last one */
+START_TEST(test_pbuf_ref_fanout)
+{
+  struct pbuf *p, *q, *v[16];
+  u32_t fanout, i;
+  LWIP_UNUSED_ARG(_i);
+
+  /* as many references as LWIP_PBUF_REF_T holds, within reason */
+  fanout = LWIP_MIN((u32_t)(LWIP_PBUF_REF_T)~0, 1000);
+  p = pbuf_alloc(PBUF_RAW, 100, PBUF_POOL);
+  fail_unless(p != NULL);
+  for (i = 1; i < fanout; i++) {
+    pbuf_ref(p);
+  }
+  fail_unless(p->ref == fanout);
+  for (i = 1; i < fanout - 16; i++) {
+    fail_unless(pbuf_free(p) == 0);
+  }
+  fail_unless(p->ref == 17);
+  for (i = 0; i < 16; i++) {
+    v[i] = p;
+  }
+  fail_unless(pbuf_free_batch(v, 16) == 0);
+  fail_unless(p->ref == 1);
+  fail_unless(pbuf_free(p) == 1);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL) == 0);
+
+  /* references shared by the chain and its tail */
+  p = pbuf_alloc(PBUF_RAW, 100, PBUF_POOL);
+  q = pbuf_alloc(PBUF_RAW, 100, PBUF_POOL);
+  fail_unless((p != NULL) && (q != NULL));
+  pbuf_chain(p, q);
+  fail_unless(q->ref == 2);
+  fail_unless(pbuf_free(p) == 1);
+  fail_unless(q->ref == 1);
+  fail_unless(pbuf_free(q) == 1);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL) == 0);
+}
+END_TEST
+
+/* pbuf_alloc_bulk() hands out independent pbufs, including chains */
+START_TEST(test_pbuf_alloc_bulk)
+{
+  struct pbuf *v[40];
+  u16_t n, i;
+  LWIP_UNUSED_ARG(_i);
+
+  n = pbuf_alloc_bulk(PBUF_TRANSPORT, 100, PBUF_POOL, v, 40);
+  fail_unless(n == 40);
+  for (i = 0; i < n; i++) {
+    fail_unless(v[i]->tot_len == 100);
+    fail_unless(v[i]->len == 100);
+    fail_unless(v[i]->ref == 1);
+    fail_unless(v[i]->next == NULL);
+    fail_unless(pbuf_match_type(v[i], PBUF_POOL));
+    fail_unless(pbuf_remove_header(v[i], 0) == 0);
+    fail_unless(pbuf_add_header(v[i], PBUF_TRANSPORT) == 0);
+    fail_unless(pbuf_add_header(v[i], 1) != 0);
+  }
+  fail_unless(pbuf_free_batch(v, n) == 40);
+
+  n = pbuf_alloc_bulk(PBUF_RAW, 2 * PBUF_POOL_BUFSIZE, PBUF_POOL, v, 3);
+  fail_unless(n == 3);
+  for (i = 0; i < n; i++) {
+    fail_unless(v[i]->tot_len == 2 * PBUF_POOL_BUFSIZE);
+  }
+  pbuf_free_batch(v, n);
+
+  n = pbuf_alloc_bulk(PBUF_RAW, 10, PBUF_RAM, v, 2);
+  fail_unless(n == 2);
+  pbuf_free_batch(v, n);
+  fail_unless(lwip_stats.mem.used == 0);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL) == 0);
+}
+END_TEST
+
+#if PBUF_POOL_SIZE_CLASSES
+/* pbuf_alloc() uses the small class for requests that fit into one small pbuf
+ * and the default class (with its usual chain layout) for everything else */
+START_TEST(test_pbuf_pool_classes_best_fit)
+{
+  struct pbuf *small, *dflt, *chain;
+  LWIP_UNUSED_ARG(_i);
+
+  small = pbuf_alloc(PBUF_TRANSPORT, 20, PBUF_POOL);
+  fail_unless(small != NULL);
+  fail_unless(small->next == NULL);
+  fail_unless(pbuf_get_allocsrc(small) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_SMALL);
+  fail_unless(pbuf_match_type(small, PBUF_POOL));
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL_SMALL) == 1);
+
+  dflt = pbuf_alloc(PBUF_RAW, PBUF_POOL_SMALL_BUFSIZE + 1, PBUF_POOL);
+  fail_unless(dflt != NULL);
+  fail_unless(dflt->next == NULL);
+  fail_unless(pbuf_get_allocsrc(dflt) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL) == 1);
+
+  /* bigger than PBUF_POOL_BUFSIZE: chained like without size classes */
+  chain = pbuf_alloc(PBUF_RAW, PBUF_POOL_BUFSIZE + 1, PBUF_POOL);
+  fail_unless(chain != NULL);
+  fail_unless(pbuf_clen(chain) == 2);
+  fail_unless(chain->len == PBUF_POOL_BUFSIZE);
+  fail_unless(pbuf_get_allocsrc(chain) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL);
+  fail_unless(pbuf_get_allocsrc(chain->next) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL) == 3);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL_LARGE) == 0);
+
+  pbuf_free(small);
+  pbuf_free(dflt);
+  pbuf_free(chain);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL_SMALL) == 0);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL) == 0);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL_LARGE) == 0);
+}
+END_TEST
+
+/* An exhausted small class falls back to the default class */
+START_TEST(test_pbuf_pool_classes_fallback)
+{
+  struct pbuf *small[PBUF_POOL_SMALL_SIZE];
+  struct pbuf *p;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < PBUF_POOL_SMALL_SIZE; i++) {
+    small[i] = pbuf_alloc(PBUF_RAW, 10, PBUF_POOL);
+    fail_unless(small[i] != NULL);
+  }
+  p = pbuf_alloc(PBUF_RAW, 10, PBUF_POOL);
+  fail_unless(p != NULL);
+  fail_unless(p->next == NULL);
+  fail_unless(pbuf_get_allocsrc(p) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL);
+#if PBUF_POOL_STATS
+  fail_unless(lwip_stats.pbuf_pool[PBUF_POOL_CLASS_DEFAULT].fallback == 1);
+#endif
+  pbuf_free(p);
+  for (i = 0; i < PBUF_POOL_SMALL_SIZE; i++) {
+    pbuf_free(small[i]);
+  }
+}
+END_TEST
+
+/* With the default class exhausted, a request that fits into one pbuf gets a
+ * single large pbuf or nothing, but is never split into small pbufs */
+START_TEST(test_pbuf_pool_classes_best_exhausted)
+{
+  struct pbuf *dflt = NULL;
+  struct pbuf *large[PBUF_POOL_LARGE_SIZE];
+  struct pbuf *p;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  while ((p = pbuf_alloc_pool(PBUF_RAW, 0, PBUF_POOL_CLASS_DEFAULT)) != NULL) {
+    if (dflt == NULL) {
+      dflt = p;
+    } else {
+      pbuf_cat(dflt, p);
+    }
+  }
+  fail_unless(dflt != NULL);
+
+  /* fits into one default pbuf: served from the large class */
+  p = pbuf_alloc(PBUF_RAW, PBUF_POOL_BUFSIZE, PBUF_POOL);
+  fail_unless(p != NULL);
+  fail_unless(p->next == NULL);
+  fail_unless(p->len == PBUF_POOL_BUFSIZE);
+  fail_unless(pbuf_get_allocsrc(p) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_LARGE);
+#if PBUF_POOL_STATS
+  fail_unless(lwip_stats.pbuf_pool[PBUF_POOL_CLASS_LARGE].fallback == 1);
+#endif
+  pbuf_free(p);
+
+  /* needs a chain of default pbufs: no fallback */
+  fail_unless(pbuf_alloc(PBUF_RAW, PBUF_POOL_BUFSIZE + 1, PBUF_POOL) == NULL);
+
+  for (i = 0; i < PBUF_POOL_LARGE_SIZE; i++) {
+    large[i] = pbuf_alloc_pool(PBUF_RAW, 0, PBUF_POOL_CLASS_LARGE);
+    fail_unless(large[i] != NULL);
+  }
+  /* the small class is still free, but must not be chained up */
+  p = pbuf_alloc(PBUF_RAW, PBUF_POOL_SMALL_BUFSIZE + 1, PBUF_POOL);
+  fail_unless(p == NULL);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL_SMALL) == 0);
+
+  for (i = 0; i < PBUF_POOL_LARGE_SIZE; i++) {
+    pbuf_free(large[i]);
+  }
+  pbuf_free(dflt);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL) == 0);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL_LARGE) == 0);
+  /* run the pbuf_free_ooseq callback queued by PBUF_POOL_IS_EMPTY() */
+  while (tcpip_thread_poll_one());
+}
+END_TEST
+
+/* Drivers can ask for a specific class, regardless of the request size */
+START_TEST(test_pbuf_pool_classes_explicit)
+{
+  struct pbuf *p;
+  LWIP_UNUSED_ARG(_i);
+
+  p = pbuf_alloc_pool(PBUF_RAW, 0, PBUF_POOL_CLASS_DEFAULT);
+  fail_unless(p != NULL);
+  fail_unless(pbuf_get_allocsrc(p) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL);
+  pbuf_free(p);
+
+  p = pbuf_alloc_pool(PBUF_RAW, 64, PBUF_POOL_CLASS_LARGE);
+  fail_unless(p != NULL);
+  fail_unless(pbuf_get_allocsrc(p) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_LARGE);
+  pbuf_free(p);
+
+  /* no fallback to a bigger class: chained small pbufs */
+  p = pbuf_alloc_pool(PBUF_RAW, 3 * PBUF_POOL_SMALL_BUFSIZE, PBUF_POOL_CLASS_SMALL);
+  fail_unless(p != NULL);
+  fail_unless(pbuf_clen(p) == 3);
+  fail_unless(pbuf_get_allocsrc(pbuf_skip(p, 2 * PBUF_POOL_SMALL_BUFSIZE, NULL)) ==
+              PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL_SMALL);
+  pbuf_free(p);
+  fail_unless(MEMP_STATS_GET(used, MEMP_PBUF_POOL_SMALL) == 0);
+
+  fail_unless(pbuf_alloc_pool(PBUF_RAW, 1, PBUF_POOL_CLASS_COUNT) == NULL);
+}
+END_TEST
+
+#if PBUF_POOL_STATS
+/* Per-class stats count pbufs and the bytes requested vs. handed out */
+START_TEST(test_pbuf_pool_classes_stats)
+{
+  struct pbuf *p;
+  struct stats_pbuf_pool *st = &lwip_stats.pbuf_pool[PBUF_POOL_CLASS_SMALL];
+  STAT_COUNTER alloc = st->alloc;
+  u32_t req_bytes = st->req_bytes;
+  u32_t buf_bytes = st->buf_bytes;
+  LWIP_UNUSED_ARG(_i);
+
+  p = pbuf_alloc(PBUF_RAW, 100, PBUF_POOL);
+  fail_unless(p != NULL);
+  fail_unless(st->alloc == alloc + 1);
+  fail_unless(st->req_bytes == req_bytes + 100);
+  fail_unless(st->buf_bytes == buf_bytes + LWIP_MEM_ALIGN_SIZE(PBUF_POOL_SMALL_BUFSIZE));
+  pbuf_free(p);
+}
+END_TEST
+#endif /* PBUF_POOL_STATS */
+#endif /* PBUF_POOL_SIZE_CLASSES */
+
 /** Create the suite including all tests for this module */
 Suite *
 pbuf_suite(void)
@@ -265,7 +549,19 @@ pbuf_suite(void)
     TESTFUNC(test_pbuf_split_64k_on_small_pbufs),
     TESTFUNC(test_pbuf_queueing_bigger_than_64k),
     TESTFUNC(test_pbuf_take_at_edge),
-    TESTFUNC(test_pbuf_get_put_at_edge)
+    TESTFUNC(test_pbuf_get_put_at_edge),
+    TESTFUNC(test_pbuf_free_batch),
+    TESTFUNC(test_pbuf_alloc_bulk),
+    TESTFUNC(test_pbuf_ref_fanout),
+#if PBUF_POOL_SIZE_CLASSES
+    TESTFUNC(test_pbuf_pool_classes_best_fit),
+    TESTFUNC(test_pbuf_pool_classes_fallback),
+    TESTFUNC(test_pbuf_pool_classes_best_exhausted),
+    TESTFUNC(test_pbuf_pool_classes_explicit),
+#if PBUF_POOL_STATS
+    TESTFUNC(test_pbuf_pool_classes_stats),
+#endif /* PBUF_POOL_STATS */
+#endif /* PBUF_POOL_SIZE_CLASSES */
   };
   return create_suite("PBUF", tests, sizeof(tests)/sizeof(testfunc), pbuf_setup, pbuf_teardown);
 }
@@ -6,6 +6,26 @@
 
 /* Setups/teardown functions */
 
+#if LWIP_TIMERS_WHEEL
+static void
+timers_setup(void)
+{
+  int i;
+  /* stop the timers started by lwip_init() */
+  for (i = 0; i < lwip_num_cyclic_timers; i++) {
+    sys_untimeout(lwip_cyclic_timer, LWIP_CONST_CAST(void *, &lwip_cyclic_timers[i]));
+  }
+  fail_unless(sys_timeouts_sleeptime() == SYS_TIMEOUTS_SLEEPTIME_INFINITE);
+}
+
+static void
+timers_teardown(void)
+{
+  fail_unless(sys_timeouts_sleeptime() == SYS_TIMEOUTS_SLEEPTIME_INFINITE);
+  lwip_sys_now = 0;
+  sys_timeouts_init();
+}
+#else /* LWIP_TIMERS_WHEEL */
 static struct sys_timeo* old_list_head;
 
 static void
@@ -23,6 +43,7 @@ timers_teardown(void)
   *list_head = old_list_head;
   lwip_sys_now = 0;
 }
+#endif /* LWIP_TIMERS_WHEEL */
 
 static int fired[3];
 static void
@@ -46,7 +67,9 @@ struct lwip_cyclic_timer test_cyclic = {10, dummy_cyclic_handler};
 static void
 do_test_cyclic_timers(u32_t offset)
 {
+#if !LWIP_TIMERS_WHEEL
   struct sys_timeo** list_head = sys_timeouts_get_next_timeout();
+#endif
 
   /* verify normal timer expiration */
   lwip_sys_now = offset + 0;
@@ -60,8 +83,11 @@ do_test_cyclic_timers(u32_t offset)
   sys_check_timeouts();
   fail_unless(cyclic_fired == 1);
 
+  fail_unless(sys_timeouts_sleeptime() == test_cyclic.interval_ms - HANDLER_EXECUTION_TIME);
+#if !LWIP_TIMERS_WHEEL
   fail_unless((*list_head)->time == (u32_t)(lwip_sys_now + test_cyclic.interval_ms - HANDLER_EXECUTION_TIME));
-  
+#endif
+
   sys_untimeout(lwip_cyclic_timer, &test_cyclic);
 
 
@@ -77,7 +103,12 @@ do_test_cyclic_timers(u32_t offset)
   sys_check_timeouts();
   fail_unless(cyclic_fired == 1);
 
+  fail_unless(sys_timeouts_sleeptime() == test_cyclic.interval_ms);
+#if !LWIP_TIMERS_WHEEL
   fail_unless((*list_head)->time == (u32_t)(lwip_sys_now + test_cyclic.interval_ms));
+#endif
+
+  sys_untimeout(lwip_cyclic_timer, &test_cyclic);
 }
 
 START_TEST(test_cyclic_timers)
@@ -127,8 +158,10 @@ END_TEST
 static void
 do_test_timers(u32_t offset)
 {
+#if !LWIP_TIMERS_WHEEL
   struct sys_timeo** list_head = sys_timeouts_get_next_timeout();
-  
+#endif
+
   lwip_sys_now = offset + 0;
 
   sys_timeout(10, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 0));
@@ -138,11 +171,13 @@ do_test_timers(u32_t offset)
   sys_timeout( 5, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 2));
   fail_unless(sys_timeouts_sleeptime() == 5);
 
+#if !LWIP_TIMERS_WHEEL
   /* linked list correctly sorted? */
   fail_unless((*list_head)->time             == (u32_t)(lwip_sys_now + 5));
   fail_unless((*list_head)->next->time       == (u32_t)(lwip_sys_now + 10));
   fail_unless((*list_head)->next->next->time == (u32_t)(lwip_sys_now + 20));
-  
+#endif
+
   /* check timers expire in correct order */
   memset(&fired, 0, sizeof(fired));
 
@@ -219,6 +254,126 @@ START_TEST(test_long_timer)
 }
 END_TEST
 
+static int fire_order[8];
+static int fire_count;
+static void
+order_handler(void* arg)
+{
+  fail_unless(fire_count < (int)LWIP_ARRAYSIZE(fire_order));
+  fire_order[fire_count++] = LWIP_PTR_NUMERIC_CAST(int, arg);
+}
+
+static void
+do_test_timers_order(u32_t offset)
+{
+  /* spread over several timing wheel revolutions, including equal times */
+  static const u32_t timeouts[] = {700, 3, 259, 3, 1000, 4, 65, 260};
+  static const int expected[] = {1, 3, 5, 6, 2, 7, 0, 4};
+  size_t i;
+
+  memset(&fire_order, 0, sizeof(fire_order));
+  fire_count = 0;
+  lwip_sys_now = offset;
+  for (i = 0; i < LWIP_ARRAYSIZE(timeouts); i++) {
+    sys_timeout(timeouts[i], order_handler, LWIP_PTR_NUMERIC_CAST(void*, i));
+  }
+  fail_unless(sys_timeouts_sleeptime() == 3);
+
+  /* all of them expire in one call, but must still be called in order */
+  lwip_sys_now = offset + 1000;
+  sys_check_timeouts();
+  fail_unless(fire_count == (int)LWIP_ARRAYSIZE(expected));
+  for (i = 0; i < LWIP_ARRAYSIZE(expected); i++) {
+    fail_unless(fire_order[i] == expected[i]);
+  }
+  fail_unless(sys_timeouts_sleeptime() == SYS_TIMEOUTS_SLEEPTIME_INFINITE);
+
+  /* same with time advancing in small steps */
+  fire_count = 0;
+  lwip_sys_now = offset;
+  for (i = 0; i < LWIP_ARRAYSIZE(timeouts); i++) {
+    sys_timeout(timeouts[i], order_handler, LWIP_PTR_NUMERIC_CAST(void*, i));
+  }
+  for (i = 0; i < 1000; i += 7) {
+    lwip_sys_now = (u32_t)(offset + i);
+    sys_check_timeouts();
+  }
+  fail_unless(fire_count == (int)LWIP_ARRAYSIZE(expected) - 1);
+  lwip_sys_now = offset + 1000;
+  sys_check_timeouts();
+  fail_unless(fire_count == (int)LWIP_ARRAYSIZE(expected));
+  for (i = 0; i < LWIP_ARRAYSIZE(expected); i++) {
+    fail_unless(fire_order[i] == expected[i]);
+  }
+}
+
+START_TEST(test_timers_order)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  /* check without u32_t wraparound */
+  do_test_timers_order(0);
+
+  /* check with u32_t wraparound */
+  do_test_timers_order(0xffffff00);
+}
+END_TEST
+
+START_TEST(test_untimeout)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&fired, 0, sizeof(fired));
+  lwip_sys_now = 100;
+
+  /* removing an unknown timeout does nothing */
+  sys_untimeout(dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 0));
+  fail_unless(sys_timeouts_sleeptime() == SYS_TIMEOUTS_SLEEPTIME_INFINITE);
+
+  sys_timeout(30, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 0));
+  sys_timeout(10, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 0));
+  sys_timeout(20, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 1));
+  fail_unless(sys_timeouts_sleeptime() == 10);
+
+  /* the matching timeout due first is removed */
+  sys_untimeout(dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 0));
+  fail_unless(sys_timeouts_sleeptime() == 20);
+  sys_untimeout(dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 1));
+  fail_unless(sys_timeouts_sleeptime() == 30);
+
+  lwip_sys_now += 30;
+  sys_check_timeouts();
+  fail_unless(fired[0] == 1);
+  fail_unless(fired[1] == 0);
+  fail_unless(sys_timeouts_sleeptime() == SYS_TIMEOUTS_SLEEPTIME_INFINITE);
+}
+END_TEST
+
+START_TEST(test_restart_timeouts)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&fired, 0, sizeof(fired));
+  lwip_sys_now = 0;
+
+  sys_timeout(10, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 0));
+  sys_timeout(25, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 1));
+
+  /* after a long time without sys_check_timeouts(), rebase the timeouts */
+  lwip_sys_now = 1000;
+  sys_restart_timeouts();
+  fail_unless(sys_timeouts_sleeptime() == 0);
+
+  sys_check_timeouts();
+  fail_unless(fired[0] == 1);
+  fail_unless(fired[1] == 0);
+  fail_unless(sys_timeouts_sleeptime() == 15);
+
+  sys_untimeout(dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 1));
+  fail_unless(sys_timeouts_sleeptime() == SYS_TIMEOUTS_SLEEPTIME_INFINITE);
+}
+END_TEST
+
 /** Create the suite including all tests for this module */
 Suite *
 timers_suite(void)
@@ -228,6 +383,9 @@ timers_suite(void)
     TESTFUNC(test_cyclic_timers),
     TESTFUNC(test_timers),
     TESTFUNC(test_long_timer),
+    TESTFUNC(test_timers_order),
+    TESTFUNC(test_untimeout),
+    TESTFUNC(test_restart_timeouts),
   };
   return create_suite("TIMERS", tests, LWIP_ARRAYSIZE(tests), timers_setup, timers_teardown);
 }
@@ -6,7 +6,9 @@
 #include "tcp/test_tcp.h"
 #include "tcp/test_tcp_oos.h"
 #include "core/test_def.h"
+#include "core/test_inet_chksum.h"
 #include "core/test_mem.h"
+#include "core/test_memp.h"
 #include "core/test_netif.h"
 #include "core/test_pbuf.h"
 #include "core/test_timers.h"
@@ -15,6 +17,7 @@
 #include "mdns/test_mdns.h"
 #include "mqtt/test_mqtt.h"
 #include "api/test_sockets.h"
+#include "api/test_tcpip.h"
 
 #include "lwip/init.h"
 #if !NO_SYS
@@ -75,7 +78,9 @@ int main(void)
     tcp_suite,
     tcp_oos_suite,
     def_suite,
+    inet_chksum_suite,
     mem_suite,
+    memp_suite,
     netif_suite,
     pbuf_suite,
     timers_suite,
@@ -83,7 +88,8 @@ int main(void)
     dhcp_suite,
     mdns_suite,
     mqtt_suite,
-    sockets_suite
+    sockets_suite,
+    tcpip_suite
   };
   size_t num = sizeof(suites)/sizeof(void*);
   LWIP_ASSERT("No suites defined", num > 0);
@@ -73,6 +73,20 @@
 
 #define MEMP_NUM_SYS_TIMEOUT            (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 8)
 
+/* Sizes and companions of optional features; they only take effect when
+   the feature is switched on via UNITTEST_OPTS (see travis.sh) */
+#define TCP_PCB_TIMERS_WHEEL_SIZE       16 /* small wheels to cover wrapping */
+#define LWIP_TIMERS_WHEEL_SIZE          16
+#ifndef LWIP_TCP_SACK_OUT
+#define LWIP_TCP_SACK_OUT               LWIP_TCP_SACK_IN
+#endif
+#ifndef LWIP_TCP_CC_CUBIC
+#define LWIP_TCP_CC_CUBIC               LWIP_TCP_CC
+#endif
+#ifndef LWIP_TCP_RACK_TLP
+#define LWIP_TCP_RACK_TLP               (LWIP_TCP_RTO_MS && LWIP_TCP_SACK_IN)
+#endif
+
 /* MIB2 stats are required to check IPv4 reassembly results */
 #define MIB2_STATS                      1
 
@@ -44,23 +44,26 @@ tcp_remove_all(void)
 
 /** Create a TCP segment usable for passing to tcp_input */
 static struct pbuf*
-tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
+tcp_create_segment_wnd_opts(ip_addr_t* src_ip, ip_addr_t* dst_ip,
                    u16_t src_port, u16_t dst_port, void* data, size_t data_len,
-                   u32_t seqno, u32_t ackno, u8_t headerflags, u16_t wnd)
+                   u32_t seqno, u32_t ackno, u8_t headerflags, u16_t wnd,
+                   const u8_t* opts, u16_t optlen)
 {
   struct pbuf *p, *q;
   struct ip_hdr* iphdr;
   struct tcp_hdr* tcphdr;
-  u16_t pbuf_len = (u16_t)(sizeof(struct ip_hdr) + sizeof(struct tcp_hdr) + data_len);
+  u16_t hdrlen = (u16_t)(sizeof(struct tcp_hdr) + optlen);
+  u16_t pbuf_len = (u16_t)(sizeof(struct ip_hdr) + hdrlen + data_len);
   LWIP_ASSERT("data_len too big", data_len <= 0xFFFF);
+  LWIP_ASSERT("optlen must be a multiple of 4", (optlen & 3) == 0);
 
   p = pbuf_alloc(PBUF_RAW, pbuf_len, PBUF_POOL);
   EXPECT_RETNULL(p != NULL);
   /* first pbuf must be big enough to hold the headers */
-  EXPECT_RETNULL(p->len >= (sizeof(struct ip_hdr) + sizeof(struct tcp_hdr)));
+  EXPECT_RETNULL(p->len >= (sizeof(struct ip_hdr) + hdrlen));
   if (data_len > 0) {
     /* first pbuf must be big enough to hold at least 1 data byte, too */
-    EXPECT_RETNULL(p->len > (sizeof(struct ip_hdr) + sizeof(struct tcp_hdr)));
+    EXPECT_RETNULL(p->len > (sizeof(struct ip_hdr) + hdrlen));
   }
 
   for(q = p; q != NULL; q = q->next) {
@@ -84,17 +87,20 @@ tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
   tcphdr->dest  = htons(dst_port);
   tcphdr->seqno = htonl(seqno);
   tcphdr->ackno = htonl(ackno);
-  TCPH_HDRLEN_SET(tcphdr, sizeof(struct tcp_hdr)/4);
+  TCPH_HDRLEN_SET(tcphdr, hdrlen/4);
   TCPH_FLAGS_SET(tcphdr, headerflags);
   tcphdr->wnd   = htons(wnd);
+  if (optlen > 0) {
+    memcpy(tcphdr + 1, opts, optlen);
+  }
 
   if (data_len > 0) {
     /* let p point to TCP data */
-    pbuf_header(p, -(s16_t)sizeof(struct tcp_hdr));
+    pbuf_header(p, -(s16_t)hdrlen);
     /* copy data */
     pbuf_take(p, data, (u16_t)data_len);
     /* let p point to TCP header again */
-    pbuf_header(p, sizeof(struct tcp_hdr));
+    pbuf_header(p, hdrlen);
   }
 
   /* calculate checksum */
@@ -107,6 +113,16 @@ tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
   return p;
 }
 
+/** Create a TCP segment usable for passing to tcp_input */
+static struct pbuf*
+tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
+                   u16_t src_port, u16_t dst_port, void* data, size_t data_len,
+                   u32_t seqno, u32_t ackno, u8_t headerflags, u16_t wnd)
+{
+  return tcp_create_segment_wnd_opts(src_ip, dst_ip, src_port, dst_port, data,
+    data_len, seqno, ackno, headerflags, wnd, NULL, 0);
+}
+
 /** Create a TCP segment usable for passing to tcp_input */
 struct pbuf*
 tcp_create_segment(ip_addr_t* src_ip, ip_addr_t* dst_ip,
@@ -141,6 +157,52 @@ struct pbuf* tcp_create_rx_segment_wnd(struct tcp_pcb* pcb, void* data, size_t d
     data, data_len, pcb->rcv_nxt + seqno_offset, pcb->lastack + ackno_offset, headerflags, wnd);
 }
 
+/** Create an ACK segment carrying a SACK option usable for passing to tcp_input
+ * - IP-addresses, ports and seqno are taken from pcb
+ * - ackno can be altered with an offset
+ * - sacks holds num_sacks pairs of left and right edges (absolute seqnos)
+ */
+struct pbuf* tcp_create_rx_segment_sack(struct tcp_pcb* pcb, u32_t ackno_offset,
+                   const u32_t* sacks, u8_t num_sacks)
+{
+  u8_t opts[4 + 4 * 8];
+  u16_t optlen = (u16_t)(4 + num_sacks * 8);
+  u8_t i;
+  LWIP_ASSERT("too many SACKs", num_sacks > 0 && num_sacks <= 4);
+
+  opts[0] = LWIP_TCP_OPT_NOP;
+  opts[1] = LWIP_TCP_OPT_NOP;
+  opts[2] = LWIP_TCP_OPT_SACK;
+  opts[3] = (u8_t)(2 + num_sacks * 8);
+  for (i = 0; i < 2 * num_sacks; i++) {
+    u32_t edge = htonl(sacks[i]);
+    memcpy(&opts[4 + i * 4], &edge, 4);
+  }
+  return tcp_create_segment_wnd_opts(&pcb->remote_ip, &pcb->local_ip, pcb->remote_port, pcb->local_port,
+    NULL, 0, pcb->rcv_nxt, pcb->lastack + ackno_offset, TCP_ACK, TCP_WND, opts, optlen);
+}
+
+/** Create an ACK segment carrying a timestamp option usable for passing to tcp_input
+ * - IP-addresses, ports and seqno are taken from pcb
+ * - ackno can be altered with an offset
+ */
+struct pbuf* tcp_create_rx_segment_ts(struct tcp_pcb* pcb, u32_t ackno_offset,
+                   u32_t tsval, u32_t tsecr)
+{
+  u8_t opts[12];
+
+  opts[0] = LWIP_TCP_OPT_NOP;
+  opts[1] = LWIP_TCP_OPT_NOP;
+  opts[2] = LWIP_TCP_OPT_TS;
+  opts[3] = 10;
+  tsval = htonl(tsval);
+  memcpy(&opts[4], &tsval, 4);
+  tsecr = htonl(tsecr);
+  memcpy(&opts[8], &tsecr, 4);
+  return tcp_create_segment_wnd_opts(&pcb->remote_ip, &pcb->local_ip, pcb->remote_port, pcb->local_port,
+    NULL, 0, pcb->rcv_nxt, pcb->lastack + ackno_offset, TCP_ACK, TCP_WND, opts, sizeof(opts));
+}
+
 /** Safely bring a tcp_pcb into the requested state */
 void
 tcp_set_state(struct tcp_pcb* pcb, enum tcp_state state, const ip_addr_t* local_ip,
@@ -158,22 +220,23 @@ tcp_set_state(struct tcp_pcb* pcb, enum tcp_state state, const ip_addr_t* local_
   pcb->lastack = iss;
   pcb->snd_lbb = iss;
   
+  /* set the addresses before registering: TCP_REG may hash them */
   if (state == ESTABLISHED) {
-    TCP_REG(&tcp_active_pcbs, pcb);
     ip_addr_copy(pcb->local_ip, *local_ip);
     pcb->local_port = local_port;
     ip_addr_copy(pcb->remote_ip, *remote_ip);
     pcb->remote_port = remote_port;
+    TCP_REG(&tcp_active_pcbs, pcb);
   } else if(state == LISTEN) {
-    TCP_REG(&tcp_listen_pcbs.pcbs, pcb);
     ip_addr_copy(pcb->local_ip, *local_ip);
     pcb->local_port = local_port;
+    TCP_REG(&tcp_listen_pcbs.pcbs, pcb);
   } else if(state == TIME_WAIT) {
-    TCP_REG(&tcp_tw_pcbs, pcb);
     ip_addr_copy(pcb->local_ip, *local_ip);
     pcb->local_port = local_port;
     ip_addr_copy(pcb->remote_ip, *remote_ip);
     pcb->remote_port = remote_port;
+    TCP_REG(&tcp_tw_pcbs, pcb);
   } else {
     fail();
   }
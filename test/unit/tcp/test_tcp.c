@@ -4,6 +4,8 @@
 #include "lwip/stats.h"
 #include "tcp_helper.h"
 #include "lwip/inet_chksum.h"
+#include "arch/sys_arch.h"
+#include "lwip/timeouts.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable: 4307) /* we explicitly wrap around TCP seqnos */
@@ -29,14 +31,43 @@ static u32_t seqnos[] = {
 
 static u8_t test_tcp_timer;
 
+#if LWIP_TCP_RTO_MS
+/* stop the timers started by lwip_init(): only run tcp timers in sys_check_timeouts() */
+static void
+test_tcp_stop_cyclic_timers(void)
+{
+  int i;
+  for (i = 0; i < lwip_num_cyclic_timers; i++) {
+    sys_untimeout(lwip_cyclic_timer, LWIP_CONST_CAST(void *, &lwip_cyclic_timers[i]));
+  }
+}
+
+/* test_tcp_tmr() calls until the initial RTO of 3 seconds expires */
+#define TEST_TCP_RTO_TMR_CALLS (3000 / TCP_TMR_INTERVAL)
+/* slow timer ticks until an RTO of 'rto' expires */
+#define TEST_TCP_RTO_SLOW_TICKS(rto) ((rto) / TCP_SLOW_INTERVAL)
+#else /* LWIP_TCP_RTO_MS */
+/* the first call runs tcp_slowtmr(), so the 6 ticks of the initial RTO
+   expire after 11 calls */
+#define TEST_TCP_RTO_TMR_CALLS 11
+#define TEST_TCP_RTO_SLOW_TICKS(rto) (rto)
+#endif /* LWIP_TCP_RTO_MS */
+
 /* our own version of tcp_tmr so we can reset fast/slow timer state */
 static void
 test_tcp_tmr(void)
 {
+#if LWIP_TCP_RTO_MS
+  /* retransmission timeouts are run by tcp_rto_timer(): advance the fake
+     clock and let sys_check_timeouts() run it and tcp_tmr() */
+  lwip_sys_now += TCP_TMR_INTERVAL;
+  sys_check_timeouts();
+#else /* LWIP_TCP_RTO_MS */
   tcp_fasttmr();
   if (++test_tcp_timer & 1) {
     tcp_slowtmr();
   }
+#endif /* LWIP_TCP_RTO_MS */
 }
 
 /* Setups/teardown functions */
@@ -52,6 +83,14 @@ tcp_setup(void)
   old_netif_default = netif_default;
   netif_list = NULL;
   netif_default = NULL;
+#if LWIP_TCP_RTO_MS
+  /* like test_tcp_tmr(), make the next tcp_tmr() call tcp_slowtmr() */
+  tcp_ticks = 0;
+  tcp_tmr();
+  if (tcp_ticks != 0) {
+    tcp_tmr();
+  }
+#endif /* LWIP_TCP_RTO_MS */
   /* reset iss to default (6510) */
   tcp_ticks = 0;
   tcp_ticks = 0 - (tcp_next_iss(&dummy_pcb) - 6510);
@@ -60,6 +99,10 @@ tcp_setup(void)
 
   test_tcp_timer = 0;
   tcp_remove_all();
+#if LWIP_TCP_RTO_MS
+  test_tcp_stop_cyclic_timers();
+  lwip_sys_now = 0;
+#endif /* LWIP_TCP_RTO_MS */
   lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
 }
 
@@ -69,6 +112,13 @@ tcp_teardown(void)
   netif_list = NULL;
   netif_default = NULL;
   tcp_remove_all();
+#if LWIP_TCP_RTO_MS
+  /* let a pending tcp_rto_timer() run out, then restart the cyclic timers */
+  lwip_sys_now += 2 * TCP_RTO_MAX;
+  sys_check_timeouts();
+  lwip_sys_now = 0;
+  sys_timeouts_init();
+#endif /* LWIP_TCP_RTO_MS */
   /* restore netif_list for next tests (e.g. loopif) */
   netif_list = old_netif_list;
   netif_default = old_netif_default;
@@ -200,6 +250,78 @@ START_TEST(test_tcp_recv_inseq)
 }
 END_TEST
 
+#define TEST_TCP_DEMUX_PCBS 4
+
+/** Create several ESTABLISHED pcbs differing only in the remote port and check
+ * that every segment is demultiplexed to the right one, also after one of them
+ * has been removed */
+START_TEST(test_tcp_recv_demux)
+{
+  struct test_tcp_counters counters[TEST_TCP_DEMUX_PCBS];
+  struct tcp_pcb *pcbs[TEST_TCP_DEMUX_PCBS];
+  struct tcp_pcb removed;
+  struct pbuf *p;
+  char data[] = {1, 2, 3, 4, 5, 6, 7, 8};
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  int i, j;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(counters, 0, sizeof(counters));
+
+  for (i = 0; i < TEST_TCP_DEMUX_PCBS; i++) {
+    counters[i].expected_data_len = sizeof(data);
+    counters[i].expected_data = data;
+    pcbs[i] = test_tcp_new_counters_pcb(&counters[i]);
+    EXPECT_RET(pcbs[i] != NULL);
+    tcp_set_state(pcbs[i], ESTABLISHED, &test_local_ip, &test_remote_ip,
+                  TEST_LOCAL_PORT, (u16_t)(TEST_REMOTE_PORT + i));
+  }
+
+  /* feed the pcbs in reverse order of creation */
+  for (i = TEST_TCP_DEMUX_PCBS - 1; i >= 0; i--) {
+    p = tcp_create_rx_segment(pcbs[i], data, 4, 0, 0, 0);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, &netif);
+    for (j = 0; j < TEST_TCP_DEMUX_PCBS; j++) {
+      EXPECT(counters[j].recv_calls == ((j >= i) ? 1U : 0U));
+      EXPECT(counters[j].err_calls == 0);
+    }
+  }
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  /* remove one pcb: a segment for it must not reach any other pcb but be
+     answered with a RST */
+  memcpy(&removed, pcbs[1], sizeof(removed));
+  tcp_abort(pcbs[1]);
+  EXPECT(counters[1].err_calls == 1);
+  txcounters.num_tx_calls = 0;
+  p = tcp_create_rx_segment(&removed, data, 4, 0, 0, 0);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(txcounters.num_tx_calls == 1);
+  for (j = 0; j < TEST_TCP_DEMUX_PCBS; j++) {
+    EXPECT(counters[j].recv_calls == 1);
+  }
+
+  /* the others are still found */
+  p = tcp_create_rx_segment(pcbs[2], &data[4], 4, 0, 0, 0);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(counters[2].recv_calls == 2);
+  EXPECT(counters[0].recv_calls == 1);
+  EXPECT(counters[3].recv_calls == 1);
+
+  for (i = 0; i < TEST_TCP_DEMUX_PCBS; i++) {
+    if (i != 1) {
+      tcp_abort(pcbs[i]);
+    }
+  }
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
 /** Create an ESTABLISHED pcb and check if receive callback is called if a segment
  * overlapping rcv_nxt is received */
 START_TEST(test_tcp_recv_inseq_trim)
@@ -760,11 +882,11 @@ START_TEST(test_tcp_rto_rexmit_wraparound)
   check_seqnos(pcb->unsent, 4, &seqnos[2]);
 
   /* call the tcp timer some times */
-  for (i = 0; i < 10; i++) {
+  for (i = 0; i < TEST_TCP_RTO_TMR_CALLS - 1; i++) {
     test_tcp_tmr();
     EXPECT(txcounters.num_tx_calls == 0);
   }
-  /* 11th call to tcp_tmr: RTO rexmit fires */
+  /* next call to tcp_tmr: RTO rexmit fires */
   test_tcp_tmr();
   EXPECT(txcounters.num_tx_calls == 1);
   check_seqnos(pcb->unacked, 1, seqnos);
@@ -1664,6 +1786,906 @@ START_TEST(test_tcp_persist_split)
 }
 END_TEST
 
+/* idle pcbs are parked unless the wheel is too small to park them at all */
+#define TEST_TCP_TIMERS_PARK (LWIP_TCP_PCB_TIMERS && (TCP_PCB_TIMERS_WHEEL_SIZE >= 4))
+
+static u32_t test_tcp_poll_calls;
+
+static err_t
+test_tcp_count_poll(void *arg, struct tcp_pcb *pcb)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(pcb);
+  test_tcp_poll_calls++;
+  return ERR_OK;
+}
+
+/* run the tcp timers for one slow timer tick */
+static void
+test_tcp_slow_tick(void)
+{
+  test_tcp_tmr();
+  test_tcp_tmr();
+}
+
+/** Check that an idle connection is only visited when its poll and keepalive
+ * timers are due and that both fire at the same ticks as with full sweeps */
+START_TEST(test_tcp_idle_timers)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  u32_t tick;
+  const u32_t first_probe = 5000 / TCP_SLOW_INTERVAL + 1;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+  test_tcp_poll_calls = 0;
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  tcp_poll(pcb, test_tcp_count_poll, 4);
+  ip_set_option(pcb, SOF_KEEPALIVE);
+  pcb->keep_idle = 5000;
+  pcb->tmr = tcp_ticks;
+
+  for (tick = 1; tick <= first_probe; tick++) {
+    test_tcp_slow_tick();
+    /* poll every 4th tick */
+    EXPECT(test_tcp_poll_calls == tick / 4);
+    if (tick < first_probe) {
+      EXPECT(txcounters.num_tx_calls == 0);
+#if TEST_TCP_TIMERS_PARK
+      /* nothing to do until the next poll or keepalive: parked */
+      EXPECT(pcb->tmr_wheel);
+#endif /* TEST_TCP_TIMERS_PARK */
+    }
+  }
+  /* first keepalive probe after keep_idle */
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(pcb->keep_cnt_sent == 1);
+
+  /* the next probe is sent TCP_KEEP_INTVL later */
+  txcounters.num_tx_calls = 0;
+  tcp_poll(pcb, NULL, 0);
+#if LWIP_TCP_KEEPALIVE
+  pcb->keep_intvl = TCP_KEEPINTVL_DEFAULT;
+#endif /* LWIP_TCP_KEEPALIVE */
+  for (; tick < first_probe + TCP_KEEPINTVL_DEFAULT / TCP_SLOW_INTERVAL; tick++) {
+    test_tcp_slow_tick();
+  }
+  EXPECT(txcounters.num_tx_calls == 0);
+  test_tcp_slow_tick();
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(pcb->keep_cnt_sent == 2);
+  EXPECT(counters.err_calls == 0);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Check that sending on a parked connection starts its retransmission timer */
+START_TEST(test_tcp_idle_send_rexmit)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  err_t err;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = TCP_WND;
+
+  /* let it idle for a few ticks */
+  for (i = 0; i < 3; i++) {
+    test_tcp_slow_tick();
+  }
+#if TEST_TCP_TIMERS_PARK
+  EXPECT(pcb->tmr_wheel);
+#endif /* TEST_TCP_TIMERS_PARK */
+
+  err = tcp_write(pcb, tx_data, TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(pcb->rtime == 0);
+#if LWIP_TCP_PCB_TIMERS
+  EXPECT(!pcb->tmr_wheel);
+#endif /* LWIP_TCP_PCB_TIMERS */
+
+  /* the segment is retransmitted after rto ticks */
+  for (i = 0; i < TEST_TCP_RTO_SLOW_TICKS(pcb->rto) - 1; i++) {
+    test_tcp_slow_tick();
+  }
+  EXPECT(txcounters.num_tx_calls == 1);
+  test_tcp_slow_tick();
+  EXPECT(txcounters.num_tx_calls == 2);
+  EXPECT(pcb->nrtx == 1);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Check that TIME-WAIT pcbs are freed after 2*MSL, and not before */
+START_TEST(test_tcp_time_wait_expiry)
+{
+  struct tcp_pcb *pcb;
+  u32_t tick;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = tcp_new();
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, TIME_WAIT, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->tmr = tcp_ticks;
+
+  for (tick = 1; tick <= 2 * TCP_MSL / TCP_SLOW_INTERVAL; tick++) {
+    test_tcp_slow_tick();
+  }
+  EXPECT(tcp_tw_pcbs == pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  test_tcp_slow_tick();
+  EXPECT(tcp_tw_pcbs == NULL);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+#if LWIP_TCP_SACK_IN
+static struct tcp_seg *
+test_tcp_find_seg(struct tcp_seg *segs, u32_t seqno)
+{
+  for (; segs != NULL; segs = segs->next) {
+    if (segs->tcphdr->seqno == htonl(seqno)) {
+      return segs;
+    }
+  }
+  return NULL;
+}
+
+/* connect a pcb and send 'num' full segments, edges[i] is the seqno of segment i */
+static struct tcp_pcb *
+test_tcp_sack_setup(struct netif *netif, struct test_tcp_txcounters *txcounters,
+                    struct test_tcp_counters *counters, u32_t *edges, int num, u8_t sack)
+{
+  struct tcp_pcb *pcb;
+  err_t err;
+  int i;
+
+  for (i = 0; i < (int)sizeof(tx_data); i++) {
+    tx_data[i] = (u8_t)i;
+  }
+  test_tcp_init_netif(netif, txcounters, &test_local_ip, &test_netmask);
+  memset(counters, 0, sizeof(struct test_tcp_counters));
+
+  pcb = test_tcp_new_counters_pcb(counters);
+  EXPECT_RETNULL(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  /* disable initial congestion window (we don't send a SYN here...) */
+  pcb->cwnd = pcb->snd_wnd;
+  if (sack) {
+    /* as if SACK_PERM was exchanged in the SYNs */
+    tcp_set_flags(pcb, TF_SACK);
+  }
+
+  for (i = 0; i <= num; i++) {
+    edges[i] = pcb->snd_nxt + (u32_t)i * TCP_MSS;
+  }
+  err = tcp_write(pcb, tx_data, (u16_t)(num * TCP_MSS), TCP_WRITE_FLAG_COPY);
+  EXPECT_RETNULL(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RETNULL(err == ERR_OK);
+  EXPECT_RETNULL(txcounters->num_tx_calls == (u32_t)num);
+  memset(txcounters, 0, sizeof(struct test_tcp_txcounters));
+  return pcb;
+}
+
+/** Lose 2 of 10 segments and check that only these are retransmitted based on
+ * the SACKs from the receiver (RFC 6675) */
+START_TEST(test_tcp_sack_recovery)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  struct pbuf* p;
+  struct tcp_seg* seg;
+  u32_t s[11];
+  u32_t sacks[6];
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_sack_setup(&netif, &txcounters, &counters, s, 10, 1);
+  EXPECT_RET(pcb != NULL);
+
+  /* ACK segment 0, segments 1 and 4 are lost */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(pcb->lastack == s[1]);
+
+  /* 1st dupack SACKs segment 2 */
+  sacks[0] = s[2]; sacks[1] = s[3];
+  p = tcp_create_rx_segment_sack(pcb, 0, sacks, 1);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->dupacks == 1);
+  seg = test_tcp_find_seg(pcb->unacked, s[2]);
+  EXPECT_RET(seg != NULL);
+  EXPECT(seg->flags & TF_SEG_SACKED);
+  EXPECT(!(pcb->unacked->flags & TF_SEG_SACKED));
+
+  /* 2nd dupack SACKs segments 2-3 */
+  sacks[1] = s[4];
+  p = tcp_create_rx_segment_sack(pcb, 0, sacks, 1);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(txcounters.num_tx_calls == 0);
+  EXPECT(!(pcb->flags & TF_INFR));
+
+  /* 3rd dupack SACKs segment 5, too: segment 1 is lost, segment 4 is not yet */
+  sacks[0] = s[5]; sacks[1] = s[6];
+  sacks[2] = s[2]; sacks[3] = s[4];
+  p = tcp_create_rx_segment_sack(pcb, 0, sacks, 2);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->flags & TF_INFR);
+  EXPECT(pcb->cwnd == 5 * TCP_MSS);
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(txcounters.num_tx_bytes == TCP_MSS + 40U);
+  EXPECT(pcb->unsent == NULL);
+  EXPECT_RET(pcb->unacked != NULL);
+  EXPECT(pcb->unacked->tcphdr->seqno == htonl(s[1]));
+  EXPECT(pcb->unacked->flags & TF_SEG_SACK_REXMIT);
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* 4th dupack SACKs segments 5-7 (and has a D-SACK for segment 0 in front),
+     now segment 4 counts as lost */
+  sacks[0] = s[0]; sacks[1] = s[1];
+  sacks[2] = s[5]; sacks[3] = s[8];
+  sacks[4] = s[2]; sacks[5] = s[4];
+  p = tcp_create_rx_segment_sack(pcb, 0, sacks, 3);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(txcounters.num_tx_bytes == TCP_MSS + 40U);
+  seg = test_tcp_find_seg(pcb->unacked, s[4]);
+  EXPECT_RET(seg != NULL);
+  EXPECT(seg->flags & TF_SEG_SACK_REXMIT);
+  EXPECT(!(seg->flags & TF_SEG_SACKED));
+  /* SACKed segments were never retransmitted */
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    EXPECT(!((seg->flags & TF_SEG_SACKED) && (seg->flags & TF_SEG_SACK_REXMIT)));
+  }
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* partial ACK up to segment 4: stay in recovery, nothing more to send */
+  p = tcp_create_rx_segment_sack(pcb, 3 * TCP_MSS, &sacks[2], 1);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->lastack == s[4]);
+  EXPECT(pcb->flags & TF_INFR);
+  EXPECT(pcb->cwnd == 5 * TCP_MSS);
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  /* ACK everything: recovery is done */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 6 * TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->lastack == s[10]);
+  EXPECT(!(pcb->flags & TF_INFR));
+  /* deflated to ssthresh, then grown by congestion avoidance */
+  EXPECT(pcb->cwnd == pcb->ssthresh + TCP_MSS);
+  EXPECT(pcb->unacked == NULL);
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  /* make sure the pcb is freed */
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Check that SACKs are ignored if SACK_PERM was not exchanged */
+START_TEST(test_tcp_sack_not_permitted)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  struct pbuf* p;
+  struct tcp_seg* seg;
+  u32_t s[6];
+  u32_t sacks[2];
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_sack_setup(&netif, &txcounters, &counters, s, 5, 0);
+  EXPECT_RET(pcb != NULL);
+
+  /* three dupacks SACKing segments 1-4: Reno fast retransmit of segment 0 */
+  sacks[0] = s[1]; sacks[1] = s[5];
+  for (i = 0; i < 3; i++) {
+    p = tcp_create_rx_segment_sack(pcb, 0, sacks, 1);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, &netif);
+  }
+  EXPECT(pcb->flags & TF_INFR);
+  EXPECT(pcb->cwnd == pcb->ssthresh + 3 * TCP_MSS);
+  EXPECT(txcounters.num_tx_calls == 1);
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    EXPECT(!(seg->flags & (TF_SEG_SACKED | TF_SEG_SACK_REXMIT)));
+  }
+
+  /* make sure the pcb is freed */
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Check that an RTO during SACK recovery forgets the SACKs and resends all */
+START_TEST(test_tcp_sack_rto)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  struct pbuf* p;
+  struct tcp_seg* seg;
+  u32_t s[6];
+  u32_t sacks[2];
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_sack_setup(&netif, &txcounters, &counters, s, 5, 1);
+  EXPECT_RET(pcb != NULL);
+
+  /* a single dupack SACKing 3 segments starts recovery */
+  sacks[0] = s[2]; sacks[1] = s[5];
+  p = tcp_create_rx_segment_sack(pcb, 0, sacks, 1);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->dupacks == 1);
+  EXPECT(pcb->flags & TF_INFR);
+  /* segments 0 and 1 both have 3 SACKed segments above them */
+  EXPECT(txcounters.num_tx_calls == 2);
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* RTO: all 5 segments are sent again */
+  pcb->cwnd = 5 * TCP_MSS;
+  tcp_rexmit_rto(pcb);
+  EXPECT(!(pcb->flags & TF_INFR));
+  EXPECT(txcounters.num_tx_calls == 5);
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    EXPECT(!(seg->flags & (TF_SEG_SACKED | TF_SEG_SACK_REXMIT)));
+  }
+
+  /* make sure the pcb is freed */
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+#endif /* LWIP_TCP_SACK_IN */
+
+#if LWIP_TCP_CC
+/** Check selecting congestion control modules */
+START_TEST(test_tcp_cc_select)
+{
+  struct tcp_pcb* pcb;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(tcp_cc_find("reno") == &tcp_cc_reno);
+#if LWIP_TCP_CC_CUBIC
+  fail_unless(tcp_cc_find("cubic") == &tcp_cc_cubic);
+#endif /* LWIP_TCP_CC_CUBIC */
+  fail_unless(tcp_cc_find("") == NULL);
+  fail_unless(tcp_cc_find("renoo") == NULL);
+
+  pcb = tcp_new();
+  fail_unless(pcb != NULL);
+  /* new pcbs use the default module */
+  fail_unless(tcp_get_cc(pcb) == &tcp_cc_reno);
+#if LWIP_TCP_CC_CUBIC
+  tcp_set_cc(pcb, &tcp_cc_cubic);
+  fail_unless(tcp_get_cc(pcb) == &tcp_cc_cubic);
+#endif /* LWIP_TCP_CC_CUBIC */
+  tcp_abort(pcb);
+}
+END_TEST
+
+#if LWIP_TCP_CC_CUBIC
+/** Check that connections accepted on a listening pcb use its congestion
+ * control module, set before or after tcp_listen() */
+START_TEST(test_tcp_cc_listen)
+{
+  struct tcp_pcb *pcb, *pcbl, *npcb;
+  struct tcp_pcb_listen *lpcb;
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct pbuf *p;
+  ip_addr_t src_addr;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+
+  pcb = tcp_new();
+  EXPECT_RET(pcb != NULL);
+  err = tcp_bind(pcb, &netif.ip_addr, 1234);
+  EXPECT(err == ERR_OK);
+  tcp_set_cc(pcb, &tcp_cc_cubic);
+  pcbl = tcp_listen(pcb);
+  EXPECT_RET(pcbl != NULL);
+  lpcb = (struct tcp_pcb_listen *)pcbl;
+  /* kept by tcp_listen() */
+  EXPECT(tcp_get_cc(pcbl) == &tcp_cc_cubic);
+
+  ip_addr_set_ip4_u32_val(src_addr, lwip_htonl(lwip_ntohl(ip_addr_get_ip4_u32(&lpcb->local_ip)) + 1));
+  p = tcp_create_segment(&src_addr, &lpcb->local_ip, 12345,
+    lpcb->local_port, NULL, 0, 12345, 54321, TCP_SYN);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  npcb = tcp_active_pcbs;
+  EXPECT_RET(npcb != NULL);
+  EXPECT(npcb->state == SYN_RCVD);
+  EXPECT(tcp_get_cc(npcb) == &tcp_cc_cubic);
+  tcp_abort(npcb);
+
+  /* changed on the listening pcb */
+  tcp_set_cc(pcbl, &tcp_cc_reno);
+  EXPECT(tcp_get_cc(pcbl) == &tcp_cc_reno);
+  tcp_set_cc(pcbl, &tcp_cc_cubic);
+  p = tcp_create_segment(&src_addr, &lpcb->local_ip, 12346,
+    lpcb->local_port, NULL, 0, 12345, 54321, TCP_SYN);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  npcb = tcp_active_pcbs;
+  EXPECT_RET(npcb != NULL);
+  EXPECT(tcp_get_cc(npcb) == &tcp_cc_cubic);
+  tcp_abort(npcb);
+
+  tcp_close(pcbl);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB_LISTEN) == 0);
+}
+END_TEST
+
+/** Check the CUBIC window function: reduction by beta on loss, concave growth
+ * back to W_max, plateau around W_max, convex growth beyond it */
+START_TEST(test_tcp_cc_cubic)
+{
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  tcpwnd_size_t last_cwnd;
+  u32_t start;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&counters, 0, sizeof(counters));
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  tcp_set_cc(pcb, &tcp_cc_cubic);
+
+  /* loss at 40 segments: ssthresh is reduced by 30% instead of 50% */
+  pcb->cwnd = 40 * TCP_MSS;
+  pcb->snd_wnd = 100 * TCP_MSS;
+  pcb->cc_ops->on_dupack(pcb);
+  EXPECT(pcb->ssthresh == 28 * TCP_MSS);
+  pcb->cc_ops->on_recovery_exit(pcb);
+  EXPECT(pcb->cwnd == 28 * TCP_MSS);
+
+  /* K = cbrt(12 / 0.4) = 3.1 s, one window is acked every 500 ms,
+     the epoch starts with the first ACK */
+  start = lwip_sys_now = 10000;
+  last_cwnd = pcb->cwnd;
+  for (i = 0; i <= 16; i++) {
+    lwip_sys_now = start + (u32_t)i * 500;
+    pcb->cc_ops->on_ack(pcb, pcb->cwnd);
+    EXPECT(pcb->cwnd >= last_cwnd);
+    last_cwnd = pcb->cwnd;
+    if (i == 2) {
+      /* concave region: most of the reduction is recovered after 1 s */
+      EXPECT(pcb->cwnd > 35 * TCP_MSS);
+      EXPECT(pcb->cwnd < 40 * TCP_MSS);
+    } else if ((i >= 5) && (i <= 8)) {
+      /* plateau around W_max */
+      EXPECT(pcb->cwnd > 39 * TCP_MSS);
+      EXPECT(pcb->cwnd < 41 * TCP_MSS);
+    }
+  }
+  /* convex region: probing beyond W_max (target at 8 s: 40 + 0.4 * 4.9^3 segments) */
+  EXPECT(pcb->cwnd > 70 * TCP_MSS);
+
+  /* RTO: ssthresh reduced by beta, restart from one segment */
+  pcb->snd_wnd = 1000 * TCP_MSS;
+  pcb->cwnd = 100 * TCP_MSS;
+  pcb->cc_ops->on_rto(pcb);
+  EXPECT(pcb->cwnd == TCP_MSS);
+  EXPECT(pcb->ssthresh == 70 * TCP_MSS);
+  /* slow start as in reno */
+  pcb->cc_ops->on_ack(pcb, TCP_MSS);
+  EXPECT(pcb->cwnd == 2 * TCP_MSS);
+
+  tcp_abort(pcb);
+  lwip_sys_now = 0;
+}
+END_TEST
+#endif /* LWIP_TCP_CC_CUBIC */
+#endif /* LWIP_TCP_CC */
+
+#if LWIP_TCP_RTO_MS
+/** Check that the RTO follows a short RTT and expires at its millisecond deadline */
+START_TEST(test_tcp_rto_ms)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  lwip_sys_now = 1000;
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = 2 * TCP_MSS;
+  EXPECT(pcb->rto == 3000);
+
+  /* the first segment is ACKed after 20 ms */
+  err = tcp_write(pcb, tx_data, TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(pcb->rttest == 1000);
+  lwip_sys_now = 1020;
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->rtime == -1);
+  /* SRTT = 20, RTTVAR = 10: 60 ms are bounded to TCP_RTO_MIN */
+  EXPECT(pcb->sa == (20 << 3));
+  EXPECT(pcb->sv == 40);
+  EXPECT(pcb->rto == TCP_RTO_MIN);
+
+  /* the second segment is lost: retransmitted exactly after TCP_RTO_MIN */
+  err = tcp_write(pcb, tx_data, TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(txcounters.num_tx_calls == 2);
+  lwip_sys_now += TCP_RTO_MIN - 1;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 2);
+  lwip_sys_now++;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 3);
+  EXPECT(pcb->nrtx == 1);
+  EXPECT(pcb->rto == 2 * TCP_RTO_MIN);
+
+  /* backed off */
+  lwip_sys_now += 2 * TCP_RTO_MIN - 1;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 3);
+  lwip_sys_now++;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 4);
+  EXPECT(pcb->nrtx == 2);
+
+  /* the ACK of a retransmission gives no RTT sample (Karn) */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->rtime == -1);
+  EXPECT(pcb->nrtx == 0);
+  EXPECT(pcb->sa == (20 << 3));
+  EXPECT(pcb->rto == TCP_RTO_MIN);
+
+  /* nothing left to retransmit */
+  lwip_sys_now += 10 * TCP_RTO_MIN;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 4);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+#if LWIP_TCP_TIMESTAMPS
+/** Check that ACKs echoing a timestamp give one RTT sample per flight */
+START_TEST(test_tcp_rto_ms_timestamps)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  lwip_sys_now = 1000;
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  tcp_set_flags(pcb, TF_TIMESTAMP);
+  tcp_nagle_disable(pcb);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = 2 * TCP_MSS;
+
+  /* two segments (less than the MSS minus the option), sent at 1000 and 1300 */
+  err = tcp_write(pcb, tx_data, 500, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  lwip_sys_now = 1300;
+  err = tcp_write(pcb, tx_data, 500, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(txcounters.num_tx_calls == 2);
+
+  /* first sample: 300 ms */
+  p = tcp_create_rx_segment_ts(pcb, 500, 1, 1000);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->sa == (300 << 3));
+  EXPECT(pcb->sv == 600);
+  EXPECT(pcb->rto == 900);
+
+  /* the ACK of the second segment is from the same flight: no sample */
+  lwip_sys_now = 1350;
+  p = tcp_create_rx_segment_ts(pcb, 500, 2, 1300);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->sa == (300 << 3));
+  EXPECT(pcb->rtime == -1);
+
+  /* the next flight is sampled again: 50 ms */
+  err = tcp_write(pcb, tx_data, 500, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  lwip_sys_now = 1400;
+  p = tcp_create_rx_segment_ts(pcb, 500, 3, 1350);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->sa == (300 << 3) + 50 - 300);
+  EXPECT(pcb->rtime == -1);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+  lwip_sys_now = 0;
+}
+END_TEST
+#endif /* LWIP_TCP_TIMESTAMPS */
+
+#if LWIP_TCP_RACK_TLP
+/** Check that a lost tail segment is probed after 2 * SRTT instead of an RTO */
+START_TEST(test_tcp_rack_tlp)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  u32_t s[5];
+  LWIP_UNUSED_ARG(_i);
+
+  lwip_sys_now = 1000;
+  pcb = test_tcp_sack_setup(&netif, &txcounters, &counters, s, 4, 1);
+  EXPECT_RET(pcb != NULL);
+
+  /* segment 0 is ACKed after 20 ms: the probe is due 2 * SRTT later */
+  lwip_sys_now = 1020;
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->sa == (20 << 3));
+  EXPECT(pcb->rack_flags & TCP_RACK_PTO_TIMER);
+  lwip_sys_now = 1059;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  /* nothing new to send: the last segment is the probe */
+  lwip_sys_now = 1060;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(txcounters.num_tx_bytes == TCP_MSS + 40U);
+  EXPECT(pcb->rack_flags & TCP_TLP_INFLIGHT);
+  EXPECT(pcb->tlp_end_seq == s[4]);
+  EXPECT(pcb->nrtx == 0);
+  EXPECT(!(pcb->flags & TF_INFR));
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* only one probe per episode, the RTO is counted from the probe */
+  lwip_sys_now = 1060 + TCP_RTO_MIN - 1;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  /* everything is ACKed */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 3 * TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->unacked == NULL);
+  EXPECT(!(pcb->rack_flags & TCP_RACK_TIMERS));
+  lwip_sys_now += 10 * TCP_RTO_MIN;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Check that RACK marks a hole lost once rtt + reo_wnd passed after a later
+ * segment was SACKed, without waiting for 3 dupacks */
+START_TEST(test_tcp_rack_reo_timer)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  u32_t s[5];
+  u32_t sacks[2];
+  LWIP_UNUSED_ARG(_i);
+
+  lwip_sys_now = 1000;
+  pcb = test_tcp_sack_setup(&netif, &txcounters, &counters, s, 4, 1);
+  EXPECT_RET(pcb != NULL);
+
+  /* segment 0 is ACKed after 20 ms: min_rtt = 20, reo_wnd = 5 */
+  lwip_sys_now = 1020;
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->rack_min_rtt == 20);
+
+  /* segment 2 is SACKed after 30 ms: segment 1 is lost at 1000 + 30 + 5 */
+  lwip_sys_now = 1030;
+  sacks[0] = s[2]; sacks[1] = s[3];
+  p = tcp_create_rx_segment_sack(pcb, 0, sacks, 1);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->dupacks == 1);
+  EXPECT(txcounters.num_tx_calls == 0);
+  EXPECT(pcb->rack_flags & TCP_RACK_REO_TIMER);
+  lwip_sys_now = 1034;
+  sys_check_timeouts();
+  EXPECT(txcounters.num_tx_calls == 0);
+  EXPECT(!(pcb->flags & TF_INFR));
+
+  lwip_sys_now = 1035;
+  sys_check_timeouts();
+  EXPECT(pcb->flags & TF_INFR);
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(txcounters.num_tx_bytes == TCP_MSS + 40U);
+  EXPECT_RET(pcb->unacked != NULL);
+  EXPECT(pcb->unacked->tcphdr->seqno == htonl(s[1]));
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* the retransmission is ACKed: recovery ends */
+  lwip_sys_now = 1060;
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 3 * TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->unacked == NULL);
+  EXPECT(!(pcb->flags & TF_INFR));
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+#endif /* LWIP_TCP_RACK_TLP */
+#endif /* LWIP_TCP_RTO_MS */
+
+#if LWIP_TCP_ZEROCOPY
+static int test_tcp_write_ref_freed;
+
+static void
+test_tcp_write_ref_free(struct pbuf *p)
+{
+  LWIP_UNUSED_ARG(p);
+  test_tcp_write_ref_freed++;
+}
+
+/** Check that data sent with tcp_write_ref() is not copied and that the
+ * reference pbuf is released once all of it has been ACKed or the pcb aborted */
+START_TEST(test_tcp_write_ref)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf_custom zc;
+  struct pbuf *ref, *p;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_write_ref_freed = 0;
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = 4 * TCP_MSS;
+
+  zc.custom_free_function = test_tcp_write_ref_free;
+  ref = pbuf_alloced_custom(PBUF_RAW, 0, PBUF_REF, &zc, NULL, 0);
+  EXPECT_RET(ref != NULL);
+  err = tcp_write_ref(pcb, tx_data, 3 * TCP_MSS, TCP_WRITE_FLAG_COPY, ref);
+  EXPECT_RET(err == ERR_OK);
+  /* one reference per segment, no data copied */
+  EXPECT(ref->ref == 4);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_REF_PBUF) == 3);
+  EXPECT_RET(pcb->unsent != NULL);
+  EXPECT(pcb->unsent->p->next != NULL);
+  EXPECT(pcb->unsent->p->next->payload == tx_data);
+  pbuf_free(ref);
+  EXPECT(test_tcp_write_ref_freed == 0);
+
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(txcounters.num_tx_calls == 3);
+  EXPECT(test_tcp_write_ref_freed == 0);
+
+  /* a partial ACK keeps the reference */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 2 * TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(test_tcp_write_ref_freed == 0);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_REF_PBUF) == 1);
+
+  /* ACKing the rest releases it */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(test_tcp_write_ref_freed == 1);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_REF_PBUF) == 0);
+
+  /* aborting with unacked data releases it, too */
+  ref = pbuf_alloced_custom(PBUF_RAW, 0, PBUF_REF, &zc, NULL, 0);
+  EXPECT_RET(ref != NULL);
+  err = tcp_write_ref(pcb, tx_data, TCP_MSS, 0, ref);
+  EXPECT_RET(err == ERR_OK);
+  pbuf_free(ref);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(test_tcp_write_ref_freed == 1);
+  tcp_abort(pcb);
+  EXPECT(test_tcp_write_ref_freed == 2);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_REF_PBUF) == 0);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+#endif /* LWIP_TCP_ZEROCOPY */
+
 /** Create the suite including all tests for this module */
 Suite *
 tcp_suite(void)
@@ -1672,6 +2694,7 @@ tcp_suite(void)
     TESTFUNC(test_tcp_new_abort),
     TESTFUNC(test_tcp_listen_passive_open),
     TESTFUNC(test_tcp_recv_inseq),
+    TESTFUNC(test_tcp_recv_demux),
     TESTFUNC(test_tcp_recv_inseq_trim),
     TESTFUNC(test_tcp_passive_close),
     TESTFUNC(test_tcp_active_abort),
@@ -1689,7 +2712,35 @@ tcp_suite(void)
     TESTFUNC(test_tcp_rto_timeout_syn_sent_link_down),
     TESTFUNC(test_tcp_zwp_timeout),
     TESTFUNC(test_tcp_zwp_timeout_link_down),
-    TESTFUNC(test_tcp_persist_split)
+    TESTFUNC(test_tcp_persist_split),
+    TESTFUNC(test_tcp_idle_timers),
+    TESTFUNC(test_tcp_idle_send_rexmit),
+    TESTFUNC(test_tcp_time_wait_expiry),
+#if LWIP_TCP_SACK_IN
+    TESTFUNC(test_tcp_sack_recovery),
+    TESTFUNC(test_tcp_sack_not_permitted),
+    TESTFUNC(test_tcp_sack_rto),
+#endif /* LWIP_TCP_SACK_IN */
+#if LWIP_TCP_CC
+    TESTFUNC(test_tcp_cc_select),
+#if LWIP_TCP_CC_CUBIC
+    TESTFUNC(test_tcp_cc_listen),
+    TESTFUNC(test_tcp_cc_cubic),
+#endif /* LWIP_TCP_CC_CUBIC */
+#endif /* LWIP_TCP_CC */
+#if LWIP_TCP_RTO_MS
+    TESTFUNC(test_tcp_rto_ms),
+#if LWIP_TCP_TIMESTAMPS
+    TESTFUNC(test_tcp_rto_ms_timestamps),
+#endif /* LWIP_TCP_TIMESTAMPS */
+#if LWIP_TCP_RACK_TLP
+    TESTFUNC(test_tcp_rack_tlp),
+    TESTFUNC(test_tcp_rack_reo_timer),
+#endif /* LWIP_TCP_RACK_TLP */
+#endif /* LWIP_TCP_RTO_MS */
+#if LWIP_TCP_ZEROCOPY
+    TESTFUNC(test_tcp_write_ref),
+#endif /* LWIP_TCP_ZEROCOPY */
   };
   return create_suite("TCP", tests, sizeof(tests)/sizeof(testfunc), tcp_setup, tcp_teardown);
 }
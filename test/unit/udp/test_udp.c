@@ -459,6 +459,105 @@ START_TEST(test_udp_bind)
 }
 END_TEST
 
+/* change the source of a packet created by test_udp_create_test_packet() */
+static void
+test_udp_set_packet_src(struct pbuf *p, u32_t src_addr, u16_t src_port)
+{
+  struct ip_hdr *ih = (struct ip_hdr *)p->payload;
+  struct udp_hdr *uh = (struct udp_hdr *)((u8_t *)p->payload + sizeof(struct ip_hdr));
+
+  ih->src.addr = src_addr;
+  IPH_CHKSUM_SET(ih, 0);
+  IPH_CHKSUM_SET(ih, inet_chksum(ih, sizeof(struct ip_hdr)));
+  uh->src = lwip_htons(src_port);
+}
+
+static void
+test_udp_input_from(u16_t port, u32_t dst_addr, u32_t src_addr, u16_t src_port, struct netif *inp)
+{
+  err_t err;
+  struct pbuf *p = test_udp_create_test_packet(16, port, dst_addr);
+  EXPECT_RET(p != NULL);
+  test_udp_set_packet_src(p, src_addr, src_port);
+  err = ip4_input(p, inp);
+  fail_unless(err == ERR_OK);
+}
+
+/* check that datagrams are demultiplexed to the right pcb while pcbs are
+   bound, connected, disconnected, rebound and removed */
+START_TEST(test_udp_demux)
+{
+  err_t err;
+  struct udp_pcb *pcb_conn, *pcb_uncon;
+  const u16_t port = 12345;
+  const u16_t port2 = 12346;
+  const u16_t remote_port = 4000;
+  ip_addr_t remote_ip;
+  struct test_udp_rxdata ctr_conn, ctr_uncon;
+  LWIP_UNUSED_ARG(_i);
+
+  IP_ADDR4(&remote_ip, 192,168,0,10);
+
+  pcb_conn = udp_new();
+  fail_unless(pcb_conn != NULL);
+  pcb_uncon = udp_new();
+  fail_unless(pcb_uncon != NULL);
+
+  err = udp_bind(pcb_conn, &test_netif1.ip_addr, port);
+  fail_unless(err == ERR_OK);
+  err = udp_connect(pcb_conn, &remote_ip, remote_port);
+  fail_unless(err == ERR_OK);
+  err = udp_bind(pcb_uncon, &test_netif2.ip_addr, port);
+  fail_unless(err == ERR_OK);
+
+  memset(&ctr_conn, 0, sizeof(ctr_conn));
+  ctr_conn.pcb = pcb_conn;
+  memset(&ctr_uncon, 0, sizeof(ctr_uncon));
+  ctr_uncon.pcb = pcb_uncon;
+  udp_recv(pcb_conn, test_recv, &ctr_conn);
+  udp_recv(pcb_uncon, test_recv, &ctr_uncon);
+
+  /* from the connected remote end */
+  test_udp_input_from(port, test_ipaddr1.addr, ip_2_ip4(&remote_ip)->addr, remote_port, &test_netif1);
+  fail_unless(ctr_conn.rx_cnt == 1);
+  fail_unless(ctr_uncon.rx_cnt == 0);
+
+  /* from another port of the remote host: no match */
+  test_udp_input_from(port, test_ipaddr1.addr, ip_2_ip4(&remote_ip)->addr, remote_port + 1, &test_netif1);
+  fail_unless(ctr_conn.rx_cnt == 1);
+  fail_unless(ctr_uncon.rx_cnt == 0);
+
+  /* same port, other local address: the unconnected pcb accepts any source */
+  test_udp_input_from(port, test_ipaddr2.addr, ip_2_ip4(&remote_ip)->addr, remote_port + 1, &test_netif2);
+  fail_unless(ctr_conn.rx_cnt == 1);
+  fail_unless(ctr_uncon.rx_cnt == 1);
+
+  /* after disconnecting, any source is accepted */
+  udp_disconnect(pcb_conn);
+  test_udp_input_from(port, test_ipaddr1.addr, ip_2_ip4(&remote_ip)->addr, remote_port + 1, &test_netif1);
+  fail_unless(ctr_conn.rx_cnt == 2);
+  fail_unless(ctr_uncon.rx_cnt == 1);
+
+  /* reconnect and rebind to another port */
+  err = udp_connect(pcb_conn, &remote_ip, remote_port);
+  fail_unless(err == ERR_OK);
+  err = udp_bind(pcb_conn, &test_netif1.ip_addr, port2);
+  fail_unless(err == ERR_OK);
+  test_udp_input_from(port, test_ipaddr1.addr, ip_2_ip4(&remote_ip)->addr, remote_port, &test_netif1);
+  fail_unless(ctr_conn.rx_cnt == 2);
+  test_udp_input_from(port2, test_ipaddr1.addr, ip_2_ip4(&remote_ip)->addr, remote_port, &test_netif1);
+  fail_unless(ctr_conn.rx_cnt == 3);
+  fail_unless(ctr_uncon.rx_cnt == 1);
+
+  /* removed pcbs are not found any more */
+  udp_remove(pcb_conn);
+  test_udp_input_from(port2, test_ipaddr1.addr, ip_2_ip4(&remote_ip)->addr, remote_port, &test_netif1);
+  fail_unless(ctr_conn.rx_cnt == 3);
+  test_udp_input_from(port, test_ipaddr2.addr, ip_2_ip4(&remote_ip)->addr, remote_port, &test_netif2);
+  fail_unless(ctr_uncon.rx_cnt == 2);
+}
+END_TEST
+
 /** Create the suite including all tests for this module */
 Suite *
 udp_suite(void)
@@ -466,7 +565,8 @@ udp_suite(void)
   testfunc tests[] = {
     TESTFUNC(test_udp_new_remove),
     TESTFUNC(test_udp_broadcast_rx_with_2_netifs),
-    TESTFUNC(test_udp_bind)
+    TESTFUNC(test_udp_bind),
+    TESTFUNC(test_udp_demux)
   };
   return create_suite("UDP", tests, sizeof(tests)/sizeof(testfunc), udp_setup, udp_teardown);
 }
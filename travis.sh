@@ -16,6 +16,41 @@ if [ $ERR != 0 ]; then
        RETVAL=1
 fi
 
+# Run the unit tests that need millisecond RTO timers and RACK-TLP
+make clean
+make check -j 4 UNITTEST_OPTS="-DLWIP_TCP_RTO_MS=1 -DLWIP_TCP_SACK_IN=1"
+ERR=$?
+echo Return value from unittests with LWIP_TCP_RTO_MS: $ERR
+if [ $ERR != 0 ]; then
+       echo "++++++++++++++++++++++++++++++ unittests with LWIP_TCP_RTO_MS failed"
+       RETVAL=1
+fi
+
+# Run the unit tests for PBUF_POOL size classes
+make clean
+make check -j 4 UNITTEST_OPTS="-DPBUF_POOL_SIZE_CLASSES=1"
+ERR=$?
+echo Return value from unittests with PBUF_POOL_SIZE_CLASSES: $ERR
+if [ $ERR != 0 ]; then
+       echo "++++++++++++++++++++++++++++++ unittests with PBUF_POOL_SIZE_CLASSES failed"
+       RETVAL=1
+fi
+
+# Run the unit tests with the optional core, TCP and API features switched on
+make clean
+make check -j 4 UNITTEST_OPTS="-DLWIP_TIMERS_WHEEL=1 -DMEMP_CACHE=1 -DMEMP_LOCKFREE=1 \
+  -DMEM_SIZE_CLASSES=1 -DLWIP_PBUF_REF_ATOMIC=1 -DLWIP_PBUF_REF_T=u16_t \
+  -DLWIP_NETIF_LINKOUTPUT_SG=1 -DLWIP_CHKSUM_ALGORITHM=5 -DLWIP_CHKSUM_COPY_ALGORITHM=2 \
+  -DLWIP_TCP_PCB_HASH=1 -DLWIP_UDP_PCB_HASH=1 -DLWIP_TCP_PCB_TIMERS=1 \
+  -DLWIP_TCP_SACK_IN=1 -DLWIP_TCP_CC=1 -DLWIP_TCP_ZEROCOPY=1 -DLWIP_SOCKET_RECV_PBUF=1 \
+  -DLWIP_NETCONN_FASTPATH=1 -DLWIP_TCPIP_INPUT_BATCH=1 -DLWIP_TCPIP_BUSY_POLL=1"
+ERR=$?
+echo Return value from unittests with optional features: $ERR
+if [ $ERR != 0 ]; then
+       echo "++++++++++++++++++++++++++++++ unittests with optional features failed"
+       RETVAL=1
+fi
+
 # Build example_app using cmake, this tests the CMake toolchain
 cd ../../../../
 # Copy lwipcfg for example app